@@ -0,0 +1,52 @@
+#include <cmath>
+
+#include "BehaviorSystem.h"
+
+using namespace DirectX;
+
+BehaviorSystem::BehaviorSystem() :
+	m_pPool(&TransformPool::GetInstance())
+{
+}
+
+void BehaviorSystem::AddRotator(Transform* a_pTransform, XMFLOAT3 a_speed)
+{
+	m_rotators.push_back({ a_pTransform->GetHandle(), a_speed });
+}
+
+void BehaviorSystem::AddOscillator(Transform* a_pTransform, XMFLOAT3 a_amplitude, float a_frequency)
+{
+	m_oscillators.push_back({ a_pTransform->GetHandle(), a_amplitude, a_frequency, 0.0f });
+}
+
+// --------------------------------------------------------
+// Angles are wrapped back into [-pi, pi) as they go so
+// they never lose precision, however long this runs.
+// Oscillators only swap last frame's offset for this
+// frame's, so anything else moving the transform (like
+// the UI) isn't undone
+// --------------------------------------------------------
+void BehaviorSystem::Update(float a_deltaTime, float a_totalTime)
+{
+	for (const Rotator& rotator : m_rotators)
+	{
+		XMFLOAT3 rotation = m_pPool->GetRotation(rotator.Transform);
+		rotation.x = XMScalarModAngle(rotation.x + rotator.Speed.x * a_deltaTime);
+		rotation.y = XMScalarModAngle(rotation.y + rotator.Speed.y * a_deltaTime);
+		rotation.z = XMScalarModAngle(rotation.z + rotator.Speed.z * a_deltaTime);
+		m_pPool->SetRotation(rotator.Transform, rotation);
+	}
+
+	for (Oscillator& oscillator : m_oscillators)
+	{
+		float offset = sinf(oscillator.Frequency * a_totalTime);
+		float change = offset - oscillator.Offset;
+		oscillator.Offset = offset;
+
+		XMFLOAT3 position = m_pPool->GetPosition(oscillator.Transform);
+		position.x += oscillator.Amplitude.x * change;
+		position.y += oscillator.Amplitude.y * change;
+		position.z += oscillator.Amplitude.z * change;
+		m_pPool->SetPosition(oscillator.Transform, position);
+	}
+}
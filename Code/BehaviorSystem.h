@@ -0,0 +1,55 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+#include "Transform.h"
+#include "TransformPool.h"
+
+// --------------------------------------------------------
+// Spins a transform at a constant rate, in radians per
+// second around each axis (pitch, yaw, roll)
+// --------------------------------------------------------
+struct Rotator
+{
+	unsigned int Transform;
+	DirectX::XMFLOAT3 Speed;
+};
+
+// --------------------------------------------------------
+// Bobs a transform back and forth along Amplitude around
+// where it started, Frequency times every 2 pi seconds
+// --------------------------------------------------------
+struct Oscillator
+{
+	unsigned int Transform;
+	DirectX::XMFLOAT3 Amplitude;
+	float Frequency;
+	float Offset;	// The sine last applied, so it can be taken back out
+};
+
+// --------------------------------------------------------
+// Simple per-frame animations, kept out of the entities
+//
+// Each kind of behavior is its own tightly packed array
+// pointing at a slot of the TransformPool, so updating
+// them is one straight loop per kind with no lookups.
+// Behaviors don't remove themselves, so the transforms
+// they point at need to outlive the system
+// --------------------------------------------------------
+class BehaviorSystem
+{
+public:
+	BehaviorSystem();
+
+	void AddRotator(Transform* a_pTransform, DirectX::XMFLOAT3 a_speed);
+
+	void AddOscillator(Transform* a_pTransform, DirectX::XMFLOAT3 a_amplitude, float a_frequency = 1.0f);
+
+	void Update(float a_deltaTime, float a_totalTime);
+
+private:
+	TransformPool* m_pPool;
+	std::vector<Rotator> m_rotators;
+	std::vector<Oscillator> m_oscillators;
+};
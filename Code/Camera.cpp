@@ -56,14 +56,10 @@ void Camera::UpdateViewMatrix()
 	// Grab the position from the transform
 	XMFLOAT3 pos = m_transform.GetPosition();
 	XMVECTOR posVector = XMLoadFloat3(&pos);
-	// Grab the rotation
-	XMFLOAT3 rot = m_transform.GetRotation();
-	XMVECTOR rotVector = XMLoadFloat3(&rot);
-	// Make a quaternion
-	XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(rotVector);
-
-	XMVECTOR defaultForward = XMVectorSet(0, 0, 1, 0); // z-axis
-	XMVECTOR currentForward = XMVector3Rotate(defaultForward, rotQuat);
+	// The transform keeps its rotation as a quaternion, so its
+	// forward vector is already just a few multiplies away
+	XMFLOAT3 forward = m_transform.GetForward();
+	XMVECTOR currentForward = XMLoadFloat3(&forward);
 
 	XMMATRIX view = XMMatrixLookToLH(posVector, currentForward, XMVectorSet(0, 1, 0, 0));
 	XMStoreFloat4x4(&m_viewMatrix, view);
@@ -0,0 +1,27 @@
+#include "CommandList.h"
+#include "JobSystem.h"
+
+void CommandList::Record(size_t a_count, size_t a_minChunkSize, const RecordFunction& a_record)
+{
+	JobSystem& jobs = JobSystem::GetInstance();
+
+	// ParallelFor hands out chunk indices below GetChunkCount(),
+	// so every chunk's bucket exists before any job starts
+	m_bucketCount = jobs.GetChunkCount(a_count, a_minChunkSize);
+	if (m_buckets.size() < m_bucketCount)
+		m_buckets.resize(m_bucketCount);
+	for (unsigned int i = 0; i < m_bucketCount; i++)
+		m_buckets[i].Packets.clear();
+
+	jobs.ParallelFor(a_count, a_minChunkSize, [this, &a_record](unsigned int a_chunk, size_t a_begin, size_t a_end) {
+		a_record(m_buckets[a_chunk].Packets, a_begin, a_end);
+	});
+
+	// Chunk i always comes before chunk i + 1 in item order
+	m_packets.clear();
+	for (unsigned int i = 0; i < m_bucketCount; i++)
+		m_packets.insert(m_packets.end(), m_buckets[i].Packets.begin(), m_buckets[i].Packets.end());
+}
+
+const std::vector<DrawPacket>& CommandList::GetPackets() { return m_packets; }
+unsigned int CommandList::GetBucketCount() { return m_bucketCount; }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// --------------------------------------------------------
+// One draw, as plain data. Batch is the caller's index for
+// the state it needs bound (shaders, material, mesh and
+// per-object data), and the rest is the draw itself - an
+// InstanceCount of zero means a plain indexed draw
+// --------------------------------------------------------
+struct DrawPacket
+{
+	uint32_t Batch;
+	uint32_t IndexStart;
+	uint32_t IndexCount;
+	uint32_t InstanceCount;
+	uint32_t FirstInstance;
+};
+
+// --------------------------------------------------------
+// A frame's draws, recorded in parallel and replayed in
+// order on the one thread allowed to submit them
+//
+// Record() splits the caller's items into chunks on the job
+// system, and each chunk writes packets into its own bucket,
+// so recording never locks. The buckets are joined back in
+// chunk order, which is item order, so the packets come out
+// the same no matter how many threads recorded them
+//
+// Nothing in here touches Direct3D - Replay() hands each
+// packet to whatever the caller does with it
+// --------------------------------------------------------
+class CommandList
+{
+public:
+	typedef std::function<void(std::vector<DrawPacket>&, size_t, size_t)> RecordFunction;
+
+	/* Throws away last frame's packets and has a_record(packets, begin, end) fill them in for [0, a_count), at least a_minChunkSize items per job */
+	void Record(size_t a_count, size_t a_minChunkSize, const RecordFunction& a_record);
+
+	const std::vector<DrawPacket>& GetPackets();
+
+	/* How many buckets the last Record() used, which is how many threads it could have run on */
+	unsigned int GetBucketCount();
+
+	// --------------------------------------------------------
+	// Calls a_bindBatch(batch) whenever a packet needs another
+	// batch's state than the one before it, then a_draw(packet)
+	// for every packet. A batch that recorded no packets (all
+	// of it culled, say) is never bound at all
+	// --------------------------------------------------------
+	template<typename BindBatch, typename Draw>
+	void Replay(BindBatch a_bindBatch, Draw a_draw)
+	{
+		bool isBatchBound = false;
+		uint32_t boundBatch = 0;
+		for (const DrawPacket& packet : m_packets) {
+			if (!isBatchBound || packet.Batch != boundBatch) {
+				a_bindBatch(packet.Batch);
+				boundBatch = packet.Batch;
+				isBatchBound = true;
+			}
+			a_draw(packet);
+		}
+	}
+
+private:
+	// Padded so that neighboring buckets' vectors, which grow on
+	// different threads, never share a cache line
+	struct Bucket
+	{
+		std::vector<DrawPacket> Packets;
+		char Padding[64];
+	};
+
+	std::vector<Bucket> m_buckets;	// Kept between frames so recording doesn't allocate
+	unsigned int m_bucketCount = 0;
+	std::vector<DrawPacket> m_packets;
+};
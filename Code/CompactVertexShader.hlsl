@@ -0,0 +1,43 @@
+#include "ShaderIncludes.hlsli"
+
+// Constant buffers, split by how often they change
+cbuffer PerFrame : register(b0)
+{
+    matrix viewMatrix;
+    matrix projectionMatrix;
+}
+
+cbuffer PerObject : register(b1)
+{
+    matrix worldMatrix;
+    matrix worldInvTransposeMatrix;
+    
+    // Turns the 0-1 positions back into local space
+    float3 positionScale;
+    float3 positionOffset;
+}
+
+// --------------------------------------------------------
+// Same as VertexShader, but for meshes stored in one of
+// the compact vertex formats - everything is unpacked
+// first and then transformed exactly the same way
+// --------------------------------------------------------
+VertexToPixel main(CompactVertexShaderInput input)
+{
+    VertexToPixel output;
+
+    float3 localPosition = positionOffset + input.localPosition.xyz * positionScale;
+    float3 normal = DecodeOctahedral(input.normal);
+    float3 tangent = DecodeOctahedral(input.tangent);
+    float handedness = input.localPosition.w * 2.0f - 1.0f;
+
+    matrix wvp = mul(mul(projectionMatrix, viewMatrix), worldMatrix);
+    output.screenPosition = mul(wvp, float4(localPosition, 1.0f));
+
+    output.uv = input.uv;
+    output.normal = mul((float3x3) worldInvTransposeMatrix, normal);
+    output.worldPosition = mul(worldMatrix, float4(localPosition, 1.0f)).xyz;
+    output.tangent = float4(normalize(mul((float3x3) worldMatrix, tangent)), handedness);
+
+    return output;
+}
@@ -0,0 +1,49 @@
+#include "ConstantBufferData.h"
+
+#include <cstring>
+
+bool WriteConstantBufferData(LocalConstantBuffer& a_buffer, unsigned int a_byteOffset, const void* a_pData, unsigned int a_size)
+{
+	unsigned char* destination = a_buffer.LocalDataBuffer + a_byteOffset;
+	if (memcmp(destination, a_pData, a_size) == 0)
+		return false;
+	memcpy(destination, a_pData, a_size);
+
+	unsigned int start = a_byteOffset;
+	unsigned int end = a_byteOffset + a_size;
+	if (!a_buffer.IsDirty) {
+		a_buffer.IsDirty = true;
+		a_buffer.DirtyStart = start;
+		a_buffer.DirtyEnd = end;
+	}
+	else {
+		if (start < a_buffer.DirtyStart) a_buffer.DirtyStart = start;
+		if (end > a_buffer.DirtyEnd) a_buffer.DirtyEnd = end;
+	}
+	return true;
+}
+
+// --------------------------------------------------------
+// Direct3D 11.0 can't update part of a constant buffer, so
+// the whole thing goes up either way - the dirty range is
+// only counted, in BytesChanged. A failed upload leaves the
+// buffer dirty, to be tried again next time
+// --------------------------------------------------------
+bool UploadConstantBufferData(LocalConstantBuffer& a_buffer, void* a_pBuffer, IConstantBufferTarget& a_target, ConstantBufferStats& a_stats)
+{
+	if (!a_buffer.IsDirty) {
+		a_stats.UploadsSkipped++;
+		return false;
+	}
+
+	if (!a_target.UploadConstantBuffer(a_pBuffer, a_buffer.IsDynamic, a_buffer.LocalDataBuffer, a_buffer.Size))
+		return false;
+
+	a_stats.UploadsPerformed++;
+	a_stats.BytesCopied += a_buffer.Size;
+	a_stats.BytesChanged += a_buffer.DirtyEnd - a_buffer.DirtyStart;
+	a_buffer.IsDirty = false;
+	a_buffer.DirtyStart = 0;
+	a_buffer.DirtyEnd = 0;
+	return true;
+}
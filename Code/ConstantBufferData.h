@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// Whatever constant buffer data is uploaded to. The buffer
+// is passed as a void* so the tracking below never needs to
+// know about Direct3D - the target casts it back
+// --------------------------------------------------------
+class IConstantBufferTarget
+{
+public:
+	virtual ~IConstantBufferTarget() {}
+
+	/* Replaces all of a buffer's contents, with Map(WRITE_DISCARD) if it's dynamic. Returns false if that failed */
+	virtual bool UploadConstantBuffer(void* a_pBuffer, bool a_isDynamic, const void* a_pData, unsigned int a_size) = 0;
+};
+
+// Running totals of the uploads UploadConstantBufferData() made and skipped
+struct ConstantBufferStats
+{
+	size_t BytesCopied = 0;
+	size_t BytesChanged = 0;	// The part of BytesCopied that actually differed
+	size_t UploadsPerformed = 0;
+	size_t UploadsSkipped = 0;
+};
+
+// --------------------------------------------------------
+// The CPU-side copy of one constant buffer, and the part of
+// it that differs from what was last uploaded
+// --------------------------------------------------------
+struct LocalConstantBuffer
+{
+	unsigned char* LocalDataBuffer = 0;
+	unsigned int Size = 0;
+
+	// Bytes of LocalDataBuffer that differ from the GPU copy,
+	// from DirtyStart up to (not including) DirtyEnd
+	bool IsDirty = true;
+	bool IsDynamic = false;	// Uploaded with Map(WRITE_DISCARD) instead of UpdateSubresource
+	unsigned int DirtyStart = 0;
+	unsigned int DirtyEnd = 0;
+};
+
+// Copies into a buffer's local data, unless it's already there, and grows
+// the dirty range to cover it. Returns whether anything changed
+bool WriteConstantBufferData(LocalConstantBuffer& a_buffer, unsigned int a_byteOffset, const void* a_pData, unsigned int a_size);
+
+// Sends a buffer's local data to a_pBuffer through a_target if it's dirty,
+// or counts it as skipped. Returns whether anything was uploaded
+bool UploadConstantBufferData(LocalConstantBuffer& a_buffer, void* a_pBuffer, IConstantBufferTarget& a_target, ConstantBufferStats& a_stats);
@@ -0,0 +1,88 @@
+#include "D3D11StateTarget.h"
+
+#include <cstring>
+
+D3D11StateTarget::D3D11StateTarget(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext)
+	: m_pContext(a_pContext)
+{
+}
+
+D3D11StateTarget::~D3D11StateTarget() {}
+
+void D3D11StateTarget::SetInputLayout(void* a_pLayout)
+{
+	m_pContext->IASetInputLayout((ID3D11InputLayout*)a_pLayout);
+}
+
+void D3D11StateTarget::SetShader(ShaderStage a_stage, void* a_pShader)
+{
+	switch (a_stage) {
+	case ShaderStage::Vertex: m_pContext->VSSetShader((ID3D11VertexShader*)a_pShader, 0, 0); break;
+	case ShaderStage::Hull: m_pContext->HSSetShader((ID3D11HullShader*)a_pShader, 0, 0); break;
+	case ShaderStage::Domain: m_pContext->DSSetShader((ID3D11DomainShader*)a_pShader, 0, 0); break;
+	case ShaderStage::Geometry: m_pContext->GSSetShader((ID3D11GeometryShader*)a_pShader, 0, 0); break;
+	case ShaderStage::Pixel: m_pContext->PSSetShader((ID3D11PixelShader*)a_pShader, 0, 0); break;
+	case ShaderStage::Compute: m_pContext->CSSetShader((ID3D11ComputeShader*)a_pShader, 0, 0); break;
+	default: break;
+	}
+}
+
+// The cache's void* arrays hold the same pointers Direct3D wants,
+// so they're handed over as they are
+void D3D11StateTarget::SetConstantBuffers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppBuffers)
+{
+	ID3D11Buffer* const* buffers = (ID3D11Buffer* const*)a_ppBuffers;
+	switch (a_stage) {
+	case ShaderStage::Vertex: m_pContext->VSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	case ShaderStage::Hull: m_pContext->HSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	case ShaderStage::Domain: m_pContext->DSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	case ShaderStage::Geometry: m_pContext->GSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	case ShaderStage::Pixel: m_pContext->PSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	case ShaderStage::Compute: m_pContext->CSSetConstantBuffers(a_startSlot, a_count, buffers); break;
+	default: break;
+	}
+}
+
+void D3D11StateTarget::SetShaderResources(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppResources)
+{
+	ID3D11ShaderResourceView* const* resources = (ID3D11ShaderResourceView* const*)a_ppResources;
+	switch (a_stage) {
+	case ShaderStage::Vertex: m_pContext->VSSetShaderResources(a_startSlot, a_count, resources); break;
+	case ShaderStage::Hull: m_pContext->HSSetShaderResources(a_startSlot, a_count, resources); break;
+	case ShaderStage::Domain: m_pContext->DSSetShaderResources(a_startSlot, a_count, resources); break;
+	case ShaderStage::Geometry: m_pContext->GSSetShaderResources(a_startSlot, a_count, resources); break;
+	case ShaderStage::Pixel: m_pContext->PSSetShaderResources(a_startSlot, a_count, resources); break;
+	case ShaderStage::Compute: m_pContext->CSSetShaderResources(a_startSlot, a_count, resources); break;
+	default: break;
+	}
+}
+
+void D3D11StateTarget::SetSamplers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppSamplers)
+{
+	ID3D11SamplerState* const* samplers = (ID3D11SamplerState* const*)a_ppSamplers;
+	switch (a_stage) {
+	case ShaderStage::Vertex: m_pContext->VSSetSamplers(a_startSlot, a_count, samplers); break;
+	case ShaderStage::Hull: m_pContext->HSSetSamplers(a_startSlot, a_count, samplers); break;
+	case ShaderStage::Domain: m_pContext->DSSetSamplers(a_startSlot, a_count, samplers); break;
+	case ShaderStage::Geometry: m_pContext->GSSetSamplers(a_startSlot, a_count, samplers); break;
+	case ShaderStage::Pixel: m_pContext->PSSetSamplers(a_startSlot, a_count, samplers); break;
+	case ShaderStage::Compute: m_pContext->CSSetSamplers(a_startSlot, a_count, samplers); break;
+	default: break;
+	}
+}
+
+bool D3D11StateTarget::UploadConstantBuffer(void* a_pBuffer, bool a_isDynamic, const void* a_pData, unsigned int a_size)
+{
+	ID3D11Buffer* buffer = (ID3D11Buffer*)a_pBuffer;
+	if (a_isDynamic) {
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (FAILED(m_pContext->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+			return false;
+		memcpy(mapped.pData, a_pData, a_size);
+		m_pContext->Unmap(buffer, 0);
+	}
+	else {
+		m_pContext->UpdateSubresource(buffer, 0, 0, a_pData, 0, 0);
+	}
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "ConstantBufferData.h"
+#include "StateCache.h"
+
+// --------------------------------------------------------
+// Sends a StateCache's binds, and constant buffer uploads,
+// to a Direct3D 11 device context
+// --------------------------------------------------------
+class D3D11StateTarget : public IStateCacheTarget, public IConstantBufferTarget
+{
+public:
+	D3D11StateTarget(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext);
+	~D3D11StateTarget();
+
+	void SetInputLayout(void* a_pLayout);
+	void SetShader(ShaderStage a_stage, void* a_pShader);
+	void SetConstantBuffers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppBuffers);
+	void SetShaderResources(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppResources);
+	void SetSamplers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppSamplers);
+
+	bool UploadConstantBuffer(void* a_pBuffer, bool a_isDynamic, const void* a_pData, unsigned int a_size);
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_pContext;
+};
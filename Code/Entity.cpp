@@ -1,12 +1,27 @@
+#include <algorithm>
+#include <cmath>
+
 #include "Entity.h"
 using namespace DirectX;
 
+namespace
+{
+	// How much a world matrix stretches each of the mesh's own axes -
+	// the lengths of its first three rows, so every parent's scale counts
+	XMFLOAT3 GetWorldScale(FXMMATRIX a_world)
+	{
+		return XMFLOAT3(
+			XMVectorGetX(XMVector3Length(a_world.r[0])),
+			XMVectorGetX(XMVector3Length(a_world.r[1])),
+			XMVectorGetX(XMVector3Length(a_world.r[2])));
+	}
+}
+
 Entity::Entity(std::shared_ptr<Mesh> a_pMesh, std::shared_ptr<Material> a_pMaterial, std::string a_entityName)
 	:m_pMesh(a_pMesh),
 	m_pMaterial(a_pMaterial),
 	m_entityName(a_entityName)
 {
-	m_transform = Transform();
 }
 
 std::shared_ptr<Mesh> Entity::GetMesh() { return m_pMesh; }
@@ -18,8 +33,95 @@ void Entity::SetMaterial(std::shared_ptr<Material> a_pMaterial) { m_pMaterial =
 
 void Entity::SetMesh(std::shared_ptr<Mesh> a_pMesh) { m_pMesh = a_pMesh; }
 
-void Entity::Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext, std::shared_ptr<Camera> a_pCamera)
+// --------------------------------------------------------
+// Projects each level's error (a distance in mesh units) to
+// pixels at the closest point of the mesh's bounding sphere
+// and keeps the coarsest level that's still under the limit
+// --------------------------------------------------------
+int Entity::SelectLod(std::shared_ptr<Camera> a_pCamera, float a_screenHeight, float a_maxPixelError)
 {
-	m_pMaterial->SendDataToShader(&m_transform, a_pCamera);
-	m_pMesh->Draw(a_pContext);
+	int lodCount = m_pMesh->GetLodCount();
+	if (lodCount <= 1 || a_pCamera->GetProjectionType())
+		return 0;
+
+	XMFLOAT3 sphereCenter = m_pMesh->GetSphereCenter();
+	XMVECTOR localCenter = XMLoadFloat3(&sphereCenter);
+	float radius = m_pMesh->GetSphereRadius();
+
+	XMFLOAT4X4 world = m_transform.GetWorldMatrix();
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+	XMVECTOR center = XMVector3TransformCoord(localCenter, worldMatrix);
+	XMFLOAT3 scale = GetWorldScale(worldMatrix);
+	float maxScale = (std::max)((std::max)(scale.x, scale.y), scale.z);
+
+	XMFLOAT3 cameraPosition = a_pCamera->GetTransform()->GetPosition();
+	float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat3(&cameraPosition))));
+	distance = (std::max)(distance - radius * maxScale, a_pCamera->GetNearClipDistance());
+
+	float pixelsPerUnit = a_screenHeight / (2.0f * tanf(a_pCamera->GetFieldOfView() * 0.5f) * distance);
+	int lod = 0;
+	for (int i = 1; i < lodCount; i++)
+	{
+		if (m_pMesh->GetLod(i).Error * maxScale * pixelsPerUnit > a_maxPixelError)
+			break;
+		lod = i;
+	}
+	return lod;
+}
+
+void Entity::RecordDraws(Camera* a_pCamera, int a_lod, bool a_isClusterCulled, unsigned int a_batch, std::vector<DrawPacket>& a_packets)
+{
+	if (!a_isClusterCulled || a_lod != 0 || m_pMesh->GetMeshletCount() == 0) {
+		MeshLod lod = m_pMesh->GetLod(a_lod);
+		a_packets.push_back({ a_batch, lod.IndexStart, lod.IndexCount, 0, 0 });
+		return;
+	}
+
+	Frustum localFrustum;
+	XMFLOAT3 localCameraPosition;
+	bool isConeCullingAllowed;
+	GetLocalCullingView(a_pCamera, localFrustum, localCameraPosition, isConeCullingAllowed);
+
+	// Each recording thread keeps its own ranges, so culling
+	// neither allocates nor writes to the shared mesh
+	static thread_local std::vector<IndexRange> t_visibleRanges;
+	m_pMesh->CullClusters(localFrustum, localCameraPosition, isConeCullingAllowed, t_visibleRanges);
+	for (const IndexRange& range : t_visibleRanges)
+		a_packets.push_back({ a_batch, range.IndexStart, range.IndexCount, 0, 0 });
+}
+
+// --------------------------------------------------------
+// Meshlet culling happens in the mesh's local space, so the
+// frustum comes from the whole world-view-projection and
+// the camera is moved into local space. Normal cones only
+// survive rotation and uniform scaling, so they're skipped
+// if the world matrix (parents and all) does anything else:
+// stretches one axis more than another, shears a rotated
+// child of a non-uniformly scaled parent, or mirrors
+// --------------------------------------------------------
+void Entity::GetLocalCullingView(Camera* a_pCamera, Frustum& a_localFrustum, XMFLOAT3& a_localCameraPosition, bool& a_isConeCullingAllowed)
+{
+	// Runs on recording threads, so it can't be the one to rebuild the matrix
+	XMFLOAT4X4 world = m_transform.ReadWorldMatrix();
+	XMFLOAT4X4 view = a_pCamera->GetViewMatrix();
+	XMFLOAT4X4 projection = a_pCamera->GetProjectionMatrix();
+	XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+
+	XMFLOAT4X4 worldViewProjection;
+	XMStoreFloat4x4(&worldViewProjection, worldMatrix * XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+	a_localFrustum = ExtractFrustum(worldViewProjection);
+
+	XMFLOAT3 cameraPosition = a_pCamera->GetTransform()->GetPosition();
+	XMStoreFloat3(&a_localCameraPosition, XMVector3TransformCoord(XMLoadFloat3(&cameraPosition), XMMatrixInverse(nullptr, worldMatrix)));
+
+	XMFLOAT3 scale = GetWorldScale(worldMatrix);
+	float minScale = (std::min)((std::min)(scale.x, scale.y), scale.z);
+	float maxScale = (std::max)((std::max)(scale.x, scale.y), scale.z);
+	float shear = (std::max)((std::max)(
+		fabsf(XMVectorGetX(XMVector3Dot(worldMatrix.r[0], worldMatrix.r[1]))),
+		fabsf(XMVectorGetX(XMVector3Dot(worldMatrix.r[1], worldMatrix.r[2])))),
+		fabsf(XMVectorGetX(XMVector3Dot(worldMatrix.r[2], worldMatrix.r[0]))));
+	float handedness = XMVectorGetX(XMVector3Dot(XMVector3Cross(worldMatrix.r[0], worldMatrix.r[1]), worldMatrix.r[2]));
+	a_isConeCullingAllowed = !a_pCamera->GetProjectionType() && minScale > 0.0f && maxScale - minScale <= maxScale * 0.001f &&
+		shear <= maxScale * maxScale * 0.001f && handedness > 0.0f;
 }
@@ -9,6 +9,7 @@
 #include "Transform.h"
 #include "Camera.h"
 #include "Material.h"
+#include "CommandList.h"
 
 class Entity
 {
@@ -23,9 +24,16 @@ public:
 	void SetMaterial(std::shared_ptr<Material> a_pMaterial);
 	void SetMesh(std::shared_ptr<Mesh> a_pMesh);
 
-	void Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext, std::shared_ptr<Camera> a_pCamera);
+	/* Picks the coarsest level of detail whose error stays under a_maxPixelError pixels on screen */
+	int SelectLod(std::shared_ptr<Camera> a_pCamera, float a_screenHeight, float a_maxPixelError);
+
+	/* Adds the draws for the mesh at the given level of detail to a_packets under a_batch (full detail meshes can be culled meshlet by meshlet), without binding or drawing anything - only reads, so any number of threads can record at once as long as the transforms are up to date */
+	void RecordDraws(Camera* a_pCamera, int a_lod, bool a_isClusterCulled, unsigned int a_batch, std::vector<DrawPacket>& a_packets);
 
 private:
+	/* The camera's frustum and position in the mesh's local space, for culling its meshlets */
+	void GetLocalCullingView(Camera* a_pCamera, Frustum& a_localFrustum, DirectX::XMFLOAT3& a_localCameraPosition, bool& a_isConeCullingAllowed);
+
 	std::shared_ptr<Mesh> m_pMesh;
 	std::shared_ptr<Material> m_pMaterial;
 	Transform m_transform;
@@ -0,0 +1,94 @@
+#include "Frustum.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Gribb/Hartmann plane extraction. A point is inside when
+// -w <= x <= w, -w <= y <= w and 0 <= z <= w in clip space,
+// and each of those six comparisons is a plane made from
+// the matrix's columns
+// --------------------------------------------------------
+Frustum ExtractFrustum(const XMFLOAT4X4& a_matrix)
+{
+	// Transposing makes the columns easy to get at
+	XMMATRIX columns = XMMatrixTranspose(XMLoadFloat4x4(&a_matrix));
+
+	XMVECTOR planes[6] = {
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top
+		columns.r[2],									// Near
+		XMVectorSubtract(columns.r[3], columns.r[2])	// Far
+	};
+
+	Frustum frustum;
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&frustum.Planes[i], XMPlaneNormalize(planes[i]));
+
+	// Transposing four planes at a time gives their x's, y's, z's and w's
+	for (int batch = 0; batch < 2; batch++)
+	{
+		XMMATRIX transposed = XMMatrixTranspose(XMMATRIX(
+			XMLoadFloat4(&frustum.Planes[batch * 4 + 0]),
+			XMLoadFloat4(&frustum.Planes[batch * 4 + 1]),
+			XMLoadFloat4(&frustum.Planes[(batch == 0) ? 2 : 4]),
+			XMLoadFloat4(&frustum.Planes[(batch == 0) ? 3 : 4])));
+		XMStoreFloat4(&frustum.PlaneX[batch], transposed.r[0]);
+		XMStoreFloat4(&frustum.PlaneY[batch], transposed.r[1]);
+		XMStoreFloat4(&frustum.PlaneZ[batch], transposed.r[2]);
+		XMStoreFloat4(&frustum.PlaneW[batch], transposed.r[3]);
+	}
+	return frustum;
+}
+
+bool IsSphereOutsideFrustum(const Frustum& a_frustum, FXMVECTOR a_center, float a_radius)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		if (XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&a_frustum.Planes[i]), a_center)) < -a_radius)
+			return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// A box is outside a plane when even its corner furthest
+// along the plane's normal is behind it - the center's
+// distance plus the extents projected onto the normal
+// --------------------------------------------------------
+bool IsBoxOutsideFrustum(const Frustum& a_frustum, FXMVECTOR a_center, FXMVECTOR a_extents)
+{
+	XMVECTOR centerX = XMVectorSplatX(a_center);
+	XMVECTOR centerY = XMVectorSplatY(a_center);
+	XMVECTOR centerZ = XMVectorSplatZ(a_center);
+	XMVECTOR extentX = XMVectorSplatX(a_extents);
+	XMVECTOR extentY = XMVectorSplatY(a_extents);
+	XMVECTOR extentZ = XMVectorSplatZ(a_extents);
+
+	XMVECTOR isOutside = XMVectorFalseInt();
+	for (int batch = 0; batch < 2; batch++)
+	{
+		XMVECTOR planeX = XMLoadFloat4(&a_frustum.PlaneX[batch]);
+		XMVECTOR planeY = XMLoadFloat4(&a_frustum.PlaneY[batch]);
+		XMVECTOR planeZ = XMLoadFloat4(&a_frustum.PlaneZ[batch]);
+
+		XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX, XMVectorMultiplyAdd(centerY, planeY, XMVectorMultiplyAdd(centerZ, planeZ, XMLoadFloat4(&a_frustum.PlaneW[batch]))));
+		XMVECTOR reach = XMVectorMultiplyAdd(extentX, XMVectorAbs(planeX), XMVectorMultiplyAdd(extentY, XMVectorAbs(planeY), XMVectorMultiply(extentZ, XMVectorAbs(planeZ))));
+		isOutside = XMVectorOrInt(isOutside, XMVectorLess(XMVectorAdd(distance, reach), XMVectorZero()));
+	}
+	return XMVector4NotEqualInt(isOutside, XMVectorFalseInt());
+}
+
+// --------------------------------------------------------
+// Arvo's method: the new center is just the transformed
+// center, and each new half-size is the old ones weighted
+// by the absolute values of the matrix
+// --------------------------------------------------------
+void TransformBox(FXMMATRIX a_matrix, FXMVECTOR a_center, FXMVECTOR a_extents, XMVECTOR& a_outCenter, XMVECTOR& a_outExtents)
+{
+	a_outCenter = XMVector3Transform(a_center, a_matrix);
+	a_outExtents = XMVectorMultiplyAdd(XMVectorSplatX(a_extents), XMVectorAbs(a_matrix.r[0]),
+		XMVectorMultiplyAdd(XMVectorSplatY(a_extents), XMVectorAbs(a_matrix.r[1]),
+		XMVectorMultiply(XMVectorSplatZ(a_extents), XMVectorAbs(a_matrix.r[2]))));
+}
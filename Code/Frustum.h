@@ -0,0 +1,40 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The six planes bounding what a camera can see, each
+// stored as (normal, distance) with the normal unit length
+// and pointing inwards
+//
+// Whatever space the matrix the planes came from maps out
+// of is the space the planes are in - a view-projection
+// gives world space planes, a world-view-projection gives
+// planes in that object's local space
+//
+// The planes are also kept transposed, four planes to a
+// vector (the last two slots repeat the near plane), so
+// box tests can check four planes per instruction
+// --------------------------------------------------------
+struct Frustum
+{
+	DirectX::XMFLOAT4 Planes[6];
+	DirectX::XMFLOAT4 PlaneX[2];
+	DirectX::XMFLOAT4 PlaneY[2];
+	DirectX::XMFLOAT4 PlaneZ[2];
+	DirectX::XMFLOAT4 PlaneW[2];
+};
+
+// Pulls the planes out of a (row vector) matrix that maps into D3D clip space
+Frustum ExtractFrustum(const DirectX::XMFLOAT4X4& a_matrix);
+
+// Returns true if the sphere is entirely outside at least one of the planes
+bool IsSphereOutsideFrustum(const Frustum& a_frustum, DirectX::FXMVECTOR a_center, float a_radius);
+
+// Returns true if the box (given as a center and half-size on each axis) is
+// entirely outside at least one of the planes
+bool IsBoxOutsideFrustum(const Frustum& a_frustum, DirectX::FXMVECTOR a_center, DirectX::FXMVECTOR a_extents);
+
+// Transforms a box by an affine (row vector) matrix, giving the axis-aligned box
+// that contains the result
+void TransformBox(DirectX::FXMMATRIX a_matrix, DirectX::FXMVECTOR a_center, DirectX::FXMVECTOR a_extents, DirectX::XMVECTOR& a_outCenter, DirectX::XMVECTOR& a_outExtents);
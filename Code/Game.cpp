@@ -2,14 +2,19 @@
 #include "Vertex.h"
 #include "Input.h"
 #include "Helpers.h"
+#include "JobSystem.h"
+#include "Frustum.h"
+#include "TransformPool.h"
+#include "TextureLoader.h"
+#include "VertexInputLayout.h"
 
 #include "ImGui/imgui.h"
 #include "ImGui/imgui_impl_dx11.h"
 #include "ImGui/imgui_impl_win32.h"
-#include "WICTextureLoader.h"
 
 #include "string"
 #include "cmath"
+#include "algorithm"
 
 // Needed for a helper function to load pre-compiled shader files
 #pragma comment(lib, "d3dcompiler.lib")
@@ -18,6 +23,11 @@
 // For the DirectX Math library
 using namespace DirectX;
 
+// Each job records at least this many batches. Meshlet culling
+// makes a batch worth a job even in small numbers, so the scene's
+// couple dozen batches are still spread across the workers
+const size_t c_minBatchesPerJob = 8;
+
 // --------------------------------------------------------
 // Constructor
 //
@@ -59,10 +69,22 @@ Game::~Game()
 	// Call Release() on any Direct3D objects made within this class
 	// - Note: this is unnecessary for D3D objects stored in ComPtrs
 
+	// The compact and instanced vertex shaders are shared statics,
+	// so they'd otherwise outlive the device
+	Material::SetCompactVertexShader(VertexFormat::Compact16, nullptr);
+	Material::SetCompactVertexShader(VertexFormat::Compact8, nullptr);
+	Material::SetInstancedVertexShader(nullptr);
+
+	// Shaders would otherwise keep binding through a deleted cache
+	ISimpleShader::BindingCache = nullptr;
+
 	// ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
 	ImGui::DestroyContext();
+
+	// Delete job system singleton, which joins its worker threads
+	delete& JobSystem::GetInstance();
 }
 
 // --------------------------------------------------------
@@ -77,10 +99,16 @@ void Game::Init()
 	ImGui_ImplDX11_Init(device.Get(), context.Get());
 	ImGui::StyleColorsDark();
 
+	// Spin up the worker threads before anything tries to use them
+	JobSystem::GetInstance().Initialize();
+
+	// Every shader binds through this from the first frame on
+	m_pStateTarget = std::make_unique<D3D11StateTarget>(context);
+	m_pStateCache = std::make_unique<StateCache>(m_pStateTarget.get());
+
 	// Helper methods for loading and creating stuff
 	LoadShaders();
-	LoadTextures();
-	LoadMeshes();
+	LoadAssets();
 	CreateEntities();
 	CreateLights();
 
@@ -114,6 +142,17 @@ void Game::Init()
 	m_stopEntityMovement = false;
 
 	m_gamma = 2.2f;
+	m_lodPixelError = 1.0f;
+	m_isClusterCullingEnabled = true;
+	m_isInstancingEnabled = true;
+	m_isStateCacheEnabled = true;
+	m_instanceBufferCapacity = 0;
+	m_drawCallCount = 0;
+	m_constantBufferBytes = 0;
+	m_constantBufferUploads = 0;
+	m_constantBufferUploadsSkipped = 0;
+	m_bindCallsMade = 0;
+	m_bindCallsSaved = 0;
 }
 
 // --------------------------------------------------------
@@ -134,10 +173,25 @@ void Game::LoadShaders()
 	m_pSkyPS = std::make_shared<SimplePixelShader>(device, context, FixPath(L"SkyPS.cso").c_str());
 	m_pPBRShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"PBRPixelShader.cso").c_str());
 	m_pTexturePixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"TexturePixelShader.cso").c_str());
+
+	// The compact vertex formats share one shader, but each packs its data
+	// differently, so each gets its own input layout (and SimpleVertexShader)
+	std::wstring compactVSPath = FixPath(L"CompactVertexShader.cso");
+	std::vector<unsigned char> compactVSByteCode;
+	ReadBinaryFile(compactVSPath, compactVSByteCode);
+	for (VertexFormat format : { VertexFormat::Compact16, VertexFormat::Compact8 })
+	{
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout = CreateVertexInputLayout(format, compactVSByteCode.data(), compactVSByteCode.size(), device);
+		Material::SetCompactVertexShader(format, std::make_shared<SimpleVertexShader>(device, context, compactVSPath.c_str(), inputLayout, false));
+	}
+
+	// Batches of the same mesh and material draw through this one, which
+	// reads the world matrices per instance instead of from a constant buffer
+	Material::SetInstancedVertexShader(std::make_shared<SimpleVertexShader>(device, context, FixPath(L"InstancedVertexShader.cso").c_str()));
 	//m_pStaticEffectPixelShader = std::make_shared<SimplePixelShader>(device, context, FixPath(L"StaticPS.cso").c_str());
 }
 
-void Game::LoadTextures()
+void Game::LoadAssets()
 {
 	// Create a sampler state
 	D3D11_SAMPLER_DESC samplerStateDescription = {};
@@ -149,103 +203,173 @@ void Game::LoadTextures()
 	samplerStateDescription.MaxLOD = D3D11_FLOAT32_MAX; // enable mipmapping at any range
 	device->CreateSamplerState(&samplerStateDescription, m_pTextureSampler.GetAddressOf());
 
-	//CreateWICTextureFromFile(
-	//  device.Get(),
-	//	context.Get(),
-	//	FixPath(L"../../Assets/Textures/filename.png").c_str(),
-	//	0,
-	//	m_pSRV.GetAddressOf());
-
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/UV.png").c_str(), 0, m_uvTexture.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/flat_normals.png").c_str(), 0, m_flatNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/normalTestN.png").c_str(), 0, m_normalTestSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/model_textures/T_HylianShield_BC.png").c_str(), 0, m_shieldDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/model_textures/T_HylianShield_Specular.png").c_str(), 0, m_shieldSpec.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/model_textures/T_HylianShield_N.png").c_str(), 0, m_shieldNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/model_textures/T_HylianShield_Metal.png").c_str(), 0, m_shieldMetal.GetAddressOf());
-CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/model_textures/T_HylianShield_Roughness.png").c_str(), 0, m_shieldRough.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/minecraft/T_Player.png").c_str(), 0, m_minecraftSkinSRV.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/rustymetal.png").c_str(), 0, m_rustyMetalDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/rustymetal_specular.png").c_str(), 0, m_rustyMetalSpec.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/brokentiles.png").c_str(), 0, m_brokenTilesDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/brokentiles_specular.png").c_str(), 0, m_brokenTilesSpec.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/tiles.png").c_str(), 0, m_tilesDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/tiles_specular.png").c_str(), 0, m_tilesSpec.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/blue_painted_planks_diff.png").c_str(), 0, m_bluePlanksDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/blue_painted_planks_spec.png").c_str(), 0, m_bluePlanksSpec.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/blue_painted_planks_n.png").c_str(), 0, m_bluePlanksNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/metal_plate_diff.png").c_str(), 0, m_metalPlateDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/metal_plate_specular.png").c_str(), 0, m_metalPlateSpec.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/metal_plate_n.png").c_str(), 0, m_metalPlateNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/stone_tiles_diff.png").c_str(), 0, m_stoneTilesDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/stone_tiles_n.png").c_str(), 0, m_stoneTilesNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/cobblestone.png").c_str(), 0, m_cobblestoneDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/cobblestone_normals.png").c_str(), 0, m_cobblestoneNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/cobblestone_metal.png").c_str(), 0, m_cobblestoneMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/cobblestone_roughness.png").c_str(), 0, m_cobblestoneRough.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/cushion.png").c_str(), 0, m_cushionDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/cushion_normals.png").c_str(), 0, m_cushionNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/rock.png").c_str(), 0, m_rockDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/rock_normals.png").c_str(), 0, m_rockNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/forest_ground_diff.png").c_str(), 0, m_forestGroundDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/forest_ground_n.png").c_str(), 0, m_forestGroundNormal.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/bronze_albedo.png").c_str(), 0, m_bronzeDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/bronze_normals.png").c_str(), 0, m_bronzeNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/bronze_metal.png").c_str(), 0, m_bronzeMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/bronze_roughness.png").c_str(), 0, m_bronzeRough.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/floor_albedo.png").c_str(), 0, m_floorDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/floor_normals.png").c_str(), 0, m_floorNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/floor_metal.png").c_str(), 0, m_floorMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/floor_roughness.png").c_str(), 0, m_floorRough.GetAddressOf());
-
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/scratched_albedo.png").c_str(), 0, m_scratchedDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/scratched_normals.png").c_str(), 0, m_scratchedNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/scratched_metal.png").c_str(), 0, m_bronzeMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/scratched_roughness.png").c_str(), 0, m_scratchedRough.GetAddressOf());
+	// Every texture file and which SRV it ends up in
+	// - Textures/ is prepended to each path
+	struct TextureLoad
+	{
+		const wchar_t* Path;
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>* SRV;
+	};
+	const TextureLoad textureLoads[] =
+	{
+		{ L"UV.png", &m_uvTexture },
+		{ L"flat_normals.png", &m_flatNormal },
+		{ L"normalTestN.png", &m_normalTestSRV },
+
+		{ L"model_textures/T_HylianShield_BC.png", &m_shieldDiff },
+		{ L"model_textures/T_HylianShield_Specular.png", &m_shieldSpec },
+		{ L"model_textures/T_HylianShield_N.png", &m_shieldNormal },
+		{ L"model_textures/T_HylianShield_Metal.png", &m_shieldMetal },
+		{ L"model_textures/T_HylianShield_Roughness.png", &m_shieldRough },
+
+		{ L"minecraft/T_Player.png", &m_minecraftSkinSRV },
+
+		{ L"rustymetal.png", &m_rustyMetalDiff },
+		{ L"rustymetal_specular.png", &m_rustyMetalSpec },
+
+		{ L"brokentiles.png", &m_brokenTilesDiff },
+		{ L"brokentiles_specular.png", &m_brokenTilesSpec },
+
+		{ L"tiles.png", &m_tilesDiff },
+		{ L"tiles_specular.png", &m_tilesSpec },
+
+		{ L"blue_painted_planks_diff.png", &m_bluePlanksDiff },
+		{ L"blue_painted_planks_spec.png", &m_bluePlanksSpec },
+		{ L"blue_painted_planks_n.png", &m_bluePlanksNormal },
+
+		{ L"metal_plate_diff.png", &m_metalPlateDiff },
+		{ L"metal_plate_specular.png", &m_metalPlateSpec },
+		{ L"metal_plate_n.png", &m_metalPlateNormal },
+
+		{ L"stone_tiles_diff.png", &m_stoneTilesDiff },
+		{ L"stone_tiles_n.png", &m_stoneTilesNormal },
+
+		{ L"cobblestone.png", &m_cobblestoneDiff },
+		{ L"cobblestone_normals.png", &m_cobblestoneNormal },
+		{ L"PBR/cobblestone_metal.png", &m_cobblestoneMetal },
+		{ L"PBR/cobblestone_roughness.png", &m_cobblestoneRough },
+
+		{ L"cushion.png", &m_cushionDiff },
+		{ L"cushion_normals.png", &m_cushionNormal },
+
+		{ L"rock.png", &m_rockDiff },
+		{ L"rock_normals.png", &m_rockNormal },
+
+		{ L"forest_ground_diff.png", &m_forestGroundDiff },
+		{ L"forest_ground_n.png", &m_forestGroundNormal },
+
+		{ L"PBR/bronze_albedo.png", &m_bronzeDiff },
+		{ L"PBR/bronze_normals.png", &m_bronzeNormal },
+		{ L"PBR/bronze_metal.png", &m_bronzeMetal },
+		{ L"PBR/bronze_roughness.png", &m_bronzeRough },
+
+		{ L"PBR/floor_albedo.png", &m_floorDiff },
+		{ L"PBR/floor_normals.png", &m_floorNormal },
+		{ L"PBR/floor_metal.png", &m_floorMetal },
+		{ L"PBR/floor_roughness.png", &m_floorRough },
+
+		{ L"PBR/scratched_albedo.png", &m_scratchedDiff },
+		{ L"PBR/scratched_normals.png", &m_scratchedNormal },
+		{ L"PBR/scratched_metal.png", &m_bronzeMetal },
+		{ L"PBR/scratched_roughness.png", &m_scratchedRough },
+
+		{ L"PBR/paint_albedo.png", &m_paintDiff },
+		{ L"PBR/paint_normals.png", &m_paintNormal },
+		{ L"PBR/bronze_metal.png", &m_paintMetal },
+		{ L"PBR/paint_roughness.png", &m_paintRough },
+
+		{ L"PBR/rough_albedo.png", &m_roughDiff },
+		{ L"PBR/rough_normals.png", &m_roughNormal },
+		{ L"PBR/rough_metal.png", &m_roughMetal },
+		{ L"PBR/rough_roughness.png", &m_roughRough },
+
+		{ L"PBR/wood_albedo.png", &m_woodDiff },
+		{ L"PBR/wood_normals.png", &m_woodNormal },
+		{ L"PBR/wood_metal.png", &m_bronzeMetal },
+		{ L"PBR/wood_roughness.png", &m_woodRough },
+	};
+	const size_t textureCount = sizeof(textureLoads) / sizeof(textureLoads[0]);
+
+	// Every model file, the name it's stored under and the vertex format it's uploaded in
+	// - Models/ is prepended to each path
+	// - The tiny primitives aren't worth packing, and the blocky player's
+	//    axis aligned normals survive 8-bit octahedral encoding exactly
+	struct MeshLoad
+	{
+		const char* Name;
+		const wchar_t* Path;
+		VertexFormat Format;
+	};
+	const MeshLoad meshLoads[] =
+	{
+		{ "cube", L"cube.obj", VertexFormat::Full },
+		{ "cylinder", L"cylinder.obj", VertexFormat::Compact16 },
+		{ "helix", L"helix.obj", VertexFormat::Compact16 },
+		{ "sphere", L"sphere.obj", VertexFormat::Compact16 },
+		{ "torus", L"torus.obj", VertexFormat::Compact16 },
+		{ "quad", L"quad_double_sided.obj", VertexFormat::Full },
+		{ "hylian shield", L"hylian_shield.obj", VertexFormat::Compact16 },
+		{ "minecraft player", L"Steve.obj", VertexFormat::Compact8 },
+	};
+	const size_t meshCount = sizeof(meshLoads) / sizeof(meshLoads[0]);
+
+	// Everything that doesn't need Direct3D - reading and decoding textures
+	// and parsing/processing models - goes out to the job system up front
+	// - Each asset gets its own counter so it can be picked up as soon as it's done
+	JobSystem& jobs = JobSystem::GetInstance();
+
+	std::vector<MeshLoadData> meshData(meshCount);
+	std::vector<char> meshLoaded(meshCount, false);
+	std::vector<JobCounter> meshCounters(meshCount);
+	for (size_t i = 0; i < meshCount; i++)
+	{
+		std::wstring path = FixPath(std::wstring(L"../../Assets/Models/") + meshLoads[i].Path);
+		VertexFormat format = meshLoads[i].Format;
+		jobs.Submit([path, i, format, &meshData, &meshLoaded]() {
+			meshLoaded[i] = Mesh::LoadFile(path, meshData[i], format);
+		}, &meshCounters[i]);
+	}
 
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/paint_albedo.png").c_str(), 0, m_paintDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/paint_normals.png").c_str(), 0, m_paintNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/bronze_metal.png").c_str(), 0, m_paintMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/paint_roughness.png").c_str(), 0, m_paintRough.GetAddressOf());
+	std::vector<DecodedTexture> textures(textureCount);
+	std::vector<JobCounter> textureCounters(textureCount);
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		std::wstring path = FixPath(std::wstring(L"../../Assets/Textures/") + textureLoads[i].Path);
+		jobs.Submit([path, i, &textures]() {
+			std::vector<unsigned char> file;
+			if (ReadBinaryFile(path, file))
+				DecodeTexture(file.data(), file.size(), textures[i]);
+		}, &textureCounters[i]);
+	}
 
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/rough_albedo.png").c_str(), 0, m_roughDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/rough_normals.png").c_str(), 0, m_roughNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/rough_metal.png").c_str(), 0, m_roughMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/rough_roughness.png").c_str(), 0, m_roughRough.GetAddressOf());
+	// Only this thread owns the context, so it creates the actual resources
+	// - All that's left for textures is the upload and generating their mips
+	// - Textures go in table order, so later entries that reuse an SRV still win
+	for (size_t i = 0; i < textureCount; i++)
+	{
+		jobs.Wait(textureCounters[i]);
+		if (!CreateTexture(device.Get(), context.Get(), textures[i], textureLoads[i].SRV->ReleaseAndGetAddressOf()))
+		{
+			printf("Error in loading texture file\n");
+			continue;
+		}
 
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/wood_albedo.png").c_str(), 0, m_woodDiff.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/wood_normals.png").c_str(), 0, m_woodNormal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/wood_metal.png").c_str(), 0, m_bronzeMetal.GetAddressOf());
-	CreateWICTextureFromFile(device.Get(), context.Get(), FixPath(L"../../Assets/Textures/PBR/wood_roughness.png").c_str(), 0, m_woodRough.GetAddressOf());
-}
+		std::vector<unsigned char>().swap(textures[i].Pixels);
+	}
 
-void Game::LoadMeshes()
-{
 	// https://www.geeksforgeeks.org/unordered_map-in-cpp-stl/
 	// https://en.cppreference.com/w/cpp/container/unordered_map
-	m_pMeshes["cube"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cube.obj").c_str(), device);
-	m_pMeshes["cylinder"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/cylinder.obj").c_str(), device);
-	m_pMeshes["helix"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/helix.obj").c_str(), device);
-	m_pMeshes["sphere"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/sphere.obj").c_str(), device);
-	m_pMeshes["torus"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/torus.obj").c_str(), device);
-	m_pMeshes["quad"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/quad_double_sided.obj").c_str(), device);
-	m_pMeshes["hylian shield"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/hylian_shield.obj").c_str(), device);
-	m_pMeshes["minecraft player"] = std::make_shared<Mesh>(FixPath(L"../../Assets/Models/Steve.obj").c_str(), device);
+	for (size_t i = 0; i < meshCount; i++)
+	{
+		jobs.Wait(meshCounters[i]);
+		if (!meshLoaded[i])
+		{
+			printf("Error in opening file");
+			continue;
+		}
+
+		m_pMeshes[meshLoads[i].Name] = std::make_shared<Mesh>(meshData[i], device);
+	}
 
 	m_pMeshes["test mesh"] = m_pMeshes["sphere"];
 	m_pMeshes["uv mesh"] = m_pMeshes["sphere"];
@@ -461,6 +585,31 @@ void Game::CreateEntities()
 		XMFLOAT3(0.0f, -3.0f, -5.0f), meshSpacing);
 	previousSize = (int)m_pEntities.size();
 
+	// The shield hangs off the Minecraft player so it follows the player
+	// around. Its position becomes an offset from the player's, which
+	// keeps it right where the rows put it
+	std::shared_ptr<Entity> shield, player;
+	for (const std::shared_ptr<Entity>& entity : m_pEntities) {
+		if (entity->GetEntityName() == "Hylian Shield") shield = entity;
+		if (entity->GetEntityName() == "Minecraft Player") player = entity;
+	}
+	XMFLOAT3 shieldPos = shield->GetTransform()->GetPosition();
+	XMFLOAT3 playerPos = player->GetTransform()->GetPosition();
+	shield->GetTransform()->SetParent(player->GetTransform());
+	shield->GetTransform()->SetPosition(shieldPos.x - playerPos.x, shieldPos.y - playerPos.y, shieldPos.z - playerPos.z);
+
+	// Hook up the animations once, by name, so nothing needs
+	// to look entities up again while the game is running
+	for (const std::shared_ptr<Entity>& entity : m_pEntities) {
+		std::string entityName = entity->GetEntityName();
+		Transform* entityTransform = entity->GetTransform();
+		if (entityName == "Helix") m_behaviors.AddRotator(entityTransform, XMFLOAT3(0, 1, 0));
+		if (entityName == "Cube") m_behaviors.AddRotator(entityTransform, XMFLOAT3(0, 1, 1));
+		if (entityName == "Torus") m_behaviors.AddRotator(entityTransform, XMFLOAT3(1, 0, 0));
+		if (entityName == "Quad") m_behaviors.AddRotator(entityTransform, XMFLOAT3(0, 0, 1));
+		if (entityName == "Cylinder" || entityName == "Sphere") m_behaviors.AddOscillator(entityTransform, XMFLOAT3(0, 1, 0));
+	}
+
 	CreateSky();
 }
 
@@ -582,51 +731,8 @@ void Game::Update(float deltaTime, float totalTime)
 	if (Input::GetInstance().KeyDown(VK_ESCAPE))
 		Quit();
 
-	if (m_stopEntityMovement == false) {
-		for (int i = 0; i < m_pEntities.size(); i++)
-		{
-			std::string entityName = m_pEntities[i]->GetEntityName();
-			Transform* entityTransform = m_pEntities[i]->GetTransform();
-			XMFLOAT3 entityRot = entityTransform->GetRotation();
-			XMFLOAT3 entityPos = entityTransform->GetPosition();
-			XMFLOAT3 entityScale = entityTransform->GetScale();
-
-			if (entityName == "Helix") {
-				entityTransform->SetRotation(0, entityRot.y + deltaTime, 0);
-				if (entityRot.y + deltaTime >= DirectX::XMConvertToRadians(360))
-					entityTransform->SetRotation(entityRot.x, 0, entityRot.z);
-			}
-			if (entityName == "Cylinder") {
-				entityTransform->SetPosition(entityPos.x, sin(totalTime), entityPos.z);
-			}
-			if (entityName == "Cube") {
-				entityTransform->SetRotation(0, entityRot.y + deltaTime, entityRot.z + deltaTime);
-				if (entityRot.y + deltaTime >= DirectX::XMConvertToRadians(360))
-					entityTransform->SetRotation(entityRot.x, 0, entityRot.z);
-				if (entityRot.z + deltaTime >= DirectX::XMConvertToRadians(360))
-					entityTransform->SetRotation(entityRot.x, entityRot.y, 0);
-			}
-			if (entityName == "Sphere") {
-				entityTransform->SetPosition(entityPos.x, sin(totalTime), entityPos.z);
-			}
-			if (entityName == "Torus") {
-				entityTransform->SetRotation(entityRot.x + deltaTime, 0, 0);
-				if (entityRot.x + deltaTime >= DirectX::XMConvertToRadians(360))
-					entityTransform->SetRotation(0, entityRot.y, entityRot.z);
-			}
-			if (entityName == "Quad") {
-				entityTransform->SetRotation(0, 0, entityRot.z + deltaTime);
-				if (entityRot.z + deltaTime >= DirectX::XMConvertToRadians(360))
-					entityTransform->SetRotation(entityRot.x, entityRot.y, 0);
-			}
-
-			//if (entityName.find("Test") != -1) {
-			//	entityTransform->SetRotation(0, entityRot.y - (deltaTime / 8), 0);
-			//	if (abs(entityRot.y - deltaTime) >= DirectX::XMConvertToRadians(360))
-			//		entityTransform->SetRotation(entityRot.x, 0, entityRot.z);
-			//}
-		}
-	}
+	if (m_stopEntityMovement == false)
+		m_behaviors.Update(deltaTime, totalTime);
 
 	m_pCameras[m_currentCamIndex]->Update(deltaTime);
 }
@@ -652,6 +758,10 @@ void Game::UpdateGUI(float deltaTime, float totalTime)
 
 	ImGui::Checkbox("Stop Entity Movement", &m_stopEntityMovement);
 	/*ImGui::SliderFloat("Gamma", &m_gamma, 0.1f, 10.0f);*/
+	ImGui::SliderFloat("LOD Pixel Error", &m_lodPixelError, 0.0f, 8.0f);
+	ImGui::Checkbox("Meshlet Culling", &m_isClusterCullingEnabled);
+	ImGui::Checkbox("Instancing", &m_isInstancingEnabled);
+	ImGui::Checkbox("State Cache", &m_isStateCacheEnabled);
 
 	// Test and UV Mesh Shape Changer
 	const char* shapes[] = { "sphere", "cylinder", "cube", "helix", "torus", "quad" };
@@ -680,6 +790,12 @@ void Game::UpdateGUI(float deltaTime, float totalTime)
 	{
 		ImGui::Text("Framerate: %f", ImGui::GetIO().Framerate);
 		ImGui::Text("Window Dimensions: %i x %i", this->windowWidth, this->windowHeight);
+		ImGui::Text("Visible Entities: %d / %d", (int)m_visibleEntities.size(), (int)m_pEntities.size());
+		ImGui::Text("State Binds: %u shaders, %u materials, %u meshes (%u avoided)", m_renderStats.ShaderBinds, m_renderStats.MaterialBinds, m_renderStats.MeshBinds, m_renderStats.BindsAvoided);
+		ImGui::Text("Draw Calls: %u (%d instances, recorded on %u threads)", m_drawCallCount, (int)m_instanceData.size(), m_commandList.GetBucketCount());
+		ImGui::Text("Constant Buffers: %u bytes (%u per draw)", (unsigned int)m_constantBufferBytes, m_drawCallCount > 0 ? (unsigned int)(m_constantBufferBytes / m_drawCallCount) : 0);
+		ImGui::Text("Constant Buffer Uploads: %u (%u unchanged, skipped)", (unsigned int)m_constantBufferUploads, (unsigned int)m_constantBufferUploadsSkipped);
+		ImGui::Text("Binding Calls: %u (%u saved by the state cache)", m_bindCallsMade, m_bindCallsSaved);
 		ImGui::Text("Cursor Position: %f, %f", ImGui::GetIO().MousePos.x, ImGui::GetIO().MousePos.y);
 	}
 
@@ -847,6 +963,240 @@ void Game::EntityGUI(std::shared_ptr<Entity> a_pEntity)
 	}
 
 	ImGui::Text("Mesh Index Count: %d", a_pEntity->GetMesh()->GetIndexCount());
+	int lod = a_pEntity->SelectLod(m_pCameras[m_currentCamIndex], (float)this->windowHeight, m_lodPixelError);
+	ImGui::Text("Level of Detail: %d of %d (%u indices)", lod, a_pEntity->GetMesh()->GetLodCount(), a_pEntity->GetMesh()->GetLod(lod).IndexCount);
+	ImGui::Text("Meshlets: %d", a_pEntity->GetMesh()->GetMeshletCount());
+	ImGui::Text("Vertex Format: %s (%u bytes)", GetVertexFormatName(a_pEntity->GetMesh()->GetVertexFormat()), GetVertexStride(a_pEntity->GetMesh()->GetVertexFormat()));
+
+	MeshOptimizationStats cacheStats = a_pEntity->GetMesh()->GetOptimizationStats();
+	ImGui::Text("Vertex Cache ACMR: %.3f -> %.3f", cacheStats.Before.ACMR, cacheStats.After.ACMR);
+	ImGui::Text("Vertex Cache ATVR: %.3f -> %.3f", cacheStats.Before.ATVR, cacheStats.After.ATVR);
+}
+
+// --------------------------------------------------------
+// Tests each entity's mesh bounds, moved into world space,
+// against the camera's frustum. Only the entities that
+// survive go on to have their materials and shaders set
+// --------------------------------------------------------
+void Game::CullEntities(std::shared_ptr<Camera> a_pCamera)
+{
+	XMFLOAT4X4 view = a_pCamera->GetViewMatrix();
+	XMFLOAT4X4 projection = a_pCamera->GetProjectionMatrix();
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+	Frustum frustum = ExtractFrustum(viewProjection);
+
+	m_visibleEntities.clear();
+	for (const std::shared_ptr<Entity>& entity : m_pEntities) {
+		Mesh* mesh = entity->GetMesh().get();
+		XMFLOAT3 boundsMin = mesh->GetBoundsMin();
+		XMFLOAT3 boundsMax = mesh->GetBoundsMax();
+		XMVECTOR localMin = XMLoadFloat3(&boundsMin);
+		XMVECTOR localMax = XMLoadFloat3(&boundsMax);
+
+		XMFLOAT4X4 world = entity->GetTransform()->GetWorldMatrix();
+		XMVECTOR center, extents;
+		TransformBox(XMLoadFloat4x4(&world), XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f), XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f), center, extents);
+
+		if (!IsBoxOutsideFrustum(frustum, center, extents))
+			m_visibleEntities.push_back(entity.get());
+	}
+}
+
+// --------------------------------------------------------
+// Queues every visible entity with a key built from its
+// shaders, material, mesh and distance, then walks the
+// sorted queue binding only what differs from the draw
+// before. Each shader's PerFrame buffer is sent the first
+// time it's bound in a frame, materials send theirs when
+// they change, and only the world matrices go up per draw
+//
+// Neighbors in the sorted queue that share a full format
+// mesh, level of detail and material are drawn as one
+// instanced batch. Every batch's world matrices go into a
+// single instance buffer, uploaded once per frame
+//
+// Each batch's draws (after meshlet culling) are recorded
+// into a command list on the job system, then replayed on
+// this thread, which is the only one that owns the context
+// --------------------------------------------------------
+void Game::DrawEntities(std::shared_ptr<Camera> a_pCamera, float a_totalTime)
+{
+	XMFLOAT3 cameraPosition = a_pCamera->GetTransform()->GetPosition();
+	XMVECTOR cameraPositionVector = XMLoadFloat3(&cameraPosition);
+	float farClipDistance = a_pCamera->GetFarClipDistance();
+
+	m_renderQueue.Clear();
+	m_visibleLods.resize(m_visibleEntities.size());
+	for (unsigned int i = 0; i < m_visibleEntities.size(); i++) {
+		Entity* entity = m_visibleEntities[i];
+		Material* material = entity->GetMaterial().get();
+		Mesh* mesh = entity->GetMesh().get();
+
+		XMFLOAT3 sphereCenter = mesh->GetSphereCenter();
+		XMFLOAT4X4 world = entity->GetTransform()->GetWorldMatrix();
+		XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&sphereCenter), XMLoadFloat4x4(&world));
+		float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(center, cameraPositionVector)));
+
+		uint64_t key = RenderQueue::MakeKey(
+			m_renderQueue.GetShaderId(material->GetVertexShader(mesh->GetVertexFormat()).get(), material->GetPixelShader().get()),
+			m_renderQueue.GetMaterialId(material),
+			m_renderQueue.GetMeshId(mesh),
+			distance / farClipDistance);
+		m_renderQueue.Add(key, i);
+		m_visibleLods[i] = entity->SelectLod(a_pCamera, (float)this->windowHeight, m_lodPixelError);
+	}
+	m_renderQueue.Sort();
+	m_renderStats = m_renderQueue.CountStateChanges();
+
+	// Batch keys are the sort keys without the depth, plus the level of detail
+	const std::vector<RenderQueueItem>& items = m_renderQueue.GetItems();
+	m_batchKeys.resize(items.size());
+	for (size_t i = 0; i < items.size(); i++) {
+		Entity* entity = m_visibleEntities[items[i].Index];
+		bool isInstanceable = m_isInstancingEnabled && Material::GetInstancedVertexShader() && entity->GetMesh()->GetVertexFormat() == VertexFormat::Full;
+		m_batchKeys[i] = isInstanceable ? (items[i].Key & ~RenderQueue::c_depthMask) | (uint64_t)m_visibleLods[items[i].Index] : c_notInstanced;
+	}
+	BuildInstanceBatches(m_batchKeys.data(), m_batchKeys.size(), 2, m_instanceBatches);
+
+	GatherInstanceData(m_instanceBatches, [this, &items](unsigned int a_draw) {
+		Transform* transform = m_visibleEntities[items[a_draw].Index]->GetTransform();
+		return MakeInstanceData(transform->GetWorldMatrix(), transform->GetWorldInverseTransposeMatrix());
+	}, m_instanceData);
+	UploadInstanceData();
+
+	// RECORD every batch's draws across the job system - only
+	// reads happen here, and the context isn't touched
+	Camera* camera = a_pCamera.get();
+	m_commandList.Record(m_instanceBatches.size(), c_minBatchesPerJob, [this, camera, &items](std::vector<DrawPacket>& a_packets, size_t a_begin, size_t a_end) {
+		for (size_t b = a_begin; b < a_end; b++) {
+			const InstanceBatch& batch = m_instanceBatches[b];
+			unsigned int index = items[batch.Start].Index;
+			Entity* entity = m_visibleEntities[index];
+			if (batch.IsInstanced) {
+				MeshLod lod = entity->GetMesh()->GetLod(m_visibleLods[index]);
+				a_packets.push_back({ (uint32_t)b, lod.IndexStart, lod.IndexCount, batch.Count, batch.FirstInstance });
+			}
+			else {
+				entity->RecordDraws(camera, m_visibleLods[index], m_isClusterCullingEnabled, (unsigned int)b, a_packets);
+			}
+		}
+	});
+
+	// REPLAY them in order on this thread, binding only what
+	// differs from the batch before
+	SimpleVertexShader* boundVertexShader = nullptr;
+	SimplePixelShader* boundPixelShader = nullptr;
+	Material* boundMaterial = nullptr;
+	Mesh* boundMesh = nullptr;
+	m_drawCallCount = 0;
+	m_frameDataShaders.clear();
+	ISimpleShader::UploadStats = ConstantBufferStats();
+	m_commandList.Replay(
+		[&](unsigned int a_batch) {
+			const InstanceBatch& batch = m_instanceBatches[a_batch];
+			Entity* entity = m_visibleEntities[items[batch.Start].Index];
+			std::shared_ptr<Material> material = entity->GetMaterial();
+			std::shared_ptr<Mesh> mesh = entity->GetMesh();
+
+			std::shared_ptr<SimpleVertexShader> vertexShader = batch.IsInstanced ? Material::GetInstancedVertexShader() : material->GetVertexShader(mesh->GetVertexFormat());
+			if (vertexShader.get() != boundVertexShader) {
+				vertexShader->SetShader();
+				if (IsFirstBindThisFrame(vertexShader.get())) {
+					vertexShader->SetMatrix4x4("viewMatrix", a_pCamera->GetViewMatrix());
+					vertexShader->SetMatrix4x4("projectionMatrix", a_pCamera->GetProjectionMatrix());
+					vertexShader->CopyBufferData("PerFrame");
+				}
+				boundVertexShader = vertexShader.get();
+			}
+
+			std::shared_ptr<SimplePixelShader> pixelShader = material->GetPixelShader();
+			if (pixelShader.get() != boundPixelShader) {
+				pixelShader->SetShader();
+				if (IsFirstBindThisFrame(pixelShader.get())) {
+					pixelShader->SetFloat("time", a_totalTime);
+					pixelShader->SetFloat("gamma", m_gamma);
+					pixelShader->SetFloat3("ambientColor", m_ambientLightColor);
+					pixelShader->SetFloat3("cameraPosition", cameraPosition);
+					pixelShader->SetData("lights", &m_lights[0], sizeof(Light) * (int)m_lights.size());
+					pixelShader->CopyBufferData("PerFrame");
+				}
+				boundPixelShader = pixelShader.get();
+				boundMaterial = nullptr;
+			}
+			if (material.get() != boundMaterial) {
+				material->BindResources();
+				boundMaterial = material.get();
+			}
+			material->SendMaterialDataToShader();
+			if (mesh.get() != boundMesh) {
+				mesh->SetBuffers(context);
+				boundMesh = mesh.get();
+			}
+			if (!batch.IsInstanced)
+				material->SendObjectDataToShader(entity->GetTransform(), mesh);
+
+			// Everything bound above has to reach the context first
+			if (ISimpleShader::BindingCache)
+				ISimpleShader::BindingCache->Flush();
+		},
+		[&](const DrawPacket& a_packet) {
+			if (a_packet.InstanceCount > 0)
+				context->DrawIndexedInstanced(a_packet.IndexCount, a_packet.InstanceCount, a_packet.IndexStart, 0, a_packet.FirstInstance);
+			else
+				context->DrawIndexed(a_packet.IndexCount, a_packet.IndexStart, 0);
+			m_drawCallCount++;
+		});
+	m_constantBufferBytes = ISimpleShader::UploadStats.BytesCopied;
+	m_constantBufferUploads = ISimpleShader::UploadStats.UploadsPerformed;
+	m_constantBufferUploadsSkipped = ISimpleShader::UploadStats.UploadsSkipped;
+}
+
+// --------------------------------------------------------
+// Whether this is the first time the shader has been bound
+// since DrawEntities started, in which case its PerFrame
+// buffer needs sending
+// --------------------------------------------------------
+bool Game::IsFirstBindThisFrame(ISimpleShader* a_pShader)
+{
+	if (std::find(m_frameDataShaders.begin(), m_frameDataShaders.end(), a_pShader) != m_frameDataShaders.end())
+		return false;
+	m_frameDataShaders.push_back(a_pShader);
+	return true;
+}
+
+// --------------------------------------------------------
+// The instance buffer only ever grows (to the next power
+// of two), and is rewritten in full each frame
+// --------------------------------------------------------
+void Game::UploadInstanceData()
+{
+	if (m_instanceData.empty())
+		return;
+
+	if (m_instanceData.size() > m_instanceBufferCapacity) {
+		m_instanceBufferCapacity = 64;
+		while (m_instanceBufferCapacity < m_instanceData.size())
+			m_instanceBufferCapacity *= 2;
+
+		D3D11_BUFFER_DESC instanceBufferDesc = {};
+		instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		instanceBufferDesc.ByteWidth = sizeof(InstanceData) * m_instanceBufferCapacity;
+		instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		m_pInstanceBuffer.Reset();
+		device->CreateBuffer(&instanceBufferDesc, 0, m_pInstanceBuffer.GetAddressOf());
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(m_pInstanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	memcpy(mapped.pData, m_instanceData.data(), sizeof(InstanceData) * m_instanceData.size());
+	context->Unmap(m_pInstanceBuffer.Get(), 0);
+
+	// Slot 0 belongs to the meshes - instances always come from slot 1
+	UINT stride = sizeof(InstanceData);
+	UINT offset = 0;
+	context->IASetVertexBuffers(1, 1, m_pInstanceBuffer.GetAddressOf(), &stride, &offset);
 }
 
 // --------------------------------------------------------
@@ -864,26 +1214,32 @@ void Game::Draw(float deltaTime, float totalTime)
 
 		// Clear the depth buffer (resets per-pixel occlusion information)
 		context->ClearDepthStencilView(depthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-	}
 
-	// DRAW geometry
-	for (std::shared_ptr<Entity> entity : m_pEntities) {
-		std::shared_ptr<SimplePixelShader> pixelShader = entity->GetMaterial()->GetPixelShader();
-		pixelShader->SetFloat("time", totalTime);
-		pixelShader->SetFloat("gamma", m_gamma);
+		// Start the state cache over each frame, in case anything
+		// (like the GUI) bound behind its back since the last one
+		ISimpleShader::BindingCache = m_isStateCacheEnabled ? m_pStateCache.get() : nullptr;
+		m_pStateCache->Invalidate();
+		m_pStateCache->ResetStats();
+	}
 
-		pixelShader->SetFloat3("ambientColor", m_ambientLightColor);
+	// UPDATE every world matrix that changed since last frame in one
+	// batch, so culling and drawing only ever read them
+	TransformPool::GetInstance().UpdateMatrices();
 
-		//pixelShader->SetData("directionalLightA", &*m_pLights[0], sizeof(Light));
-		//pixelShader->SetData("directionalLightB", &*m_pLights[1], sizeof(Light));
-		//pixelShader->SetData("directionalLightC", &*m_pLights[2], sizeof(Light));
-		pixelShader->SetData("lights", &m_lights[0], sizeof(Light) * (int)m_lights.size());
+	// CULL anything the camera can't see
+	CullEntities(m_pCameras[m_currentCamIndex]);
 
-		entity->Draw(context, m_pCameras[m_currentCamIndex]);
-	}
+	// DRAW geometry
+	DrawEntities(m_pCameras[m_currentCamIndex], totalTime);
 
 	m_pSky->Draw(m_pCameras[m_currentCamIndex]);
 
+	// Nothing may be left waiting in the cache once drawing's done
+	if (ISimpleShader::BindingCache)
+		ISimpleShader::BindingCache->Flush();
+	m_bindCallsMade = m_pStateCache->GetCallsMade();
+	m_bindCallsSaved = m_pStateCache->GetCallsSaved();
+
 	// Frame END
 	// - These should happen exactly ONCE PER FRAME
 	// - At the very end of the frame (after drawing *everything*)
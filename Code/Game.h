@@ -14,6 +14,12 @@
 #include "SimpleShader.h"
 #include "Lights.h"
 #include "Sky.h"
+#include "BehaviorSystem.h"
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "StateCache.h"
+#include "D3D11StateTarget.h"
+#include "CommandList.h"
 
 class Game : public DXCore
 {
@@ -38,13 +44,22 @@ public:
 private:
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void LoadShaders();
-	void LoadTextures();
-	void LoadMeshes();
+	void LoadAssets();
 	void CreateEntities();
 	void SetEntitiesInRow(std::vector<std::shared_ptr<Entity>> a_pEntities, DirectX::XMFLOAT3 a_origin, float a_spacing);
 	void CreateSky();
 	void CreateLights();
 
+	// Fills m_visibleEntities with the entities whose bounds are inside the camera's frustum
+	void CullEntities(std::shared_ptr<Camera> a_pCamera);
+
+	// Sorts the visible entities by the state they need and draws them, only binding what changes
+	void DrawEntities(std::shared_ptr<Camera> a_pCamera, float a_totalTime);
+
+	// Copies m_instanceData into the instance buffer (growing it if needed) and binds it
+	void UploadInstanceData();
+	bool IsFirstBindThisFrame(ISimpleShader* a_pShader);
+
 	// Note the usage of ComPtr below
 	//  - This is a smart pointer for objects that abide by the
 	//     Component Object Model, which DirectX objects do
@@ -59,11 +74,35 @@ private:
 	std::shared_ptr <Sky> m_pSky;
 	int m_currentCamIndex;
 	float m_gamma;
+	bool m_isClusterCullingEnabled;
+	bool m_isInstancingEnabled;
+	bool m_isStateCacheEnabled;
+	float m_lodPixelError;	// How far (in pixels) a simplified mesh may stray before a finer level is drawn
 
 	DirectX::XMFLOAT3 m_ambientLightColor;
 	std::vector<Light> m_lights;
 	std::vector<std::shared_ptr<Camera>> m_pCameras;
 	std::vector<std::shared_ptr<Entity>> m_pEntities;
+	std::vector<Entity*> m_visibleEntities;	// Rebuilt every frame, so raw pointers into m_pEntities
+	RenderQueue m_renderQueue;
+	RenderQueueStats m_renderStats;	// From the last frame, for the UI
+	std::vector<int> m_visibleLods;	// Level of detail for each of m_visibleEntities
+	std::vector<uint64_t> m_batchKeys;
+	std::vector<InstanceBatch> m_instanceBatches;
+	std::vector<InstanceData> m_instanceData;
+	CommandList m_commandList;	// Every draw of the frame, recorded in parallel and replayed in order
+	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pInstanceBuffer;
+	unsigned int m_instanceBufferCapacity;
+	unsigned int m_drawCallCount;
+	size_t m_constantBufferBytes;	// Sent to constant buffers by DrawEntities last frame
+	size_t m_constantBufferUploads;
+	size_t m_constantBufferUploadsSkipped;
+	std::unique_ptr<D3D11StateTarget> m_pStateTarget;
+	std::unique_ptr<StateCache> m_pStateCache;	// Handed to every shader through ISimpleShader::BindingCache
+	unsigned int m_bindCallsMade;	// Shader, buffer, texture and sampler binds that reached the context last frame
+	unsigned int m_bindCallsSaved;
+	std::vector<ISimpleShader*> m_frameDataShaders;	// Shaders whose PerFrame buffer is already sent this frame
+	BehaviorSystem m_behaviors;	// Animations for the entities above, updated every frame
 
 	std::shared_ptr<SimpleVertexShader> m_pVertexShader;
 	std::shared_ptr<SimpleVertexShader> m_pSkyVS;
@@ -1,5 +1,6 @@
 #include <Windows.h>
 #include <codecvt>
+#include <fstream>
 #include <locale>
 
 #include "Helpers.h"
@@ -85,3 +86,22 @@ std::wstring NarrowToWide(const std::string& str)
 	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
 	return converter.from_bytes(str);
 }
+
+
+// ----------------------------------------------------
+//  Reads a whole file into a byte array in one go.
+//  Nothing here touches Direct3D, so it's safe to
+//  call from any thread.
+// ----------------------------------------------------
+bool ReadBinaryFile(const std::wstring& filePath, std::vector<unsigned char>& data)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::streamsize size = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	data.resize((size_t)size);
+	return size == 0 || (bool)file.read((char*)data.data(), size);
+}
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 // Helpers for determining the actual path to the executable
 std::wstring GetExePath();
 std::wstring FixPath(const std::wstring& relativeFilePath);
 std::string WideToNarrow(const std::wstring& str);
-std::wstring NarrowToWide(const std::string& str);
\ No newline at end of file
+std::wstring NarrowToWide(const std::string& str);
+
+// Reads an entire file into memory, returning false if it can't be opened
+bool ReadBinaryFile(const std::wstring& filePath, std::vector<unsigned char>& data);
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+void BuildInstanceBatches(const uint64_t* a_batchKeys, size_t a_count, unsigned int a_minInstances, std::vector<InstanceBatch>& a_batches)
+{
+	a_batches.clear();
+
+	unsigned int instanceCount = 0;
+	for (size_t start = 0; start < a_count;)
+	{
+		size_t end = start + 1;
+		if (a_batchKeys[start] != c_notInstanced)
+		{
+			while (end < a_count && a_batchKeys[end] == a_batchKeys[start])
+				end++;
+		}
+
+		unsigned int runLength = (unsigned int)(end - start);
+		if (runLength >= a_minInstances && runLength > 1)
+		{
+			a_batches.push_back({ (unsigned int)start, runLength, instanceCount, true });
+			instanceCount += runLength;
+		}
+		else
+		{
+			for (size_t i = start; i < end; i++)
+				a_batches.push_back({ (unsigned int)i, 1, 0, false });
+		}
+		start = end;
+	}
+}
+
+void GatherInstanceData(const std::vector<InstanceBatch>& a_batches, const std::function<InstanceData(unsigned int)>& a_getInstance, std::vector<InstanceData>& a_instances)
+{
+	a_instances.clear();
+	for (const InstanceBatch& batch : a_batches)
+	{
+		if (!batch.IsInstanced)
+			continue;
+		for (unsigned int i = batch.Start; i < batch.Start + batch.Count; i++)
+			a_instances.push_back(a_getInstance(i));
+	}
+}
+
+InstanceData MakeInstanceData(const XMFLOAT4X4& a_world, const XMFLOAT4X4& a_worldInverseTranspose)
+{
+	InstanceData instance;
+	instance.World = a_world;
+	for (int row = 0; row < 3; row++)
+		instance.WorldInverseTranspose[row] = XMFLOAT4(a_worldInverseTranspose.m[row][0], a_worldInverseTranspose.m[row][1], a_worldInverseTranspose.m[row][2], 0.0f);
+	return instance;
+}
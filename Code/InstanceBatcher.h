@@ -0,0 +1,45 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Batch key for draws that always go on their own
+const uint64_t c_notInstanced = ~0ull;
+
+// --------------------------------------------------------
+// What the instanced vertex shader reads per instance - a
+// world matrix and the upper 3x3 of its inverse-transpose
+// (the fourth column of each row is unused)
+// --------------------------------------------------------
+struct InstanceData
+{
+	DirectX::XMFLOAT4X4 World;
+	DirectX::XMFLOAT4 WorldInverseTranspose[3];
+};
+
+// --------------------------------------------------------
+// A run of draws to submit together. Instanced batches
+// read their instances from FirstInstance onwards in the
+// frame's instance buffer, the rest are single draws
+// --------------------------------------------------------
+struct InstanceBatch
+{
+	unsigned int Start;
+	unsigned int Count;
+	unsigned int FirstInstance;
+	bool IsInstanced;
+};
+
+// Splits a_count (already sorted) draws into batches. Neighbors with the same key,
+// other than c_notInstanced, become one instanced batch once there are at least
+// a_minInstances of them - anything else is drawn alone
+void BuildInstanceBatches(const uint64_t* a_batchKeys, size_t a_count, unsigned int a_minInstances, std::vector<InstanceBatch>& a_batches);
+
+// Clears a_instances and fills it with every instanced batch's instances, in batch order,
+// so each batch's run starts at its FirstInstance. a_getInstance is given each draw's index
+void GatherInstanceData(const std::vector<InstanceBatch>& a_batches, const std::function<InstanceData(unsigned int)>& a_getInstance, std::vector<InstanceData>& a_instances);
+
+// Fills in an instance from a world matrix and its inverse-transpose
+InstanceData MakeInstanceData(const DirectX::XMFLOAT4X4& a_world, const DirectX::XMFLOAT4X4& a_worldInverseTranspose);
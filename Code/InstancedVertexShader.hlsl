@@ -0,0 +1,33 @@
+#include "ShaderIncludes.hlsli"
+
+// Constant buffer - the world matrices come in with each instance instead
+cbuffer PerFrame : register(b0)
+{
+    matrix viewMatrix;
+    matrix projectionMatrix;
+}
+
+// --------------------------------------------------------
+// Same as VertexShader, but draws many copies of a mesh in
+// one call, each with its own world matrices read from the
+// instance buffer (see InstanceData in InstanceBatcher.h).
+// Those rows come straight from the C++ matrices, so they
+// multiply on the right of the vector
+// --------------------------------------------------------
+VertexToPixel main(InstancedVertexShaderInput input)
+{
+    VertexToPixel output;
+
+    float4x4 worldMatrix = float4x4(input.worldRow0, input.worldRow1, input.worldRow2, input.worldRow3);
+    float3x3 worldInvTransposeMatrix = float3x3(input.worldInvTransposeRow0.xyz, input.worldInvTransposeRow1.xyz, input.worldInvTransposeRow2.xyz);
+
+    float4 worldPosition = mul(float4(input.localPosition, 1.0f), worldMatrix);
+    output.screenPosition = mul(mul(projectionMatrix, viewMatrix), worldPosition);
+
+    output.uv = input.uv;
+    output.normal = mul(input.normal, worldInvTransposeMatrix);
+    output.worldPosition = worldPosition.xyz;
+    output.tangent = float4(normalize(mul(input.tangent.xyz, (float3x3) worldMatrix)), input.tangent.w);
+
+    return output;
+}
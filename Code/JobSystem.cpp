@@ -0,0 +1,224 @@
+#include <algorithm>
+
+#include "JobSystem.h"
+
+// Singleton requirement
+JobSystem* JobSystem::instance;
+thread_local unsigned int JobSystem::t_queueIndex = 0;
+
+// --------------- Basic usage -----------------
+//
+// Jobs are plain functions (usually lambdas) that get
+// run on whichever thread is free first. To wait for a
+// batch of them, submit them against the same counter:
+//
+//   JobSystem& jobs = JobSystem::GetInstance();
+//   JobCounter counter;
+//   jobs.Submit([]() { DoSomeWork(); }, &counter);
+//   jobs.Submit([]() { DoMoreWork(); }, &counter);
+//   jobs.Wait(counter);
+//
+// Waiting doesn't just sleep - the waiting thread runs
+// queued jobs itself until the counter hits zero. Jobs
+// must not touch the Direct3D context, since only the
+// thread that owns it may use it.
+//
+// ----------------------------------------------
+
+JobSystem::~JobSystem()
+{
+	Shutdown();
+}
+
+// --------------------------------------------------------
+// Creates one queue per thread (queue 0 belongs to whoever
+// isn't a worker, like the main thread) and starts workers
+// --------------------------------------------------------
+void JobSystem::Initialize(unsigned int a_threadCount)
+{
+	if (m_running)
+		return;
+
+	if (a_threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		a_threadCount = (cores > 1) ? cores - 1 : 1;
+	}
+
+	m_queueCount = a_threadCount + 1;
+	m_queues = std::make_unique<JobQueue[]>(m_queueCount);
+	m_running = true;
+
+	for (unsigned int i = 1; i < m_queueCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerLoop, this, i));
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	if (!m_running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_running = false;
+	}
+	m_wakeCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+
+	// Anything still queued gets run here rather than dropped
+	while (TryRunJob(0)) {}
+
+	m_queues.reset();
+	m_queueCount = 0;
+}
+
+// --------------------------------------------------------
+// Pushes the job onto the calling thread's own queue. With
+// no workers running, the job just runs immediately
+// --------------------------------------------------------
+void JobSystem::Submit(std::function<void()> a_job, JobCounter* a_pCounter)
+{
+	if (a_pCounter)
+		a_pCounter->Count++;
+
+	if (!m_running)
+	{
+		a_job();
+		if (a_pCounter)
+			a_pCounter->Count--;
+		return;
+	}
+
+	{
+		JobQueue& queue = m_queues[t_queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back({ std::move(a_job), a_pCounter });
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingJobs++;
+	}
+	m_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(JobCounter& a_counter)
+{
+	while (a_counter.Count > 0)
+	{
+		if (!m_running || !TryRunJob(t_queueIndex))
+			std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::GetThreadCount()
+{
+	return m_running ? m_queueCount : 1;
+}
+
+unsigned int JobSystem::GetChunkCount(size_t a_count, size_t a_minChunkSize)
+{
+	if (a_count == 0)
+		return 0;
+
+	size_t chunks = (a_minChunkSize > 1) ? (a_count + a_minChunkSize - 1) / a_minChunkSize : a_count;
+	return (unsigned int)std::min<size_t>(chunks, GetThreadCount());
+}
+
+// --------------------------------------------------------
+// Runs one job per chunk, at most one chunk per thread. The
+// calling thread takes the first chunk itself rather than
+// sitting idle, and small counts never leave this thread
+//
+// Chunk i always covers [a_count * i / chunks, a_count *
+// (i + 1) / chunks), so callers can size per-chunk scratch
+// space up front with GetChunkCount()
+// --------------------------------------------------------
+void JobSystem::ParallelFor(size_t a_count, size_t a_minChunkSize, const std::function<void(unsigned int, size_t, size_t)>& a_job)
+{
+	unsigned int chunks = GetChunkCount(a_count, a_minChunkSize);
+	if (chunks == 0)
+		return;
+
+	JobCounter counter;
+	for (unsigned int i = 1; i < chunks; i++)
+	{
+		size_t begin = a_count * i / chunks;
+		size_t end = a_count * (i + 1) / chunks;
+		Submit([&a_job, i, begin, end]() { a_job(i, begin, end); }, &counter);
+	}
+
+	a_job(0, 0, a_count / chunks);
+	Wait(counter);
+}
+
+void JobSystem::WorkerLoop(unsigned int a_queueIndex)
+{
+	t_queueIndex = a_queueIndex;
+
+	while (true)
+	{
+		if (TryRunJob(a_queueIndex))
+			continue;
+
+		// Nothing to do anywhere, so sleep until something is submitted
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]() { return m_pendingJobs > 0 || !m_running; });
+
+		if (!m_running && m_pendingJobs == 0)
+			return;
+	}
+}
+
+// --------------------------------------------------------
+// Takes the newest job from this thread's queue (it's the
+// most likely to still be in cache), or failing that steals
+// the oldest job from another thread's queue
+// --------------------------------------------------------
+bool JobSystem::TryRunJob(unsigned int a_queueIndex)
+{
+	Job job = {};
+	bool found = false;
+
+	for (unsigned int i = 0; i < m_queueCount && !found; i++)
+	{
+		unsigned int index = (a_queueIndex + i) % m_queueCount;
+		JobQueue& queue = m_queues[index];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			continue;
+
+		if (i == 0)
+		{
+			job = std::move(queue.Jobs.back());
+			queue.Jobs.pop_back();
+		}
+		else
+		{
+			job = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+		}
+		found = true;
+	}
+
+	if (!found)
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_pendingJobs--;
+	}
+
+	job.Function();
+	if (job.Counter)
+		job.Counter->Count--;
+
+	return true;
+}
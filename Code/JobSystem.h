@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Tracks a group of submitted jobs - it counts up when a job
+// is submitted against it and back down when that job finishes
+// --------------------------------------------------------
+struct JobCounter
+{
+	std::atomic<int> Count{ 0 };
+};
+
+class JobSystem
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static JobSystem& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new JobSystem();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	JobSystem(JobSystem const&) = delete;
+	void operator=(JobSystem const&) = delete;
+
+private:
+	static JobSystem* instance;
+	JobSystem() : m_running(false), m_pendingJobs(0) {};
+#pragma endregion
+
+public:
+	~JobSystem();
+
+	/* Starts the worker threads - zero means one per core, minus the calling thread */
+	void Initialize(unsigned int a_threadCount = 0);
+
+	/* Finishes any queued work and joins the worker threads */
+	void Shutdown();
+
+	/* Queues a job to run on any thread, optionally tracked by a counter */
+	void Submit(std::function<void()> a_job, JobCounter* a_pCounter = nullptr);
+
+	/* Blocks until the counter reaches zero, running queued jobs in the meantime */
+	void Wait(JobCounter& a_counter);
+
+	/* Returns the number of threads that can run jobs, including the calling thread */
+	unsigned int GetThreadCount();
+
+	/* Returns how many chunks ParallelFor will split a_count items into */
+	unsigned int GetChunkCount(size_t a_count, size_t a_minChunkSize);
+
+	/* Splits [0, a_count) into chunks of at least a_minChunkSize and runs a_job on each (chunk index, begin, end), returning once they're all done */
+	void ParallelFor(size_t a_count, size_t a_minChunkSize, const std::function<void(unsigned int, size_t, size_t)>& a_job);
+
+private:
+	struct Job
+	{
+		std::function<void()> Function;
+		JobCounter* Counter;
+	};
+
+	// Each thread owns a queue - it pushes and pops at the back,
+	// while idle threads steal from the front of everyone else's
+	struct JobQueue
+	{
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	void WorkerLoop(unsigned int a_queueIndex);
+	bool TryRunJob(unsigned int a_queueIndex);
+
+	std::vector<std::thread> m_workers;
+	std::unique_ptr<JobQueue[]> m_queues;
+	unsigned int m_queueCount = 0;
+
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	std::atomic<bool> m_running;
+	std::atomic<int> m_pendingJobs;
+
+	// Queue index of the current thread - 0 for any thread that isn't a worker
+	static thread_local unsigned int t_queueIndex;
+};
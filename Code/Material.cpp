@@ -1,5 +1,22 @@
 #include "Material.h"
 
+std::shared_ptr<SimpleVertexShader> Material::s_pCompactVertexShaders[(int)VertexFormat::Count];
+std::shared_ptr<SimpleVertexShader> Material::s_pInstancedVertexShader;
+std::unordered_map<SimplePixelShader*, Material*> Material::s_pUploadedMaterials;
+
+// Hashed at compile time, so looking the handles up never builds a string
+constexpr unsigned int c_worldMatrixHash = SimpleShaderHash("worldMatrix");
+constexpr unsigned int c_worldInvTransposeMatrixHash = SimpleShaderHash("worldInvTransposeMatrix");
+constexpr unsigned int c_positionScaleHash = SimpleShaderHash("positionScale");
+constexpr unsigned int c_positionOffsetHash = SimpleShaderHash("positionOffset");
+constexpr unsigned int c_roughnessHash = SimpleShaderHash("roughness");
+constexpr unsigned int c_colorTintHash = SimpleShaderHash("colorTint");
+constexpr unsigned int c_uvScaleHash = SimpleShaderHash("uvScale");
+constexpr unsigned int c_uvOffsetHash = SimpleShaderHash("uvOffset");
+constexpr unsigned int c_useSpecularMapHash = SimpleShaderHash("useSpecularMap");
+constexpr unsigned int c_perObjectHash = SimpleShaderHash("PerObject");
+constexpr unsigned int c_perMaterialHash = SimpleShaderHash("PerMaterial");
+
 Material::Material(std::shared_ptr<SimpleVertexShader> a_pVertexShader, std::shared_ptr<SimplePixelShader> a_pPixelShader, DirectX::XMFLOAT3 a_colorTint, float a_roughness, bool a_useSpecularMap, DirectX::XMFLOAT2 a_uvScale, DirectX::XMFLOAT2 a_uvOffset)
 {
 	m_pVertexShader = a_pVertexShader;
@@ -9,9 +26,19 @@ Material::Material(std::shared_ptr<SimpleVertexShader> a_pVertexShader, std::sha
 	m_useSpecularMap = a_useSpecularMap;
 	m_uvScale = a_uvScale;
 	m_uvOffset = a_uvOffset;
+	m_isDataDirty = true;
 }
 
+Material::~Material() { ForgetUpload(); }
+
 std::shared_ptr<SimpleVertexShader> Material::GetVertexShader() { return m_pVertexShader; }
+std::shared_ptr<SimpleVertexShader> Material::GetVertexShader(VertexFormat a_format)
+{
+	// Meshes in a compact format need the shader that can unpack them
+	if (a_format != VertexFormat::Full && s_pCompactVertexShaders[(int)a_format])
+		return s_pCompactVertexShaders[(int)a_format];
+	return m_pVertexShader;
+}
 std::shared_ptr<SimplePixelShader> Material::GetPixelShader() { return m_pPixelShader; }
 DirectX::XMFLOAT3 Material::GetColorTint() { return m_colorTint; }
 float Material::GetRoughness() { return m_roughness; }
@@ -20,40 +47,96 @@ DirectX::XMFLOAT2 Material::GetUVScale() { return m_uvScale; }
 DirectX::XMFLOAT2 Material::GetUVOffset() { return m_uvOffset; }
 
 void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> a_pVertexShader) { m_pVertexShader = a_pVertexShader; }
-void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> a_pPixelShader) { m_pPixelShader = a_pPixelShader; }
-void Material::SetColorTint(DirectX::XMFLOAT3 a_colorTint) { m_colorTint = a_colorTint; }
+void Material::SetPixelShader(std::shared_ptr<SimplePixelShader> a_pPixelShader) { ForgetUpload(); m_pPixelShader = a_pPixelShader; m_isDataDirty = true; }
+void Material::SetColorTint(DirectX::XMFLOAT3 a_colorTint) { m_colorTint = a_colorTint; m_isDataDirty = true; }
 void Material::SetRoughness(float a_roughness) {
 	if (a_roughness < 0.0f) m_roughness = 0.0f;
 	if (a_roughness > 1.0f) m_roughness = 1.0f;
 	else m_roughness = a_roughness;
+	m_isDataDirty = true;
 }
-void Material::SetUVScale(DirectX::XMFLOAT2 a_uvScale) { m_uvScale = a_uvScale; }
-void Material::SetUVOffset(DirectX::XMFLOAT2 a_uvOffset) { m_uvOffset = a_uvOffset; }
+void Material::SetUVScale(DirectX::XMFLOAT2 a_uvScale) { m_uvScale = a_uvScale; m_isDataDirty = true; }
+void Material::SetUVOffset(DirectX::XMFLOAT2 a_uvOffset) { m_uvOffset = a_uvOffset; m_isDataDirty = true; }
 void Material::AddTextureSRV(std::string a_shaderName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> a_srv) { m_textureSRVs.insert({ a_shaderName, a_srv }); }
 void Material::AddSampler(std::string a_shaderName, Microsoft::WRL::ComPtr<ID3D11SamplerState> a_sampler) { m_samplers.insert({ a_shaderName, a_sampler }); }
 
-void Material::SendDataToShader(Transform* a_transform, std::shared_ptr<Camera> a_pCamera)
+void Material::SetCompactVertexShader(VertexFormat a_format, std::shared_ptr<SimpleVertexShader> a_pVertexShader) { s_pCompactVertexShaders[(int)a_format] = a_pVertexShader; }
+void Material::SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> a_pVertexShader) { s_pInstancedVertexShader = a_pVertexShader; }
+std::shared_ptr<SimpleVertexShader> Material::GetInstancedVertexShader() { return s_pInstancedVertexShader; }
+
+void Material::BindResources()
+{
+	for (auto& t : m_textureSRVs) { m_pPixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
+	for (auto& s : m_samplers) { m_pPixelShader->SetSamplerState(s.first.c_str(), s.second); }
+}
+
+// --------------------------------------------------------
+// Every material sharing a pixel shader shares its one
+// PerMaterial buffer, so it has to be sent again whenever
+// a different material was the last to use it
+// --------------------------------------------------------
+void Material::SendMaterialDataToShader()
 {
-	// Activate shaders
-	this->GetVertexShader()->SetShader();
-	this->GetPixelShader()->SetShader();
+	Material*& uploaded = s_pUploadedMaterials[m_pPixelShader.get()];
+	if (uploaded == this && !m_isDataDirty)
+		return;
 
-	m_pVertexShader->SetMatrix4x4("worldMatrix", a_transform->GetWorldMatrix());
-	m_pVertexShader->SetMatrix4x4("worldInvTransposeMatrix", a_transform->GetWorldInverseTransposeMatrix());
-	m_pVertexShader->SetMatrix4x4("viewMatrix", a_pCamera->GetViewMatrix());
-	m_pVertexShader->SetMatrix4x4("projectionMatrix", a_pCamera->GetProjectionMatrix());
-	m_pVertexShader->CopyAllBufferData();
+	MaterialHandles& handles = m_materialHandles;
+	if (handles.Shader != m_pPixelShader.get())
+	{
+		handles.Shader = m_pPixelShader.get();
+		handles.Roughness = m_pPixelShader->GetVariableHandle(c_roughnessHash);
+		handles.ColorTint = m_pPixelShader->GetVariableHandle(c_colorTintHash);
+		handles.UVScale = m_pPixelShader->GetVariableHandle(c_uvScaleHash);
+		handles.UVOffset = m_pPixelShader->GetVariableHandle(c_uvOffsetHash);
+		handles.UseSpecularMap = m_pPixelShader->GetVariableHandle(c_useSpecularMapHash);
+		handles.PerMaterialBuffer = (unsigned int)m_pPixelShader->GetBufferIndex(c_perMaterialHash);
+	}
 
-	m_pPixelShader->SetFloat("roughness", this->GetRoughness());
-	m_pPixelShader->SetFloat3("cameraPosition", a_pCamera->GetTransform()->GetPosition());
-	m_pPixelShader->SetFloat3("colorTint", this->GetColorTint());
+	m_pPixelShader->SetFloat(handles.Roughness, this->GetRoughness());
+	m_pPixelShader->SetFloat3(handles.ColorTint, this->GetColorTint());
 
-	for (auto& t : m_textureSRVs) { m_pPixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
-	for (auto& s : m_samplers) { m_pPixelShader->SetSamplerState(s.first.c_str(), s.second); }
+	m_pPixelShader->SetFloat2(handles.UVScale, m_uvScale);
+	m_pPixelShader->SetFloat2(handles.UVOffset, m_uvOffset);
+	m_pPixelShader->SetInt(handles.UseSpecularMap, (int)m_useSpecularMap);
+
+	m_pPixelShader->CopyBufferData(handles.PerMaterialBuffer);
+	uploaded = this;
+	m_isDataDirty = false;
+}
+
+void Material::ForgetUpload()
+{
+	auto uploaded = s_pUploadedMaterials.find(m_pPixelShader.get());
+	if (uploaded != s_pUploadedMaterials.end() && uploaded->second == this)
+		s_pUploadedMaterials.erase(uploaded);
+}
+
+void Material::SendObjectDataToShader(Transform* a_transform, std::shared_ptr<Mesh> a_pMesh)
+{
+	VertexFormat format = a_pMesh->GetVertexFormat();
+	std::shared_ptr<SimpleVertexShader> vertexShader = GetVertexShader(format);
 
-	m_pPixelShader->SetFloat2("uvScale", m_uvScale);
-	m_pPixelShader->SetFloat2("uvOffset", m_uvOffset);
-	m_pPixelShader->SetInt("useSpecularMap", (int)m_useSpecularMap);
+	ObjectHandles& handles = m_objectHandles[(int)format];
+	if (handles.Shader != vertexShader.get())
+	{
+		handles.Shader = vertexShader.get();
+		handles.WorldMatrix = vertexShader->GetVariableHandle(c_worldMatrixHash);
+		handles.WorldInvTransposeMatrix = vertexShader->GetVariableHandle(c_worldInvTransposeMatrixHash);
+		handles.PositionScale = vertexShader->GetVariableHandle(c_positionScaleHash);
+		handles.PositionOffset = vertexShader->GetVariableHandle(c_positionOffsetHash);
+		handles.PerObjectBuffer = (unsigned int)vertexShader->GetBufferIndex(c_perObjectHash);
+	}
 
-	m_pPixelShader->CopyAllBufferData();
+	vertexShader->SetMatrix4x4(handles.WorldMatrix, a_transform->GetWorldMatrix());
+	vertexShader->SetMatrix4x4(handles.WorldInvTransposeMatrix, a_transform->GetWorldInverseTransposeMatrix());
+	if (vertexShader != m_pVertexShader)
+	{
+		// Compact positions are 0-1 across the mesh's bounds
+		DirectX::XMFLOAT3 boundsMin = a_pMesh->GetBoundsMin();
+		DirectX::XMFLOAT3 boundsMax = a_pMesh->GetBoundsMax();
+		vertexShader->SetFloat3(handles.PositionScale, DirectX::XMFLOAT3(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+		vertexShader->SetFloat3(handles.PositionOffset, boundsMin);
+	}
+	vertexShader->CopyBufferData(handles.PerObjectBuffer);
 }
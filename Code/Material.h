@@ -6,13 +6,17 @@
 #include "SimpleShader.h"
 #include "Transform.h"
 #include "Camera.h"
+#include "Mesh.h"
 
 class Material
 {
 public:
 	Material(std::shared_ptr<SimpleVertexShader> a_pVertexShader, std::shared_ptr<SimplePixelShader> a_pPixelShader, DirectX::XMFLOAT3 a_colorTint, float a_roughness = 0.0f, bool a_useSpecularMap = false, DirectX::XMFLOAT2 a_uvScale = DirectX::XMFLOAT2(1, 1), DirectX::XMFLOAT2 a_uvOffset = DirectX::XMFLOAT2(0, 0));
+	~Material();
 
 	std::shared_ptr<SimpleVertexShader> GetVertexShader();
+	/* Returns the vertex shader that's actually used for meshes in the given format */
+	std::shared_ptr<SimpleVertexShader> GetVertexShader(VertexFormat a_format);
 	std::shared_ptr<SimplePixelShader> GetPixelShader();
 	DirectX::XMFLOAT3 GetColorTint();
 	float GetRoughness();
@@ -30,12 +34,62 @@ public:
 	void AddTextureSRV(std::string a_shaderName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> a_srv);
 	void AddSampler(std::string a_shaderName, Microsoft::WRL::ComPtr<ID3D11SamplerState> a_sampler);
 
-	void SendDataToShader(Transform* a_transform, std::shared_ptr<Camera> a_pCamera);
+	/* Sets the vertex shader used in place of any material's own for meshes stored in a compact format */
+	static void SetCompactVertexShader(VertexFormat a_format, std::shared_ptr<SimpleVertexShader> a_pVertexShader);
+
+	/* Sets the vertex shader that draws instanced batches of full format meshes, shared by every material */
+	static void SetInstancedVertexShader(std::shared_ptr<SimpleVertexShader> a_pVertexShader);
+	static std::shared_ptr<SimpleVertexShader> GetInstancedVertexShader();
+
+	/* Binds just the textures and samplers to the pixel shader */
+	void BindResources();
+
+	/* Sends the PerMaterial constants, unless the pixel shader already holds this material's current values */
+	void SendMaterialDataToShader();
+
+	/* Sends just the PerObject constants, for when everything else is already bound and sent */
+	void SendObjectDataToShader(Transform* a_transform, std::shared_ptr<Mesh> a_pMesh);
 
 private:
+	// Whose values each pixel shader's PerMaterial buffer currently holds
+	static std::unordered_map<SimplePixelShader*, Material*> s_pUploadedMaterials;
+
+	// Drops this material's entry in s_pUploadedMaterials, so neither pointer
+	// can be mistaken for a newer shader or material at the same address
+	void ForgetUpload();
+
+	// Compact formats need their own input layout and unpacking, so the
+	// shaders for them are shared by every material (Full is unused)
+	static std::shared_ptr<SimpleVertexShader> s_pCompactVertexShaders[(int)VertexFormat::Count];
+	static std::shared_ptr<SimpleVertexShader> s_pInstancedVertexShader;
+
+	// Variable handles for whichever shader they were last looked up in
+	struct ObjectHandles
+	{
+		SimpleVertexShader* Shader = nullptr;
+		SimpleShaderHandle WorldMatrix;
+		SimpleShaderHandle WorldInvTransposeMatrix;
+		SimpleShaderHandle PositionScale;
+		SimpleShaderHandle PositionOffset;
+		unsigned int PerObjectBuffer = 0;	// Out of range (so never copied) if the shader has no PerObject buffer
+	};
+	struct MaterialHandles
+	{
+		SimplePixelShader* Shader = nullptr;
+		SimpleShaderHandle Roughness;
+		SimpleShaderHandle ColorTint;
+		SimpleShaderHandle UVScale;
+		SimpleShaderHandle UVOffset;
+		SimpleShaderHandle UseSpecularMap;
+		unsigned int PerMaterialBuffer = 0;
+	};
+
 	std::shared_ptr<SimpleVertexShader> m_pVertexShader;
 	std::shared_ptr<SimplePixelShader> m_pPixelShader;
 
+	ObjectHandles m_objectHandles[(int)VertexFormat::Count];	// One per vertex format, since each can use a different shader
+	MaterialHandles m_materialHandles;
+
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_textureSRVs;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> m_samplers;
 
@@ -44,4 +98,5 @@ private:
 	DirectX::XMFLOAT2 m_uvOffset;
 	float m_roughness;
 	bool m_useSpecularMap;
+	bool m_isDataDirty;	// Changed since it was last sent
 };
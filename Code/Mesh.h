@@ -3,33 +3,97 @@
 #include <d3d11.h>
 #include <wrl/client.h>
 #include <string>
+#include <vector>
 
 #include "Vertex.h"
+#include "MeshOptimizer.h"
+#include "MeshCache.h"
+#include "VertexFormat.h"
+#include "MeshClusters.h"
+
+// --------------------------------------------------------
+// Everything Mesh::LoadFile produces on the CPU - either a
+// mapped cache file or freshly processed data - waiting to
+// be turned into GPU buffers
+// --------------------------------------------------------
+struct MeshLoadData
+{
+	bool IsCached = false;
+	MappedMeshCache Cache;
+	MeshData Data;
+	VertexFormat Format = VertexFormat::Full;
+	std::vector<unsigned char> PackedVertices;	// Data's vertices in Format - empty for Full, which uploads them as they are
+	MeshOptimizationStats Stats;
+	DirectX::XMFLOAT3 BoundsMin = DirectX::XMFLOAT3(0, 0, 0);
+	DirectX::XMFLOAT3 BoundsMax = DirectX::XMFLOAT3(0, 0, 0);
+	DirectX::XMFLOAT3 SphereCenter = DirectX::XMFLOAT3(0, 0, 0);
+	float SphereRadius = 0.0f;
+};
 
 class Mesh {
 public:
 	Mesh(Vertex* a_vertexArray, int a_vertexCount, unsigned int* a_indexArray, int a_indexCount, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
-	Mesh(const std::wstring a_filename, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
+	Mesh(const std::wstring a_filename, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice, VertexFormat a_vertexFormat = VertexFormat::Full);
+	Mesh(MeshLoadData& a_loadData, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
 	~Mesh();
 
+	/* Loads and processes a model file on the CPU only, packing its vertices in a_vertexFormat - safe to call from any thread */
+	static bool LoadFile(const std::wstring& a_filename, MeshLoadData& a_loadData, VertexFormat a_vertexFormat = VertexFormat::Full);
+
 	/* Returns the pointer to the vertex buffer object */
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 
 	/* Returns the pointer to the index buffer object */
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
 
-	/* Returns the number of indices this mesh contains */
+	/* Returns the number of indices in the full detail mesh */
 	int GetIndexCount();
 
-	/* Sets the buffers and tells DirectX to draw the correct number of indices */
-	void Draw(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext);
+	/* Returns how many levels of detail the mesh has, always at least one */
+	int GetLodCount();
+
+	/* Returns the index range and error of a level of detail, 0 being the full mesh */
+	MeshLod GetLod(int a_lod);
+
+	/* Returns the vertex cache statistics from when the mesh was loaded */
+	MeshOptimizationStats GetOptimizationStats();
+
+	/* Returns the layout the vertex buffer is stored in */
+	VertexFormat GetVertexFormat();
+
+	/* Returns how many meshlets the full detail level is split into, 0 if it isn't */
+	int GetMeshletCount();
+
+	/* Returns the corners of the mesh's local space bounding box */
+	DirectX::XMFLOAT3 GetBoundsMin();
+	DirectX::XMFLOAT3 GetBoundsMax();
+
+	/* Returns the mesh's local space bounding sphere */
+	DirectX::XMFLOAT3 GetSphereCenter();
+	float GetSphereRadius();
+
+	/* Binds the vertex and index buffers to the input assembler */
+	void SetBuffers(Microsoft::WRL::ComPtr<ID3D11DeviceContext> a_pContext);
+
+	/* Fills a_ranges with the index ranges of the full detail level's meshlets that are inside the frustum and not facing away from the camera (both in local space), without touching the mesh or the context. Returns how many meshlets survived */
+	size_t CullClusters(const Frustum& a_localFrustum, DirectX::XMFLOAT3 a_localCameraPosition, bool a_isConeCullingAllowed, std::vector<IndexRange>& a_ranges);
 
 private:
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_pContext;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pVertexBuffer;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> m_pIndexBuffer;
+	VertexFormat m_vertexFormat;
+	DXGI_FORMAT m_indexFormat;
 	int m_indexBufferCount;
+	MeshOptimizationStats m_optimizationStats;
+	DirectX::XMFLOAT3 m_boundsMin;
+	DirectX::XMFLOAT3 m_boundsMax;
+	DirectX::XMFLOAT3 m_sphereCenter;
+	float m_sphereRadius;
+	std::vector<MeshLod> m_lods;
+	std::vector<Meshlet> m_meshlets;
 
-	void CreateBuffers(Vertex* a_vertexArray, int a_vertexCount, unsigned int* a_indexArray, int a_indexCount, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
-	void CalculateTangents(Vertex* a_verts, int a_numVerts, unsigned int* a_indices, int a_numIndices);
+	void CreateFromLoadData(MeshLoadData& a_loadData, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
+	void CreateBuffers(const void* a_vertexData, int a_vertexCount, const unsigned int* a_indexArray, int a_indexCount, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
+	void CreateBuffers(const void* a_vertexData, int a_vertexCount, const void* a_indexData, DXGI_FORMAT a_indexFormat, int a_indexCount, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
 };
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+#include "MeshCache.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t c_meshCacheMagic = 0x4853454D;	// "MESH" when read as bytes
+
+	// Keeps the blobs 16-byte aligned within the file
+	uint64_t AlignOffset(uint64_t a_offset)
+	{
+		return (a_offset + 15) & ~(uint64_t)15;
+	}
+
+	// 64-bit FNV-1a
+	uint64_t HashBytes(const void* a_data, size_t a_size, uint64_t a_hash = 14695981039346656037ull)
+	{
+		const unsigned char* bytes = (const unsigned char*)a_data;
+		for (size_t i = 0; i < a_size; i++)
+		{
+			a_hash ^= bytes[i];
+			a_hash *= 1099511628211ull;
+		}
+		return a_hash;
+	}
+
+	// Whether a range of whole triangles fits inside the index blob
+	bool IsIndexRangeValid(unsigned int a_start, unsigned int a_count, uint32_t a_indexCount)
+	{
+		return a_count % 3 == 0 && (uint64_t)a_start + a_count <= a_indexCount;
+	}
+
+	template<typename Index>
+	bool AreIndicesInRange(const Index* a_indices, uint32_t a_indexCount, uint32_t a_vertexCount)
+	{
+		for (uint32_t i = 0; i < a_indexCount; i++)
+			if (a_indices[i] >= a_vertexCount)
+				return false;
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Every level of detail and meshlet has to be a range of
+	// the index blob, and every index has to name a vertex in
+	// the vertex blob - otherwise drawing or culling the mesh
+	// would read past what's mapped
+	// --------------------------------------------------------
+	bool AreRangesValid(const MeshCacheHeader& a_header, const unsigned char* a_pView)
+	{
+		for (uint32_t i = 0; i < a_header.LodCount; i++)
+			if (!IsIndexRangeValid(a_header.Lods[i].IndexStart, a_header.Lods[i].IndexCount, a_header.IndexCount))
+				return false;
+
+		// Meshlets only ever split up the full detail level
+		uint32_t fullIndexCount = a_header.LodCount > 0 ? a_header.Lods[0].IndexStart + a_header.Lods[0].IndexCount : a_header.IndexCount;
+		const Meshlet* meshlets = (const Meshlet*)(a_pView + a_header.MeshletOffset);
+		for (uint32_t i = 0; i < a_header.MeshletCount; i++)
+			if (!IsIndexRangeValid(meshlets[i].IndexStart, meshlets[i].IndexCount, fullIndexCount))
+				return false;
+
+		const void* indices = a_pView + a_header.IndexOffset;
+		if (a_header.IndexStride == sizeof(unsigned short))
+			return AreIndicesInRange((const unsigned short*)indices, a_header.IndexCount, a_header.VertexCount);
+		return AreIndicesInRange((const unsigned int*)indices, a_header.IndexCount, a_header.VertexCount);
+	}
+}
+
+// --------------------------------------------------------
+// Swaps the model's extension for .mesh
+// --------------------------------------------------------
+std::wstring GetMeshCachePath(const std::wstring& a_sourcePath)
+{
+	size_t dot = a_sourcePath.find_last_of(L'.');
+	size_t slash = a_sourcePath.find_last_of(L"/\\");
+	if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+		return a_sourcePath + L".mesh";
+
+	return a_sourcePath.substr(0, dot) + L".mesh";
+}
+
+// --------------------------------------------------------
+// Hashing the .obj's contents would mean reading the very
+// file the cache exists to avoid, so this uses the size
+// and write time the file system already has on hand
+// --------------------------------------------------------
+bool GetMeshSourceHash(const std::wstring& a_sourcePath, uint64_t& a_hash)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes = {};
+	if (!GetFileAttributesExW(a_sourcePath.c_str(), GetFileExInfoStandard, &attributes))
+		return false;
+
+	a_hash = HashBytes(&attributes.nFileSizeHigh, sizeof(attributes.nFileSizeHigh));
+	a_hash = HashBytes(&attributes.nFileSizeLow, sizeof(attributes.nFileSizeLow), a_hash);
+	a_hash = HashBytes(&attributes.ftLastWriteTime, sizeof(attributes.ftLastWriteTime), a_hash);
+	return true;
+}
+
+// --------------------------------------------------------
+// Min/max of every vertex position
+// --------------------------------------------------------
+void CalculateBounds(const Vertex* a_vertices, size_t a_vertexCount, XMFLOAT3& a_min, XMFLOAT3& a_max)
+{
+	if (a_vertexCount == 0)
+	{
+		a_min = XMFLOAT3(0, 0, 0);
+		a_max = XMFLOAT3(0, 0, 0);
+		return;
+	}
+
+	XMVECTOR minimum = XMLoadFloat3(&a_vertices[0].Position);
+	XMVECTOR maximum = minimum;
+	for (size_t i = 1; i < a_vertexCount; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&a_vertices[i].Position);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+
+	XMStoreFloat3(&a_min, minimum);
+	XMStoreFloat3(&a_max, maximum);
+}
+
+// --------------------------------------------------------
+// Ritter's bounding sphere: start from two far apart points
+// and grow the sphere just enough to take in any vertex
+// that's still outside it
+// --------------------------------------------------------
+void CalculateBoundingSphere(const Vertex* a_vertices, size_t a_vertexCount, XMFLOAT3& a_center, float& a_radius)
+{
+	if (a_vertexCount == 0)
+	{
+		a_center = XMFLOAT3(0, 0, 0);
+		a_radius = 0.0f;
+		return;
+	}
+
+	// The vertex furthest from a given point
+	auto furthestFrom = [&](FXMVECTOR a_point) {
+		XMVECTOR furthest = XMLoadFloat3(&a_vertices[0].Position);
+		float furthestSq = 0.0f;
+		for (size_t i = 0; i < a_vertexCount; i++)
+		{
+			XMVECTOR position = XMLoadFloat3(&a_vertices[i].Position);
+			float distanceSq = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(position, a_point)));
+			if (distanceSq > furthestSq)
+			{
+				furthest = position;
+				furthestSq = distanceSq;
+			}
+		}
+		return furthest;
+	};
+
+	XMVECTOR a = furthestFrom(XMLoadFloat3(&a_vertices[0].Position));
+	XMVECTOR b = furthestFrom(a);
+	XMVECTOR center = XMVectorScale(XMVectorAdd(a, b), 0.5f);
+	float radius = XMVectorGetX(XMVector3Length(XMVectorSubtract(b, a))) * 0.5f;
+
+	for (size_t i = 0; i < a_vertexCount; i++)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&a_vertices[i].Position), center);
+		float distance = XMVectorGetX(XMVector3Length(offset));
+		if (distance > radius)
+		{
+			// Move the center towards the point by just enough that the
+			// far side of the old sphere stays inside the new one
+			float newRadius = (radius + distance) * 0.5f;
+			center = XMVectorAdd(center, XMVectorScale(offset, (newRadius - radius) / distance));
+			radius = newRadius;
+		}
+	}
+
+	XMStoreFloat3(&a_center, center);
+	a_radius = radius;
+}
+
+// --------------------------------------------------------
+// Writes the header and both blobs. Indices are narrowed
+// to 16 bits here (when they fit) and the vertices come
+// in already packed, so loading never has to touch either
+// of them again
+// --------------------------------------------------------
+bool WriteMeshCache(const std::wstring& a_cachePath, const MeshData& a_meshData, VertexFormat a_vertexFormat, const void* a_vertexData, const MeshOptimizationStats& a_stats, uint64_t a_sourceHash)
+{
+	std::vector<unsigned short> shortIndices;
+	const void* indexData = a_meshData.Indices.data();
+	uint32_t indexStride = sizeof(unsigned int);
+	if (CanUseShortIndices(a_meshData.Vertices.size()))
+	{
+		shortIndices.assign(a_meshData.Indices.begin(), a_meshData.Indices.end());
+		indexData = shortIndices.data();
+		indexStride = sizeof(unsigned short);
+	}
+
+	MeshCacheHeader header = {};
+	header.Magic = c_meshCacheMagic;
+	header.Version = c_meshCacheVersion;
+	header.VertexFormat = (uint32_t)a_vertexFormat;
+	header.VertexStride = GetVertexStride(a_vertexFormat);
+	header.IndexStride = indexStride;
+	header.VertexCount = (uint32_t)a_meshData.Vertices.size();
+	header.IndexCount = (uint32_t)a_meshData.Indices.size();
+	header.SourceHash = a_sourceHash;
+	header.VertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+	header.IndexOffset = AlignOffset(header.VertexOffset + (uint64_t)header.VertexStride * header.VertexCount);
+	header.MeshletCount = (uint32_t)a_meshData.Meshlets.size();
+	header.MeshletOffset = AlignOffset(header.IndexOffset + (uint64_t)header.IndexStride * header.IndexCount);
+	header.Stats = a_stats;
+	header.LodCount = (uint32_t)(std::min)(a_meshData.Lods.size(), c_maxMeshLods);
+	for (uint32_t i = 0; i < header.LodCount; i++)
+		header.Lods[i] = a_meshData.Lods[i];
+	CalculateBounds(a_meshData.Vertices.data(), a_meshData.Vertices.size(), header.BoundsMin, header.BoundsMax);
+	CalculateBoundingSphere(a_meshData.Vertices.data(), a_meshData.Vertices.size(), header.SphereCenter, header.SphereRadius);
+
+	std::ofstream file(a_cachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return false;
+
+	const char padding[16] = {};
+	file.write((const char*)&header, sizeof(header));
+	file.write(padding, header.VertexOffset - sizeof(header));
+	file.write((const char*)a_vertexData, (std::streamsize)header.VertexStride * header.VertexCount);
+	file.write(padding, header.IndexOffset - (header.VertexOffset + (uint64_t)header.VertexStride * header.VertexCount));
+	file.write((const char*)indexData, (std::streamsize)header.IndexStride * header.IndexCount);
+	file.write(padding, header.MeshletOffset - (header.IndexOffset + (uint64_t)header.IndexStride * header.IndexCount));
+	file.write((const char*)a_meshData.Meshlets.data(), (std::streamsize)sizeof(Meshlet) * header.MeshletCount);
+
+	if (!file.good())
+	{
+		// Never leave a half-written cache behind for the next run to trip over
+		file.close();
+		DeleteFileW(a_cachePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+MappedMeshCache::MappedMeshCache()
+	: m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr),
+	m_pView(nullptr)
+{
+}
+
+MappedMeshCache::~MappedMeshCache()
+{
+	Close();
+}
+
+// --------------------------------------------------------
+// Maps the whole file read-only and validates the header
+// against what this build of the loader would produce. A
+// cache packed in another vertex format is stale too, and
+// gets rewritten in the one that's wanted now
+// --------------------------------------------------------
+bool MappedMeshCache::Open(const std::wstring& a_cachePath, uint64_t a_sourceHash, VertexFormat a_vertexFormat)
+{
+	Close();
+
+	m_file = CreateFileW(a_cachePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(MeshCacheHeader))
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pView = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_pView)
+	{
+		Close();
+		return false;
+	}
+
+	// Anything that doesn't match exactly is treated as stale
+	const MeshCacheHeader& header = GetHeader();
+	uint64_t size = (uint64_t)fileSize.QuadPart;
+	if (header.Magic != c_meshCacheMagic ||
+		header.Version != c_meshCacheVersion ||
+		header.VertexFormat != (uint32_t)a_vertexFormat ||
+		header.VertexStride != GetVertexStride(a_vertexFormat) ||
+		(header.IndexStride != sizeof(unsigned short) && header.IndexStride != sizeof(unsigned int)) ||
+		header.SourceHash != a_sourceHash ||
+		header.VertexCount == 0 || header.IndexCount == 0 ||
+		header.LodCount > c_maxMeshLods ||
+		header.VertexOffset + (uint64_t)header.VertexStride * header.VertexCount > size ||
+		header.IndexOffset + (uint64_t)header.IndexStride * header.IndexCount > size ||
+		header.MeshletOffset + (uint64_t)sizeof(Meshlet) * header.MeshletCount > size ||
+		!AreRangesValid(header, m_pView))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedMeshCache::Close()
+{
+	if (m_pView)
+		UnmapViewOfFile(m_pView);
+	if (m_mapping)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_pView = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+const MeshCacheHeader& MappedMeshCache::GetHeader() { return *(const MeshCacheHeader*)m_pView; }
+const void* MappedMeshCache::GetVertices() { return m_pView + GetHeader().VertexOffset; }
+const void* MappedMeshCache::GetIndices() { return m_pView + GetHeader().IndexOffset; }
+const Meshlet* MappedMeshCache::GetMeshlets() { return (const Meshlet*)(m_pView + GetHeader().MeshletOffset); }
+DXGI_FORMAT MappedMeshCache::GetIndexFormat() { return GetHeader().IndexStride == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT; }
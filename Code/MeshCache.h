@@ -0,0 +1,99 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+
+#include "MeshData.h"
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+
+// Bump this whenever the loader/optimizer output changes so that
+// old cache files are thrown away instead of being trusted
+const uint32_t c_meshCacheVersion = 7;
+
+// --------------------------------------------------------
+// Header at the start of every .mesh file
+//
+// The vertex blob (already packed in the mesh's vertex format,
+// relative to the bounds below) and the index blob (16 or
+// 32-bit, already in the format the index buffer wants)
+// follow at the given offsets, so a mapped file can be handed
+// straight to CreateBuffer as pSysMem. The meshlets of the
+// full detail level come last
+// --------------------------------------------------------
+struct MeshCacheHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t VertexFormat;		// The VertexFormat the vertex blob is packed in
+	uint32_t VertexStride;
+	uint32_t IndexStride;
+	uint32_t VertexCount;
+	uint32_t IndexCount;
+	uint64_t SourceHash;		// Hash of the source .obj's size and write time
+	uint64_t VertexOffset;
+	uint64_t IndexOffset;
+	uint64_t MeshletOffset;
+	DirectX::XMFLOAT3 BoundsMin;
+	DirectX::XMFLOAT3 BoundsMax;
+	DirectX::XMFLOAT3 SphereCenter;
+	float SphereRadius;
+	MeshOptimizationStats Stats;
+	uint32_t LodCount;
+	MeshLod Lods[c_maxMeshLods];
+	uint32_t MeshletCount;
+};
+
+// Returns the path of the cache file that sits next to a source model
+std::wstring GetMeshCachePath(const std::wstring& a_sourcePath);
+
+// Hashes the source file's size and last write time, which is enough to notice
+// it changed without having to read it. Returns false if the file doesn't exist
+bool GetMeshSourceHash(const std::wstring& a_sourcePath, uint64_t& a_hash);
+
+// Computes the axis-aligned bounds of a set of vertices
+void CalculateBounds(const Vertex* a_vertices, size_t a_vertexCount, DirectX::XMFLOAT3& a_min, DirectX::XMFLOAT3& a_max);
+
+// Computes a bounding sphere around a set of vertices - not the smallest
+// possible, but usually within a few percent of it
+void CalculateBoundingSphere(const Vertex* a_vertices, size_t a_vertexCount, DirectX::XMFLOAT3& a_center, float& a_radius);
+
+// Writes a fully processed mesh out to a cache file. a_vertexData is the mesh's vertices
+// already packed in a_vertexFormat, relative to the bounds CalculateBounds() gives them
+bool WriteMeshCache(const std::wstring& a_cachePath, const MeshData& a_meshData, VertexFormat a_vertexFormat, const void* a_vertexData, const MeshOptimizationStats& a_stats, uint64_t a_sourceHash);
+
+// --------------------------------------------------------
+// A read-only view of a .mesh file mapped into memory
+//
+// Nothing is copied out of the file - the pointers returned
+// point directly into the mapping and are only valid for the
+// lifetime of this object
+// --------------------------------------------------------
+class MappedMeshCache
+{
+public:
+	MappedMeshCache();
+	~MappedMeshCache();
+
+	MappedMeshCache(MappedMeshCache const&) = delete;
+	void operator=(MappedMeshCache const&) = delete;
+
+	/* Maps the file and checks it against the expected source hash and vertex format, returning false if it's missing or stale */
+	bool Open(const std::wstring& a_cachePath, uint64_t a_sourceHash, VertexFormat a_vertexFormat);
+
+	/* Unmaps the file */
+	void Close();
+
+	const MeshCacheHeader& GetHeader();
+	const void* GetVertices();
+	const void* GetIndices();
+	const Meshlet* GetMeshlets();
+	DXGI_FORMAT GetIndexFormat();
+
+private:
+	HANDLE m_file;
+	HANDLE m_mapping;
+	const unsigned char* m_pView;
+};
@@ -0,0 +1,204 @@
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <algorithm>
+
+#include "MeshClusters.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Cones wider than this (the smallest cosine between the axis and a
+	// triangle normal) would almost never be culled, so they aren't tried
+	const float c_minConeCosine = 0.1f;
+
+	void AddMeshlet(MeshData& a_meshData, unsigned int a_indexStart, unsigned int a_indexCount)
+	{
+		Meshlet meshlet;
+		meshlet.IndexStart = a_indexStart;
+		meshlet.IndexCount = a_indexCount;
+		CalculateMeshletBounds(meshlet, a_meshData.Indices.data(), a_meshData.Vertices.data());
+		a_meshData.Meshlets.push_back(meshlet);
+	}
+}
+
+// --------------------------------------------------------
+// Walks the triangles in order, starting a new meshlet
+// whenever the next one would push the current one past
+// either limit. The vertex cache optimizer already keeps
+// neighboring triangles together, which is exactly what
+// makes the resulting clusters tight
+// --------------------------------------------------------
+void BuildMeshlets(MeshData& a_meshData)
+{
+	a_meshData.Meshlets.clear();
+
+	size_t indexCount = a_meshData.Lods.empty() ? a_meshData.Indices.size() : a_meshData.Lods[0].IndexCount;
+	const unsigned int* indices = a_meshData.Indices.data();
+
+	// Which meshlet each vertex was last added to
+	std::vector<unsigned int> vertexMeshlet(a_meshData.Vertices.size(), UINT_MAX);
+	unsigned int meshletId = 0;
+	unsigned int meshletStart = 0;
+	size_t meshletVertices = 0;
+
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		size_t newVertices = 0;
+		for (int c = 0; c < 3; c++)
+		{
+			bool isRepeat = (c > 0 && indices[i + c] == indices[i]) || (c > 1 && indices[i + c] == indices[i + 1]);
+			if (vertexMeshlet[indices[i + c]] != meshletId && !isRepeat)
+				newVertices++;
+		}
+
+		size_t meshletTriangles = (i - meshletStart) / 3;
+		if (meshletVertices + newVertices > c_maxMeshletVertices || meshletTriangles + 1 > c_maxMeshletTriangles)
+		{
+			AddMeshlet(a_meshData, meshletStart, (unsigned int)(i - meshletStart));
+			meshletId++;
+			meshletStart = (unsigned int)i;
+			meshletVertices = 0;
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			if (vertexMeshlet[indices[i + c]] != meshletId)
+			{
+				vertexMeshlet[indices[i + c]] = meshletId;
+				meshletVertices++;
+			}
+		}
+	}
+
+	if (indexCount > meshletStart)
+		AddMeshlet(a_meshData, meshletStart, (unsigned int)(indexCount - meshletStart));
+}
+
+// --------------------------------------------------------
+// The sphere is centered on the meshlet's bounding box.
+// The cone's axis is the average triangle normal and it's
+// as wide as the normal furthest from that. Its apex is
+// pulled back along the axis until every triangle's plane
+// is in front of it, so any camera inside the (opposite)
+// cone sees only the backs of the triangles
+// --------------------------------------------------------
+void CalculateMeshletBounds(Meshlet& a_meshlet, const unsigned int* a_indices, const Vertex* a_verts)
+{
+	const unsigned int* indices = a_indices + a_meshlet.IndexStart;
+	size_t triangleCount = a_meshlet.IndexCount / 3;
+
+	XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+	XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+	for (size_t i = 0; i < a_meshlet.IndexCount; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&a_verts[indices[i]].Position);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+	XMVECTOR center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+
+	float radiusSq = 0.0f;
+	for (size_t i = 0; i < a_meshlet.IndexCount; i++)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&a_verts[indices[i]].Position), center);
+		radiusSq = (std::max)(radiusSq, XMVectorGetX(XMVector3LengthSq(offset)));
+	}
+	XMStoreFloat3(&a_meshlet.Center, center);
+	a_meshlet.Radius = sqrtf(radiusSq);
+
+	// Start out with a cone that never culls, in case there's
+	// nothing better to be had
+	a_meshlet.ConeApex = a_meshlet.Center;
+	a_meshlet.ConeAxis = XMFLOAT3(0, 0, 1);
+	a_meshlet.ConeCutoff = 1.0f;
+
+	std::vector<XMVECTOR> normals;
+	normals.reserve(triangleCount);
+	XMVECTOR axis = XMVectorZero();
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&a_verts[indices[t * 3 + 0]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&a_verts[indices[t * 3 + 1]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&a_verts[indices[t * 3 + 2]].Position);
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+
+		// Degenerate triangles can't be seen from either side
+		if (XMVectorGetX(XMVector3LengthSq(normal)) <= 0.0f)
+		{
+			normals.push_back(XMVectorZero());
+			continue;
+		}
+
+		normal = XMVector3Normalize(normal);
+		normals.push_back(normal);
+		axis = XMVectorAdd(axis, normal);
+	}
+
+	if (XMVectorGetX(XMVector3LengthSq(axis)) <= 0.0f)
+		return;
+	axis = XMVector3Normalize(axis);
+
+	float minCosine = 1.0f;
+	for (const XMVECTOR& normal : normals)
+	{
+		if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+			minCosine = (std::min)(minCosine, XMVectorGetX(XMVector3Dot(axis, normal)));
+	}
+	if (minCosine <= c_minConeCosine)
+		return;
+
+	float maxDistance = 0.0f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		if (XMVectorGetX(XMVector3LengthSq(normals[t])) <= 0.0f)
+			continue;
+
+		// How far back along the axis the center has to move
+		// to get behind this triangle's plane
+		XMVECTOR p0 = XMLoadFloat3(&a_verts[indices[t * 3]].Position);
+		float distance = XMVectorGetX(XMVector3Dot(XMVectorSubtract(center, p0), normals[t])) / XMVectorGetX(XMVector3Dot(axis, normals[t]));
+		maxDistance = (std::max)(maxDistance, distance);
+	}
+
+	XMStoreFloat3(&a_meshlet.ConeApex, XMVectorSubtract(center, XMVectorScale(axis, maxDistance)));
+	XMStoreFloat3(&a_meshlet.ConeAxis, axis);
+	a_meshlet.ConeCutoff = sqrtf(1.0f - minCosine * minCosine);
+}
+
+bool IsMeshletCulled(const Meshlet& a_meshlet, const Frustum& a_localFrustum, FXMVECTOR a_localCameraPosition, bool a_isConeCullingAllowed)
+{
+	if (IsSphereOutsideFrustum(a_localFrustum, XMLoadFloat3(&a_meshlet.Center), a_meshlet.Radius))
+		return true;
+
+	if (!a_isConeCullingAllowed || a_meshlet.ConeCutoff >= 1.0f)
+		return false;
+
+	XMVECTOR view = XMVector3Normalize(XMVectorSubtract(XMLoadFloat3(&a_meshlet.ConeApex), a_localCameraPosition));
+	return XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&a_meshlet.ConeAxis))) >= a_meshlet.ConeCutoff;
+}
+
+size_t CullMeshlets(const Meshlet* a_meshlets, size_t a_meshletCount, const Frustum& a_localFrustum, const XMFLOAT3& a_localCameraPosition, bool a_isConeCullingAllowed, std::vector<IndexRange>& a_ranges)
+{
+	a_ranges.clear();
+
+	XMVECTOR cameraPosition = XMLoadFloat3(&a_localCameraPosition);
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < a_meshletCount; i++)
+	{
+		const Meshlet& meshlet = a_meshlets[i];
+		if (IsMeshletCulled(meshlet, a_localFrustum, cameraPosition, a_isConeCullingAllowed))
+			continue;
+
+		// Meshlets are laid out back to back, so neighbors that both
+		// survive can go out in a single draw
+		if (!a_ranges.empty() && a_ranges.back().IndexStart + a_ranges.back().IndexCount == meshlet.IndexStart)
+			a_ranges.back().IndexCount += meshlet.IndexCount;
+		else
+			a_ranges.push_back({ meshlet.IndexStart, meshlet.IndexCount });
+		visibleCount++;
+	}
+	return visibleCount;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include "MeshData.h"
+#include "Frustum.h"
+
+// A contiguous run of indices to hand to DrawIndexed
+struct IndexRange
+{
+	unsigned int IndexStart;
+	unsigned int IndexCount;
+};
+
+// Splits the full detail level of a mesh (LOD0, or all of Indices if it has no
+// levels) into meshlets of at most c_maxMeshletVertices vertices and
+// c_maxMeshletTriangles triangles. Triangles keep their (cache optimized) order,
+// so every meshlet is one contiguous range of the index buffer
+void BuildMeshlets(MeshData& a_meshData);
+
+// Computes the bounding sphere and normal cone of a meshlet's triangles
+void CalculateMeshletBounds(Meshlet& a_meshlet, const unsigned int* a_indices, const Vertex* a_verts);
+
+// Returns true if the meshlet is entirely outside the frustum or, when cones are
+// allowed, every one of its triangles faces away from the camera. The frustum and
+// camera position must both be in the mesh's local space
+bool IsMeshletCulled(const Meshlet& a_meshlet, const Frustum& a_localFrustum, DirectX::FXMVECTOR a_localCameraPosition, bool a_isConeCullingAllowed);
+
+// Culls every meshlet and replaces a_ranges with the index ranges of the ones that
+// survive, merging neighbors into a single range. Returns how many survived
+size_t CullMeshlets(const Meshlet* a_meshlets, size_t a_meshletCount, const Frustum& a_localFrustum, const DirectX::XMFLOAT3& a_localCameraPosition, bool a_isConeCullingAllowed, std::vector<IndexRange>& a_ranges);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "Vertex.h"
+
+// Most levels of detail a mesh will carry, including the full mesh
+const size_t c_maxMeshLods = 4;
+
+// --------------------------------------------------------
+// One level of detail - a range of the index buffer. Level
+// 0 is the full mesh and every level after it is a coarser
+// copy drawn with the same vertices
+// --------------------------------------------------------
+struct MeshLod
+{
+	unsigned int IndexStart = 0;
+	unsigned int IndexCount = 0;
+	float Error = 0.0f;	// Furthest this level strays from the full mesh, in local units
+};
+
+// Most vertices and triangles a single meshlet will hold
+const size_t c_maxMeshletVertices = 64;
+const size_t c_maxMeshletTriangles = 124;
+
+// --------------------------------------------------------
+// A small cluster of neighboring triangles - a range of
+// the full detail mesh's indices - along with the bounds
+// needed to cull it on the CPU before it's drawn
+// --------------------------------------------------------
+struct Meshlet
+{
+	unsigned int IndexStart = 0;
+	unsigned int IndexCount = 0;
+	DirectX::XMFLOAT3 Center;		// Bounding sphere, in local space
+	float Radius = 0.0f;
+	DirectX::XMFLOAT3 ConeApex;		// Every triangle faces away from a camera that looks
+	DirectX::XMFLOAT3 ConeAxis;		// down the axis from within this cone behind the apex
+	float ConeCutoff = 1.0f;		// Sine of the cone's half angle, 1 when it can never be culled
+};
+
+// Whether a mesh with this many vertices can use 16-bit indices, which
+// halves the index buffer and the bandwidth needed to read it
+inline bool CanUseShortIndices(size_t a_vertexCount) { return a_vertexCount <= 0xFFFF; }
+
+// --------------------------------------------------------
+// CPU-side geometry for a single mesh
+//
+// This is what the loaders produce and what Mesh uploads
+// to the GPU - nothing in here touches Direct3D
+// --------------------------------------------------------
+struct MeshData
+{
+	std::vector<Vertex> Vertices;
+	std::vector<unsigned int> Indices;
+	std::vector<MeshLod> Lods;	// Empty until GenerateLods() splits Indices into levels
+	std::vector<Meshlet> Meshlets;	// Empty until BuildMeshlets() splits up the full detail level
+};
@@ -0,0 +1,400 @@
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshOptimizer.h"
+
+namespace
+{
+	// Tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+	const int c_maxCacheSize = 32;
+	const float c_cacheDecayPower = 1.5f;
+	const float c_lastTriangleScore = 0.75f;
+	const float c_valenceBoostScale = 2.0f;
+	const float c_valenceBoostPower = 0.5f;
+
+	const unsigned int c_unused = 0xFFFFFFFF;
+
+	// How much worse (as a ratio of ACMR) sorting clusters for overdraw
+	// may leave the vertex cache - the same 5% Sander et al. allow
+	const float c_maxOverdrawCacheCost = 1.05f;
+
+	// Scores a vertex by where it sits in the simulated cache and how many
+	// triangles still need it - low valence vertices get a boost so they
+	// are finished off rather than left stranded
+	float VertexScore(int a_cachePosition, unsigned int a_activeTriangles)
+	{
+		if (a_activeTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (a_cachePosition >= 0)
+		{
+			// The three verts of the last triangle all get the same score
+			// so there's no bias towards which edge is continued
+			if (a_cachePosition < 3)
+				score = c_lastTriangleScore;
+			else
+			{
+				const float scaler = 1.0f / (c_maxCacheSize - 3);
+				score = powf(1.0f - (a_cachePosition - 3) * scaler, c_cacheDecayPower);
+			}
+		}
+
+		score += c_valenceBoostScale * powf((float)a_activeTriangles, -c_valenceBoostPower);
+		return score;
+	}
+}
+
+// --------------------------------------------------------
+// Simulates a FIFO post-transform cache over the index buffer
+// and counts how many vertices would have to be shaded
+// --------------------------------------------------------
+VertexCacheStats AnalyzeVertexCache(const unsigned int* a_indices, size_t a_indexCount, size_t a_vertexCount, unsigned int a_cacheSize)
+{
+	VertexCacheStats stats;
+	if (a_indexCount < 3 || a_vertexCount == 0)
+		return stats;
+
+	// Each vertex remembers when it entered the cache, so checking
+	// for a hit is one compare instead of a search
+	std::vector<size_t> cacheEntryTime(a_vertexCount, 0);
+	size_t cacheTime = a_cacheSize + 1;
+	size_t misses = 0;
+
+	for (size_t i = 0; i < a_indexCount; i++)
+	{
+		unsigned int index = a_indices[i];
+		if (cacheTime - cacheEntryTime[index] > a_cacheSize)
+		{
+			cacheEntryTime[index] = cacheTime++;
+			misses++;
+		}
+	}
+
+	stats.ACMR = (float)misses / (a_indexCount / 3);
+	stats.ATVR = (float)misses / a_vertexCount;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Reorders triangles so that consecutive triangles share
+// as many vertices as possible, using Forsyth's greedy
+// scoring approach with a simulated LRU cache
+// --------------------------------------------------------
+void OptimizeVertexCache(unsigned int* a_indices, size_t a_indexCount, size_t a_vertexCount)
+{
+	size_t triangleCount = a_indexCount / 3;
+	if (triangleCount == 0 || a_vertexCount == 0)
+		return;
+
+	// Build vertex -> triangle adjacency as one flat array, where each
+	// vertex's still-unemitted triangles sit at the front of its range
+	std::vector<unsigned int> activeCounts(a_vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+		activeCounts[a_indices[i]]++;
+
+	std::vector<unsigned int> offsets(a_vertexCount + 1, 0);
+	for (size_t v = 0; v < a_vertexCount; v++)
+		offsets[v + 1] = offsets[v] + activeCounts[v];
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int k = 0; k < 3; k++)
+			adjacency[fill[a_indices[t * 3 + k]]++] = (unsigned int)t;
+	}
+
+	// Initial scores
+	std::vector<int> cachePositions(a_vertexCount, -1);
+	std::vector<float> vertexScores(a_vertexCount);
+	for (size_t v = 0; v < a_vertexCount; v++)
+		vertexScores[v] = VertexScore(-1, activeCounts[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> isEmitted(triangleCount, false);
+	int bestTriangle = -1;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScores[t] =
+			vertexScores[a_indices[t * 3]] +
+			vertexScores[a_indices[t * 3 + 1]] +
+			vertexScores[a_indices[t * 3 + 2]];
+
+		if (triangleScores[t] > bestScore)
+		{
+			bestScore = triangleScores[t];
+			bestTriangle = (int)t;
+		}
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+
+	unsigned int cache[c_maxCacheSize + 3];
+	int cacheCount = 0;
+	size_t nextUnemitted = 0;
+
+	while (bestTriangle >= 0)
+	{
+		const unsigned int* tri = &a_indices[bestTriangle * 3];
+		isEmitted[bestTriangle] = true;
+		output.push_back(tri[0]);
+		output.push_back(tri[1]);
+		output.push_back(tri[2]);
+
+		// The emitted triangle's verts go to the front of the cache and
+		// the triangle is removed from each of their active lists
+		unsigned int newCache[c_maxCacheSize + 3];
+		int newCount = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = tri[k];
+			newCache[newCount++] = v;
+
+			unsigned int* list = &adjacency[offsets[v]];
+			unsigned int count = activeCounts[v];
+			for (unsigned int a = 0; a < count; a++)
+			{
+				if (list[a] == (unsigned int)bestTriangle)
+				{
+					list[a] = list[count - 1];
+					list[count - 1] = (unsigned int)bestTriangle;
+					activeCounts[v]--;
+					break;
+				}
+			}
+		}
+		for (int c = 0; c < cacheCount; c++)
+		{
+			unsigned int v = cache[c];
+			if (v != tri[0] && v != tri[1] && v != tri[2])
+				newCache[newCount++] = v;
+		}
+
+		// Rescore everything that moved (including anything that just fell
+		// out of the cache) and push the change onto their triangles
+		for (int c = 0; c < newCount; c++)
+		{
+			unsigned int v = newCache[c];
+			cachePositions[v] = (c < c_maxCacheSize) ? c : -1;
+
+			float newScore = VertexScore(cachePositions[v], activeCounts[v]);
+			float delta = newScore - vertexScores[v];
+			vertexScores[v] = newScore;
+
+			const unsigned int* list = &adjacency[offsets[v]];
+			for (unsigned int a = 0; a < activeCounts[v]; a++)
+				triangleScores[list[a]] += delta;
+		}
+
+		cacheCount = (newCount < c_maxCacheSize) ? newCount : c_maxCacheSize;
+		for (int c = 0; c < cacheCount; c++)
+			cache[c] = newCache[c];
+
+		// The next triangle is the best one touching the cache
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for (int c = 0; c < cacheCount; c++)
+		{
+			unsigned int v = cache[c];
+			const unsigned int* list = &adjacency[offsets[v]];
+			for (unsigned int a = 0; a < activeCounts[v]; a++)
+			{
+				if (triangleScores[list[a]] > bestScore)
+				{
+					bestScore = triangleScores[list[a]];
+					bestTriangle = (int)list[a];
+				}
+			}
+		}
+
+		// Nothing in the cache has work left, so start a new island
+		if (bestTriangle < 0)
+		{
+			while (nextUnemitted < triangleCount && isEmitted[nextUnemitted])
+				nextUnemitted++;
+			if (nextUnemitted < triangleCount)
+				bestTriangle = (int)nextUnemitted;
+		}
+	}
+
+	memcpy(a_indices, output.data(), output.size() * sizeof(unsigned int));
+}
+
+// --------------------------------------------------------
+// Splits the cache-optimized triangle list into clusters
+// wherever the cache would start cold, then sorts those
+// clusters so outward-facing ones on the outside of the mesh
+// draw first and occlude the rest (Sander et al., "Fast
+// Triangle Reordering for Vertex Locality and Reduced Overdraw")
+//
+// Moving a cluster can still cost hits - its later triangles
+// may have reused vertices the previous cluster left in the
+// cache - so the new order is only kept if its ACMR stays
+// within c_maxOverdrawCacheCost of the order it replaces
+// --------------------------------------------------------
+void OptimizeOverdraw(unsigned int* a_indices, size_t a_indexCount, const std::vector<Vertex>& a_vertices)
+{
+	size_t triangleCount = a_indexCount / 3;
+	if (triangleCount == 0 || a_vertices.empty())
+		return;
+
+	// Find cluster boundaries: a triangle whose three verts all miss
+	// the cache doesn't lean on the triangles before it, so it's
+	// where moving things around costs the fewest hits
+	const size_t cacheSize = 16;
+	std::vector<size_t> cacheEntryTime(a_vertices.size(), 0);
+	size_t cacheTime = cacheSize + 1;
+	std::vector<size_t> clusterStarts;
+
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int index = a_indices[t * 3 + k];
+			if (cacheTime - cacheEntryTime[index] > cacheSize)
+			{
+				cacheEntryTime[index] = cacheTime++;
+				misses++;
+			}
+		}
+
+		if (t == 0 || misses == 3)
+			clusterStarts.push_back(t);
+	}
+	clusterStarts.push_back(triangleCount);
+
+	size_t clusterCount = clusterStarts.size() - 1;
+	if (clusterCount < 2)
+		return;
+
+	// Mesh centroid, for judging how far "out" each cluster sits
+	float meshCenter[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t v = 0; v < a_vertices.size(); v++)
+	{
+		meshCenter[0] += a_vertices[v].Position.x;
+		meshCenter[1] += a_vertices[v].Position.y;
+		meshCenter[2] += a_vertices[v].Position.z;
+	}
+	for (int k = 0; k < 3; k++)
+		meshCenter[k] /= (float)a_vertices.size();
+
+	// Sort key is the cluster's area-weighted normal dotted with the
+	// direction from the mesh center to the cluster's center
+	std::vector<float> sortKeys(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		float center[3] = { 0.0f, 0.0f, 0.0f };
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		float area = 0.0f;
+
+		for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const DirectX::XMFLOAT3& p0 = a_vertices[a_indices[t * 3]].Position;
+			const DirectX::XMFLOAT3& p1 = a_vertices[a_indices[t * 3 + 1]].Position;
+			const DirectX::XMFLOAT3& p2 = a_vertices[a_indices[t * 3 + 2]].Position;
+
+			float e1[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			float e2[3] = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+
+			// Clockwise front faces in a left-handed space, so e1 x e2 points out
+			float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0] };
+			float triArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			center[0] += (p0.x + p1.x + p2.x) / 3.0f * triArea;
+			center[1] += (p0.y + p1.y + p2.y) / 3.0f * triArea;
+			center[2] += (p0.z + p1.z + p2.z) / 3.0f * triArea;
+			for (int k = 0; k < 3; k++)
+				normal[k] += n[k];
+			area += triArea;
+		}
+
+		float key = 0.0f;
+		if (area > 0.0f)
+		{
+			float normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (int k = 0; k < 3; k++)
+			{
+				float toCluster = center[k] / area - meshCenter[k];
+				key += toCluster * (normalLength > 0.0f ? normal[k] / normalLength : 0.0f);
+			}
+		}
+		sortKeys[c] = key;
+	}
+
+	std::vector<unsigned int> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+		order[c] = (unsigned int)c;
+	std::stable_sort(order.begin(), order.end(),
+		[&sortKeys](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		size_t first = clusterStarts[order[c]] * 3;
+		size_t last = clusterStarts[order[c] + 1] * 3;
+		output.insert(output.end(), a_indices + first, a_indices + last);
+	}
+
+	float acmrBefore = AnalyzeVertexCache(a_indices, a_indexCount, a_vertices.size()).ACMR;
+	float acmrAfter = AnalyzeVertexCache(output.data(), output.size(), a_vertices.size()).ACMR;
+	if (acmrAfter > acmrBefore * c_maxOverdrawCacheCost)
+		return;
+
+	memcpy(a_indices, output.data(), output.size() * sizeof(unsigned int));
+}
+
+// --------------------------------------------------------
+// Renumbers vertices in first-use order so the input
+// assembler walks the vertex buffer roughly linearly
+// --------------------------------------------------------
+void OptimizeVertexFetch(MeshData& a_meshData)
+{
+	std::vector<Vertex>& vertices = a_meshData.Vertices;
+	std::vector<unsigned int>& indices = a_meshData.Indices;
+
+	std::vector<unsigned int> remap(vertices.size(), c_unused);
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		unsigned int& newIndex = remap[indices[i]];
+		if (newIndex == c_unused)
+		{
+			newIndex = (unsigned int)reordered.size();
+			reordered.push_back(vertices[indices[i]]);
+		}
+		indices[i] = newIndex;
+	}
+
+	vertices.swap(reordered);
+}
+
+// --------------------------------------------------------
+// Triangle order first (for the post-transform cache),
+// then clusters of it for overdraw, then vertex order to
+// match it all (for pre-transform fetch)
+// --------------------------------------------------------
+MeshOptimizationStats OptimizeMesh(MeshData& a_meshData)
+{
+	MeshOptimizationStats stats;
+	stats.Before = AnalyzeVertexCache(a_meshData.Indices.data(), a_meshData.Indices.size(), a_meshData.Vertices.size());
+
+	OptimizeVertexCache(a_meshData.Indices.data(), a_meshData.Indices.size(), a_meshData.Vertices.size());
+	OptimizeOverdraw(a_meshData.Indices.data(), a_meshData.Indices.size(), a_meshData.Vertices);
+	OptimizeVertexFetch(a_meshData);
+
+	stats.After = AnalyzeVertexCache(a_meshData.Indices.data(), a_meshData.Indices.size(), a_meshData.Vertices.size());
+	return stats;
+}
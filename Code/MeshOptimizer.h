@@ -0,0 +1,43 @@
+#pragma once
+
+#include "MeshData.h"
+
+// --------------------------------------------------------
+// Post-transform vertex cache statistics for an index buffer
+//
+// ACMR - Average Cache Miss Ratio (transformed verts per triangle)
+//        0.5 is the theoretical best, 3.0 is the worst
+// ATVR - Average Transform to Vertex Ratio (transformed verts per vertex)
+//        1.0 is perfect - every vertex shaded exactly once
+// --------------------------------------------------------
+struct VertexCacheStats
+{
+	float ACMR = 0.0f;
+	float ATVR = 0.0f;
+};
+
+// Statistics from before and after OptimizeMesh ran
+struct MeshOptimizationStats
+{
+	VertexCacheStats Before;
+	VertexCacheStats After;
+};
+
+// Simulates a FIFO post-transform cache of the given size over the index buffer
+VertexCacheStats AnalyzeVertexCache(const unsigned int* a_indices, size_t a_indexCount, size_t a_vertexCount, unsigned int a_cacheSize = 16);
+
+// Reorders triangles for post-transform cache locality (Forsyth's algorithm)
+void OptimizeVertexCache(unsigned int* a_indices, size_t a_indexCount, size_t a_vertexCount);
+
+// Reorders clusters of an already cache-optimized index buffer so
+// outward-facing surfaces draw first, unless that would undo more
+// than a little of the cache work (it's left alone in that case)
+void OptimizeOverdraw(unsigned int* a_indices, size_t a_indexCount, const std::vector<Vertex>& a_vertices);
+
+// Reorders vertices into the order the index buffer first uses them,
+// dropping any that are never referenced
+void OptimizeVertexFetch(MeshData& a_meshData);
+
+// Runs the full optimization pipeline on a mesh that is about to be
+// uploaded, returning cache statistics from before and after
+MeshOptimizationStats OptimizeMesh(MeshData& a_meshData);
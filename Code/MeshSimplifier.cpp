@@ -0,0 +1,575 @@
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Border edges get planes of their own so collapses can't drag them
+	// inwards - weighted well above the faces so borders keep their shape
+	const float c_borderWeight = 10.0f;
+
+	// Largest error a level of detail may have, as a fraction of the mesh's size
+	const float c_maxLodError = 0.02f;
+
+	// A level has to drop at least this fraction of the previous
+	// level's triangles to be worth a slot of its own
+	const float c_minLodReduction = 0.15f;
+
+	// How a vertex position is allowed to move
+	// - Manifold: surrounded by triangles, can collapse onto any neighbor
+	// - Border: on an open edge, can only slide along that edge
+	// - Seam: split in two by a UV/normal seam, can only slide along the
+	//    seam, taking both of its vertices with it
+	// - Locked: anywhere messier than that, never moves
+	enum class VertexKind : unsigned char
+	{
+		Manifold,
+		Border,
+		Seam,
+		Locked
+	};
+
+	// --------------------------------------------------------
+	// Quadric error metric (Garland & Heckbert): the summed
+	// squared distance to a set of planes, kept as a symmetric
+	// 4x4 matrix so any number of planes add up into the same
+	// ten numbers. Weight is the total weight of the planes
+	// --------------------------------------------------------
+	struct Quadric
+	{
+		float A00, A11, A22;
+		float A10, A20, A21;
+		float B0, B1, B2;
+		float C;
+		float Weight;
+	};
+
+	// Quadric of the plane ax + by + cz + d = 0, with (a, b, c) unit length
+	Quadric PlaneQuadric(float a_a, float a_b, float a_c, float a_d, float a_weight)
+	{
+		Quadric q;
+		q.A00 = a_a * a_a * a_weight;
+		q.A11 = a_b * a_b * a_weight;
+		q.A22 = a_c * a_c * a_weight;
+		q.A10 = a_b * a_a * a_weight;
+		q.A20 = a_c * a_a * a_weight;
+		q.A21 = a_c * a_b * a_weight;
+		q.B0 = a_a * a_d * a_weight;
+		q.B1 = a_b * a_d * a_weight;
+		q.B2 = a_c * a_d * a_weight;
+		q.C = a_d * a_d * a_weight;
+		q.Weight = a_weight;
+		return q;
+	}
+
+	void AddQuadric(Quadric& a_sum, const Quadric& a_q)
+	{
+		a_sum.A00 += a_q.A00;
+		a_sum.A11 += a_q.A11;
+		a_sum.A22 += a_q.A22;
+		a_sum.A10 += a_q.A10;
+		a_sum.A20 += a_q.A20;
+		a_sum.A21 += a_q.A21;
+		a_sum.B0 += a_q.B0;
+		a_sum.B1 += a_q.B1;
+		a_sum.B2 += a_q.B2;
+		a_sum.C += a_q.C;
+		a_sum.Weight += a_q.Weight;
+	}
+
+	// Weighted mean squared distance from the point to the quadric's planes
+	float QuadricError(const Quadric& a_q, const XMFLOAT3& a_p)
+	{
+		float rx = a_q.B0 + a_q.A10 * a_p.y;
+		float ry = a_q.B1 + a_q.A21 * a_p.z;
+		float rz = a_q.B2 + a_q.A20 * a_p.x;
+		rx = rx * 2.0f + a_q.A00 * a_p.x;
+		ry = ry * 2.0f + a_q.A11 * a_p.y;
+		rz = rz * 2.0f + a_q.A22 * a_p.z;
+
+		float r = a_q.C + rx * a_p.x + ry * a_p.y + rz * a_p.z;
+		return (a_q.Weight > 0.0f) ? fabsf(r) / a_q.Weight : 0.0f;
+	}
+
+	XMVECTOR TriangleNormal(const XMFLOAT3& a_p0, const XMFLOAT3& a_p1, const XMFLOAT3& a_p2)
+	{
+		XMVECTOR p0 = XMLoadFloat3(&a_p0);
+		return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&a_p1), p0), XMVectorSubtract(XMLoadFloat3(&a_p2), p0));
+	}
+
+	// Directed edge between two positions, packed for sorting and searching
+	inline unsigned long long EdgeKey(unsigned int a_from, unsigned int a_to)
+	{
+		return ((unsigned long long)a_from << 32) | a_to;
+	}
+
+	inline bool HasEdge(const std::vector<unsigned long long>& a_edges, unsigned int a_from, unsigned int a_to)
+	{
+		return std::binary_search(a_edges.begin(), a_edges.end(), EdgeKey(a_from, a_to));
+	}
+
+	// An edge is open (on a border) if no triangle runs along it the other way
+	inline bool IsOpenEdge(const std::vector<unsigned long long>& a_edges, unsigned int a_a, unsigned int a_b)
+	{
+		return (HasEdge(a_edges, a_a, a_b) && !HasEdge(a_edges, a_b, a_a)) ||
+			(HasEdge(a_edges, a_b, a_a) && !HasEdge(a_edges, a_a, a_b));
+	}
+
+	// Every directed edge of the triangles, between positions rather than vertices
+	void BuildEdges(const unsigned int* a_indices, size_t a_indexCount, const std::vector<unsigned int>& a_positionIds, std::vector<unsigned long long>& a_edges)
+	{
+		a_edges.clear();
+		a_edges.reserve(a_indexCount);
+		for (size_t i = 0; i < a_indexCount; i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int from = a_positionIds[a_indices[i + e]];
+				unsigned int to = a_positionIds[a_indices[i + (e + 1) % 3]];
+				a_edges.push_back(EdgeKey(from, to));
+			}
+		}
+		std::sort(a_edges.begin(), a_edges.end());
+	}
+
+	// Largest side of the mesh's bounding box
+	float MeshExtent(const Vertex* a_verts, size_t a_vertexCount, XMFLOAT3& a_min)
+	{
+		if (a_vertexCount == 0)
+		{
+			a_min = XMFLOAT3(0, 0, 0);
+			return 0.0f;
+		}
+
+		XMVECTOR minimum = XMLoadFloat3(&a_verts[0].Position);
+		XMVECTOR maximum = minimum;
+		for (size_t i = 1; i < a_vertexCount; i++)
+		{
+			XMVECTOR position = XMLoadFloat3(&a_verts[i].Position);
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+
+		XMFLOAT3 extent;
+		XMStoreFloat3(&a_min, minimum);
+		XMStoreFloat3(&extent, XMVectorSubtract(maximum, minimum));
+		return (std::max)(extent.x, (std::max)(extent.y, extent.z));
+	}
+
+	// A collapse moves every triangle using From's position onto To's
+	struct Collapse
+	{
+		unsigned int From;
+		unsigned int To;
+		float Error;
+	};
+}
+
+// --------------------------------------------------------
+// Edge collapse simplification, in passes. Each pass finds
+// every allowed collapse, sorts them by error and performs
+// the cheapest ones that don't overlap each other
+//
+// Vertices that only differ by UVs/normals share a position
+// and are treated as one. Positions on such a seam are
+// locked, so the texture mapping never tears, and border
+// positions can only slide along the border. Collapses
+// always land on an existing vertex, which is what lets
+// every level share the original vertex buffer
+// --------------------------------------------------------
+size_t SimplifyMesh(unsigned int* a_destination, const unsigned int* a_indices, size_t a_indexCount, const Vertex* a_verts, size_t a_vertexCount, size_t a_targetIndexCount, float a_targetError, float* a_pResultError)
+{
+	size_t indexCount = a_indexCount - a_indexCount % 3;
+	memmove(a_destination, a_indices, indexCount * sizeof(unsigned int));
+	if (a_pResultError)
+		*a_pResultError = 0.0f;
+
+	// Work in a unit-sized copy of the mesh so the quadrics stay well conditioned
+	XMFLOAT3 boundsMin;
+	float extent = MeshExtent(a_verts, a_vertexCount, boundsMin);
+	if (indexCount <= a_targetIndexCount || extent <= 0.0f)
+		return indexCount;
+
+	float scale = 1.0f / extent;
+	std::vector<XMFLOAT3> positions(a_vertexCount);
+	for (size_t i = 0; i < a_vertexCount; i++)
+	{
+		positions[i].x = (a_verts[i].Position.x - boundsMin.x) * scale;
+		positions[i].y = (a_verts[i].Position.y - boundsMin.y) * scale;
+		positions[i].z = (a_verts[i].Position.z - boundsMin.z) * scale;
+	}
+
+	// Give vertices with identical positions the same position id (the
+	// lowest vertex index among them). Vertices that also match in normal
+	// and UV are interchangeable, so the triangles all use the first one
+	// - Tangents are left out of the comparison, since they're built
+	//    per vertex and rarely come out bit-identical
+	std::vector<unsigned int> sorted(a_vertexCount);
+	for (size_t i = 0; i < a_vertexCount; i++)
+		sorted[i] = (unsigned int)i;
+	auto compareAttributes = [&](unsigned int a_a, unsigned int a_b) {
+		const Vertex& a = a_verts[a_a];
+		const Vertex& b = a_verts[a_b];
+		int position = memcmp(&a.Position, &b.Position, sizeof(XMFLOAT3));
+		if (position != 0) return position;
+		int normal = memcmp(&a.Normal, &b.Normal, sizeof(XMFLOAT3));
+		if (normal != 0) return normal;
+		return memcmp(&a.UV, &b.UV, sizeof(XMFLOAT2));
+	};
+	std::sort(sorted.begin(), sorted.end(), [&](unsigned int a_a, unsigned int a_b) {
+		int order = compareAttributes(a_a, a_b);
+		return (order != 0) ? order < 0 : a_a < a_b;
+	});
+
+	std::vector<unsigned int> positionIds(a_vertexCount);
+	std::vector<unsigned int> canonical(a_vertexCount);
+	for (size_t i = 0; i < a_vertexCount; i++)
+	{
+		unsigned int v = sorted[i];
+		unsigned int previous = (i > 0) ? sorted[i - 1] : v;
+		bool isSamePosition = (i > 0) && memcmp(&a_verts[v].Position, &a_verts[previous].Position, sizeof(XMFLOAT3)) == 0;
+		bool isSameVertex = isSamePosition && compareAttributes(v, previous) == 0;
+		positionIds[v] = isSamePosition ? positionIds[previous] : v;
+		canonical[v] = isSameVertex ? canonical[previous] : v;
+	}
+	for (size_t i = 0; i < indexCount; i++)
+		a_destination[i] = canonical[a_destination[i]];
+
+	// Count the distinct vertices (wedges) in use at each position,
+	// remembering the other one wherever there are exactly two
+	std::vector<unsigned int> copies(a_vertexCount, 0);
+	std::vector<unsigned int> otherWedge(a_vertexCount);
+	std::vector<unsigned int> firstWedge(a_vertexCount);
+	std::vector<char> isUsed(a_vertexCount, 0);
+	for (size_t i = 0; i < indexCount; i++)
+		isUsed[a_destination[i]] = 1;
+	for (size_t i = 0; i < a_vertexCount; i++)
+	{
+		if (!isUsed[i])
+			continue;
+
+		unsigned int p = positionIds[i];
+		if (copies[p] == 0)
+			firstWedge[p] = (unsigned int)i;
+		else
+		{
+			otherWedge[i] = firstWedge[p];
+			otherWedge[firstWedge[p]] = (unsigned int)i;
+		}
+		copies[p]++;
+	}
+
+	// Classify every position by its open edges and copies
+	std::vector<unsigned long long> edges;
+	BuildEdges(a_destination, indexCount, positionIds, edges);
+
+	std::vector<unsigned int> openOut(a_vertexCount, 0);
+	std::vector<unsigned int> openIn(a_vertexCount, 0);
+	std::vector<VertexKind> kinds(a_vertexCount, VertexKind::Manifold);
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		unsigned int from = (unsigned int)(edges[i] >> 32);
+		unsigned int to = (unsigned int)(edges[i] & 0xFFFFFFFF);
+
+		// The same directed edge twice means the surface folds over itself there
+		if (i > 0 && edges[i] == edges[i - 1])
+		{
+			kinds[from] = VertexKind::Locked;
+			kinds[to] = VertexKind::Locked;
+		}
+		if (!HasEdge(edges, to, from))
+		{
+			openOut[from]++;
+			openIn[to]++;
+		}
+	}
+	for (size_t i = 0; i < a_vertexCount; i++)
+	{
+		if (positionIds[i] != i || kinds[i] == VertexKind::Locked)
+			continue;
+
+		bool isClosed = openOut[i] == 0 && openIn[i] == 0;
+		if (copies[i] == 2 && isClosed)
+			kinds[i] = VertexKind::Seam;
+		else if (copies[i] > 1)
+			kinds[i] = VertexKind::Locked;
+		else if (isClosed)
+			kinds[i] = VertexKind::Manifold;
+		else if (openOut[i] == 1 && openIn[i] == 1)
+			kinds[i] = VertexKind::Border;
+		else
+			kinds[i] = VertexKind::Locked;
+	}
+
+	// Every position starts with the planes of the triangles around it,
+	// plus a perpendicular plane for each border edge it's on
+	std::vector<Quadric> quadrics(a_vertexCount, Quadric{});
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		unsigned int p[3] = { positionIds[a_destination[i]], positionIds[a_destination[i + 1]], positionIds[a_destination[i + 2]] };
+
+		XMVECTOR normal = TriangleNormal(positions[p[0]], positions[p[1]], positions[p[2]]);
+		float area = XMVectorGetX(XMVector3Length(normal));
+		if (area <= 0.0f)
+			continue;
+
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, XMVectorScale(normal, 1.0f / area));
+		float d = -(n.x * positions[p[0]].x + n.y * positions[p[0]].y + n.z * positions[p[0]].z);
+		Quadric faceQuadric = PlaneQuadric(n.x, n.y, n.z, d, area);
+		for (int c = 0; c < 3; c++)
+			AddQuadric(quadrics[p[c]], faceQuadric);
+
+		for (int e = 0; e < 3; e++)
+		{
+			unsigned int from = p[e];
+			unsigned int to = p[(e + 1) % 3];
+			if (HasEdge(edges, to, from))
+				continue;
+
+			XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(&positions[to]), XMLoadFloat3(&positions[from]));
+			float length = XMVectorGetX(XMVector3Length(edge));
+			XMVECTOR edgeNormal = XMVector3Normalize(XMVector3Cross(edge, normal));
+
+			XMFLOAT3 en;
+			XMStoreFloat3(&en, edgeNormal);
+			float ed = -(en.x * positions[from].x + en.y * positions[from].y + en.z * positions[from].z);
+			Quadric edgeQuadric = PlaneQuadric(en.x, en.y, en.z, ed, length * c_borderWeight);
+			AddQuadric(quadrics[from], edgeQuadric);
+			AddQuadric(quadrics[to], edgeQuadric);
+		}
+	}
+
+	float maxError = a_targetError * scale;
+	float maxErrorSq = maxError * maxError;
+	float resultErrorSq = 0.0f;
+
+	std::vector<unsigned int> collapseRemap(a_vertexCount);
+	for (size_t i = 0; i < a_vertexCount; i++)
+		collapseRemap[i] = (unsigned int)i;
+
+	std::vector<char> touched(a_vertexCount, 0);
+	std::vector<unsigned int> adjacencyOffsets(a_vertexCount + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<Collapse> collapses;
+
+	while (indexCount > a_targetIndexCount)
+	{
+		// Fresh view of the current triangles - open edges, and the
+		// triangles around each position (as a compact offset table)
+		BuildEdges(a_destination, indexCount, positionIds, edges);
+
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (size_t i = 0; i < indexCount; i++)
+			adjacencyOffsets[positionIds[a_destination[i]] + 1]++;
+		for (size_t i = 0; i < a_vertexCount; i++)
+			adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+		adjacency.resize(indexCount);
+		{
+			std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indexCount; i++)
+				adjacency[fill[positionIds[a_destination[i]]]++] = (unsigned int)(i / 3);
+		}
+
+		// Every allowed collapse, priced by how far it moves the surface
+		collapses.clear();
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				unsigned int v0 = a_destination[i + e];
+				unsigned int v1 = a_destination[i + (e + 1) % 3];
+				unsigned int p0 = positionIds[v0];
+				unsigned int p1 = positionIds[v1];
+				if (p0 == p1)
+					continue;
+
+				bool isOpen = (kinds[p0] == VertexKind::Border || kinds[p1] == VertexKind::Border) && IsOpenEdge(edges, p0, p1);
+
+				// Seams are checked properly once a collapse is picked, since
+				// that needs to find where the other side of the seam goes
+				Quadric q = quadrics[p0];
+				AddQuadric(q, quadrics[p1]);
+				if (kinds[p0] == VertexKind::Manifold || kinds[p0] == VertexKind::Seam || (kinds[p0] == VertexKind::Border && isOpen))
+					collapses.push_back({ v0, v1, QuadricError(q, positions[p1]) });
+				if (kinds[p1] == VertexKind::Manifold || kinds[p1] == VertexKind::Seam || (kinds[p1] == VertexKind::Border && isOpen))
+					collapses.push_back({ v1, v0, QuadricError(q, positions[p0]) });
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a_a, const Collapse& a_b) { return a_a.Error < a_b.Error; });
+
+		// Take the cheapest collapses, skipping any that would touch
+		// triangles another collapse already changed this pass
+		size_t trianglesToRemove = (indexCount - a_targetIndexCount) / 3;
+		size_t trianglesRemoved = 0;
+		size_t collapseCount = 0;
+		std::fill(touched.begin(), touched.end(), 0);
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.Error > maxErrorSq || trianglesRemoved >= trianglesToRemove)
+				break;
+
+			unsigned int p0 = positionIds[collapse.From];
+			unsigned int p1 = positionIds[collapse.To];
+			if (touched[p0] || touched[p1])
+				continue;
+
+			// A seam position only moves along the seam - the vertex on
+			// the other side has to have an edge to p1 as well, and land
+			// on a different vertex there than this side does
+			unsigned int seamFrom = 0;
+			unsigned int seamTo = 0;
+			if (kinds[p0] == VertexKind::Seam)
+			{
+				seamFrom = otherWedge[collapse.From];
+				bool isFound = false;
+				for (unsigned int a = adjacencyOffsets[p0]; a < adjacencyOffsets[p0 + 1] && !isFound; a++)
+				{
+					const unsigned int* triangle = &a_destination[adjacency[a] * 3];
+					if (triangle[0] != seamFrom && triangle[1] != seamFrom && triangle[2] != seamFrom)
+						continue;
+
+					for (int c = 0; c < 3 && !isFound; c++)
+					{
+						if (positionIds[triangle[c]] == p1 && triangle[c] != collapse.To)
+						{
+							seamTo = triangle[c];
+							isFound = true;
+						}
+					}
+				}
+				if (!isFound)
+					continue;
+			}
+
+			// Moving p0 onto p1 must not flip (or nearly flip) any
+			// triangle that survives the collapse
+			bool isFlipped = false;
+			for (unsigned int a = adjacencyOffsets[p0]; a < adjacencyOffsets[p0 + 1] && !isFlipped; a++)
+			{
+				const unsigned int* triangle = &a_destination[adjacency[a] * 3];
+				unsigned int tp[3] = { positionIds[triangle[0]], positionIds[triangle[1]], positionIds[triangle[2]] };
+				if (tp[0] == p1 || tp[1] == p1 || tp[2] == p1)
+					continue;
+
+				XMFLOAT3 moved[3] = { positions[tp[0]], positions[tp[1]], positions[tp[2]] };
+				for (int c = 0; c < 3; c++)
+				{
+					if (tp[c] == p0)
+						moved[c] = positions[p1];
+				}
+
+				XMVECTOR before = TriangleNormal(positions[tp[0]], positions[tp[1]], positions[tp[2]]);
+				XMVECTOR after = TriangleNormal(moved[0], moved[1], moved[2]);
+				float alignment = XMVectorGetX(XMVector3Dot(before, after));
+				float lengths = XMVectorGetX(XMVector3Length(before)) * XMVectorGetX(XMVector3Length(after));
+				isFlipped = alignment <= 0.25f * lengths;
+			}
+			if (isFlipped)
+				continue;
+
+			collapseRemap[collapse.From] = collapse.To;
+			if (kinds[p0] == VertexKind::Seam)
+				collapseRemap[seamFrom] = seamTo;
+			AddQuadric(quadrics[p1], quadrics[p0]);
+			resultErrorSq = (std::max)(resultErrorSq, collapse.Error);
+
+			// Lock everything around p0 for the rest of the pass
+			touched[p1] = 1;
+			for (unsigned int a = adjacencyOffsets[p0]; a < adjacencyOffsets[p0 + 1]; a++)
+			{
+				const unsigned int* triangle = &a_destination[adjacency[a] * 3];
+				for (int c = 0; c < 3; c++)
+					touched[positionIds[triangle[c]]] = 1;
+			}
+
+			trianglesRemoved += (kinds[p0] == VertexKind::Border) ? 1 : 2;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		// Apply the collapses and drop the triangles that lost their area
+		size_t writeCount = 0;
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			unsigned int v0 = collapseRemap[a_destination[i]];
+			unsigned int v1 = collapseRemap[a_destination[i + 1]];
+			unsigned int v2 = collapseRemap[a_destination[i + 2]];
+			unsigned int p0 = positionIds[v0];
+			unsigned int p1 = positionIds[v1];
+			unsigned int p2 = positionIds[v2];
+			if (p0 == p1 || p1 == p2 || p0 == p2)
+				continue;
+
+			a_destination[writeCount++] = v0;
+			a_destination[writeCount++] = v1;
+			a_destination[writeCount++] = v2;
+		}
+		indexCount = writeCount;
+
+		for (size_t i = 0; i < a_vertexCount; i++)
+			collapseRemap[i] = (unsigned int)i;
+	}
+
+	if (a_pResultError)
+		*a_pResultError = sqrtf(resultErrorSq) * extent;
+
+	return indexCount;
+}
+
+// --------------------------------------------------------
+// Every level is simplified from the full mesh (rather than
+// from the level before it), so each level's error is
+// measured against the real surface
+// --------------------------------------------------------
+void GenerateLods(MeshData& a_meshData)
+{
+	std::vector<unsigned int>& indices = a_meshData.Indices;
+	size_t fullCount = indices.size();
+
+	MeshLod fullLod;
+	fullLod.IndexStart = 0;
+	fullLod.IndexCount = (unsigned int)fullCount;
+	fullLod.Error = 0.0f;
+	a_meshData.Lods.assign(1, fullLod);
+
+	XMFLOAT3 boundsMin;
+	float extent = MeshExtent(a_meshData.Vertices.data(), a_meshData.Vertices.size(), boundsMin);
+	if (fullCount == 0 || extent <= 0.0f)
+		return;
+
+	std::vector<unsigned int> lodIndices(fullCount);
+	size_t previousCount = fullCount;
+	float previousError = 0.0f;
+	for (size_t level = 1; level < c_maxMeshLods; level++)
+	{
+		size_t targetCount = (fullCount >> level) / 3 * 3;
+		if (targetCount == 0)
+			break;
+
+		float error = 0.0f;
+		size_t count = SimplifyMesh(lodIndices.data(), indices.data(), fullCount, a_meshData.Vertices.data(), a_meshData.Vertices.size(), targetCount, c_maxLodError * extent, &error);
+		if (count == 0 || count >= previousCount || count > previousCount - (size_t)(previousCount * c_minLodReduction))
+			break;
+
+		OptimizeVertexCache(lodIndices.data(), count, a_meshData.Vertices.size());
+
+		MeshLod lod;
+		lod.IndexStart = (unsigned int)indices.size();
+		lod.IndexCount = (unsigned int)count;
+		lod.Error = (std::max)(error, previousError);
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.begin() + count);
+		a_meshData.Lods.push_back(lod);
+
+		previousCount = count;
+		previousError = lod.Error;
+	}
+}
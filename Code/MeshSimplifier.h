@@ -0,0 +1,14 @@
+#pragma once
+
+#include "MeshData.h"
+
+// Collapses edges (cheapest first, by quadric error) until the triangles in
+// a_indices are down to a_targetIndexCount or the next collapse would move the
+// surface further than a_targetError. Writes the simplified indices (which still
+// reference the same vertices) to a_destination and returns how many there are.
+// Errors are distances in the mesh's own units
+size_t SimplifyMesh(unsigned int* a_destination, const unsigned int* a_indices, size_t a_indexCount, const Vertex* a_verts, size_t a_vertexCount, size_t a_targetIndexCount, float a_targetError, float* a_pResultError = nullptr);
+
+// Appends progressively coarser copies of the mesh to its index buffer (each
+// with about half the triangles of the last) and fills in a_meshData.Lods
+void GenerateLods(MeshData& a_meshData);
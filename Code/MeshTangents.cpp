@@ -0,0 +1,344 @@
+#include <vector>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include "MeshTangents.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Triangles whose UVs have (almost) no area in texture space
+	// don't say anything about which way the texture runs
+	const float c_minUVArea = 1e-12f;
+
+	// Below these sizes the work isn't worth handing to another thread
+	const size_t c_minTrianglesPerJob = 32768;
+	const size_t c_minVerticesPerJob = 32768;
+
+	// Four of anything, one per triangle in a batch
+	struct Vector3SoA
+	{
+		XMVECTOR X;
+		XMVECTOR Y;
+		XMVECTOR Z;
+	};
+
+	Vector3SoA Subtract(const Vector3SoA& a_a, const Vector3SoA& a_b)
+	{
+		return { XMVectorSubtract(a_a.X, a_b.X), XMVectorSubtract(a_a.Y, a_b.Y), XMVectorSubtract(a_a.Z, a_b.Z) };
+	}
+
+	XMVECTOR Dot(const Vector3SoA& a_a, const Vector3SoA& a_b)
+	{
+		return XMVectorMultiplyAdd(a_a.X, a_b.X, XMVectorMultiplyAdd(a_a.Y, a_b.Y, XMVectorMultiply(a_a.Z, a_b.Z)));
+	}
+
+	// Normalizes all four vectors, leaving zero length ones at zero
+	Vector3SoA Normalize(const Vector3SoA& a_v)
+	{
+		XMVECTOR lengthSq = Dot(a_v, a_v);
+		XMVECTOR scale = XMVectorSelect(XMVectorZero(), XMVectorReciprocalSqrtEst(lengthSq), XMVectorGreater(lengthSq, XMVectorZero()));
+		return { XMVectorMultiply(a_v.X, scale), XMVectorMultiply(a_v.Y, scale), XMVectorMultiply(a_v.Z, scale) };
+	}
+
+	// Angle between two edges leaving the same corner, for all four triangles
+	XMVECTOR CornerAngle(const Vector3SoA& a_edge1, const Vector3SoA& a_edge2)
+	{
+		XMVECTOR lengthsSq = XMVectorMultiply(Dot(a_edge1, a_edge1), Dot(a_edge2, a_edge2));
+		XMVECTOR cosine = XMVectorMultiply(Dot(a_edge1, a_edge2), XMVectorReciprocalSqrtEst(lengthsSq));
+		cosine = XMVectorSelect(XMVectorZero(), cosine, XMVectorGreater(lengthsSq, XMVectorZero()));
+		return XMVectorACos(XMVectorClamp(cosine, XMVectorReplicate(-1.0f), XMVectorReplicate(1.0f)));
+	}
+
+	// Adds four weighted tangents (with their handedness in w) into
+	// the accumulators of four different vertices
+	void Accumulate(XMFLOAT4A* a_sums, unsigned int a_firstVertex, const unsigned int* a_vertexIndices, const Vector3SoA& a_tangent, FXMVECTOR a_handedness, FXMVECTOR a_weights)
+	{
+		// Transposing turns the SoA columns back into one vector per triangle
+		XMMATRIX rows = XMMatrixTranspose(XMMATRIX(
+			XMVectorMultiply(a_tangent.X, a_weights),
+			XMVectorMultiply(a_tangent.Y, a_weights),
+			XMVectorMultiply(a_tangent.Z, a_weights),
+			XMVectorMultiply(a_handedness, a_weights)));
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			XMFLOAT4A& sum = a_sums[a_vertexIndices[lane] - a_firstVertex];
+			XMStoreFloat4A(&sum, XMVectorAdd(XMLoadFloat4A(&sum), rows.r[lane]));
+		}
+	}
+
+	// --------------------------------------------------------
+	// Running sums for the vertices one chunk of triangles
+	// touches. Optimized meshes have their vertices in the
+	// order the triangles first use them, so a chunk of
+	// triangles only touches a narrow band of vertices and
+	// the sums only need to cover [First, End)
+	// --------------------------------------------------------
+	struct AccumulatorChunk
+	{
+		unsigned int First = 0;
+		unsigned int End = 0;
+		std::vector<XMFLOAT4A> Sums;
+	};
+
+	// Sizes a chunk's sums to cover every vertex its triangles use
+	void AllocateChunk(AccumulatorChunk& a_chunk, const unsigned int* a_indices, size_t a_firstTriangle, size_t a_endTriangle, const unsigned int* a_remap)
+	{
+		unsigned int first = UINT_MAX;
+		unsigned int last = 0;
+		for (size_t i = a_firstTriangle * 3; i < a_endTriangle * 3; i++)
+		{
+			unsigned int index = a_remap ? a_remap[a_indices[i]] : a_indices[i];
+			first = (std::min)(first, index);
+			last = (std::max)(last, index);
+		}
+
+		a_chunk.First = (first <= last) ? first : 0;
+		a_chunk.End = (first <= last) ? last + 1 : 0;
+		a_chunk.Sums.assign(a_chunk.End - a_chunk.First, XMFLOAT4A(0, 0, 0, 0));
+	}
+
+	// Adds up what every chunk gathered for one vertex
+	XMVECTOR SumChunks(const std::vector<AccumulatorChunk>& a_chunks, unsigned int a_index)
+	{
+		XMVECTOR sum = XMVectorZero();
+		for (const AccumulatorChunk& chunk : a_chunks)
+		{
+			if (a_index >= chunk.First && a_index < chunk.End)
+				sum = XMVectorAdd(sum, XMLoadFloat4A(&chunk.Sums[a_index - chunk.First]));
+		}
+		return sum;
+	}
+
+	// Any unit vector perpendicular to the normal, for vertices whose
+	// triangles were all degenerate and never got a real tangent
+	XMVECTOR PerpendicularTo(FXMVECTOR a_normal)
+	{
+		XMVECTOR axis = (fabsf(XMVectorGetX(a_normal)) < 0.9f) ? XMVectorSet(1, 0, 0, 0) : XMVectorSet(0, 1, 0, 0);
+		return XMVector3Normalize(XMVector3Cross(axis, a_normal));
+	}
+
+	// --------------------------------------------------------
+	// Adds the tangents of triangles [a_firstTriangle,
+	// a_endTriangle) into one chunk's sums
+	//
+	// Triangles are processed four at a time in SoA form (one
+	// SIMD lane per triangle), and the sums are kept in their
+	// own aligned arrays rather than in the Vertex structs
+	// --------------------------------------------------------
+	void AccumulateTangents(const Vertex* a_verts, const unsigned int* a_indices, size_t a_firstTriangle, size_t a_endTriangle, AccumulatorChunk& a_chunk)
+	{
+		for (size_t first = a_firstTriangle; first < a_endTriangle; first += 4)
+		{
+			// Gather the batch - a short final batch repeats its last
+			// triangle in the unused lanes, which get masked out below
+			unsigned int corners[3][4];
+			const Vertex* verts[3][4];
+			for (int lane = 0; lane < 4; lane++)
+			{
+				size_t triangle = (first + lane < a_endTriangle) ? first + lane : a_endTriangle - 1;
+				for (int c = 0; c < 3; c++)
+				{
+					corners[c][lane] = a_indices[triangle * 3 + c];
+					verts[c][lane] = &a_verts[corners[c][lane]];
+				}
+			}
+			XMVECTOR inRange = XMVectorSetInt(
+				0xFFFFFFFF,
+				(first + 1 < a_endTriangle) ? 0xFFFFFFFF : 0,
+				(first + 2 < a_endTriangle) ? 0xFFFFFFFF : 0,
+				(first + 3 < a_endTriangle) ? 0xFFFFFFFF : 0);
+
+			// Transposing four loaded positions/uvs gives one SoA
+			// row per component (the fourth row is unused)
+			Vector3SoA positions[3];
+			XMVECTOR u[3];
+			XMVECTOR v[3];
+			for (int c = 0; c < 3; c++)
+			{
+				const Vertex* const* cv = verts[c];
+				XMMATRIX p = XMMatrixTranspose(XMMATRIX(
+					XMLoadFloat3(&cv[0]->Position),
+					XMLoadFloat3(&cv[1]->Position),
+					XMLoadFloat3(&cv[2]->Position),
+					XMLoadFloat3(&cv[3]->Position)));
+				XMMATRIX uv = XMMatrixTranspose(XMMATRIX(
+					XMLoadFloat2(&cv[0]->UV),
+					XMLoadFloat2(&cv[1]->UV),
+					XMLoadFloat2(&cv[2]->UV),
+					XMLoadFloat2(&cv[3]->UV)));
+
+				positions[c] = { p.r[0], p.r[1], p.r[2] };
+				u[c] = uv.r[0];
+				v[c] = uv.r[1];
+			}
+
+			// Edges in both position and uv space
+			Vector3SoA edge1 = Subtract(positions[1], positions[0]);
+			Vector3SoA edge2 = Subtract(positions[2], positions[0]);
+			Vector3SoA edge3 = Subtract(positions[2], positions[1]);
+			XMVECTOR s1 = XMVectorSubtract(u[1], u[0]);
+			XMVECTOR t1 = XMVectorSubtract(v[1], v[0]);
+			XMVECTOR s2 = XMVectorSubtract(u[2], u[0]);
+			XMVECTOR t2 = XMVectorSubtract(v[2], v[0]);
+
+			// Degenerate uvs would divide by zero, so those lanes are dropped
+			XMVECTOR uvArea = XMVectorSubtract(XMVectorMultiply(s1, t2), XMVectorMultiply(s2, t1));
+			XMVECTOR valid = XMVectorAndInt(inRange, XMVectorGreaterOrEqual(XMVectorAbs(uvArea), XMVectorReplicate(c_minUVArea)));
+
+			// Solve for the directions of +u and +v across each triangle
+			// - Only their directions are used, so
+			//    rather than dividing by the uv area we just take its sign
+			XMVECTOR areaSign = XMVectorSelect(XMVectorReplicate(1.0f), XMVectorReplicate(-1.0f), XMVectorLess(uvArea, XMVectorZero()));
+			XMVECTOR t2Signed = XMVectorMultiply(t2, areaSign);
+			XMVECTOR t1Signed = XMVectorMultiply(t1, areaSign);
+			XMVECTOR s1Signed = XMVectorMultiply(s1, areaSign);
+			XMVECTOR s2Signed = XMVectorMultiply(s2, areaSign);
+
+			Vector3SoA tangent = Normalize({
+				XMVectorNegativeMultiplySubtract(edge2.X, t1Signed, XMVectorMultiply(edge1.X, t2Signed)),
+				XMVectorNegativeMultiplySubtract(edge2.Y, t1Signed, XMVectorMultiply(edge1.Y, t2Signed)),
+				XMVectorNegativeMultiplySubtract(edge2.Z, t1Signed, XMVectorMultiply(edge1.Z, t2Signed)) });
+			Vector3SoA bitangent = {
+				XMVectorNegativeMultiplySubtract(edge1.X, s2Signed, XMVectorMultiply(edge2.X, s1Signed)),
+				XMVectorNegativeMultiplySubtract(edge1.Y, s2Signed, XMVectorMultiply(edge2.Y, s1Signed)),
+				XMVectorNegativeMultiplySubtract(edge1.Z, s2Signed, XMVectorMultiply(edge2.Z, s1Signed)) };
+
+			// Only the bitangent's side of the face/tangent plane is kept -
+			// the vertex's handedness is a weighted vote of its triangles
+			// - Clockwise front faces in a left-handed space, so e1 x e2 points out
+			Vector3SoA faceNormal = {
+				XMVectorNegativeMultiplySubtract(edge1.Z, edge2.Y, XMVectorMultiply(edge1.Y, edge2.Z)),
+				XMVectorNegativeMultiplySubtract(edge1.X, edge2.Z, XMVectorMultiply(edge1.Z, edge2.X)),
+				XMVectorNegativeMultiplySubtract(edge1.Y, edge2.X, XMVectorMultiply(edge1.X, edge2.Y)) };
+			Vector3SoA normalCrossTangent = {
+				XMVectorNegativeMultiplySubtract(faceNormal.Z, tangent.Y, XMVectorMultiply(faceNormal.Y, tangent.Z)),
+				XMVectorNegativeMultiplySubtract(faceNormal.X, tangent.Z, XMVectorMultiply(faceNormal.Z, tangent.X)),
+				XMVectorNegativeMultiplySubtract(faceNormal.Y, tangent.X, XMVectorMultiply(faceNormal.X, tangent.Y)) };
+			XMVECTOR handedness = XMVectorSelect(XMVectorReplicate(1.0f), XMVectorReplicate(-1.0f), XMVectorLess(Dot(normalCrossTangent, bitangent), XMVectorZero()));
+
+			// Weight by corner angle so the result doesn't depend on how
+			// the surface around a vertex happens to be triangulated
+			Vector3SoA negatedEdge1 = { XMVectorNegate(edge1.X), XMVectorNegate(edge1.Y), XMVectorNegate(edge1.Z) };
+			XMVECTOR angle0 = CornerAngle(edge1, edge2);
+			XMVECTOR angle1 = CornerAngle(edge3, negatedEdge1);
+			XMVECTOR angle2 = XMVectorMax(XMVectorSubtract(XMVectorReplicate(XM_PI), XMVectorAdd(angle0, angle1)), XMVectorZero());
+
+			const XMVECTOR weights[3] = {
+				XMVectorSelect(XMVectorZero(), angle0, valid),
+				XMVectorSelect(XMVectorZero(), angle1, valid),
+				XMVectorSelect(XMVectorZero(), angle2, valid) };
+
+			for (int c = 0; c < 3; c++)
+			{
+				Accumulate(a_chunk.Sums.data(), a_chunk.First, corners[c], tangent, handedness, weights[c]);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Builds the tangent frame in the same spirit as MikkTSpace:
+// each triangle's tangent is normalized and weighted by the
+// angle at each corner, then the per-vertex sums are
+// orthogonalized against the normal
+//
+// Large meshes are split into chunks of triangles that are
+// accumulated on separate threads, each into its own sums,
+// and then the sums are added up and finished per vertex -
+// also in parallel, since every vertex is independent then
+// --------------------------------------------------------
+void CalculateTangents(Vertex* a_verts, size_t a_numVerts, const unsigned int* a_indices, size_t a_numIndices)
+{
+	JobSystem& jobs = JobSystem::GetInstance();
+	size_t triangleCount = a_numIndices / 3;
+
+	// xyz is the weighted tangent sum, w is the weighted handedness vote
+	std::vector<AccumulatorChunk> chunks(jobs.GetChunkCount(triangleCount, c_minTrianglesPerJob));
+	jobs.ParallelFor(triangleCount, c_minTrianglesPerJob, [&](unsigned int a_chunk, size_t a_begin, size_t a_end) {
+		AllocateChunk(chunks[a_chunk], a_indices, a_begin, a_end, nullptr);
+		AccumulateTangents(a_verts, a_indices, a_begin, a_end, chunks[a_chunk]);
+	});
+
+	// Ensure all of the tangents are orthogonal to the normals and
+	// work out which way the bitangent points relative to them
+	jobs.ParallelFor(a_numVerts, c_minVerticesPerJob, [&](unsigned int, size_t a_begin, size_t a_end) {
+		for (size_t i = a_begin; i < a_end; i++)
+		{
+			XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&a_verts[i].Normal));
+			XMVECTOR sum = SumChunks(chunks, (unsigned int)i);
+			XMVECTOR tangent = XMVectorSetW(sum, 0.0f);
+
+			// Use Gram-Schmidt orthonormalize to ensure
+			// the normal and tangent are exactly 90 degrees apart
+			tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+			if (XMVectorGetX(XMVector3LengthSq(tangent)) < 1e-12f)
+				tangent = PerpendicularTo(normal);
+			else
+				tangent = XMVector3Normalize(tangent);
+
+			// Mirrored UVs put the bitangent on the other side of the
+			// normal/tangent plane, which the shaders undo with w
+			float handedness = (XMVectorGetW(sum) < 0.0f) ? -1.0f : 1.0f;
+
+			XMStoreFloat4(&a_verts[i].Tangent, XMVectorSetW(tangent, handedness));
+		}
+	});
+}
+
+// --------------------------------------------------------
+// Gives vertices without a normal the area weighted average
+// of the normals of the faces around them
+//
+// The faces are summed per position rather than per vertex,
+// so vertices that were only split because of their UVs
+// still end up sharing a normal and the seam stays smooth
+// --------------------------------------------------------
+void CalculateNormals(Vertex* a_verts, size_t a_numVerts, const unsigned int* a_indices, size_t a_numIndices, const unsigned int* a_positionIds)
+{
+	JobSystem& jobs = JobSystem::GetInstance();
+	size_t triangleCount = a_numIndices / 3;
+
+	std::vector<AccumulatorChunk> chunks(jobs.GetChunkCount(triangleCount, c_minTrianglesPerJob));
+	jobs.ParallelFor(triangleCount, c_minTrianglesPerJob, [&](unsigned int a_chunk, size_t a_begin, size_t a_end) {
+		AccumulatorChunk& chunk = chunks[a_chunk];
+		AllocateChunk(chunk, a_indices, a_begin, a_end, a_positionIds);
+
+		for (size_t t = a_begin; t < a_end; t++)
+		{
+			const unsigned int* corners = &a_indices[t * 3];
+			XMVECTOR p0 = XMLoadFloat3(&a_verts[corners[0]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&a_verts[corners[1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&a_verts[corners[2]].Position);
+
+			// Clockwise front faces in a left-handed space, so e1 x e2 points
+			// out - and its length is twice the area, which is the weighting
+			XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			for (int c = 0; c < 3; c++)
+			{
+				XMFLOAT4A& sum = chunk.Sums[a_positionIds[corners[c]] - chunk.First];
+				XMStoreFloat4A(&sum, XMVectorAdd(XMLoadFloat4A(&sum), faceNormal));
+			}
+		}
+	});
+
+	jobs.ParallelFor(a_numVerts, c_minVerticesPerJob, [&](unsigned int, size_t a_begin, size_t a_end) {
+		for (size_t i = a_begin; i < a_end; i++)
+		{
+			XMFLOAT3& normal = a_verts[i].Normal;
+			if (normal.x != 0.0f || normal.y != 0.0f || normal.z != 0.0f)
+				continue;
+
+			// Faces with no area at all leave nothing to average
+			XMVECTOR sum = XMVectorSetW(SumChunks(chunks, a_positionIds[i]), 0.0f);
+			if (XMVectorGetX(XMVector3LengthSq(sum)) < 1e-24f)
+				sum = XMVectorSet(0, 1, 0, 0);
+
+			XMStoreFloat3(&normal, XMVector3Normalize(sum));
+		}
+	});
+}
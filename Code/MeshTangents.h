@@ -0,0 +1,13 @@
+#pragma once
+
+#include "Vertex.h"
+
+// Generates a unit tangent for every vertex from the mesh's positions, normals
+// and UVs. The tangent's w holds the handedness of the UV mapping (+1 or -1),
+// so the bitangent is cross(tangent, normal) * w - mirrored UVs get -1
+void CalculateTangents(Vertex* a_verts, size_t a_numVerts, const unsigned int* a_indices, size_t a_numIndices);
+
+// Generates smooth normals for any vertices whose normal is zero. a_positionIds
+// gives each vertex's original position, so vertices that only differ by their
+// UVs are smoothed together
+void CalculateNormals(Vertex* a_verts, size_t a_numVerts, const unsigned int* a_indices, size_t a_numIndices, const unsigned int* a_positionIds);
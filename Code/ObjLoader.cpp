@@ -0,0 +1,420 @@
+#include <fstream>
+#include <cmath>
+
+#include "ObjLoader.h"
+#include "MeshTangents.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Small hand-written tokenizer helpers
+//
+// The whole file is read into one null-terminated buffer,
+// so the terminator doubles as an end-of-buffer sentinel
+// and none of these need to carry an end pointer around
+// --------------------------------------------------------
+namespace
+{
+	// Exact powers of ten - anything larger falls back to pow()
+	const double c_powersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	inline bool IsSpace(char a_c) { return a_c == ' ' || a_c == '\t' || a_c == '\r'; }
+	inline bool IsDigit(char a_c) { return a_c >= '0' && a_c <= '9'; }
+
+	inline const char* SkipSpaces(const char* a_p)
+	{
+		while (IsSpace(*a_p)) a_p++;
+		return a_p;
+	}
+
+	// Returns the start of the next line (or the terminator)
+	inline const char* NextLine(const char* a_p)
+	{
+		while (*a_p != '\n' && *a_p != '\0') a_p++;
+		return (*a_p == '\n') ? a_p + 1 : a_p;
+	}
+
+	inline double Pow10(int a_exponent)
+	{
+		if (a_exponent <= 22) return c_powersOfTen[a_exponent];
+		return pow(10.0, a_exponent);
+	}
+
+	// Parses a float (with optional sign, fraction and exponent)
+	// and returns a pointer to the first character after it
+	const char* ParseFloat(const char* a_p, float& a_out)
+	{
+		a_p = SkipSpaces(a_p);
+
+		bool negative = false;
+		if (*a_p == '-') { negative = true; a_p++; }
+		else if (*a_p == '+') a_p++;
+
+		// Integer and fraction digits go into a single mantissa, with
+		// the decimal point tracked as a power of ten
+		unsigned long long mantissa = 0;
+		int exponent = 0;
+		int significantDigits = 0;
+		for (; IsDigit(*a_p); a_p++)
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*a_p - '0');
+				if (mantissa != 0) significantDigits++;
+			}
+			else exponent++;
+		}
+		if (*a_p == '.')
+		{
+			for (a_p++; IsDigit(*a_p); a_p++)
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + (*a_p - '0');
+					if (mantissa != 0) significantDigits++;
+					exponent--;
+				}
+			}
+		}
+		if (*a_p == 'e' || *a_p == 'E')
+		{
+			a_p++;
+			bool negativeExponent = false;
+			if (*a_p == '-') { negativeExponent = true; a_p++; }
+			else if (*a_p == '+') a_p++;
+
+			int explicitExponent = 0;
+			for (; IsDigit(*a_p); a_p++)
+			{
+				if (explicitExponent < 1000)
+					explicitExponent = explicitExponent * 10 + (*a_p - '0');
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		}
+
+		double value = (double)mantissa;
+		if (exponent < 0) value /= Pow10(-exponent);
+		else if (exponent > 0) value *= Pow10(exponent);
+
+		a_out = (float)(negative ? -value : value);
+		return a_p;
+	}
+
+	// Parses a (possibly negative) integer, returning 0 if there are no digits
+	const char* ParseInt(const char* a_p, int& a_out)
+	{
+		bool negative = false;
+		if (*a_p == '-') { negative = true; a_p++; }
+		else if (*a_p == '+') a_p++;
+
+		int value = 0;
+		for (; IsDigit(*a_p); a_p++)
+			value = value * 10 + (*a_p - '0');
+
+		a_out = negative ? -value : value;
+		return a_p;
+	}
+
+	// Converts a 1-based (or negative, relative) obj index to a 0-based
+	// index, returning -1 if it's missing or out of range
+	inline int ResolveIndex(int a_objIndex, size_t a_count)
+	{
+		int index = (a_objIndex < 0) ? (int)a_count + a_objIndex : a_objIndex - 1;
+		return (index >= 0 && (size_t)index < a_count) ? index : -1;
+	}
+
+	// --------------------------------------------------------
+	// Open-addressing table used to weld identical corners
+	//
+	// Each face corner is keyed on its (position, uv, normal)
+	// index triple, so corners that share all three become a
+	// single vertex referenced by multiple indices
+	// --------------------------------------------------------
+	class CornerTable
+	{
+	public:
+		CornerTable(size_t a_expectedCount)
+		{
+			// Keep the load factor at or below 50%
+			size_t capacity = 16;
+			while (capacity < a_expectedCount * 2) capacity <<= 1;
+			m_mask = capacity - 1;
+			m_slots.resize(capacity);
+		}
+
+		// Returns the slot for this key - check IsEmpty to see if it's new
+		unsigned int& Find(int a_position, int a_uv, int a_normal)
+		{
+			size_t slot = Hash(a_position, a_uv, a_normal) & m_mask;
+			while (true)
+			{
+				Slot& s = m_slots[slot];
+				if (s.Vertex == c_emptySlot)
+				{
+					s.Position = a_position;
+					s.UV = a_uv;
+					s.Normal = a_normal;
+					return s.Vertex;
+				}
+				if (s.Position == a_position && s.UV == a_uv && s.Normal == a_normal)
+					return s.Vertex;
+				slot = (slot + 1) & m_mask;
+			}
+		}
+
+		static bool IsEmpty(unsigned int a_vertex) { return a_vertex == c_emptySlot; }
+
+	private:
+		static const unsigned int c_emptySlot = 0xFFFFFFFF;
+
+		struct Slot
+		{
+			int Position = 0;
+			int UV = 0;
+			int Normal = 0;
+			unsigned int Vertex = c_emptySlot;
+		};
+
+		static size_t Hash(int a_position, int a_uv, int a_normal)
+		{
+			unsigned long long h = (unsigned int)a_position * 0x9E3779B97F4A7C15ull;
+			h ^= ((unsigned int)a_uv + 0x632BE59BD9B4E019ull) + (h << 6) + (h >> 2);
+			h ^= ((unsigned int)a_normal + 0x85EBCA77C2B2AE63ull) + (h << 6) + (h >> 2);
+			return (size_t)(h ^ (h >> 32));
+		}
+
+		std::vector<Slot> m_slots;
+		size_t m_mask;
+	};
+
+	// Counts the whitespace separated tokens left on this line
+	int CountTokens(const char* a_p)
+	{
+		int count = 0;
+		while (true)
+		{
+			a_p = SkipSpaces(a_p);
+			if (*a_p == '\n' || *a_p == '\0' || *a_p == '#') return count;
+			count++;
+			while (!IsSpace(*a_p) && *a_p != '\n' && *a_p != '\0') a_p++;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Loads an .obj file into CPU memory
+//
+// The file is read with a single large read, then handed
+// to ParseOBJ(), which walks it twice: once to count the
+// elements so every vector can be reserved exactly, and
+// once to actually parse them. Lines can be any length
+// and faces can have any number of corners (they're
+// triangulated as a fan).
+//
+// Corners sharing the same position/uv/normal indices are
+// welded into one vertex, so the index buffer is real
+// rather than just 0..N-1.
+//
+// Files without normals get smooth ones generated once
+// all of the faces are in.
+// --------------------------------------------------------
+bool LoadOBJ(const std::wstring& a_filename, MeshData& a_meshData)
+{
+	// Read the entire file into a null-terminated buffer
+#ifdef _WIN32
+	std::ifstream obj(a_filename, std::ios::binary | std::ios::ate);
+#else
+	// Only MSVC's streams take wide paths - elsewhere (the tests)
+	// the paths are plain ASCII, so narrowing them is enough
+	std::ifstream obj(std::string(a_filename.begin(), a_filename.end()), std::ios::binary | std::ios::ate);
+#endif
+	if (!obj.is_open())
+		return false;
+
+	std::streamsize fileSize = obj.tellg();
+	if (fileSize < 0)
+		return false;
+
+	std::vector<char> buffer((size_t)fileSize + 1);
+	obj.seekg(0, std::ios::beg);
+	if (fileSize > 0 && !obj.read(buffer.data(), fileSize))
+		return false;
+	buffer[(size_t)fileSize] = '\0';
+	obj.close();
+
+	ParseOBJ(buffer.data(), a_meshData);
+	return true;
+}
+
+void ParseOBJ(const char* a_text, MeshData& a_meshData)
+{
+	// First pass - count everything so nothing reallocates later
+	size_t positionCount = 0;
+	size_t normalCount = 0;
+	size_t uvCount = 0;
+	size_t triangleCount = 0;
+	size_t cornerCount = 0;
+	for (const char* p = a_text; *p != '\0'; p = NextLine(p))
+	{
+		p = SkipSpaces(p);
+		if (p[0] == 'v')
+		{
+			if (IsSpace(p[1])) positionCount++;
+			else if (p[1] == 'n') normalCount++;
+			else if (p[1] == 't') uvCount++;
+		}
+		else if (p[0] == 'f' && IsSpace(p[1]))
+		{
+			int corners = CountTokens(p + 1);
+			if (corners >= 3)
+			{
+				triangleCount += corners - 2;
+				cornerCount += corners;
+			}
+		}
+	}
+
+	// Variables used while reading the file
+	std::vector<XMFLOAT3> positions;	// Positions from the file
+	std::vector<XMFLOAT3> normals;		// Normals from the file
+	std::vector<XMFLOAT2> uvs;			// UVs from the file
+	std::vector<int> faceKeys;				// Position/uv/normal index triples of the face currently being read
+	std::vector<unsigned int> faceCorners;	// Welded vertex indices of the same face
+	std::vector<unsigned int> vertexPositions;	// Position each welded vertex came from
+	bool isMissingNormals = false;			// Whether any corner had no normal
+	CornerTable cornerTable(cornerCount);	// Maps index triples to welded vertices
+	positions.reserve(positionCount);
+	normals.reserve(normalCount);
+	uvs.reserve(uvCount);
+	faceKeys.reserve(8 * 3);
+	faceCorners.reserve(8);
+	vertexPositions.reserve(cornerCount);
+
+	std::vector<Vertex>& verts = a_meshData.Vertices;
+	std::vector<unsigned int>& indices = a_meshData.Indices;
+	verts.clear();
+	indices.clear();
+	verts.reserve(cornerCount);
+	indices.reserve(triangleCount * 3);
+
+	// The model is most likely in a right-handed space,
+	// especially if it came from Maya.  We want to convert
+	// to a left-handed space for DirectX.  This means we
+	// need to:
+	//  - Invert the Z position
+	//  - Invert the normal's Z
+	//  - Flip the winding order
+	// We also need to flip the UV coordinate since DirectX
+	// defines (0,0) as the top left of the texture, and many
+	// 3D modeling packages use the bottom left as (0,0)
+	//
+	// The flips are applied as each element is read, so the
+	// face assembly below only has to copy values around
+	for (const char* p = a_text; *p != '\0'; p = NextLine(p))
+	{
+		p = SkipSpaces(p);
+
+		if (p[0] == 'v' && p[1] == 'n')
+		{
+			XMFLOAT3 norm;
+			p = ParseFloat(p + 2, norm.x);
+			p = ParseFloat(p, norm.y);
+			p = ParseFloat(p, norm.z);
+			norm.z *= -1.0f;
+			normals.push_back(norm);
+		}
+		else if (p[0] == 'v' && p[1] == 't')
+		{
+			XMFLOAT2 uv;
+			p = ParseFloat(p + 2, uv.x);
+			p = ParseFloat(p, uv.y);
+			uv.y = 1.0f - uv.y;
+			uvs.push_back(uv);
+		}
+		else if (p[0] == 'v' && IsSpace(p[1]))
+		{
+			XMFLOAT3 pos;
+			p = ParseFloat(p + 1, pos.x);
+			p = ParseFloat(p, pos.y);
+			p = ParseFloat(p, pos.z);
+			pos.z *= -1.0f;
+			positions.push_back(pos);
+		}
+		else if (p[0] == 'f' && IsSpace(p[1]))
+		{
+			// Read every corner of the face - each one is "v", "v/vt",
+			// "v//vn" or "v/vt/vn". Missing UVs are zeroed, and missing
+			// normals are generated once the whole file is read
+			faceKeys.clear();
+			bool isFaceValid = true;
+			p = SkipSpaces(p + 1);
+			while (*p != '\n' && *p != '\0' && *p != '#')
+			{
+				int positionIndex = 0;
+				int uvIndex = 0;
+				int normalIndex = 0;
+				p = ParseInt(p, positionIndex);
+				if (*p == '/')
+				{
+					p = ParseInt(p + 1, uvIndex);
+					if (*p == '/')
+						p = ParseInt(p + 1, normalIndex);
+				}
+
+				// Skip anything unexpected so a bad token can't stall the loop
+				while (!IsSpace(*p) && *p != '\n' && *p != '\0') p++;
+				p = SkipSpaces(p);
+
+				int position = ResolveIndex(positionIndex, positions.size());
+				if (position < 0)
+					isFaceValid = false;
+				faceKeys.push_back(position);
+				faceKeys.push_back(ResolveIndex(uvIndex, uvs.size()));
+				faceKeys.push_back(ResolveIndex(normalIndex, normals.size()));
+			}
+
+			// Nothing is welded until the whole face checks out, so a
+			// rejected face can't leave orphaned vertices behind
+			if (!isFaceValid || faceKeys.size() < 3 * 3)
+				continue;
+
+			faceCorners.clear();
+			for (size_t k = 0; k < faceKeys.size(); k += 3)
+			{
+				int position = faceKeys[k];
+				int uv = faceKeys[k + 1];
+				int normal = faceKeys[k + 2];
+
+				// Reuse the vertex if this exact corner has been seen before
+				unsigned int& vertexIndex = cornerTable.Find(position, uv, normal);
+				if (CornerTable::IsEmpty(vertexIndex))
+				{
+					Vertex corner = {};
+					corner.Position = positions[position];
+					if (uv >= 0) corner.UV = uvs[uv];
+					if (normal >= 0) corner.Normal = normals[normal];
+					else isMissingNormals = true;
+
+					vertexIndex = (unsigned int)verts.size();
+					verts.push_back(corner);
+					vertexPositions.push_back((unsigned int)position);
+				}
+				faceCorners.push_back(vertexIndex);
+			}
+
+			// Triangulate as a fan around the first corner, flipping
+			// the winding order of each triangle as we go
+			for (size_t c = 1; c + 1 < faceCorners.size(); c++)
+			{
+				indices.push_back(faceCorners[0]);
+				indices.push_back(faceCorners[c + 1]);
+				indices.push_back(faceCorners[c]);
+			}
+		}
+	}
+
+	if (isMissingNormals)
+		CalculateNormals(verts.data(), verts.size(), indices.data(), indices.size(), vertexPositions.data());
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "MeshData.h"
+
+// Parses an .obj file into a_meshData, converting it to DirectX's
+// left-handed space along the way. Returns false if the file can't be read
+bool LoadOBJ(const std::wstring& a_filename, MeshData& a_meshData);
+
+// Does the parsing for LoadOBJ() on text that's already in memory, which
+// must end with a '\0'
+void ParseOBJ(const char* a_text, MeshData& a_meshData);
@@ -2,17 +2,21 @@
 
 #define NUM_LIGHTS 5
 
-cbuffer ExternalData : register(b0)
+cbuffer PerFrame : register(b0)
 {
 	float gamma;
-	float roughness;
-	float3 colorTint;
 	float3 ambientColor;
 	float3 cameraPosition;
 
 	Light lights[NUM_LIGHTS]; // Array of exactly NUM_LIGHTS lights
 }
 
+cbuffer PerMaterial : register(b1)
+{
+	float roughness;
+	float3 colorTint;
+}
+
 float4 main(VertexToPixel input) : SV_TARGET
 {
 	input.normal = normalize(input.normal); // Must renormalize any interpolated vectors
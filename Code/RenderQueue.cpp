@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <cstring>
+
+#include "RenderQueue.h"
+
+const uint64_t RenderQueue::c_shaderMask;
+const uint64_t RenderQueue::c_materialMask;
+const uint64_t RenderQueue::c_meshMask;
+const uint64_t RenderQueue::c_depthMask;
+
+namespace
+{
+	// Ids are 16 bits, so anything past the last one shares it
+	const unsigned int c_maxId = 0xFFFF;
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int a_shaderId, unsigned int a_materialId, unsigned int a_meshId, float a_depth)
+{
+	float depth = (std::min)((std::max)(a_depth, 0.0f), 1.0f);
+	return ((uint64_t)(a_shaderId & c_maxId) << 48) |
+		((uint64_t)(a_materialId & c_maxId) << 32) |
+		((uint64_t)(a_meshId & c_maxId) << 16) |
+		(uint64_t)(depth * c_maxId);
+}
+
+unsigned int RenderQueue::GetShaderId(const void* a_pVertexShader, const void* a_pPixelShader) { return GetId(m_shaderIds, a_pVertexShader, a_pPixelShader); }
+unsigned int RenderQueue::GetMaterialId(const void* a_pMaterial) { return GetId(m_materialIds, a_pMaterial, nullptr); }
+unsigned int RenderQueue::GetMeshId(const void* a_pMesh) { return GetId(m_meshIds, a_pMesh, nullptr); }
+
+unsigned int RenderQueue::GetId(IdMap& a_ids, const void* a_pFirst, const void* a_pSecond)
+{
+	auto inserted = a_ids.insert({ { a_pFirst, a_pSecond }, (std::min)((unsigned int)a_ids.size(), c_maxId) });
+	return inserted.first->second;
+}
+
+void RenderQueue::Clear() { m_items.clear(); }
+void RenderQueue::Add(uint64_t a_key, unsigned int a_index) { m_items.push_back({ a_key, a_index }); }
+const std::vector<RenderQueueItem>& RenderQueue::GetItems() { return m_items; }
+
+// --------------------------------------------------------
+// Least significant byte first, one counting pass per byte.
+// All eight histograms are filled in a single read of the
+// keys, and any byte that's the same in every key (high
+// id bytes usually are) is skipped entirely
+// --------------------------------------------------------
+void RenderQueue::Sort()
+{
+	size_t count = m_items.size();
+	if (count < 2)
+		return;
+
+	unsigned int histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (const RenderQueueItem& item : m_items)
+	{
+		for (int pass = 0; pass < 8; pass++)
+			histograms[pass][(item.Key >> (pass * 8)) & 0xFF]++;
+	}
+
+	m_scratch.resize(count);
+	for (int pass = 0; pass < 8; pass++)
+	{
+		unsigned int* histogram = histograms[pass];
+		if (histogram[(m_items[0].Key >> (pass * 8)) & 0xFF] == count)
+			continue;
+
+		unsigned int offset = 0;
+		for (int bucket = 0; bucket < 256; bucket++)
+		{
+			unsigned int bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+
+		for (const RenderQueueItem& item : m_items)
+			m_scratch[histogram[(item.Key >> (pass * 8)) & 0xFF]++] = item;
+		m_items.swap(m_scratch);
+	}
+}
+
+// --------------------------------------------------------
+// Shaders are bound when their part of the key changes,
+// material textures when the shaders or the material do,
+// and mesh buffers (which belong to the input assembler,
+// not the shaders) only when the mesh does
+// --------------------------------------------------------
+RenderQueueStats RenderQueue::CountStateChanges()
+{
+	RenderQueueStats stats;
+	stats.Draws = (unsigned int)m_items.size();
+
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		uint64_t changed = i == 0 ? ~0ull : m_items[i].Key ^ m_items[i - 1].Key;
+		if (changed & c_shaderMask) stats.ShaderBinds++;
+		if (changed & (c_shaderMask | c_materialMask)) stats.MaterialBinds++;
+		if (changed & c_meshMask) stats.MeshBinds++;
+	}
+
+	stats.BindsAvoided = stats.Draws * 3 - (stats.ShaderBinds + stats.MaterialBinds + stats.MeshBinds);
+	return stats;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------------
+// One draw waiting in the queue - its sort key and the
+// caller's index for whatever it's drawing
+// --------------------------------------------------------
+struct RenderQueueItem
+{
+	uint64_t Key;
+	unsigned int Index;
+};
+
+// --------------------------------------------------------
+// How many times each kind of state has to be bound to
+// submit the sorted queue, compared to binding all three
+// for every draw
+// --------------------------------------------------------
+struct RenderQueueStats
+{
+	unsigned int Draws = 0;
+	unsigned int ShaderBinds = 0;
+	unsigned int MaterialBinds = 0;
+	unsigned int MeshBinds = 0;
+	unsigned int BindsAvoided = 0;
+};
+
+// --------------------------------------------------------
+// Sorts a frame's draws so ones sharing state end up next
+// to each other
+//
+// Each draw gets a 64 bit key made of 16 bit ids for its
+// shaders, material and mesh (in that order, since that's
+// roughly what each costs to change) with its depth at the
+// bottom, so draws that share everything else go front to
+// back. Walking the sorted keys, state only needs binding
+// when its part of the key differs from the last draw's
+//
+// Nothing in here touches Direct3D - the ids come from
+// whatever pointers the caller hands over
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	static const uint64_t c_shaderMask = 0xFFFF000000000000ull;
+	static const uint64_t c_materialMask = 0x0000FFFF00000000ull;
+	static const uint64_t c_meshMask = 0x00000000FFFF0000ull;
+	static const uint64_t c_depthMask = 0x000000000000FFFFull;
+
+	/* Packs a draw's ids and its depth (0 at the camera, 1 at the far plane) into a sort key */
+	static uint64_t MakeKey(unsigned int a_shaderId, unsigned int a_materialId, unsigned int a_meshId, float a_depth);
+
+	/* Small ids that stay the same from frame to frame, handed out the first time each pointer is seen */
+	unsigned int GetShaderId(const void* a_pVertexShader, const void* a_pPixelShader);
+	unsigned int GetMaterialId(const void* a_pMaterial);
+	unsigned int GetMeshId(const void* a_pMesh);
+
+	void Clear();
+	void Add(uint64_t a_key, unsigned int a_index);
+
+	/* Radix sorts the items by key */
+	void Sort();
+
+	const std::vector<RenderQueueItem>& GetItems();
+
+	/* Counts the binds needed to submit the items in their current order */
+	RenderQueueStats CountStateChanges();
+
+private:
+	typedef std::map<std::pair<const void*, const void*>, unsigned int> IdMap;
+	static unsigned int GetId(IdMap& a_ids, const void* a_pFirst, const void* a_pSecond);
+
+	std::vector<RenderQueueItem> m_items;
+	std::vector<RenderQueueItem> m_scratch;
+	IdMap m_shaderIds;
+	IdMap m_materialIds;
+	IdMap m_meshIds;
+};
@@ -16,7 +16,35 @@ struct VertexShaderInput
     float3 localPosition : POSITION; // XYZ position
     float3 normal : NORMAL;
     float2 uv : TEXCOORD;
-    float3 tangent : TANGENT;
+    float4 tangent : TANGENT; // w is the bitangent sign
+};
+
+// The compact vertex formats (see VertexFormat.h) - the input layout
+// unpacks them to floats, and CompactVertexShader finishes the job
+struct CompactVertexShaderInput
+{
+    float4 localPosition : POSITION; // XYZ within the mesh bounds, W is the bitangent sign (0 or 1)
+    float2 normal : NORMAL; // Octahedral encoded
+    float2 tangent : TANGENT; // Octahedral encoded
+    float2 uv : TEXCOORD;
+};
+
+// A regular vertex plus the instance it belongs to - semantics ending
+// in _PER_INSTANCE are read from the second vertex buffer, once per
+// instance, by the input layout SimpleShader builds
+struct InstancedVertexShaderInput
+{
+    float3 localPosition : POSITION;
+    float3 normal : NORMAL;
+    float2 uv : TEXCOORD;
+    float4 tangent : TANGENT;
+    float4 worldRow0 : WORLD_PER_INSTANCE0;
+    float4 worldRow1 : WORLD_PER_INSTANCE1;
+    float4 worldRow2 : WORLD_PER_INSTANCE2;
+    float4 worldRow3 : WORLD_PER_INSTANCE3;
+    float4 worldInvTransposeRow0 : WORLDINVTRANSPOSE_PER_INSTANCE0;
+    float4 worldInvTransposeRow1 : WORLDINVTRANSPOSE_PER_INSTANCE1;
+    float4 worldInvTransposeRow2 : WORLDINVTRANSPOSE_PER_INSTANCE2;
 };
 
 // Struct representing the data we expect to receive from earlier pipeline stages
@@ -35,7 +63,7 @@ struct VertexToPixel
     float2 uv : TEXCOORD;
     float3 worldPosition : POSITION;
     float3 normal : NORMAL;
-    float3 tangent : TANGENT;
+    float4 tangent : TANGENT; // w is the bitangent sign
 };
 
 struct VertexToSkyPixel
@@ -71,6 +99,16 @@ static const float F0_NON_METAL = 0.04f;
 static const float MIN_ROUGHNESS = 0.0000001f; // 6 zeros after decimal
 static const float PI = 3.14159265359f;
 
+// Turns an octahedral encoded direction back into a unit vector
+// - Must match DecodeOctahedral() in VertexFormat.cpp
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 direction = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-direction.z);
+    direction.xy += (direction.xy >= 0.0f) ? -fold : fold;
+    return normalize(direction);
+}
+
 float Random(float2 s)
 {
     return frac(sin(dot(s, float2(12, 75))) * 43758);
@@ -0,0 +1,222 @@
+#include "ShaderReflectionCache.h"
+
+namespace
+{
+	const uint32_t c_shaderReflectionMagic = 0x4C464552;	// "REFL" when read as bytes
+
+	// Nothing in a real shader comes close to this many of anything,
+	// so a bigger count means the file is damaged
+	const uint32_t c_maxReflectedCount = 0xFFFF;
+
+	// Byte-at-a-time so the file reads the same on any platform
+	void WriteU32(std::vector<unsigned char>& a_bytes, uint32_t a_value)
+	{
+		for (int i = 0; i < 4; i++)
+			a_bytes.push_back((unsigned char)(a_value >> (i * 8)));
+	}
+
+	void WriteU64(std::vector<unsigned char>& a_bytes, uint64_t a_value)
+	{
+		WriteU32(a_bytes, (uint32_t)a_value);
+		WriteU32(a_bytes, (uint32_t)(a_value >> 32));
+	}
+
+	void WriteString(std::vector<unsigned char>& a_bytes, const std::string& a_string)
+	{
+		WriteU32(a_bytes, (uint32_t)a_string.size());
+		a_bytes.insert(a_bytes.end(), a_string.begin(), a_string.end());
+	}
+
+	// --------------------------------------------------------
+	// Reads values back in the same order, and remembers the
+	// first time it runs off the end so the caller only has to
+	// check once at the end
+	// --------------------------------------------------------
+	struct ByteReader
+	{
+		const unsigned char* Bytes;
+		size_t Size;
+		size_t Position;
+		bool IsValid;
+
+		uint32_t ReadU32()
+		{
+			if (!IsValid || Size - Position < 4) {
+				IsValid = false;
+				return 0;
+			}
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= (uint32_t)Bytes[Position + i] << (i * 8);
+			Position += 4;
+			return value;
+		}
+
+		uint64_t ReadU64()
+		{
+			uint64_t low = ReadU32();
+			uint64_t high = ReadU32();
+			return low | (high << 32);
+		}
+
+		uint32_t ReadCount()
+		{
+			uint32_t count = ReadU32();
+			if (count > c_maxReflectedCount) {
+				IsValid = false;
+				return 0;
+			}
+			return count;
+		}
+
+		std::string ReadString()
+		{
+			uint32_t length = ReadU32();
+			if (!IsValid || Size - Position < length) {
+				IsValid = false;
+				return std::string();
+			}
+			std::string value((const char*)Bytes + Position, length);
+			Position += length;
+			return value;
+		}
+	};
+
+	void WriteResources(std::vector<unsigned char>& a_bytes, const std::vector<ShaderReflectionResource>& a_resources)
+	{
+		WriteU32(a_bytes, (uint32_t)a_resources.size());
+		for (const ShaderReflectionResource& resource : a_resources) {
+			WriteString(a_bytes, resource.Name);
+			WriteU32(a_bytes, resource.BindIndex);
+		}
+	}
+
+	void ReadResources(ByteReader& a_reader, std::vector<ShaderReflectionResource>& a_resources)
+	{
+		a_resources.resize(a_reader.ReadCount());
+		for (ShaderReflectionResource& resource : a_resources) {
+			resource.Name = a_reader.ReadString();
+			resource.BindIndex = a_reader.ReadU32();
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Swaps the shader's extension for .refl
+// --------------------------------------------------------
+std::wstring GetShaderReflectionCachePath(const std::wstring& a_shaderPath)
+{
+	size_t dot = a_shaderPath.find_last_of(L'.');
+	size_t slash = a_shaderPath.find_last_of(L"/\\");
+	if (dot == std::wstring::npos || (slash != std::wstring::npos && dot < slash))
+		return a_shaderPath + L".refl";
+
+	return a_shaderPath.substr(0, dot) + L".refl";
+}
+
+uint64_t HashShaderBytecode(const void* a_bytecode, size_t a_size)
+{
+	const unsigned char* bytes = (const unsigned char*)a_bytecode;
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < a_size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Header (magic, version, bytecode hash), then each table
+// as a count followed by its entries. Strings are stored
+// as a length and their characters
+// --------------------------------------------------------
+void SerializeShaderReflection(const ShaderReflectionData& a_data, uint64_t a_bytecodeHash, std::vector<unsigned char>& a_bytes)
+{
+	a_bytes.clear();
+	WriteU32(a_bytes, c_shaderReflectionMagic);
+	WriteU32(a_bytes, c_shaderReflectionVersion);
+	WriteU64(a_bytes, a_bytecodeHash);
+
+	WriteU32(a_bytes, (uint32_t)a_data.ConstantBuffers.size());
+	for (const ShaderReflectionBuffer& buffer : a_data.ConstantBuffers)
+	{
+		WriteString(a_bytes, buffer.Name);
+		WriteU32(a_bytes, buffer.Type);
+		WriteU32(a_bytes, buffer.Size);
+		WriteU32(a_bytes, buffer.BindIndex);
+		WriteU32(a_bytes, (uint32_t)buffer.Variables.size());
+		for (const ShaderReflectionVariable& variable : buffer.Variables)
+		{
+			WriteString(a_bytes, variable.Name);
+			WriteU32(a_bytes, variable.ByteOffset);
+			WriteU32(a_bytes, variable.Size);
+		}
+	}
+
+	WriteResources(a_bytes, a_data.Textures);
+	WriteResources(a_bytes, a_data.Samplers);
+
+	WriteU32(a_bytes, (uint32_t)a_data.Inputs.size());
+	for (const ShaderReflectionInput& input : a_data.Inputs)
+	{
+		WriteString(a_bytes, input.SemanticName);
+		WriteU32(a_bytes, input.SemanticIndex);
+		WriteU32(a_bytes, input.ComponentType);
+		WriteU32(a_bytes, input.Mask);
+	}
+}
+
+bool DeserializeShaderReflection(const unsigned char* a_bytes, size_t a_size, uint64_t a_bytecodeHash, ShaderReflectionData& a_data)
+{
+	a_data = ShaderReflectionData();
+
+	ByteReader reader = { a_bytes, a_size, 0, true };
+	if (reader.ReadU32() != c_shaderReflectionMagic ||
+		reader.ReadU32() != c_shaderReflectionVersion ||
+		reader.ReadU64() != a_bytecodeHash ||
+		!reader.IsValid)
+		return false;
+
+	a_data.ConstantBuffers.resize(reader.ReadCount());
+	for (ShaderReflectionBuffer& buffer : a_data.ConstantBuffers)
+	{
+		buffer.Name = reader.ReadString();
+		buffer.Type = reader.ReadU32();
+		buffer.Size = reader.ReadU32();
+		buffer.BindIndex = reader.ReadU32();
+		buffer.Variables.resize(reader.ReadCount());
+		for (ShaderReflectionVariable& variable : buffer.Variables)
+		{
+			variable.Name = reader.ReadString();
+			variable.ByteOffset = reader.ReadU32();
+			variable.Size = reader.ReadU32();
+
+			// Variables have to fit inside their buffer
+			if ((uint64_t)variable.ByteOffset + variable.Size > buffer.Size)
+				reader.IsValid = false;
+		}
+		if (!reader.IsValid)
+			break;
+	}
+
+	ReadResources(reader, a_data.Textures);
+	ReadResources(reader, a_data.Samplers);
+
+	a_data.Inputs.resize(reader.ReadCount());
+	for (ShaderReflectionInput& input : a_data.Inputs)
+	{
+		input.SemanticName = reader.ReadString();
+		input.SemanticIndex = reader.ReadU32();
+		input.ComponentType = reader.ReadU32();
+		input.Mask = reader.ReadU32();
+	}
+
+	// Trailing bytes mean it wasn't written by this version either
+	if (!reader.IsValid || reader.Position != reader.Size)
+	{
+		a_data = ShaderReflectionData();
+		return false;
+	}
+	return true;
+}
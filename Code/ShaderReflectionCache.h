@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Bump this whenever what's reflected (or how it's stored) changes so
+// that old cache files are thrown away instead of being trusted
+const uint32_t c_shaderReflectionVersion = 1;
+
+// --------------------------------------------------------
+// Everything SimpleShader needs from shader reflection,
+// kept free of Direct3D types so it can be saved, loaded
+// and checked anywhere. Enum values (buffer types, register
+// component types) are stored as their raw numbers
+// --------------------------------------------------------
+struct ShaderReflectionVariable
+{
+	std::string Name;
+	uint32_t ByteOffset = 0;
+	uint32_t Size = 0;
+};
+
+struct ShaderReflectionBuffer
+{
+	std::string Name;
+	uint32_t Type = 0;		// D3D_CBUFFER_TYPE
+	uint32_t Size = 0;
+	uint32_t BindIndex = 0;
+	std::vector<ShaderReflectionVariable> Variables;
+};
+
+struct ShaderReflectionResource
+{
+	std::string Name;
+	uint32_t BindIndex = 0;
+};
+
+struct ShaderReflectionInput
+{
+	std::string SemanticName;
+	uint32_t SemanticIndex = 0;
+	uint32_t ComponentType = 0;	// D3D_REGISTER_COMPONENT_TYPE
+	uint32_t Mask = 0;
+};
+
+struct ShaderReflectionData
+{
+	std::vector<ShaderReflectionBuffer> ConstantBuffers;
+	std::vector<ShaderReflectionResource> Textures;	// Structured buffers count as textures
+	std::vector<ShaderReflectionResource> Samplers;
+	std::vector<ShaderReflectionInput> Inputs;	// Only filled in for vertex shaders
+};
+
+// Returns the path of the cache file that sits next to a compiled shader
+std::wstring GetShaderReflectionCachePath(const std::wstring& a_shaderPath);
+
+// 64-bit FNV-1a of a compiled shader, which a cache file has to match to be used
+uint64_t HashShaderBytecode(const void* a_bytecode, size_t a_size);
+
+// Packs reflection data into a little-endian byte stream, tagged with the bytecode's hash
+void SerializeShaderReflection(const ShaderReflectionData& a_data, uint64_t a_bytecodeHash, std::vector<unsigned char>& a_bytes);
+
+// Unpacks what SerializeShaderReflection wrote. Returns false (leaving a_data
+// empty) if the bytes are truncated, from another version or another shader
+bool DeserializeShaderReflection(const unsigned char* a_bytes, size_t a_size, uint64_t a_bytecodeHash, ShaderReflectionData& a_data);
@@ -0,0 +1,120 @@
+#include "SimpleNameTable.h"
+
+#include <cstring>
+
+// --------------------------------------------------------
+// SimpleShaderHash() for a string whose length is already
+// known, which saves looking for the terminator (and the
+// recursion) at runtime
+// --------------------------------------------------------
+static unsigned int HashName(const std::string& name)
+{
+	unsigned int hash = 2166136261u;
+	for (char c : name)
+	{
+		hash ^= (unsigned char)c;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Whether a slot holds the given name - lengths first, as
+// they're nearly always enough to tell names apart
+// --------------------------------------------------------
+bool SimpleNameTable::IsMatch(const Slot& slot, unsigned int hash, const std::string& name) const
+{
+	return slot.Hash == hash &&
+		slot.NameLength == name.size() &&
+		memcmp(names.data() + slot.NameOffset, name.data(), name.size()) == 0;
+}
+
+// --------------------------------------------------------
+// Empties the table, keeping its memory
+// --------------------------------------------------------
+void SimpleNameTable::Clear()
+{
+	slots.clear();
+	names.clear();
+	count = 0;
+}
+
+// --------------------------------------------------------
+// Makes room for the given number of names - twice as many
+// slots, rounded up to a power of two, so probes stay short
+// --------------------------------------------------------
+void SimpleNameTable::Reserve(unsigned int newCount)
+{
+	Clear();
+
+	unsigned int slotCount = 4;
+	while (slotCount < newCount * 2)
+		slotCount *= 2;
+
+	Slot empty = {};
+	empty.Value = c_emptySlot;
+	slots.assign(slotCount, empty);
+}
+
+// --------------------------------------------------------
+// Linear probing from the slot the name's hash lands on
+// --------------------------------------------------------
+bool SimpleNameTable::Insert(const std::string& name, unsigned int value)
+{
+	if (slots.empty() || (count + 1) * 2 > slots.size())
+		return false;
+
+	unsigned int hash = HashName(name);
+	unsigned int mask = (unsigned int)slots.size() - 1;
+	bool isHashShared = false;
+	unsigned int i = hash & mask;
+	for (; slots[i].Value != c_emptySlot; i = (i + 1) & mask)
+	{
+		if (slots[i].Hash != hash)
+			continue;
+		if (IsMatch(slots[i], hash, name))
+			return false;
+
+		// A different name with the same hash - mark both
+		slots[i].IsHashShared = true;
+		isHashShared = true;
+	}
+
+	slots[i].Hash = hash;
+	slots[i].Value = value;
+	slots[i].NameOffset = (unsigned int)names.size();
+	slots[i].NameLength = (unsigned int)name.size();
+	slots[i].IsHashShared = isHashShared;
+	names += name;
+	count++;
+	return true;
+}
+
+int SimpleNameTable::Find(const std::string& name) const
+{
+	if (slots.empty())
+		return -1;
+
+	unsigned int hash = HashName(name);
+	unsigned int mask = (unsigned int)slots.size() - 1;
+	for (unsigned int i = hash & mask; slots[i].Value != c_emptySlot; i = (i + 1) & mask)
+	{
+		if (IsMatch(slots[i], hash, name))
+			return (int)slots[i].Value;
+	}
+	return -1;
+}
+
+int SimpleNameTable::FindHash(unsigned int nameHash) const
+{
+	if (slots.empty())
+		return -1;
+
+	unsigned int mask = (unsigned int)slots.size() - 1;
+	for (unsigned int i = nameHash & mask; slots[i].Value != c_emptySlot; i = (i + 1) & mask)
+	{
+		if (slots[i].Hash == nameHash)
+			return slots[i].IsHashShared ? -1 : (int)slots[i].Value;
+	}
+	return -1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// FNV-1a hash of a variable name, for finding it without
+// building a std::string - evaluate it at compile time by
+// storing it in a constexpr, e.g.
+//   constexpr unsigned int c_world = SimpleShaderHash("worldMatrix");
+// --------------------------------------------------------
+constexpr unsigned int SimpleShaderHash(const char* name, unsigned int hash = 2166136261u)
+{
+	return *name ? SimpleShaderHash(name + 1, (hash ^ (unsigned char)*name) * 16777619u) : hash;
+}
+
+// --------------------------------------------------------
+// Maps names to indices with open addressing in a single
+// flat array of slots, with every name packed into one
+// string - no nodes and no allocation per entry. Reserve()
+// room for everything before inserting
+// --------------------------------------------------------
+class SimpleNameTable
+{
+public:
+	void Clear();
+	void Reserve(unsigned int newCount);
+
+	// Returns false if the name is already in the table (or it's full)
+	bool Insert(const std::string& name, unsigned int value);
+
+	// Both return -1 when the name isn't there. Finding by hash alone
+	// also fails for names that share their hash with another
+	int Find(const std::string& name) const;
+	int FindHash(unsigned int nameHash) const;
+
+	unsigned int GetCount() const { return count; }
+
+private:
+	struct Slot
+	{
+		unsigned int Hash;
+		unsigned int Value;		// c_emptySlot when unused
+		unsigned int NameOffset;	// Into names
+		unsigned int NameLength;
+		bool IsHashShared;
+	};
+	static const unsigned int c_emptySlot = 0xFFFFFFFF;
+
+	bool IsMatch(const Slot& slot, unsigned int hash, const std::string& name) const;
+
+	std::vector<Slot> slots;	// Always a power of two, at most half full
+	std::string names;
+	unsigned int count = 0;
+};
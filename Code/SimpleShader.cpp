@@ -1,9 +1,19 @@
 #include "SimpleShader.h"
 
+#include <fstream>
+
 // Default error reporting state
 bool ISimpleShader::ReportErrors = false;
 bool ISimpleShader::ReportWarnings = false;
 
+// Constant buffer upload counters and options
+ConstantBufferStats ISimpleShader::UploadStats;
+bool ISimpleShader::UseDynamicBuffers = false;
+bool ISimpleShader::UseReflectionCache = true;
+
+// Binds go straight to each shader's device context until this is set
+StateCache* ISimpleShader::BindingCache = nullptr;
+
 // To enable error reporting, use either or both 
 // of the following lines somewhere in your program, 
 // preferably before loading/using any shaders.
@@ -20,6 +30,7 @@ bool ISimpleShader::ReportWarnings = false;
 // Constructor accepts Direct3D device & context
 // --------------------------------------------------------
 ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Microsoft::WRL::ComPtr<ID3D11DeviceContext> context)
+	: uploadTarget(context)
 {
 	// Save the device
 	this->device = device;
@@ -27,7 +38,7 @@ ISimpleShader::ISimpleShader(Microsoft::WRL::ComPtr<ID3D11Device> device, Micros
 
 	// Set up fields
 	this->constantBufferCount = 0;
-	this->constantBuffers = 0;
+	this->localData = 0;
 	this->shaderValid = false;
 }
 
@@ -45,34 +56,29 @@ ISimpleShader::~ISimpleShader()
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
-	// Handle constant buffers and local data buffers
-	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		delete[] constantBuffers[i].LocalDataBuffer;
-	}
-
-	if (constantBuffers)
+	// Handle constant buffers and their local data
+	constantBuffers.clear();
+	constantBufferCount = 0;
+	if (localData)
 	{
-		delete[] constantBuffers;
-		constantBufferCount = 0;
+		_aligned_free(localData);
+		localData = 0;
 	}
 
-	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
-		delete shaderResourceViews[i];
-	
-	for (unsigned int i = 0; i < samplerStates.size(); i++)
-		delete samplerStates[i];
+	variables.clear();
+	shaderResourceViews.clear();
+	samplerStates.clear();
 
 	// Clean up tables
-	varTable.clear();
-	cbTable.clear();
-	samplerTable.clear();
-	textureTable.clear();
+	varTable.Clear();
+	cbTable.Clear();
+	samplerTable.Clear();
+	textureTable.Clear();
 }
 
 // --------------------------------------------------------
 // Loads the specified shader and builds the variable table 
-// using shader reflection.
+// using shader reflection (or the cached results of it).
 //
 // shaderFile - A "wide string" specifying the compiled shader to load
 // 
@@ -94,6 +100,29 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Get the reflection data - from the cache file next to the
+	// shader if it's there and matches, or from the shader itself
+	uint64_t bytecodeHash = HashShaderBytecode(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
+	std::wstring cachePath = GetShaderReflectionCachePath(shaderFile);
+	if (!UseReflectionCache || !ReadReflectionCache(cachePath, bytecodeHash))
+	{
+		if (!ReflectShader())
+		{
+			if (ReportErrors)
+			{
+				LogError("SimpleShader::LoadShaderFile() - Error reflecting shader from file '");
+				LogW(shaderFile);
+				LogError("'.\n");
+			}
+
+			return false;
+		}
+
+		// Only cache what reflection actually found
+		if (UseReflectionCache)
+			WriteReflectionCache(cachePath, bytecodeHash);
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
 	shaderValid = CreateShader(shaderBlob);
@@ -109,63 +138,179 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Create resource arrays, sizing everything up front so
+	// nothing has to grow while it's filled in
+	constantBufferCount = (unsigned int)reflection.ConstantBuffers.size();
+	constantBuffers.resize(constantBufferCount);
+	shaderResourceViews.reserve(reflection.Textures.size());
+	samplerStates.reserve(reflection.Samplers.size());
+
+	unsigned int variableCount = 0;
+	size_t localDataSize = 0;
+	for (const ShaderReflectionBuffer& buffer : reflection.ConstantBuffers)
+	{
+		variableCount += (unsigned int)buffer.Variables.size();
+		localDataSize += ((buffer.Size + 15) / 16) * 16;
+	}
+	variables.reserve(variableCount);
+
+	cbTable.Reserve(constantBufferCount);
+	varTable.Reserve(variableCount);
+	textureTable.Reserve((unsigned int)reflection.Textures.size());
+	samplerTable.Reserve((unsigned int)reflection.Samplers.size());
+
+	// One slab for every buffer's local data, each starting on a 16-byte boundary
+	if (localDataSize > 0)
+	{
+		localData = (unsigned char*)_aligned_malloc(localDataSize, 16);
+		ZeroMemory(localData, localDataSize);
+	}
+	
+	// Handle bound resources (like textures and samplers)
+	for (const ShaderReflectionResource& resource : reflection.Textures)
+	{
+		SimpleSRV srv = {};
+		srv.BindIndex = resource.BindIndex;							// Shader bind point
+		srv.Index = (unsigned int)shaderResourceViews.size();		// Raw index
+
+		textureTable.Insert(resource.Name, srv.Index);
+		shaderResourceViews.push_back(srv);
+	}
+
+	for (const ShaderReflectionResource& resource : reflection.Samplers)
+	{
+		SimpleSampler samp = {};
+		samp.BindIndex = resource.BindIndex;				// Shader bind point
+		samp.Index = (unsigned int)samplerStates.size();	// Raw index
+
+		samplerTable.Insert(resource.Name, samp.Index);
+		samplerStates.push_back(samp);
+	}
+
+	// Loop through all constant buffers
+	size_t localDataOffset = 0;
+	for (unsigned int b = 0; b < constantBufferCount; b++)
+	{
+		const ShaderReflectionBuffer& bufferDesc = reflection.ConstantBuffers[b];
+
+		// Save the type, which we reference when setting these buffers
+		constantBuffers[b].Type = (D3D_CBUFFER_TYPE)bufferDesc.Type;
+		
+		// Set up the buffer and put its index in the table
+		constantBuffers[b].BindIndex = bufferDesc.BindIndex;
+		constantBuffers[b].Name = bufferDesc.Name;
+		cbTable.Insert(bufferDesc.Name, b);
+
+		// Create this constant buffer
+		D3D11_BUFFER_DESC newBuffDesc = {};
+		newBuffDesc.Usage = UseDynamicBuffers ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
+		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		newBuffDesc.CPUAccessFlags = UseDynamicBuffers ? D3D11_CPU_ACCESS_WRITE : 0;
+		newBuffDesc.MiscFlags = 0;
+		newBuffDesc.StructureByteStride = 0;
+		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
+
+		// Give this constant buffer its part of the local data slab
+		constantBuffers[b].Size = bufferDesc.Size;
+		constantBuffers[b].LocalDataBuffer = localData + localDataOffset;
+		localDataOffset += newBuffDesc.ByteWidth;
+
+		// Nothing's on the GPU yet, so the whole thing starts dirty
+		constantBuffers[b].IsDynamic = UseDynamicBuffers;
+		constantBuffers[b].IsDirty = true;
+		constantBuffers[b].DirtyStart = 0;
+		constantBuffers[b].DirtyEnd = bufferDesc.Size;
+
+		// Loop through all variables in this buffer
+		constantBuffers[b].FirstVariable = (unsigned int)variables.size();
+		constantBuffers[b].VariableCount = (unsigned int)bufferDesc.Variables.size();
+		for (const ShaderReflectionVariable& varDesc : bufferDesc.Variables)
+		{
+			// Create the variable struct
+			SimpleShaderVariable varStruct = {};
+			varStruct.ConstantBufferIndex = b;
+			varStruct.ByteOffset = varDesc.ByteOffset;
+			varStruct.Size = varDesc.Size;
+
+			// Add this variable to the table and the array
+			varTable.Insert(varDesc.Name, (unsigned int)variables.size());
+			variables.push_back(varStruct);
+		}
+	}
+
+	// Names sharing a hash can't be told apart by it, so neither is
+	// found by GetVariableHandle(hash) - let someone know
+	if (ReportWarnings)
+	{
+		for (const ShaderReflectionBuffer& buffer : reflection.ConstantBuffers)
+		{
+			for (const ShaderReflectionVariable& varDesc : buffer.Variables)
+			{
+				if (varTable.FindHash(SimpleShaderHash(varDesc.Name.c_str())) >= 0)
+					continue;
+				LogWarning("SimpleShader::LoadShaderFile() - Shader variable '");
+				Log(varDesc.Name);
+				LogWarning("' has the same name hash as another variable. It can't be found by hash.\n");
+			}
+		}
+	}
+
+	// All set
+	return true;
+}
+
+// --------------------------------------------------------
+// Fills in the reflection data from the shader blob using
+// D3D shader reflection - the slow path, taken when there's
+// no usable cache file
+// --------------------------------------------------------
+bool ISimpleShader::ReflectShader()
+{
+	reflection = ShaderReflectionData();
+
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
+	HRESULT hr = D3DReflect(
 		shaderBlob->GetBufferPointer(),
 		shaderBlob->GetBufferSize(),
 		IID_ID3D11ShaderReflection,
 		(void**)refl.GetAddressOf());
+	if (FAILED(hr))
+		return false;
 	
 	// Get the description of the shader
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Create resource arrays
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
-	// Handle bound resources (like shaders and samplers)
-	unsigned int resourceCount = shaderDesc.BoundResources;
-	for (unsigned int r = 0; r < resourceCount; r++)
+	// Handle bound resources (like textures and samplers)
+	for (unsigned int r = 0; r < shaderDesc.BoundResources; r++)
 	{
 		// Get this resource's description
 		D3D11_SHADER_INPUT_BIND_DESC resourceDesc;
 		refl->GetResourceBindingDesc(r, &resourceDesc);
 
+		ShaderReflectionResource resource;
+		resource.Name = resourceDesc.Name;
+		resource.BindIndex = resourceDesc.BindPoint;
+
 		// Check the type
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_STRUCTURED: // Treat structured buffers as texture resources
 		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
-
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
+			reflection.Textures.push_back(resource);
 			break;
 
 		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
-
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
+			reflection.Samplers.push_back(resource);
 			break;
 		}
 	}
 
 	// Loop through all constant buffers
-	for (unsigned int b = 0; b < constantBufferCount; b++)
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
 	{
 		// Get this buffer
 		ID3D11ShaderReflectionConstantBuffer* cb =
@@ -175,64 +320,94 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		D3D11_SHADER_BUFFER_DESC bufferDesc;
 		cb->GetDesc(&bufferDesc);
 
-		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
-		
 		// Get the description of the resource binding, so
 		// we know exactly how it's bound in the shader
 		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
 		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
-		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
-
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc = {};
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = ((bufferDesc.Size + 15) / 16) * 16; // Quick and dirty 16-byte alignment using integer division
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, constantBuffers[b].ConstantBuffer.GetAddressOf());
 
-		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		ShaderReflectionBuffer buffer;
+		buffer.Name = bufferDesc.Name;
+		buffer.Type = (uint32_t)bufferDesc.Type;
+		buffer.Size = bufferDesc.Size;
+		buffer.BindIndex = bindDesc.BindPoint;
 
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
-			// Get this variable
-			ID3D11ShaderReflectionVariable* var =
-				cb->GetVariableByIndex(v);
-			
-			// Get the description of the variable and its type
+			// Get the description of this variable
 			D3D11_SHADER_VARIABLE_DESC varDesc;
-			var->GetDesc(&varDesc);
+			cb->GetVariableByIndex(v)->GetDesc(&varDesc);
 
-			// Create the variable struct
-			SimpleShaderVariable varStruct = {};
-			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
+			ShaderReflectionVariable variable;
+			variable.Name = varDesc.Name;
+			variable.ByteOffset = varDesc.StartOffset;
+			variable.Size = varDesc.Size;
+			buffer.Variables.push_back(variable);
+		}
+
+		reflection.ConstantBuffers.push_back(buffer);
+	}
 
-			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
-			constantBuffers[b].Variables.push_back(varStruct);
+	// The input signature, which vertex shaders need for their input layout
+	if (D3D11_SHVER_GET_TYPE(shaderDesc.Version) == D3D11_SHVER_VERTEX_SHADER)
+	{
+		for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+		{
+			D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+			refl->GetInputParameterDesc(i, &paramDesc);
+
+			ShaderReflectionInput input;
+			input.SemanticName = paramDesc.SemanticName;
+			input.SemanticIndex = paramDesc.SemanticIndex;
+			input.ComponentType = (uint32_t)paramDesc.ComponentType;
+			input.Mask = paramDesc.Mask;
+			reflection.Inputs.push_back(input);
 		}
 	}
 
-	// All set
 	return true;
 }
 
+// --------------------------------------------------------
+// Loads the reflection data from a cache file, returning
+// false if it's missing or was made from different bytecode
+// --------------------------------------------------------
+bool ISimpleShader::ReadReflectionCache(const std::wstring& cachePath, uint64_t bytecodeHash)
+{
+	std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::vector<unsigned char> bytes((size_t)file.tellg());
+	file.seekg(0);
+	if (!file.read((char*)bytes.data(), (std::streamsize)bytes.size()))
+		return false;
+
+	return DeserializeShaderReflection(bytes.data(), bytes.size(), bytecodeHash, reflection);
+}
+
+// --------------------------------------------------------
+// Saves the reflection data for next time - failing to is
+// harmless, it just means reflecting again on the next run
+// --------------------------------------------------------
+void ISimpleShader::WriteReflectionCache(const std::wstring& cachePath, uint64_t bytecodeHash)
+{
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(reflection, bytecodeHash, bytes);
+
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return;
+
+	file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+	if (!file.good())
+	{
+		// Never leave a half-written cache behind for the next run to trip over
+		file.close();
+		DeleteFileW(cachePath.c_str());
+	}
+}
+
 // --------------------------------------------------------
 // Helper for looking up a variable by name and also
 // verifying that it is the requested size
@@ -243,15 +418,14 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-		varTable.find(name);
+	int index = varTable.Find(name);
 
 	// Did we find the key?
-	if (result == varTable.end())
+	if (index < 0)
 		return 0;
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
+	// Grab the variable itself
+	SimpleShaderVariable* var = &variables[index];
 
 	// Is the data size correct ?
 	if (size > 0 && var->Size != size)
@@ -267,15 +441,14 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
-		cbTable.find(name);
+	int index = cbTable.Find(name);
 
 	// Did we find the key?
-	if (result == cbTable.end())
+	if (index < 0)
 		return 0;
 
 	// Success
-	return result->second;
+	return &constantBuffers[index];
 }
 
 // --------------------------------------------------------
@@ -345,14 +518,9 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy any that changed
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer.Get(), 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
-	}
+		UploadConstantBuffer(&constantBuffers[i]);
 }
 
 // --------------------------------------------------------
@@ -379,10 +547,8 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	SimpleConstantBuffer* cb = &this->constantBuffers[index];
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadConstantBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -401,10 +567,8 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	SimpleConstantBuffer* cb = this->FindConstantBuffer(bufferName);
 	if (!cb) return;
 
-	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer.Get(), 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	// Copy the data (if it changed) and get out
+	UploadConstantBuffer(cb);
 }
 
 
@@ -446,15 +610,30 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 	}
 
 	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	WriteLocalData(var->ConstantBufferIndex, var->ByteOffset, data, size);
 
 	// Success
 	return true;
 }
 
+// --------------------------------------------------------
+// Copies data into a constant buffer's local data buffer,
+// marking it dirty if it changed
+// --------------------------------------------------------
+void ISimpleShader::WriteLocalData(unsigned int bufferIndex, unsigned int byteOffset, const void* data, unsigned int size)
+{
+	WriteConstantBufferData(constantBuffers[bufferIndex], byteOffset, data, size);
+}
+
+// --------------------------------------------------------
+// Copies a constant buffer's local data to the GPU, or
+// skips it when nothing has changed since the last copy
+// --------------------------------------------------------
+void ISimpleShader::UploadConstantBuffer(SimpleConstantBuffer* cb)
+{
+	UploadConstantBufferData(*cb, cb->ConstantBuffer.Get(), uploadTarget, UploadStats);
+}
+
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
@@ -535,6 +714,63 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Looks up a variable by name, for the handle setters -
+// the handle is invalid if the variable doesn't exist
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(std::string name)
+{
+	SimpleShaderHandle handle;
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var == 0)
+		return handle;
+
+	handle.ByteOffset = var->ByteOffset;
+	handle.Size = var->Size;
+	handle.ConstantBufferIndex = var->ConstantBufferIndex;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Looks up a variable by the SimpleShaderHash() of its
+// name - the handle is invalid if the variable doesn't
+// exist (or shares its hash with another)
+// --------------------------------------------------------
+SimpleShaderHandle ISimpleShader::GetVariableHandle(unsigned int nameHash)
+{
+	SimpleShaderHandle handle;
+	int index = varTable.FindHash(nameHash);
+	if (index < 0)
+		return handle;
+
+	handle.ByteOffset = variables[index].ByteOffset;
+	handle.Size = variables[index].Size;
+	handle.ConstantBufferIndex = variables[index].ConstantBufferIndex;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Sets a variable through a handle from GetVariableHandle()
+//
+// Returns true if data is copied, false if the handle is
+// invalid or the data won't fit in the variable
+// --------------------------------------------------------
+bool ISimpleShader::SetData(const SimpleShaderHandle& handle, const void* data, unsigned int size)
+{
+	if (!handle.IsValid() || size > handle.Size || handle.ConstantBufferIndex >= constantBufferCount)
+		return false;
+
+	WriteLocalData(handle.ConstantBufferIndex, handle.ByteOffset, data, size);
+	return true;
+}
+
+bool ISimpleShader::SetInt(const SimpleShaderHandle& handle, int data) { return SetData(handle, &data, sizeof(int)); }
+bool ISimpleShader::SetFloat(const SimpleShaderHandle& handle, float data) { return SetData(handle, &data, sizeof(float)); }
+bool ISimpleShader::SetFloat2(const SimpleShaderHandle& handle, const DirectX::XMFLOAT2& data) { return SetData(handle, &data, sizeof(float) * 2); }
+bool ISimpleShader::SetFloat3(const SimpleShaderHandle& handle, const DirectX::XMFLOAT3& data) { return SetData(handle, &data, sizeof(float) * 3); }
+bool ISimpleShader::SetFloat4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4& data) { return SetData(handle, &data, sizeof(float) * 4); }
+bool ISimpleShader::SetMatrix4x4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4X4& data) { return SetData(handle, &data, sizeof(float) * 16); }
+
 // --------------------------------------------------------
 // Determines if the shader contains the specified
 // variable within one of its constant buffers
@@ -576,15 +812,14 @@ const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleSRV*>::iterator result =
-		textureTable.find(name);
+	int index = textureTable.Find(name);
 
 	// Did we find the key?
-	if (result == textureTable.end())
+	if (index < 0)
 		return 0;
 
 	// Success
-	return result->second;
+	return &shaderResourceViews[index];
 }
 
 
@@ -599,7 +834,7 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 	if (index >= shaderResourceViews.size()) return 0;
 
 	// Grab the bind index
-	return shaderResourceViews[index];
+	return &shaderResourceViews[index];
 }
 
 
@@ -611,15 +846,14 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleSampler*>::iterator result =
-		samplerTable.find(name);
+	int index = samplerTable.Find(name);
 
 	// Did we find the key?
-	if (result == samplerTable.end())
+	if (index < 0)
 		return 0;
 
 	// Success
-	return result->second;
+	return &samplerStates[index];
 }
 
 // --------------------------------------------------------
@@ -633,7 +867,7 @@ const SimpleSampler* ISimpleShader::GetSamplerInfo(unsigned int index)
 	if (index >= samplerStates.size()) return 0;
 
 	// Grab the bind index
-	return samplerStates[index];
+	return &samplerStates[index];
 }
 
 
@@ -680,6 +914,16 @@ const SimpleConstantBuffer * ISimpleShader::GetBufferInfo(unsigned int index)
 	return &constantBuffers[index];
 }
 
+// --------------------------------------------------------
+// Looks up a constant buffer's index by the SimpleShaderHash()
+// of its name, for CopyBufferData(unsigned int) - returns -1
+// if the buffer doesn't exist (or shares its hash with another)
+// --------------------------------------------------------
+int ISimpleShader::GetBufferIndex(unsigned int nameHash)
+{
+	return cbTable.FindHash(nameHash);
+}
+
 
 
 
@@ -767,32 +1011,17 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 		return true;
 
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
-	// matches what the vertex shader expects.  Code adapted from:
+	// input signature from reflection to create an input layout
+	// that matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-	// Reflect shader info
-	Microsoft::WRL::ComPtr<ID3D11ShaderReflection> refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)refl.GetAddressOf());
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
 	// Read input layout description from shader info
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	for (const ShaderReflectionInput& paramDesc : reflection.Inputs)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
+		const std::string& sem = paramDesc.SemanticName;
 		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
 		bool isPerInstance = 
 			lenDiff >= 0 &&
@@ -800,7 +1029,7 @@ bool SimpleVertexShader::CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlo
 
 		// Fill out input element desc
 		D3D11_INPUT_ELEMENT_DESC elementDesc = {};
-		elementDesc.SemanticName = paramDesc.SemanticName;
+		elementDesc.SemanticName = paramDesc.SemanticName.c_str();
 		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
 		elementDesc.InputSlot = 0;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
@@ -869,8 +1098,16 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout.Get());
-	deviceContext->VSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+	{
+		BindingCache->SetInputLayout(inputLayout.Get());
+		BindingCache->SetShader(ShaderStage::Vertex, shader.Get());
+	}
+	else
+	{
+		deviceContext->IASetInputLayout(inputLayout.Get());
+		deviceContext->VSSetShader(shader.Get(), 0, 0);
+	}
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -880,10 +1117,13 @@ void SimpleVertexShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Vertex, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->VSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -911,7 +1151,10 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Vertex, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -941,7 +1184,10 @@ bool SimpleVertexShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Vertex, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1012,7 +1258,10 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+		BindingCache->SetShader(ShaderStage::Pixel, shader.Get());
+	else
+		deviceContext->PSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,10 +1271,13 @@ void SimplePixelShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Pixel, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->PSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1053,7 +1305,10 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, Microsoft::WRL::
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Pixel, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1083,7 +1338,10 @@ bool SimplePixelShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr
 	}
 
 	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Pixel, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1156,7 +1414,10 @@ void SimpleDomainShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->DSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+		BindingCache->SetShader(ShaderStage::Domain, shader.Get());
+	else
+		deviceContext->DSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1166,10 +1427,13 @@ void SimpleDomainShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Domain, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->DSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1197,7 +1461,10 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, Microsoft::WRL:
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Domain, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1227,7 +1494,10 @@ bool SimpleDomainShader::SetSamplerState(std::string name, Microsoft::WRL::ComPt
 	}
 
 	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Domain, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1299,7 +1569,10 @@ void SimpleHullShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->HSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+		BindingCache->SetShader(ShaderStage::Hull, shader.Get());
+	else
+		deviceContext->HSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1309,10 +1582,13 @@ void SimpleHullShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Hull, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->HSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1340,7 +1616,10 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, Microsoft::WRL::C
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Hull, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1370,7 +1649,10 @@ bool SimpleHullShader::SetSamplerState(std::string name, Microsoft::WRL::ComPtr<
 	}
 
 	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Hull, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1573,7 +1855,10 @@ void SimpleGeometryShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->GSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+		BindingCache->SetShader(ShaderStage::Geometry, shader.Get());
+	else
+		deviceContext->GSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1583,10 +1868,13 @@ void SimpleGeometryShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Geometry, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->GSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1614,7 +1902,10 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, Microsoft::WR
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Geometry, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1644,7 +1935,10 @@ bool SimpleGeometryShader::SetSamplerState(std::string name, Microsoft::WRL::Com
 	}
 
 	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Geometry, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -1783,7 +2077,10 @@ void SimpleComputeShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->CSSetShader(shader.Get(), 0, 0);
+	if (BindingCache)
+		BindingCache->SetShader(ShaderStage::Compute, shader.Get());
+	else
+		deviceContext->CSSetShader(shader.Get(), 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1793,10 +2090,13 @@ void SimpleComputeShader::SetShaderAndCBs()
 			continue;
 
 		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			constantBuffers[i].ConstantBuffer.GetAddressOf());
+		if (BindingCache)
+			BindingCache->SetConstantBuffer(ShaderStage::Compute, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer.Get());
+		else
+			deviceContext->CSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				constantBuffers[i].ConstantBuffer.GetAddressOf());
 	}
 }
 
@@ -1822,6 +2122,7 @@ void SimpleComputeShader::SetShaderAndCBs()
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ)
 {
+	if (BindingCache) BindingCache->Flush();
 	deviceContext->Dispatch(groupsX, groupsY, groupsZ);
 }
 
@@ -1847,6 +2148,7 @@ void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int gr
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ)
 {
+	if (BindingCache) BindingCache->Flush();
 	deviceContext->Dispatch(
 		max((unsigned int)ceil((float)threadsX / this->threadsX), 1),
 		max((unsigned int)ceil((float)threadsY / this->threadsY), 1),
@@ -1885,7 +2187,10 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, Microsoft::WRL
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetShaderResource(ShaderStage::Compute, srvInfo->BindIndex, srv.Get());
+	else
+		deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, srv.GetAddressOf());
 
 	// Success
 	return true;
@@ -1915,7 +2220,10 @@ bool SimpleComputeShader::SetSamplerState(std::string name, Microsoft::WRL::ComP
 	}
 
 	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
+	if (BindingCache)
+		BindingCache->SetSampler(ShaderStage::Compute, sampInfo->BindIndex, samplerState.Get());
+	else
+		deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, samplerState.GetAddressOf());
 
 	// Success
 	return true;
@@ -11,6 +11,12 @@
 #include <vector>
 #include <string>
 
+#include "ConstantBufferData.h"
+#include "D3D11StateTarget.h"
+#include "ShaderReflectionCache.h"
+#include "SimpleNameTable.h"
+#include "StateCache.h"
+
 
 // --------------------------------------------------------
 // Used by simple shaders to store information about
@@ -23,20 +29,34 @@ struct SimpleShaderVariable
 	unsigned int ConstantBufferIndex;
 };
 
+// --------------------------------------------------------
+// A variable's location, looked up once so it can be set
+// over and over without searching for it by name. Only
+// valid for the shader it came from
+// --------------------------------------------------------
+struct SimpleShaderHandle
+{
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;	// Zero when the variable wasn't found
+	unsigned int ConstantBufferIndex = 0;
+
+	bool IsValid() const { return Size > 0; }
+};
+
 // --------------------------------------------------------
 // Contains information about a specific
 // constant buffer in a shader, as well as
-// the local data buffer for it
+// the local data buffer for it (which points
+// into the shader's single local data slab)
 // --------------------------------------------------------
-struct SimpleConstantBuffer
+struct SimpleConstantBuffer : LocalConstantBuffer
 {
 	std::string Name;
 	D3D_CBUFFER_TYPE Type = D3D_CBUFFER_TYPE::D3D11_CT_CBUFFER;
-	unsigned int Size = 0;
 	unsigned int BindIndex = 0;
 	Microsoft::WRL::ComPtr<ID3D11Buffer> ConstantBuffer = 0;
-	unsigned char* LocalDataBuffer = 0;
-	std::vector<SimpleShaderVariable> Variables;
+	unsigned int FirstVariable = 0;		// This buffer's range of the shader's variables
+	unsigned int VariableCount = 0;
 };
 
 // --------------------------------------------------------
@@ -89,6 +109,19 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Looks a variable up once, for the setters below - these skip
+	// the string and the search entirely
+	SimpleShaderHandle GetVariableHandle(std::string name);
+	SimpleShaderHandle GetVariableHandle(unsigned int nameHash);	// From SimpleShaderHash()
+
+	bool SetData(const SimpleShaderHandle& handle, const void* data, unsigned int size);
+	bool SetInt(const SimpleShaderHandle& handle, int data);
+	bool SetFloat(const SimpleShaderHandle& handle, float data);
+	bool SetFloat2(const SimpleShaderHandle& handle, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(const SimpleShaderHandle& handle, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(const SimpleShaderHandle& handle, const DirectX::XMFLOAT4X4& data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv) = 0;
 	virtual bool SetSamplerState(std::string name, Microsoft::WRL::ComPtr<ID3D11SamplerState> samplerState) = 0;
@@ -103,17 +136,18 @@ public:
 	
 	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
-	size_t GetShaderResourceViewCount() { return textureTable.size(); }
+	size_t GetShaderResourceViewCount() { return shaderResourceViews.size(); }
 	
 	const SimpleSampler* GetSamplerInfo(std::string name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
-	size_t GetSamplerCount() { return samplerTable.size(); }
+	size_t GetSamplerCount() { return samplerStates.size(); }
 
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
 	unsigned int GetBufferSize(unsigned int index);
 	const SimpleConstantBuffer* GetBufferInfo(std::string name);
 	const SimpleConstantBuffer* GetBufferInfo(unsigned int index);
+	int GetBufferIndex(unsigned int nameHash);	// From SimpleShaderHash(), -1 if there's no such buffer
 	
 	// Misc getters
 	Microsoft::WRL::ComPtr<ID3DBlob> GetShaderBlob() { return shaderBlob; }
@@ -122,28 +156,60 @@ public:
 	static bool ReportErrors;
 	static bool ReportWarnings;
 
+	// Running totals for every shader's constant buffers - reset
+	// them whenever you want to start measuring. Copies of buffers
+	// that haven't changed since their last upload are skipped
+	static ConstantBufferStats UploadStats;
+
+	// Creates constant buffers as dynamic, so they're uploaded with
+	// Map(WRITE_DISCARD) - only affects shaders loaded afterwards
+	static bool UseDynamicBuffers;
+
+	// Saves reflection results in a .refl file next to each .cso and
+	// loads them from there on later runs, instead of reflecting again
+	static bool UseReflectionCache;
+
+	// When set, SetShader(), SetShaderResourceView() and SetSamplerState()
+	// go through this instead of the device context, and only reach the
+	// context when it's flushed (which dispatching a compute shader does)
+	static StateCache* BindingCache;
+
 protected:
 	
 	bool shaderValid;
 	Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
 	Microsoft::WRL::ComPtr<ID3D11Device> device;
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext> deviceContext;
+	D3D11StateTarget uploadTarget;	// Where constant buffer data goes
 
 	// Resource counts
 	unsigned int constantBufferCount;
 	
-	// Maps for variables and buffers
-	SimpleConstantBuffer*		constantBuffers; // For index-based lookup
-	std::vector<SimpleSRV*>		shaderResourceViews;
-	std::vector<SimpleSampler*>	samplerStates;
-	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
-	std::unordered_map<std::string, SimpleSRV*> textureTable;
-	std::unordered_map<std::string, SimpleSampler*> samplerTable;
+	// Flat arrays of everything in the shader, for index-based lookup
+	std::vector<SimpleConstantBuffer>	constantBuffers;
+	std::vector<SimpleShaderVariable>	variables;	// Grouped by constant buffer
+	std::vector<SimpleSRV>				shaderResourceViews;
+	std::vector<SimpleSampler>			samplerStates;
+	unsigned char*						localData;	// Every constant buffer's local data, 16-byte aligned
+
+	// Tables from names to indices in the arrays above
+	SimpleNameTable cbTable;
+	SimpleNameTable varTable;
+	SimpleNameTable textureTable;
+	SimpleNameTable samplerTable;
+
+	// What the tables above were built from - also used by vertex
+	// shaders for their input layout
+	ShaderReflectionData reflection;
 
 	// Initialization method
 	bool LoadShaderFile(LPCWSTR shaderFile);
 
+	// Getting the reflection data, from the shader or a cache file
+	bool ReflectShader();
+	bool ReadReflectionCache(const std::wstring& cachePath, uint64_t bytecodeHash);
+	void WriteReflectionCache(const std::wstring& cachePath, uint64_t bytecodeHash);
+
 	// Pure virtual functions for dealing with shader types
 	virtual bool CreateShader(Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob) = 0;
 	virtual void SetShaderAndCBs() = 0;
@@ -154,6 +220,12 @@ protected:
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
 
+	// Copies into a constant buffer's local data, marking it dirty if it changed
+	void WriteLocalData(unsigned int bufferIndex, unsigned int byteOffset, const void* data, unsigned int size);
+
+	// Sends a constant buffer's local data to the GPU, if it's dirty
+	void UploadConstantBuffer(SimpleConstantBuffer* cb);
+
 	// Error logging
 	void Log(std::string message, WORD color);
 	void LogW(std::wstring message, WORD color);
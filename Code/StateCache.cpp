@@ -0,0 +1,91 @@
+#include "StateCache.h"
+
+StateCache::StateCache(IStateCacheTarget* a_pTarget)
+	: m_pTarget(a_pTarget), m_bindsRequested(0), m_callsMade(0)
+{
+}
+
+StateCache::~StateCache() {}
+
+void StateCache::SetInputLayout(void* a_pLayout)
+{
+	m_bindsRequested++;
+	m_inputLayout.Set(0, a_pLayout);
+}
+
+void StateCache::SetShader(ShaderStage a_stage, void* a_pShader)
+{
+	m_bindsRequested++;
+	m_stages[(unsigned int)a_stage].Shader.Set(0, a_pShader);
+}
+
+void StateCache::SetConstantBuffer(ShaderStage a_stage, unsigned int a_slot, void* a_pBuffer)
+{
+	m_bindsRequested++;
+	m_stages[(unsigned int)a_stage].ConstantBuffers.Set(a_slot, a_pBuffer);
+}
+
+void StateCache::SetShaderResource(ShaderStage a_stage, unsigned int a_slot, void* a_pResource)
+{
+	m_bindsRequested++;
+	m_stages[(unsigned int)a_stage].ShaderResources.Set(a_slot, a_pResource);
+}
+
+void StateCache::SetSampler(ShaderStage a_stage, unsigned int a_slot, void* a_pSampler)
+{
+	m_bindsRequested++;
+	m_stages[(unsigned int)a_stage].Samplers.Set(a_slot, a_pSampler);
+}
+
+// --------------------------------------------------------
+// Input layout first, then each stage's shader followed by
+// its buffers, textures and samplers
+// --------------------------------------------------------
+void StateCache::Flush()
+{
+	IStateCacheTarget* target = m_pTarget;
+	m_callsMade += m_inputLayout.Flush([target](unsigned int, unsigned int, void* const* a_ppValues) {
+		target->SetInputLayout(a_ppValues[0]);
+	});
+
+	for (unsigned int s = 0; s < (unsigned int)ShaderStage::Count; s++) {
+		ShaderStage stage = (ShaderStage)s;
+		StageSlots& slots = m_stages[s];
+		m_callsMade += slots.Shader.Flush([target, stage](unsigned int, unsigned int, void* const* a_ppValues) {
+			target->SetShader(stage, a_ppValues[0]);
+		});
+		m_callsMade += slots.ConstantBuffers.Flush([target, stage](unsigned int a_start, unsigned int a_count, void* const* a_ppValues) {
+			target->SetConstantBuffers(stage, a_start, a_count, a_ppValues);
+		});
+		m_callsMade += slots.ShaderResources.Flush([target, stage](unsigned int a_start, unsigned int a_count, void* const* a_ppValues) {
+			target->SetShaderResources(stage, a_start, a_count, a_ppValues);
+		});
+		m_callsMade += slots.Samplers.Flush([target, stage](unsigned int a_start, unsigned int a_count, void* const* a_ppValues) {
+			target->SetSamplers(stage, a_start, a_count, a_ppValues);
+		});
+	}
+}
+
+void StateCache::Invalidate()
+{
+	m_inputLayout.Invalidate();
+	for (StageSlots& slots : m_stages) {
+		slots.Shader.Invalidate();
+		slots.ConstantBuffers.Invalidate();
+		slots.ShaderResources.Invalidate();
+		slots.Samplers.Invalidate();
+	}
+}
+
+void StateCache::ResetStats()
+{
+	m_bindsRequested = 0;
+	m_callsMade = 0;
+}
+
+unsigned int StateCache::GetBindsRequested() { return m_bindsRequested; }
+unsigned int StateCache::GetCallsMade() { return m_callsMade; }
+
+// Every bind used to be its own call, so whatever wasn't made was saved
+// (binds still pending when the stats were reset can leave more calls than binds)
+unsigned int StateCache::GetCallsSaved() { return m_bindsRequested > m_callsMade ? m_bindsRequested - m_callsMade : 0; }
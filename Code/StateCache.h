@@ -0,0 +1,178 @@
+#pragma once
+
+#include <bitset>
+
+// The pipeline stages a StateCache tracks, in the order they're flushed
+enum class ShaderStage : unsigned int
+{
+	Vertex,
+	Hull,
+	Domain,
+	Geometry,
+	Pixel,
+	Compute,
+	Count
+};
+
+// Slot counts for one stage, matching Direct3D 11's limits
+const unsigned int c_constantBufferSlotCount = 14;
+const unsigned int c_shaderResourceSlotCount = 128;
+const unsigned int c_samplerSlotCount = 16;
+
+// --------------------------------------------------------
+// Whatever a StateCache sends its binds to. Every object is
+// passed as a void* so the cache itself never needs to know
+// about Direct3D - the target casts them back
+// --------------------------------------------------------
+class IStateCacheTarget
+{
+public:
+	virtual ~IStateCacheTarget() {}
+
+	virtual void SetInputLayout(void* a_pLayout) = 0;
+	virtual void SetShader(ShaderStage a_stage, void* a_pShader) = 0;
+	virtual void SetConstantBuffers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppBuffers) = 0;
+	virtual void SetShaderResources(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppResources) = 0;
+	virtual void SetSamplers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppSamplers) = 0;
+};
+
+// --------------------------------------------------------
+// A copy of what's bound to one kind of slot, plus the binds
+// asked for since the last flush. A bind that matches what's
+// already there is dropped, and the rest go out one call per
+// run of neighboring slots
+// --------------------------------------------------------
+template<unsigned int SlotCount>
+class BindingSlots
+{
+public:
+	BindingSlots() { Invalidate(); }
+
+	/* Queues a bind, returns false if it matches what's already bound */
+	bool Set(unsigned int a_slot, void* a_pValue)
+	{
+		if (a_slot >= SlotCount)
+			return false;
+
+		m_pending[a_slot] = a_pValue;
+		if (m_isKnown[a_slot] && m_bound[a_slot] == a_pValue) {
+			m_isDirty.reset(a_slot);
+			return false;
+		}
+
+		m_isDirty.set(a_slot);
+		if (a_slot < m_firstDirty) m_firstDirty = a_slot;
+		if (a_slot > m_lastDirty) m_lastDirty = a_slot;
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// Calls a_submit(startSlot, count, values) once per run of
+	// changed slots. A run carries on across slots that are
+	// known to hold their pending value already, since binding
+	// them again costs nothing next to starting another call.
+	// Returns the number of calls made
+	// --------------------------------------------------------
+	template<typename Submit>
+	unsigned int Flush(Submit a_submit)
+	{
+		unsigned int calls = 0;
+		unsigned int slot = m_firstDirty;
+		while (slot <= m_lastDirty) {
+			if (!m_isDirty[slot]) {
+				slot++;
+				continue;
+			}
+
+			unsigned int end = slot + 1;
+			for (unsigned int next = end; next <= m_lastDirty && (m_isDirty[next] || m_isKnown[next]); next++) {
+				if (m_isDirty[next])
+					end = next + 1;
+			}
+
+			a_submit(slot, end - slot, &m_pending[slot]);
+			for (unsigned int i = slot; i < end; i++) {
+				m_bound[i] = m_pending[i];
+				m_isKnown.set(i);
+			}
+			calls++;
+			slot = end;
+		}
+
+		m_isDirty.reset();
+		m_firstDirty = SlotCount;
+		m_lastDirty = 0;
+		return calls;
+	}
+
+	/* Forgets what's bound (and anything pending), so every slot is bound again next time */
+	void Invalidate()
+	{
+		for (unsigned int i = 0; i < SlotCount; i++) {
+			m_pending[i] = nullptr;
+			m_bound[i] = nullptr;
+		}
+		m_isKnown.reset();
+		m_isDirty.reset();
+		m_firstDirty = SlotCount;
+		m_lastDirty = 0;
+	}
+
+private:
+	void* m_pending[SlotCount];
+	void* m_bound[SlotCount];
+	std::bitset<SlotCount> m_isKnown;
+	std::bitset<SlotCount> m_isDirty;
+	unsigned int m_firstDirty;
+	unsigned int m_lastDirty;
+};
+
+// --------------------------------------------------------
+// Sits between the shaders and the device context so that
+// binding the same shader, buffer, texture or sampler again
+// does nothing, and textures or samplers bound to slots next
+// to each other go out together. Binds are held until Flush(),
+// which has to happen before every draw or dispatch
+//
+// Anything bound to the context without going through the
+// cache makes its copy wrong - call Invalidate() afterwards
+// --------------------------------------------------------
+class StateCache
+{
+public:
+	StateCache(IStateCacheTarget* a_pTarget);
+	~StateCache();
+
+	void SetInputLayout(void* a_pLayout);
+	void SetShader(ShaderStage a_stage, void* a_pShader);
+	void SetConstantBuffer(ShaderStage a_stage, unsigned int a_slot, void* a_pBuffer);
+	void SetShaderResource(ShaderStage a_stage, unsigned int a_slot, void* a_pResource);
+	void SetSampler(ShaderStage a_stage, unsigned int a_slot, void* a_pSampler);
+
+	/* Sends every pending bind to the target */
+	void Flush();
+	/* Forgets everything, so the next flush binds it all again */
+	void Invalidate();
+
+	/* Starts counting binds and calls from zero, e.g. once a frame */
+	void ResetStats();
+	unsigned int GetBindsRequested();
+	unsigned int GetCallsMade();
+	unsigned int GetCallsSaved();
+
+private:
+	struct StageSlots
+	{
+		BindingSlots<1> Shader;
+		BindingSlots<c_constantBufferSlotCount> ConstantBuffers;
+		BindingSlots<c_shaderResourceSlotCount> ShaderResources;
+		BindingSlots<c_samplerSlotCount> Samplers;
+	};
+
+	IStateCacheTarget* m_pTarget;
+	BindingSlots<1> m_inputLayout;
+	StageSlots m_stages[(unsigned int)ShaderStage::Count];
+
+	unsigned int m_bindsRequested;
+	unsigned int m_callsMade;
+};
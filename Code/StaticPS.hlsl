@@ -1,11 +1,15 @@
 #include "ShaderIncludes.hlsli"
 
-cbuffer ExternalData:register(b0)
+cbuffer PerFrame : register(b0)
 {
-	float4 colorTint;
 	float time;
 }
 
+cbuffer PerMaterial : register(b1)
+{
+	float4 colorTint;
+}
+
 float4 main(VertexToPixel input) : SV_TARGET
 {
 	return float4(colorTint.r, Random(float2(time, input.uv.y)), colorTint.b, 0);
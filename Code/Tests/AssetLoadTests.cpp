@@ -0,0 +1,105 @@
+#include <cstring>
+#include <string>
+
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshTangents.h"
+#include "MeshSimplifier.h"
+#include "MeshClusters.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	const size_t c_modelCount = sizeof(c_testModels) / sizeof(c_testModels[0]);
+
+	// The CPU side of Mesh::LoadFile when there's no cache to map - the
+	// bounds and the cache file itself need Windows, so they're left out
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::string path = std::string(MODELS_DIR) + a_model;
+		if (!LoadOBJ(std::wstring(path.begin(), path.end()), a_meshData) || a_meshData.Indices.empty())
+			return false;
+
+		OptimizeMesh(a_meshData);
+		CalculateTangents(a_meshData.Vertices.data(), a_meshData.Vertices.size(), a_meshData.Indices.data(), a_meshData.Indices.size());
+		GenerateLods(a_meshData);
+		BuildMeshlets(a_meshData);
+		return true;
+	}
+
+	template<typename T>
+	bool AreBytesEqual(const std::vector<T>& a_first, const std::vector<T>& a_second)
+	{
+		return a_first.size() == a_second.size() &&
+			(a_first.empty() || memcmp(a_first.data(), a_second.data(), a_first.size() * sizeof(T)) == 0);
+	}
+
+	// Bit for bit, since anything else means the result depends on timing
+	bool AreEqual(const MeshData& a_first, const MeshData& a_second)
+	{
+		return AreBytesEqual(a_first.Vertices, a_second.Vertices) && AreBytesEqual(a_first.Indices, a_second.Indices) &&
+			AreBytesEqual(a_first.Lods, a_second.Lods) && AreBytesEqual(a_first.Meshlets, a_second.Meshlets);
+	}
+
+	// One model after another on this thread - each one's own
+	// work (like tangents) still spreads over the job system
+	std::vector<MeshData> LoadOneByOne()
+	{
+		std::vector<MeshData> meshes(c_modelCount);
+		for (size_t i = 0; i < c_modelCount; i++)
+			CHECK(LoadModel(c_testModels[i], meshes[i]));
+		return meshes;
+	}
+
+	// Every model at once, the way Game::LoadAssets submits them
+	std::vector<MeshData> LoadConcurrently()
+	{
+		JobSystem& jobs = JobSystem::GetInstance();
+		std::vector<MeshData> meshes(c_modelCount);
+		std::vector<char> isLoaded(c_modelCount, false);
+		JobCounter counter;
+		for (size_t i = 0; i < c_modelCount; i++) {
+			jobs.Submit([i, &meshes, &isLoaded]() {
+				isLoaded[i] = LoadModel(c_testModels[i], meshes[i]);
+			}, &counter);
+		}
+		jobs.Wait(counter);
+
+		for (size_t i = 0; i < c_modelCount; i++)
+			CHECK(isLoaded[i]);
+		return meshes;
+	}
+}
+
+// Loading everything at once comes out the same as loading it one at a time, every time
+void TestConcurrentLoadIsDeterministic(unsigned int a_threadCount)
+{
+	JobSystem::GetInstance().Initialize(a_threadCount);
+	printf("%u thread(s)\n", JobSystem::GetInstance().GetThreadCount());
+
+	std::vector<MeshData> reference = LoadOneByOne();
+	for (int run = 0; run < 4; run++) {
+		std::vector<MeshData> meshes = LoadConcurrently();
+		for (size_t i = 0; i < c_modelCount; i++) {
+			if (!AreEqual(meshes[i], reference[i]))
+				printf("%s differs on run %d\n", c_testModels[i], run);
+			CHECK(AreEqual(meshes[i], reference[i]));
+		}
+	}
+
+	JobSystem::GetInstance().Shutdown();
+}
+
+int main()
+{
+	// Zero is one thread per core, then a few fixed counts so the
+	// result doesn't hinge on whatever machine this runs on
+	TestConcurrentLoadIsDeterministic(0);
+	TestConcurrentLoadIsDeterministic(1);
+	TestConcurrentLoadIsDeterministic(3);
+	TestConcurrentLoadIsDeterministic(7);
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
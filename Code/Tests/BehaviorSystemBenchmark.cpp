@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BehaviorSystem.h"
+#include "Transform.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const size_t c_entityCount = 100000;
+	const double c_minSeconds = 0.5;
+	const float c_deltaTime = 1.0f / 60.0f;
+
+	// The names Game gives its entities - all but the last two are animated
+	const char* c_entityNames[] = { "Helix", "Cylinder", "Cube", "Sphere", "Torus", "Quad", "Shield", "Steve" };
+
+	// Just the parts of an Entity that Game::Update touched, held the same way
+	struct NamedEntity
+	{
+		std::string Name;
+		Transform EntityTransform;
+	};
+
+	// Runs a_frame over and over until enough time has passed for
+	// a steady number, and returns milliseconds per frame
+	double MeasureFrames(const std::function<void(float, float)>& a_frame)
+	{
+		int frames = 0;
+		double seconds = 0.0;
+		float totalTime = 0.0f;
+		while (seconds < c_minSeconds) {
+			totalTime += c_deltaTime;
+			auto start = std::chrono::high_resolution_clock::now();
+			a_frame(c_deltaTime, totalTime);
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			frames++;
+		}
+		return seconds * 1e3 / frames;
+	}
+
+	// --------------------------------------------------------
+	// Game::Update as it was before BehaviorSystem - a copy of
+	// every entity's name compared against each animated one,
+	// every frame, with the transform read back in full
+	// --------------------------------------------------------
+	void UpdateByName(std::vector<std::shared_ptr<NamedEntity>>& a_entities, float a_deltaTime, float a_totalTime)
+	{
+		for (int i = 0; i < a_entities.size(); i++)
+		{
+			std::string entityName = a_entities[i]->Name;
+			Transform* entityTransform = &a_entities[i]->EntityTransform;
+			XMFLOAT3 entityRot = entityTransform->GetRotation();
+			XMFLOAT3 entityPos = entityTransform->GetPosition();
+			XMFLOAT3 entityScale = entityTransform->GetScale();
+
+			if (entityName == "Helix") {
+				entityTransform->SetRotation(0, entityRot.y + a_deltaTime, 0);
+				if (entityRot.y + a_deltaTime >= XMConvertToRadians(360))
+					entityTransform->SetRotation(entityRot.x, 0, entityRot.z);
+			}
+			if (entityName == "Cylinder") {
+				entityTransform->SetPosition(entityPos.x, sin(a_totalTime), entityPos.z);
+			}
+			if (entityName == "Cube") {
+				entityTransform->SetRotation(0, entityRot.y + a_deltaTime, entityRot.z + a_deltaTime);
+				if (entityRot.y + a_deltaTime >= XMConvertToRadians(360))
+					entityTransform->SetRotation(entityRot.x, 0, entityRot.z);
+				if (entityRot.z + a_deltaTime >= XMConvertToRadians(360))
+					entityTransform->SetRotation(entityRot.x, entityRot.y, 0);
+			}
+			if (entityName == "Sphere") {
+				entityTransform->SetPosition(entityPos.x, sin(a_totalTime), entityPos.z);
+			}
+			if (entityName == "Torus") {
+				entityTransform->SetRotation(entityRot.x + a_deltaTime, 0, 0);
+				if (entityRot.x + a_deltaTime >= XMConvertToRadians(360))
+					entityTransform->SetRotation(0, entityRot.y, entityRot.z);
+			}
+			if (entityName == "Quad") {
+				entityTransform->SetRotation(0, 0, entityRot.z + a_deltaTime);
+				if (entityRot.z + a_deltaTime >= XMConvertToRadians(360))
+					entityTransform->SetRotation(entityRot.x, entityRot.y, 0);
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Animates 100k stand-in entities (three in four of them
+// animated, named and held behind shared_ptrs like Game's)
+// the old way, by checking every entity's name, and with
+// BehaviorSystem's packed arrays, hooked up once by name
+// the way Game::CreateEntities does. Reports milliseconds
+// per frame for each. Only the updates are timed - the
+// matrices are never rebuilt
+// --------------------------------------------------------
+int main()
+{
+	std::vector<std::shared_ptr<NamedEntity>> entities;
+	entities.reserve(c_entityCount);
+	const size_t nameCount = sizeof(c_entityNames) / sizeof(c_entityNames[0]);
+	for (size_t i = 0; i < c_entityCount; i++) {
+		entities.push_back(std::make_shared<NamedEntity>());
+		entities.back()->Name = c_entityNames[i % nameCount];
+		entities.back()->EntityTransform.SetPosition((float)(i % 1000), 0.0f, (float)(i / 1000));
+	}
+
+	BehaviorSystem behaviors;
+	size_t animatedCount = 0;
+	for (const std::shared_ptr<NamedEntity>& entity : entities) {
+		const std::string& entityName = entity->Name;
+		Transform* entityTransform = &entity->EntityTransform;
+		if (entityName == "Helix") behaviors.AddRotator(entityTransform, XMFLOAT3(0, 1, 0));
+		if (entityName == "Cube") behaviors.AddRotator(entityTransform, XMFLOAT3(0, 1, 1));
+		if (entityName == "Torus") behaviors.AddRotator(entityTransform, XMFLOAT3(1, 0, 0));
+		if (entityName == "Quad") behaviors.AddRotator(entityTransform, XMFLOAT3(0, 0, 1));
+		if (entityName == "Cylinder" || entityName == "Sphere") behaviors.AddOscillator(entityTransform, XMFLOAT3(0, 1, 0));
+		if (entityName != "Shield" && entityName != "Steve")
+			animatedCount++;
+	}
+
+	double nameTime = MeasureFrames([&entities](float a_deltaTime, float a_totalTime) {
+		UpdateByName(entities, a_deltaTime, a_totalTime);
+	});
+	double arrayTime = MeasureFrames([&behaviors](float a_deltaTime, float a_totalTime) {
+		behaviors.Update(a_deltaTime, a_totalTime);
+	});
+
+	printf("%zu entities, %zu of them animated\n", entities.size(), animatedCount);
+	printf("%-24s %12s\n", "Update", "ms/frame");
+	printf("%-24s %12.3f\n", "Name checks", nameTime);
+	printf("%-24s %12.3f\n", "Behavior arrays", arrayTime);
+	printf("Behavior arrays are %.2fx as fast\n", nameTime / arrayTime);
+
+	entities.clear();
+	delete& TransformPool::GetInstance();
+	delete& JobSystem::GetInstance();
+	return 0;
+}
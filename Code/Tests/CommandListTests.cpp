@@ -0,0 +1,150 @@
+#include <vector>
+
+#include "CommandList.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	// One call the replay made - a bind (of Packet.Batch) or a draw
+	struct BackendCall
+	{
+		bool IsBind;
+		DrawPacket Packet;
+	};
+
+	bool operator==(const BackendCall& a_first, const BackendCall& a_second)
+	{
+		return a_first.IsBind == a_second.IsBind &&
+			a_first.Packet.Batch == a_second.Packet.Batch &&
+			a_first.Packet.IndexStart == a_second.Packet.IndexStart &&
+			a_first.Packet.IndexCount == a_second.Packet.IndexCount &&
+			a_first.Packet.InstanceCount == a_second.Packet.InstanceCount &&
+			a_first.Packet.FirstInstance == a_second.Packet.FirstInstance;
+	}
+
+	// --------------------------------------------------------
+	// Records a batch's draws the way Game::DrawEntities does -
+	// some batches are instanced (one packet), some split into
+	// clusters (a few packets) and some culled entirely (none).
+	// Uneven busy work makes the chunks finish in any order
+	// --------------------------------------------------------
+	void RecordBatches(std::vector<DrawPacket>& a_packets, size_t a_begin, size_t a_end)
+	{
+		for (size_t b = a_begin; b < a_end; b++) {
+			volatile unsigned int work = 0;
+			for (unsigned int i = 0; i < (b * 7919) % 2000; i++)
+				work = work + i;
+
+			uint32_t batch = (uint32_t)b;
+			if (b % 7 == 3)
+				continue;
+			if (b % 5 == 0) {
+				a_packets.push_back({ batch, batch * 100, 36, (uint32_t)(b % 4) + 2, batch * 10 });
+				continue;
+			}
+			for (uint32_t cluster = 0; cluster < (uint32_t)(b % 3) + 1; cluster++)
+				a_packets.push_back({ batch, batch * 100 + cluster * 12, 12, 0, 0 });
+		}
+	}
+
+	// Replays the list into a null backend that just writes down what it's asked to do
+	std::vector<BackendCall> ReplayToNullBackend(CommandList& a_commandList)
+	{
+		std::vector<BackendCall> calls;
+		a_commandList.Replay(
+			[&calls](unsigned int a_batch) {
+				calls.push_back({ true, { a_batch, 0, 0, 0, 0 } });
+			},
+			[&calls](const DrawPacket& a_packet) {
+				calls.push_back({ false, a_packet });
+			});
+		return calls;
+	}
+
+	// What a single thread recording and submitting each batch in turn would do
+	std::vector<BackendCall> GetSerialCalls(size_t a_count)
+	{
+		std::vector<BackendCall> calls;
+		std::vector<DrawPacket> packets;
+		for (size_t b = 0; b < a_count; b++) {
+			packets.clear();
+			RecordBatches(packets, b, b + 1);
+			if (!packets.empty())
+				calls.push_back({ true, { (uint32_t)b, 0, 0, 0, 0 } });
+			for (const DrawPacket& packet : packets)
+				calls.push_back({ false, packet });
+		}
+		return calls;
+	}
+}
+
+// --------------------------------------------------------
+// Recording on one thread, then on 2, 4 and 7 threads with
+// chunks small enough to go to all of them - replaying has
+// to make exactly the calls serial recording does, in the
+// same order, with one bind per batch that has any draws
+// --------------------------------------------------------
+void TestReplayMatchesSerial()
+{
+	const size_t counts[] = { 0, 1, 2, 5, 63, 1000 };
+	const unsigned int threadCounts[] = { 2, 4, 7 };
+
+	for (size_t count : counts) {
+		std::vector<BackendCall> expected = GetSerialCalls(count);
+
+		// Serial - the job system isn't running, so everything stays on this thread
+		CommandList commandList;
+		JobSystem::GetInstance().Shutdown();
+		commandList.Record(count, 1, RecordBatches);
+		CHECK(commandList.GetBucketCount() == (count > 0 ? 1u : 0u));
+		std::vector<BackendCall> serial = ReplayToNullBackend(commandList);
+		CHECK(serial == expected);
+
+		for (unsigned int threads : threadCounts) {
+			JobSystem::GetInstance().Shutdown();
+			JobSystem::GetInstance().Initialize(threads - 1);
+			for (int frame = 0; frame < 3; frame++) {
+				commandList.Record(count, 4, RecordBatches);
+				CHECK(commandList.GetBucketCount() == JobSystem::GetInstance().GetChunkCount(count, 4));
+				CHECK(ReplayToNullBackend(commandList) == serial);
+			}
+		}
+
+		size_t binds = 0;
+		for (const BackendCall& call : serial)
+			binds += call.IsBind;
+		printf("%4zu batches: %zu calls (%zu binds), the same on 1, 2, 4 and 7 threads\n", count, serial.size(), binds);
+	}
+	JobSystem::GetInstance().Shutdown();
+}
+
+// Neighboring packets from the same batch share one bind, even across chunks
+void TestBindsAcrossChunks()
+{
+	JobSystem::GetInstance().Initialize(3);
+
+	CommandList commandList;
+	commandList.Record(8, 2, [](std::vector<DrawPacket>& a_packets, size_t a_begin, size_t a_end) {
+		for (size_t i = a_begin; i < a_end; i++)
+			a_packets.push_back({ (uint32_t)(i / 4), (uint32_t)i * 3, 3, 0, 0 });
+	});
+	CHECK(commandList.GetBucketCount() == 4);
+
+	std::vector<BackendCall> calls = ReplayToNullBackend(commandList);
+	CHECK(calls.size() == 10);
+	CHECK(calls.size() == 10 && calls[0].IsBind && calls[0].Packet.Batch == 0 && calls[5].IsBind && calls[5].Packet.Batch == 1);
+	for (size_t i = 0; i < calls.size(); i++)
+		CHECK(calls[i].IsBind == (i == 0 || i == 5));
+
+	JobSystem::GetInstance().Shutdown();
+}
+
+int main()
+{
+	TestReplayMatchesSerial();
+	TestBindsAcrossChunks();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
@@ -0,0 +1,294 @@
+#include <cstring>
+#include <vector>
+
+#include "ConstantBufferData.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	// Stands in for the device context, adding up everything it's asked
+	// to upload and keeping a copy of the last upload
+	class CountingUploadTarget : public IConstantBufferTarget
+	{
+	public:
+		bool UploadConstantBuffer(void* a_pBuffer, bool a_isDynamic, const void* a_pData, unsigned int a_size)
+		{
+			if (ShouldFail)
+				return false;
+
+			Uploads++;
+			Bytes += a_size;
+			pLastBuffer = a_pBuffer;
+			WasLastDynamic = a_isDynamic;
+			LastData.assign((const unsigned char*)a_pData, (const unsigned char*)a_pData + a_size);
+			return true;
+		}
+
+		size_t Uploads = 0;
+		size_t Bytes = 0;
+		void* pLastBuffer = nullptr;
+		bool WasLastDynamic = false;
+		std::vector<unsigned char> LastData;
+		bool ShouldFail = false;	// Fails every upload, like a Map() that can't
+	};
+
+	// A constant buffer's local data, laid out the way a shader's reflection gives it
+	class TestBuffer
+	{
+	public:
+		TestBuffer(unsigned int a_size) : m_data(a_size, 0)
+		{
+			// Nothing's on the GPU yet, so the whole thing starts dirty
+			Local.LocalDataBuffer = m_data.data();
+			Local.Size = a_size;
+			Local.DirtyEnd = a_size;
+		}
+		TestBuffer(const TestBuffer&) = delete;
+
+		void Write(unsigned int a_byteOffset, const void* a_pData, unsigned int a_size) { WriteConstantBufferData(Local, a_byteOffset, a_pData, a_size); }
+		void Upload(IConstantBufferTarget& a_target, ConstantBufferStats& a_stats) { UploadConstantBufferData(Local, this, a_target, a_stats); }
+
+		LocalConstantBuffer Local;
+
+	private:
+		std::vector<unsigned char> m_data;
+	};
+
+	const unsigned int c_drawCount = 1000;
+	const unsigned int c_materialCount = 8;
+	const unsigned int c_lightCount = 5;
+	const unsigned int c_lightSize = 64;
+
+	// What changes per draw, per material and per frame
+	struct Matrix { float m[16]; };
+	struct MaterialData { float Roughness; float ColorTint[3]; float UVScale[2]; float UVOffset[2]; int UseSpecularMap; };
+	struct FrameData { Matrix View; Matrix Projection; float Gamma; float AmbientColor[3]; float CameraPosition[3]; unsigned char Lights[c_lightCount * c_lightSize]; };
+
+	Matrix GetWorld(unsigned int a_draw)
+	{
+		Matrix world = { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, (float)a_draw, 0, 0, 1 } };
+		return world;
+	}
+
+	MaterialData GetMaterial(unsigned int a_material)
+	{
+		MaterialData material = { 0.1f * a_material, { 1, 1, 1 }, { 1, 1 }, { 0, 0 }, (int)(a_material % 2) };
+		return material;
+	}
+
+	FrameData GetFrame(float a_cameraZ)
+	{
+		FrameData frame = {};
+		for (int i = 0; i < 4; i++)
+			frame.View.m[i * 5] = frame.Projection.m[i * 5] = 1.0f;
+		frame.View.m[14] = a_cameraZ;
+		frame.Gamma = 2.2f;
+		frame.CameraPosition[2] = -a_cameraZ;
+		for (unsigned int i = 0; i < sizeof(frame.Lights); i++)
+			frame.Lights[i] = (unsigned char)i;
+		return frame;
+	}
+
+	// Draws sorted by material, the way the render queue leaves them
+	unsigned int GetDrawMaterial(unsigned int a_draw) { return a_draw * c_materialCount / c_drawCount; }
+
+	// --------------------------------------------------------
+	// A frame the way it was before the split - each shader
+	// had one buffer holding everything, set and sent in full
+	// for every draw by CopyAllBufferData, which didn't check
+	// for changes. Offsets are from the old shaders' reflection
+	// --------------------------------------------------------
+	void DrawOneBufferFrame(TestBuffer& a_vertex, TestBuffer& a_pixel, const FrameData& a_frame, IConstantBufferTarget& a_target)
+	{
+		for (unsigned int i = 0; i < c_drawCount; i++) {
+			Matrix world = GetWorld(i);
+			a_vertex.Write(0, &world, 64);
+			a_vertex.Write(64, &world, 64);
+			a_vertex.Write(128, &a_frame.View, 64);
+			a_vertex.Write(192, &a_frame.Projection, 64);
+
+			MaterialData material = GetMaterial(GetDrawMaterial(i));
+			a_pixel.Write(0, &a_frame.Gamma, 4);
+			a_pixel.Write(4, &material.Roughness, 4);
+			a_pixel.Write(16, material.ColorTint, 12);
+			a_pixel.Write(32, a_frame.AmbientColor, 12);
+			a_pixel.Write(48, a_frame.CameraPosition, 12);
+			a_pixel.Write(64, material.UVScale, 8);
+			a_pixel.Write(72, material.UVOffset, 8);
+			a_pixel.Write(80, &material.UseSpecularMap, 4);
+			a_pixel.Write(96, a_frame.Lights, sizeof(a_frame.Lights));
+
+			a_target.UploadConstantBuffer(&a_vertex, false, a_vertex.Local.LocalDataBuffer, a_vertex.Local.Size);
+			a_target.UploadConstantBuffer(&a_pixel, false, a_pixel.Local.LocalDataBuffer, a_pixel.Local.Size);
+		}
+	}
+
+	// --------------------------------------------------------
+	// A frame the way Game::DrawEntities does it now - each
+	// shader's PerFrame buffer once, PerMaterial when the
+	// material changes and PerObject's two matrices per draw
+	// --------------------------------------------------------
+	struct SplitBuffers
+	{
+		TestBuffer VertexPerFrame{ 128 };
+		TestBuffer VertexPerObject{ 128 };
+		TestBuffer PixelPerFrame{ 32 + c_lightCount * c_lightSize };
+		TestBuffer PixelPerMaterial{ 48 };
+	};
+
+	void DrawSplitFrame(SplitBuffers& a_buffers, const FrameData& a_frame, IConstantBufferTarget& a_target, ConstantBufferStats& a_stats)
+	{
+		a_buffers.VertexPerFrame.Write(0, &a_frame.View, 64);
+		a_buffers.VertexPerFrame.Write(64, &a_frame.Projection, 64);
+		a_buffers.VertexPerFrame.Upload(a_target, a_stats);
+		a_buffers.PixelPerFrame.Write(0, &a_frame.Gamma, 4);
+		a_buffers.PixelPerFrame.Write(4, a_frame.AmbientColor, 12);
+		a_buffers.PixelPerFrame.Write(16, a_frame.CameraPosition, 12);
+		a_buffers.PixelPerFrame.Write(32, a_frame.Lights, sizeof(a_frame.Lights));
+		a_buffers.PixelPerFrame.Upload(a_target, a_stats);
+
+		unsigned int boundMaterial = c_materialCount;
+		for (unsigned int i = 0; i < c_drawCount; i++) {
+			if (GetDrawMaterial(i) != boundMaterial) {
+				boundMaterial = GetDrawMaterial(i);
+				MaterialData material = GetMaterial(boundMaterial);
+				a_buffers.PixelPerMaterial.Write(0, &material.Roughness, 4);
+				a_buffers.PixelPerMaterial.Write(4, material.ColorTint, 12);
+				a_buffers.PixelPerMaterial.Write(16, material.UVScale, 8);
+				a_buffers.PixelPerMaterial.Write(24, material.UVOffset, 8);
+				a_buffers.PixelPerMaterial.Write(32, &material.UseSpecularMap, 4);
+				a_buffers.PixelPerMaterial.Upload(a_target, a_stats);
+			}
+
+			Matrix world = GetWorld(i);
+			a_buffers.VertexPerObject.Write(0, &world, 64);
+			a_buffers.VertexPerObject.Write(64, &world, 64);
+			a_buffers.VertexPerObject.Upload(a_target, a_stats);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Counts the constant buffer bytes a frame of draws sends
+// with one buffer per shader, and with PerFrame, PerMaterial
+// and PerObject buffers. After the first frame, a camera
+// that hasn't moved leaves both PerFrame buffers unsent
+// --------------------------------------------------------
+void TestSplitBufferBytes()
+{
+	FrameData frame = GetFrame(-5.0f);
+
+	CountingUploadTarget oneBufferTarget;
+	TestBuffer vertex(256);
+	TestBuffer pixel(96 + c_lightCount * c_lightSize);
+	DrawOneBufferFrame(vertex, pixel, frame, oneBufferTarget);
+	CHECK(oneBufferTarget.Bytes == c_drawCount * (256 + 416));
+
+	CountingUploadTarget splitTarget;
+	ConstantBufferStats splitStats;
+	SplitBuffers buffers;
+	DrawSplitFrame(buffers, frame, splitTarget, splitStats);
+	CHECK(splitTarget.Bytes == (128 + 352) + c_materialCount * 48 + c_drawCount * 128);
+	CHECK(splitTarget.Uploads == 2 + c_materialCount + c_drawCount);
+	CHECK(splitStats.BytesCopied == splitTarget.Bytes && splitStats.UploadsPerformed == splitTarget.Uploads);
+
+	printf("%u draws, %u materials: one buffer per shader %zu bytes (%zu a draw), split %zu bytes (%zu a draw)\n",
+		c_drawCount, c_materialCount, oneBufferTarget.Bytes, oneBufferTarget.Bytes / c_drawCount, splitTarget.Bytes, splitTarget.Bytes / c_drawCount);
+	CHECK(splitTarget.Bytes * 4 < oneBufferTarget.Bytes);
+
+	// The same frame again - the camera's still, so only materials and objects go up
+	splitTarget = CountingUploadTarget();
+	splitStats = ConstantBufferStats();
+	DrawSplitFrame(buffers, frame, splitTarget, splitStats);
+	CHECK(splitTarget.Bytes == c_materialCount * 48 + c_drawCount * 128);
+	CHECK(splitStats.UploadsSkipped == 2);
+
+	// Moving the camera changes PerFrame, and both buffers go up again
+	splitTarget = CountingUploadTarget();
+	DrawSplitFrame(buffers, GetFrame(-6.0f), splitTarget, splitStats);
+	CHECK(splitTarget.Bytes == (128 + 352) + c_materialCount * 48 + c_drawCount * 128);
+}
+
+// --------------------------------------------------------
+// Only buffers that changed since their last upload go up.
+// Writing the bytes a buffer already holds doesn't dirty
+// it, the dirty range covers everything that did change,
+// and what reaches the target is the whole local copy
+// --------------------------------------------------------
+void TestSkipsUnchangedUploads()
+{
+	CountingUploadTarget target;
+	ConstantBufferStats stats;
+	TestBuffer buffer(64);
+
+	// New buffers are dirty, so the first upload always happens
+	CHECK(buffer.Local.IsDirty && buffer.Local.DirtyStart == 0 && buffer.Local.DirtyEnd == 64);
+	buffer.Upload(target, stats);
+	CHECK(target.Uploads == 1 && target.pLastBuffer == &buffer && target.LastData.size() == 64);
+	CHECK(!buffer.Local.IsDirty && stats.UploadsPerformed == 1 && stats.BytesCopied == 64 && stats.BytesChanged == 64);
+
+	// Nothing written, or the same bytes written again - skipped
+	buffer.Upload(target, stats);
+	float zeros[4] = {};
+	CHECK(!WriteConstantBufferData(buffer.Local, 16, zeros, sizeof(zeros)));
+	buffer.Upload(target, stats);
+	CHECK(target.Uploads == 1 && stats.UploadsSkipped == 2 && stats.BytesCopied == 64);
+
+	// Two separate changes make one range covering both
+	float value = 3.0f;
+	CHECK(WriteConstantBufferData(buffer.Local, 40, &value, 4));
+	CHECK(buffer.Local.IsDirty && buffer.Local.DirtyStart == 40 && buffer.Local.DirtyEnd == 44);
+	CHECK(WriteConstantBufferData(buffer.Local, 8, &value, 4));
+	CHECK(!WriteConstantBufferData(buffer.Local, 40, &value, 4));
+	CHECK(WriteConstantBufferData(buffer.Local, 24, &value, 4));
+	CHECK(buffer.Local.DirtyStart == 8 && buffer.Local.DirtyEnd == 44);
+
+	// The whole buffer goes up, only the changed part is counted as changed
+	buffer.Upload(target, stats);
+	float uploaded[16];
+	memcpy(uploaded, target.LastData.data(), sizeof(uploaded));
+	CHECK(target.Uploads == 2 && uploaded[2] == 3.0f && uploaded[6] == 3.0f && uploaded[10] == 3.0f && uploaded[0] == 0.0f);
+	CHECK(stats.UploadsPerformed == 2 && stats.BytesCopied == 128 && stats.BytesChanged == 64 + 36);
+	CHECK(!buffer.Local.IsDirty && buffer.Local.DirtyStart == 0 && buffer.Local.DirtyEnd == 0);
+
+	// Setting a value back is still a change
+	value = 0.0f;
+	CHECK(WriteConstantBufferData(buffer.Local, 8, &value, 4));
+	buffer.Upload(target, stats);
+	CHECK(target.Uploads == 3 && target.LastData[8 + 3] == 0);
+}
+
+// --------------------------------------------------------
+// Dynamic buffers are flagged to the target, so it can Map()
+// them instead, and an upload that fails leaves the buffer
+// dirty and uncounted, to go up on the next try
+// --------------------------------------------------------
+void TestDynamicAndFailedUploads()
+{
+	CountingUploadTarget target;
+	ConstantBufferStats stats;
+	TestBuffer buffer(32);
+	buffer.Local.IsDynamic = true;
+
+	buffer.Upload(target, stats);
+	CHECK(target.Uploads == 1 && target.WasLastDynamic);
+
+	int value = 7;
+	WriteConstantBufferData(buffer.Local, 4, &value, 4);
+	target.ShouldFail = true;
+	buffer.Upload(target, stats);
+	CHECK(buffer.Local.IsDirty && buffer.Local.DirtyStart == 4 && buffer.Local.DirtyEnd == 8);
+	CHECK(stats.UploadsPerformed == 1 && stats.UploadsSkipped == 0 && stats.BytesCopied == 32);
+
+	target.ShouldFail = false;
+	buffer.Upload(target, stats);
+	CHECK(target.Uploads == 2 && !buffer.Local.IsDirty && stats.UploadsPerformed == 2 && stats.BytesChanged == 32 + 4);
+}
+
+int main()
+{
+	TestSplitBufferBytes();
+	TestSkipsUnchangedUploads();
+	TestDynamicAndFailedUploads();
+	return TestResult();
+}
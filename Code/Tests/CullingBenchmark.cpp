@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "Frustum.h"
+#include "ReferenceCulling.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const size_t c_entityCount = 100000;
+	const double c_minSeconds = 0.25;
+
+	// What Game::CullEntities reads from each entity - its mesh's local bounds and its world matrix
+	struct CullEntity
+	{
+		XMFLOAT3 BoundsMin;
+		XMFLOAT3 BoundsMax;
+		XMFLOAT4X4 World;
+	};
+
+	// Entities scattered all around the camera, most of them out of its view
+	std::vector<CullEntity> GetRandomEntities()
+	{
+		std::mt19937 random(540);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+		std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+		std::uniform_real_distribution<float> size(0.1f, 1.5f);
+
+		std::vector<CullEntity> entities(c_entityCount);
+		for (CullEntity& entity : entities) {
+			XMFLOAT3 extents(size(random), size(random), size(random));
+			entity.BoundsMin = XMFLOAT3(-extents.x, -extents.y, -extents.z);
+			entity.BoundsMax = extents;
+			XMStoreFloat4x4(&entity.World,
+				XMMatrixScaling(scale(random), scale(random), scale(random)) *
+				XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+				XMMatrixTranslation(position(random), position(random), position(random)));
+		}
+		return entities;
+	}
+
+	// Runs a_isOutside over every entity until enough time has passed for a steady
+	// number, and returns nanoseconds per entity and how many were kept
+	double MeasureCulling(const std::vector<CullEntity>& a_entities, const std::function<bool(const CullEntity&)>& a_isOutside, size_t& a_keptCount)
+	{
+		std::vector<const CullEntity*> visible;
+		visible.reserve(a_entities.size());
+		int runs = 0;
+		double seconds = 0.0;
+		while (seconds < c_minSeconds) {
+			visible.clear();
+			auto start = std::chrono::high_resolution_clock::now();
+			for (const CullEntity& entity : a_entities)
+				if (!a_isOutside(entity))
+					visible.push_back(&entity);
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			runs++;
+		}
+		a_keptCount = visible.size();
+		return seconds * 1e9 / ((double)a_entities.size() * runs);
+	}
+}
+
+// --------------------------------------------------------
+// Culls 100k random entities against a 45 degree camera
+// the way Game::CullEntities does - each mesh's local box
+// moved into world space with Arvo's method and checked
+// against four planes at a time - and the brute force way,
+// moving all eight corners and checking them plane by
+// plane. Reports nanoseconds per entity and how many were
+// kept by each; Arvo's box is never tighter, so it can
+// keep a few more, but never fewer
+// --------------------------------------------------------
+int main()
+{
+	XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 1000.0f);
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, view * projection);
+	Frustum frustum = ExtractFrustum(viewProjection);
+
+	std::vector<CullEntity> entities = GetRandomEntities();
+
+	size_t arvoKept = 0;
+	double arvoTime = MeasureCulling(entities, [&](const CullEntity& a_entity) {
+		XMVECTOR localMin = XMLoadFloat3(&a_entity.BoundsMin);
+		XMVECTOR localMax = XMLoadFloat3(&a_entity.BoundsMax);
+		XMVECTOR center, extents;
+		TransformBox(XMLoadFloat4x4(&a_entity.World), XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f), XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f), center, extents);
+		return IsBoxOutsideFrustum(frustum, center, extents);
+	}, arvoKept);
+
+	size_t cornersKept = 0;
+	double cornersTime = MeasureCulling(entities, [&](const CullEntity& a_entity) {
+		return IsBoxOutsideFrustumByCorners(frustum, XMLoadFloat4x4(&a_entity.World), XMLoadFloat3(&a_entity.BoundsMin), XMLoadFloat3(&a_entity.BoundsMax));
+	}, cornersKept);
+
+	printf("%zu entities\n", entities.size());
+	printf("%-16s %10s %10s\n", "Method", "ns/entity", "Kept");
+	printf("%-16s %10.2f %10zu\n", "Arvo", arvoTime, arvoKept);
+	printf("%-16s %10.2f %10zu\n", "Eight corners", cornersTime, cornersKept);
+	printf("Arvo is %.2fx as fast and keeps %.2f%% more\n", cornersTime / arvoTime, 100.0 * ((double)arvoKept - (double)cornersKept) / (double)cornersKept);
+	return 0;
+}
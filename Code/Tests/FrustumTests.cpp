@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <random>
+
+#include "Frustum.h"
+#include "ReferenceCulling.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const int c_boxCount = 20000;
+
+	// The kind of camera Game uses, at the origin looking down +z
+	Frustum GetCameraFrustum()
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 100.0f);
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, view * projection);
+		return ExtractFrustum(viewProjection);
+	}
+
+	// Boxes all around the camera, in front of, behind and straddling every plane
+	void GetRandomBox(std::mt19937& a_random, XMVECTOR& a_min, XMVECTOR& a_max)
+	{
+		std::uniform_real_distribution<float> position(-80.0f, 80.0f);
+		std::uniform_real_distribution<float> depth(-20.0f, 120.0f);
+		std::uniform_real_distribution<float> size(0.05f, 8.0f);
+		XMVECTOR center = XMVectorSet(position(a_random), position(a_random), depth(a_random), 0.0f);
+		XMVECTOR extents = XMVectorSet(size(a_random), size(a_random), size(a_random), 0.0f);
+		a_min = XMVectorSubtract(center, extents);
+		a_max = XMVectorAdd(center, extents);
+	}
+
+	// Scale (not always uniform), rotation and translation, the way Transform builds a world matrix
+	XMMATRIX GetRandomWorld(std::mt19937& a_random)
+	{
+		std::uniform_real_distribution<float> scale(0.2f, 3.0f);
+		std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+		std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+		std::uniform_real_distribution<float> depth(-10.0f, 110.0f);
+		return XMMatrixScaling(scale(a_random), scale(a_random), scale(a_random)) *
+			XMMatrixRotationRollPitchYaw(angle(a_random), angle(a_random), angle(a_random)) *
+			XMMatrixTranslation(position(a_random), position(a_random), depth(a_random));
+	}
+
+	// One of the eight corners of a box, picked by the bits of a_corner
+	XMVECTOR GetCorner(FXMVECTOR a_min, FXMVECTOR a_max, int a_corner)
+	{
+		return XMVectorSelect(a_min, a_max, XMVectorSelectControl(a_corner & 1, (a_corner >> 1) & 1, (a_corner >> 2) & 1, 0));
+	}
+
+	// How far the closest corner of a world box is from being on the other side of any plane
+	float GetClosestMargin(const Frustum& a_frustum, FXMVECTOR a_min, FXMVECTOR a_max)
+	{
+		float margin = FLT_MAX;
+		for (int i = 0; i < 6; i++)
+			for (int c = 0; c < 8; c++) {
+				XMVECTOR corner = GetCorner(a_min, a_max, c);
+				margin = (std::min)(margin, fabsf(XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&a_frustum.Planes[i]), corner))));
+			}
+		return margin;
+	}
+}
+
+// --------------------------------------------------------
+// For a box that's already axis aligned, checking the one
+// corner furthest along each plane's normal is exact - it
+// has to give the same answer as checking all eight, other
+// than for boxes that just touch a plane
+// --------------------------------------------------------
+void TestAxisAlignedBoxes()
+{
+	Frustum frustum = GetCameraFrustum();
+	std::mt19937 random(540);
+
+	int outsideCount = 0;
+	int mismatchCount = 0;
+	for (int i = 0; i < c_boxCount; i++) {
+		XMVECTOR boxMin, boxMax;
+		GetRandomBox(random, boxMin, boxMax);
+		bool isOutside = IsBoxOutsideFrustum(frustum, XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f), XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f));
+		bool isOutsideByCorners = IsBoxOutsideFrustumByCorners(frustum, XMMatrixIdentity(), boxMin, boxMax);
+		if (isOutside != isOutsideByCorners && GetClosestMargin(frustum, boxMin, boxMax) > 1e-4f)
+			mismatchCount++;
+		outsideCount += isOutsideByCorners ? 1 : 0;
+	}
+
+	printf("Axis aligned: %d of %d boxes outside, %d mismatches\n", outsideCount, c_boxCount, mismatchCount);
+	CHECK(mismatchCount == 0);
+	CHECK(outsideCount > c_boxCount / 10 && outsideCount < c_boxCount * 9 / 10);
+}
+
+// --------------------------------------------------------
+// Arvo's box is exactly the bounds of the eight moved
+// corners, and culling with it never loses a box that the
+// corners themselves show to be (even partly) visible
+// --------------------------------------------------------
+void TestTransformedBoxes()
+{
+	Frustum frustum = GetCameraFrustum();
+	std::mt19937 random(1997);
+
+	int keptCount = 0;
+	int extraCount = 0;
+	int lostCount = 0;
+	int looseCount = 0;
+	for (int i = 0; i < c_boxCount; i++) {
+		XMVECTOR localMin, localMax;
+		GetRandomBox(random, localMin, localMax);
+		localMin = XMVectorScale(localMin, 0.05f);
+		localMax = XMVectorScale(localMax, 0.05f);
+		XMMATRIX world = GetRandomWorld(random);
+
+		XMVECTOR center, extents;
+		TransformBox(world, XMVectorScale(XMVectorAdd(localMin, localMax), 0.5f), XMVectorScale(XMVectorSubtract(localMax, localMin), 0.5f), center, extents);
+
+		// The furthest any moved corner gets from the new center, on each axis
+		XMVECTOR reach = XMVectorZero();
+		for (int c = 0; c < 8; c++) {
+			XMVECTOR corner = XMVector3Transform(GetCorner(localMin, localMax, c), world);
+			reach = XMVectorMax(reach, XMVectorAbs(XMVectorSubtract(corner, center)));
+		}
+		XMVECTOR slack = XMVectorAbs(XMVectorSubtract(reach, extents));
+		if (XMVectorGetX(slack) > 1e-3f || XMVectorGetY(slack) > 1e-3f || XMVectorGetZ(slack) > 1e-3f)
+			looseCount++;
+
+		bool isOutside = IsBoxOutsideFrustum(frustum, center, extents);
+		bool isOutsideByCorners = IsBoxOutsideFrustumByCorners(frustum, world, localMin, localMax);
+		if (isOutside && !isOutsideByCorners)
+			lostCount++;
+		if (!isOutside)
+			keptCount++;
+		if (!isOutside && isOutsideByCorners)
+			extraCount++;
+	}
+
+	printf("Transformed: %d of %d boxes kept, %d only because their bounds grew, %d lost, %d loose\n",
+		keptCount, c_boxCount, extraCount, lostCount, looseCount);
+	CHECK(lostCount == 0);
+	CHECK(looseCount == 0);
+	CHECK(keptCount > 0 && keptCount < c_boxCount);
+}
+
+int main()
+{
+	TestAxisAlignedBoxes();
+	TestTransformedBoxes();
+	return TestResult();
+}
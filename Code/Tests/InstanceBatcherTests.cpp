@@ -0,0 +1,197 @@
+#include <random>
+#include <vector>
+
+#include "InstanceBatcher.h"
+#include "RenderQueue.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Everything about a draw that decides whether it can share a batch
+	struct TestDraw
+	{
+		unsigned int Material;
+		unsigned int Mesh;
+		unsigned int Lod;
+		bool IsInstanceable;
+	};
+
+	// Every draw has a world matrix that says which draw it belongs to
+	XMFLOAT4X4 GetTestWorld(unsigned int a_draw)
+	{
+		XMFLOAT4X4 world = {
+			1, 0, 0, 0,
+			0, 1, 0, 0,
+			0, 0, 1, 0,
+			(float)a_draw, 0, 0, 1 };
+		return world;
+	}
+
+	// --------------------------------------------------------
+	// Batches the draws the way Game::DrawEntities does - sort
+	// keys from their state and a depth, sorted, then batch
+	// keys of the sort key with the depth swapped for the
+	// level of detail. a_order gets the draws in sorted order
+	// --------------------------------------------------------
+	void BatchDraws(const std::vector<TestDraw>& a_draws, unsigned int a_minInstances, std::vector<unsigned int>& a_order, std::vector<uint64_t>& a_batchKeys, std::vector<InstanceBatch>& a_batches)
+	{
+		RenderQueue queue;
+		for (unsigned int i = 0; i < a_draws.size(); i++)
+			queue.Add(RenderQueue::MakeKey(0, a_draws[i].Material, a_draws[i].Mesh, (float)(i % 97) / 97.0f), i);
+		queue.Sort();
+
+		const std::vector<RenderQueueItem>& items = queue.GetItems();
+		a_order.clear();
+		a_batchKeys.clear();
+		for (const RenderQueueItem& item : items) {
+			const TestDraw& draw = a_draws[item.Index];
+			a_order.push_back(item.Index);
+			a_batchKeys.push_back(draw.IsInstanceable ? (item.Key & ~RenderQueue::c_depthMask) | draw.Lod : c_notInstanced);
+		}
+		BuildInstanceBatches(a_batchKeys.data(), a_batchKeys.size(), a_minInstances, a_batches);
+	}
+
+	std::vector<TestDraw> GetRandomDraws(size_t a_count)
+	{
+		std::mt19937 random(540);
+		std::vector<TestDraw> draws;
+		for (size_t i = 0; i < a_count; i++)
+			draws.push_back({ (unsigned int)(random() % 5), (unsigned int)(random() % 4), (unsigned int)(random() % 3), random() % 8 != 0 });
+		return draws;
+	}
+}
+
+// --------------------------------------------------------
+// The batches cover every draw exactly once, in order. An
+// instanced batch is a whole run of draws sharing material,
+// mesh and level of detail (the draws either side of it
+// differ), long enough to be worth instancing, and its
+// instances follow on from the batch before's
+// --------------------------------------------------------
+void TestGrouping(unsigned int a_minInstances)
+{
+	std::vector<TestDraw> draws = GetRandomDraws(3000);
+	std::vector<unsigned int> order;
+	std::vector<uint64_t> batchKeys;
+	std::vector<InstanceBatch> batches;
+	BatchDraws(draws, a_minInstances, order, batchKeys, batches);
+
+	unsigned int nextDraw = 0;
+	unsigned int nextInstance = 0;
+	unsigned int instancedBatches = 0;
+	for (const InstanceBatch& batch : batches) {
+		CHECK(batch.Start == nextDraw && batch.Count > 0);
+		nextDraw = batch.Start + batch.Count;
+
+		const TestDraw& first = draws[order[batch.Start]];
+		if (!batch.IsInstanced) {
+			CHECK(batch.Count == 1);
+			continue;
+		}
+
+		instancedBatches++;
+		CHECK(batch.Count >= a_minInstances && batch.Count > 1);
+		CHECK(batch.FirstInstance == nextInstance);
+		nextInstance += batch.Count;
+		for (unsigned int i = batch.Start; i < batch.Start + batch.Count; i++) {
+			const TestDraw& draw = draws[order[i]];
+			CHECK(draw.IsInstanceable && draw.Material == first.Material && draw.Mesh == first.Mesh && draw.Lod == first.Lod);
+		}
+		CHECK(batch.Start == 0 || batchKeys[batch.Start - 1] != batchKeys[batch.Start]);
+		CHECK(nextDraw == batchKeys.size() || batchKeys[nextDraw] != batchKeys[batch.Start]);
+	}
+	CHECK(nextDraw == draws.size());
+
+	// A single draw only goes alone if its run is too short or it can't be instanced
+	for (size_t b = 0; b < batches.size(); b++) {
+		if (batches[b].IsInstanced)
+			continue;
+		size_t start = batches[b].Start;
+		size_t end = start + 1;
+		while (batchKeys[start] != c_notInstanced && start > 0 && batchKeys[start - 1] == batchKeys[start])
+			start--;
+		while (batchKeys[end - 1] != c_notInstanced && end < batchKeys.size() && batchKeys[end] == batchKeys[end - 1])
+			end++;
+		CHECK(batchKeys[batches[b].Start] == c_notInstanced || end - start < a_minInstances || end - start == 1);
+	}
+
+	printf("%zu draws in %zu batches (%u instanced, %u instances) with at least %u a batch\n",
+		draws.size(), batches.size(), instancedBatches, nextInstance, a_minInstances);
+	CHECK(instancedBatches > 0);
+}
+
+// Hand-made runs with the answers worked out beforehand
+void TestSmallRuns()
+{
+	const uint64_t keys[] = { 5, 5, 5, c_notInstanced, c_notInstanced, 7, 8, 8, 5, 5 };
+	std::vector<InstanceBatch> batches;
+	BuildInstanceBatches(keys, 10, 2, batches);
+
+	const InstanceBatch expected[] = {
+		{ 0, 3, 0, true }, { 3, 1, 0, false }, { 4, 1, 0, false }, { 5, 1, 0, false }, { 6, 2, 3, true }, { 8, 2, 5, true } };
+	CHECK(batches.size() == 6);
+	for (size_t i = 0; i < batches.size() && i < 6; i++) {
+		CHECK(batches[i].Start == expected[i].Start && batches[i].Count == expected[i].Count && batches[i].IsInstanced == expected[i].IsInstanced);
+		if (expected[i].IsInstanced)
+			CHECK(batches[i].FirstInstance == expected[i].FirstInstance);
+	}
+
+	// Runs shorter than the minimum all go alone
+	BuildInstanceBatches(keys, 10, 3, batches);
+	CHECK(batches.size() == 8 && batches[0].IsInstanced && batches[0].Count == 3);
+	for (size_t i = 1; i < batches.size(); i++)
+		CHECK(!batches[i].IsInstanced && batches[i].Count == 1);
+
+	BuildInstanceBatches(keys, 0, 2, batches);
+	CHECK(batches.empty());
+}
+
+// --------------------------------------------------------
+// Instance data comes out batch by batch, each instance at
+// its batch's FirstInstance plus its place in the batch,
+// holding that draw's world matrix and the upper 3x3 of
+// its inverse-transpose
+// --------------------------------------------------------
+void TestInstanceDataOrder()
+{
+	std::vector<TestDraw> draws = GetRandomDraws(3000);
+	std::vector<unsigned int> order;
+	std::vector<uint64_t> batchKeys;
+	std::vector<InstanceBatch> batches;
+	BatchDraws(draws, 2, order, batchKeys, batches);
+
+	std::vector<InstanceData> instances(5);
+	GatherInstanceData(batches, [&order](unsigned int a_draw) {
+		XMFLOAT4X4 world = GetTestWorld(order[a_draw]);
+		XMFLOAT4X4 inverseTranspose = world;
+		inverseTranspose.m[0][3] = (float)order[a_draw];
+		inverseTranspose.m[1][2] = -(float)order[a_draw];
+		return MakeInstanceData(world, inverseTranspose);
+	}, instances);
+
+	size_t instanceCount = 0;
+	for (const InstanceBatch& batch : batches) {
+		if (!batch.IsInstanced)
+			continue;
+		instanceCount += batch.Count;
+		for (unsigned int i = 0; i < batch.Count; i++) {
+			unsigned int draw = order[batch.Start + i];
+			const InstanceData& instance = instances[batch.FirstInstance + i];
+			CHECK(instance.World.m[3][0] == (float)draw);
+			CHECK(instance.WorldInverseTranspose[1].z == -(float)draw);
+			CHECK(instance.WorldInverseTranspose[0].w == 0.0f);
+		}
+	}
+	CHECK(instances.size() == instanceCount);
+}
+
+int main()
+{
+	TestGrouping(2);
+	TestGrouping(4);
+	TestSmallRuns();
+	TestInstanceDataOrder();
+	return TestResult();
+}
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <string>
+
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshClusters.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + a_model);
+		if (text.empty())
+			return false;
+		ParseOBJ(text.data(), a_meshData);
+		OptimizeMesh(a_meshData);
+		GenerateLods(a_meshData);
+		BuildMeshlets(a_meshData);
+		return !a_meshData.Indices.empty();
+	}
+
+	// A frustum so big that nothing in a model is ever outside it, leaving only the cones to cull
+	Frustum GetEverythingFrustum()
+	{
+		const float c_scale = 1e-4f;
+		XMFLOAT4X4 matrix = {
+			c_scale, 0.0f, 0.0f, 0.0f,
+			0.0f, c_scale, 0.0f, 0.0f,
+			0.0f, 0.0f, c_scale, 0.0f,
+			0.0f, 0.0f, 0.5f, 1.0f };
+		return ExtractFrustum(matrix);
+	}
+
+	// Evenly spread directions over the whole sphere
+	std::vector<XMFLOAT3> GetTestDirections()
+	{
+		std::vector<XMFLOAT3> directions;
+		const int c_count = 256;
+		for (int i = 0; i < c_count; i++) {
+			float y = 1.0f - 2.0f * (i + 0.5f) / c_count;
+			float radius = sqrtf(1.0f - y * y);
+			float angle = i * 2.399963f;	// The golden angle
+			directions.push_back(XMFLOAT3(cosf(angle) * radius, y, sinf(angle) * radius));
+		}
+		return directions;
+	}
+}
+
+// --------------------------------------------------------
+// Meshlets are back to back ranges of whole triangles that
+// exactly cover the full detail level, each within both
+// limits and inside its own bounding sphere
+// --------------------------------------------------------
+void TestMeshletLimits(const char* a_model)
+{
+	MeshData meshData;
+	CHECK(LoadModel(a_model, meshData));
+	CHECK(!meshData.Meshlets.empty());
+	size_t fullCount = meshData.Lods.empty() ? meshData.Indices.size() : meshData.Lods[0].IndexCount;
+
+	unsigned int nextStart = 0;
+	size_t mostVertices = 0;
+	size_t mostTriangles = 0;
+	std::vector<unsigned int> vertexMeshlet(meshData.Vertices.size(), UINT_MAX);
+	for (size_t m = 0; m < meshData.Meshlets.size(); m++) {
+		const Meshlet& meshlet = meshData.Meshlets[m];
+		CHECK(meshlet.IndexStart == nextStart);
+		CHECK(meshlet.IndexCount > 0 && meshlet.IndexCount % 3 == 0);
+		nextStart = meshlet.IndexStart + meshlet.IndexCount;
+
+		size_t vertexCount = 0;
+		bool isInSphere = true;
+		XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+		for (unsigned int i = meshlet.IndexStart; i < meshlet.IndexStart + meshlet.IndexCount; i++) {
+			unsigned int index = meshData.Indices[i];
+			if (vertexMeshlet[index] != m) {
+				vertexMeshlet[index] = (unsigned int)m;
+				vertexCount++;
+			}
+			float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&meshData.Vertices[index].Position), center)));
+			isInSphere &= distance <= meshlet.Radius * 1.0001f + 1e-6f;
+		}
+		CHECK(isInSphere);
+		mostVertices = (std::max)(mostVertices, vertexCount);
+		mostTriangles = (std::max)(mostTriangles, (size_t)meshlet.IndexCount / 3);
+	}
+
+	printf("%-24s %zu triangles in %zu meshlets, at most %zu vertices and %zu triangles each\n",
+		a_model, fullCount / 3, meshData.Meshlets.size(), mostVertices, mostTriangles);
+	CHECK(nextStart == fullCount);
+	CHECK(mostVertices <= c_maxMeshletVertices);
+	CHECK(mostTriangles <= c_maxMeshletTriangles);
+}
+
+// --------------------------------------------------------
+// Looks at every meshlet from all around, near and far. A
+// cone may only cull a meshlet when the camera is behind
+// every one of its triangles - and on the smooth models it
+// has to actually cull some of them to be worth having
+// --------------------------------------------------------
+void TestNormalCones(const char* a_model, bool a_isCullingExpected)
+{
+	MeshData meshData;
+	CHECK(LoadModel(a_model, meshData));
+	Frustum frustum = GetEverythingFrustum();
+	std::vector<XMFLOAT3> directions = GetTestDirections();
+
+	size_t viewCount = 0;
+	size_t culledCount = 0;
+	size_t wrongCount = 0;
+	for (const Meshlet& meshlet : meshData.Meshlets) {
+		const unsigned int* indices = &meshData.Indices[meshlet.IndexStart];
+		XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+
+		for (float distance : { 1.5f, 4.0f, 50.0f }) {
+			for (const XMFLOAT3& direction : directions) {
+				XMVECTOR camera = XMVectorAdd(center, XMVectorScale(XMLoadFloat3(&direction), meshlet.Radius * distance + 1e-3f));
+				viewCount++;
+				if (!IsMeshletCulled(meshlet, frustum, camera, true))
+					continue;
+				culledCount++;
+
+				bool isAnyFacing = false;
+				for (unsigned int t = 0; t < meshlet.IndexCount; t += 3) {
+					XMVECTOR p0 = XMLoadFloat3(&meshData.Vertices[indices[t]].Position);
+					XMVECTOR p1 = XMLoadFloat3(&meshData.Vertices[indices[t + 1]].Position);
+					XMVECTOR p2 = XMLoadFloat3(&meshData.Vertices[indices[t + 2]].Position);
+					XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+					float length = XMVectorGetX(XMVector3Length(normal));
+					if (length <= 0.0f)
+						continue;
+
+					// Signed distance from the triangle's plane to the camera
+					float side = XMVectorGetX(XMVector3Dot(XMVectorSubtract(camera, p0), normal)) / length;
+					isAnyFacing |= side > 1e-4f * meshlet.Radius;
+				}
+				if (isAnyFacing)
+					wrongCount++;
+			}
+		}
+
+		// Never culled from in front of the meshlet, by the sphere or the cone
+		CHECK(!IsMeshletCulled(meshlet, frustum, center, false));
+	}
+
+	printf("%-24s %zu of %zu views culled by cones, %zu wrongly\n", a_model, culledCount, viewCount, wrongCount);
+	CHECK(wrongCount == 0);
+	if (a_isCullingExpected)
+		CHECK(culledCount > 0);
+}
+
+// A single flat quad's cone is exact: its whole back half-space is culled, and none of the front
+void TestFlatMeshletCone()
+{
+	MeshData meshData;
+	CHECK(LoadModel("quad.obj", meshData));
+	CHECK(meshData.Meshlets.size() == 1);
+	const Meshlet& meshlet = meshData.Meshlets[0];
+	CHECK(meshlet.ConeCutoff < 1e-3f);
+
+	Frustum frustum = GetEverythingFrustum();
+	XMVECTOR center = XMLoadFloat3(&meshlet.Center);
+	XMVECTOR axis = XMLoadFloat3(&meshlet.ConeAxis);
+	for (const XMFLOAT3& direction : GetTestDirections()) {
+		float facing = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&direction), axis));
+		if (fabsf(facing) < 0.05f)
+			continue;
+		XMVECTOR camera = XMVectorAdd(center, XMVectorScale(XMLoadFloat3(&direction), 2.0f));
+		CHECK(IsMeshletCulled(meshlet, frustum, camera, true) == (facing < 0.0f));
+		CHECK(!IsMeshletCulled(meshlet, frustum, camera, false));
+	}
+}
+
+int main()
+{
+	// Models without normals generate them on the job system
+	JobSystem::GetInstance().Initialize();
+
+	for (const char* model : c_testModels)
+		TestMeshletLimits(model);
+	for (const char* model : c_testModels)
+		TestNormalCones(model, std::string(model) == "sphere.obj" || std::string(model) == "torus.obj");
+	TestFlatMeshletCone();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstring>
+
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	// A triangle as the bytes of its three vertices, rotated so the
+	// smallest comes first - the same triangle (with the same winding)
+	// compares equal however it was renumbered or rotated
+	typedef std::vector<unsigned char> TriangleKey;
+
+	std::vector<TriangleKey> GetTriangles(const MeshData& a_meshData)
+	{
+		std::vector<TriangleKey> triangles;
+		for (size_t t = 0; t + 2 < a_meshData.Indices.size(); t += 3) {
+			TriangleKey corners[3];
+			for (int k = 0; k < 3; k++) {
+				const unsigned char* bytes = (const unsigned char*)&a_meshData.Vertices[a_meshData.Indices[t + k]];
+				corners[k].assign(bytes, bytes + sizeof(Vertex));
+			}
+
+			int first = 0;
+			for (int k = 1; k < 3; k++)
+				if (corners[k] < corners[first]) first = k;
+
+			TriangleKey key;
+			for (int k = 0; k < 3; k++)
+				key.insert(key.end(), corners[(first + k) % 3].begin(), corners[(first + k) % 3].end());
+			triangles.push_back(key);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + a_model);
+		if (text.empty())
+			return false;
+		ParseOBJ(text.data(), a_meshData);
+		return !a_meshData.Indices.empty();
+	}
+}
+
+// The whole pipeline never leaves the cache worse off, and only ever reorders triangles
+void TestOptimizeMesh(const char* a_model)
+{
+	MeshData meshData;
+	CHECK(LoadModel(a_model, meshData));
+	std::vector<TriangleKey> trianglesBefore = GetTriangles(meshData);
+
+	MeshOptimizationStats stats = OptimizeMesh(meshData);
+	printf("%-24s ACMR %.3f -> %.3f\n", a_model, stats.Before.ACMR, stats.After.ACMR);
+	CHECK(stats.After.ACMR <= stats.Before.ACMR);
+	CHECK(GetTriangles(meshData) == trianglesBefore);
+
+	// Every vertex left over is used, and nothing points past the end
+	std::vector<bool> isUsed(meshData.Vertices.size(), false);
+	bool isInRange = true;
+	for (unsigned int index : meshData.Indices) {
+		if (index >= meshData.Vertices.size()) { isInRange = false; continue; }
+		isUsed[index] = true;
+	}
+	CHECK(isInRange);
+	CHECK(std::find(isUsed.begin(), isUsed.end(), false) == isUsed.end());
+}
+
+// Sorting for overdraw costs at most the allowed share of the cache work before it
+void TestOverdrawKeepsCacheOrder(const char* a_model)
+{
+	MeshData meshData;
+	CHECK(LoadModel(a_model, meshData));
+
+	OptimizeVertexCache(meshData.Indices.data(), meshData.Indices.size(), meshData.Vertices.size());
+	float acmrBefore = AnalyzeVertexCache(meshData.Indices.data(), meshData.Indices.size(), meshData.Vertices.size()).ACMR;
+	std::vector<TriangleKey> trianglesBefore = GetTriangles(meshData);
+
+	OptimizeOverdraw(meshData.Indices.data(), meshData.Indices.size(), meshData.Vertices);
+	float acmrAfter = AnalyzeVertexCache(meshData.Indices.data(), meshData.Indices.size(), meshData.Vertices.size()).ACMR;
+	CHECK(acmrAfter <= acmrBefore * 1.05f);
+	CHECK(GetTriangles(meshData) == trianglesBefore);
+}
+
+int main()
+{
+	// Models without normals generate them on the job system
+	JobSystem::GetInstance().Initialize();
+
+	for (const char* model : c_testModels) {
+		TestOptimizeMesh(model);
+		TestOverdrawKeepsCacheOrder(model);
+	}
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
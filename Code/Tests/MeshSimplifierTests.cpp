@@ -0,0 +1,115 @@
+#include <cfloat>
+#include <string>
+
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + a_model);
+		if (text.empty())
+			return false;
+		ParseOBJ(text.data(), a_meshData);
+		return !a_meshData.Indices.empty();
+	}
+
+	// Whole triangles that all point at real vertices, and none collapsed down to a line or a point
+	void CheckTriangles(const unsigned int* a_indices, size_t a_indexCount, size_t a_vertexCount)
+	{
+		CHECK(a_indexCount % 3 == 0);
+		bool isInRange = true;
+		bool isDegenerate = false;
+		for (size_t i = 0; i + 2 < a_indexCount; i += 3) {
+			unsigned int a = a_indices[i];
+			unsigned int b = a_indices[i + 1];
+			unsigned int c = a_indices[i + 2];
+			isInRange &= (a < a_vertexCount && b < a_vertexCount && c < a_vertexCount);
+			isDegenerate |= (a == b || b == c || a == c);
+		}
+		CHECK(isInRange);
+		CHECK(!isDegenerate);
+	}
+}
+
+// Each level is its own range of the index buffer, smaller and no more accurate than the one before
+void TestGenerateLods(const char* a_model)
+{
+	MeshData meshData;
+	CHECK(LoadModel(a_model, meshData));
+	OptimizeMesh(meshData);
+	size_t fullCount = meshData.Indices.size();
+
+	GenerateLods(meshData);
+	CHECK(!meshData.Lods.empty() && meshData.Lods.size() <= c_maxMeshLods);
+	CHECK(meshData.Lods[0].IndexStart == 0 && meshData.Lods[0].IndexCount == fullCount && meshData.Lods[0].Error == 0.0f);
+
+	printf("%-24s %zu", a_model, fullCount / 3);
+	for (size_t level = 1; level < meshData.Lods.size(); level++) {
+		const MeshLod& lod = meshData.Lods[level];
+		const MeshLod& previous = meshData.Lods[level - 1];
+		printf(" -> %u", lod.IndexCount / 3);
+
+		CHECK(lod.IndexStart == previous.IndexStart + previous.IndexCount);
+		CHECK(lod.IndexCount > 0 && lod.IndexCount < previous.IndexCount);
+		CHECK(lod.Error >= previous.Error);
+		CheckTriangles(&meshData.Indices[lod.IndexStart], lod.IndexCount, meshData.Vertices.size());
+	}
+	printf(" triangles\n");
+
+	// The levels are all there is - nothing left over past the last one
+	const MeshLod& last = meshData.Lods.back();
+	CHECK(last.IndexStart + last.IndexCount == meshData.Indices.size());
+}
+
+// The bigger, smoother models always have room to simplify
+void TestLodsReduce()
+{
+	for (const char* model : { "cylinder.obj", "sphere.obj", "torus.obj", "hylian_shield.obj" }) {
+		MeshData meshData;
+		CHECK(LoadModel(model, meshData));
+		OptimizeMesh(meshData);
+		GenerateLods(meshData);
+		CHECK(meshData.Lods.size() > 1);
+	}
+}
+
+// Given no error limit, simplifying goes all the way down to the target
+void TestSimplifyToTarget()
+{
+	MeshData meshData;
+	CHECK(LoadModel("sphere.obj", meshData));
+	size_t target = meshData.Indices.size() / 4 / 3 * 3;
+
+	std::vector<unsigned int> simplified(meshData.Indices.size());
+	float error = -1.0f;
+	size_t count = SimplifyMesh(simplified.data(), meshData.Indices.data(), meshData.Indices.size(),
+		meshData.Vertices.data(), meshData.Vertices.size(), target, FLT_MAX, &error);
+	CHECK(count > 0 && count <= target);
+	CHECK(error > 0.0f);
+	CheckTriangles(simplified.data(), count, meshData.Vertices.size());
+
+	// And with no room for error at all, only collapses that move nothing are made
+	count = SimplifyMesh(simplified.data(), meshData.Indices.data(), meshData.Indices.size(),
+		meshData.Vertices.data(), meshData.Vertices.size(), target, 0.0f, &error);
+	CHECK(count > target && error == 0.0f);
+	CheckTriangles(simplified.data(), count, meshData.Vertices.size());
+}
+
+int main()
+{
+	// Models without normals generate them on the job system
+	JobSystem::GetInstance().Initialize();
+
+	for (const char* model : c_testModels)
+		TestGenerateLods(model);
+	TestLodsReduce();
+	TestSimplifyToTarget();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
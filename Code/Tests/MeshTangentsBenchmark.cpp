@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <tuple>
+
+#include "ObjLoader.h"
+#include "MeshTangents.h"
+#include "JobSystem.h"
+#include "ReferenceTangents.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	const double c_minSeconds = 0.25;
+
+	// Runs a_work over fresh copies of the vertices until enough time has
+	// passed for a steady number, and returns triangles per second
+	double MeasureTriangleRate(const MeshData& a_meshData, const std::function<void(Vertex*)>& a_work)
+	{
+		std::vector<Vertex> vertices;
+		int runs = 0;
+		double seconds = 0.0;
+		while (seconds < c_minSeconds) {
+			vertices = a_meshData.Vertices;
+			auto start = std::chrono::high_resolution_clock::now();
+			a_work(vertices.data());
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			runs++;
+		}
+		return (double)(a_meshData.Indices.size() / 3) * runs / seconds;
+	}
+
+	// Numbers each distinct position, the way the loader does before it
+	// generates normals, so vertices split by their UVs smooth together
+	std::vector<unsigned int> GetPositionIds(const MeshData& a_meshData)
+	{
+		std::map<std::tuple<float, float, float>, unsigned int> ids;
+		std::vector<unsigned int> positionIds;
+		positionIds.reserve(a_meshData.Vertices.size());
+		for (const Vertex& vertex : a_meshData.Vertices) {
+			std::tuple<float, float, float> position(vertex.Position.x, vertex.Position.y, vertex.Position.z);
+			positionIds.push_back(ids.insert(std::make_pair(position, (unsigned int)ids.size())).first->second);
+		}
+		return positionIds;
+	}
+}
+
+// --------------------------------------------------------
+// Generates tangents for each bundled model with the SIMD
+// kernel and with the scalar one it replaced, then normals
+// (as if the file had none), and reports triangles per
+// second for each. The job system is never started, so it
+// all runs on this thread and only the kernels are timed
+// --------------------------------------------------------
+int main()
+{
+	printf("%-24s %10s %14s %14s %8s %14s\n", "Model", "Triangles", "Scalar tri/s", "SoA tri/s", "Speedup", "Normals tri/s");
+	for (const char* model : c_testModels)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + model);
+		if (text.empty()) {
+			printf("%-24s could not be read\n", model);
+			continue;
+		}
+
+		MeshData meshData;
+		ParseOBJ(text.data(), meshData);
+		const unsigned int* indices = meshData.Indices.data();
+		size_t vertexCount = meshData.Vertices.size();
+		size_t indexCount = meshData.Indices.size();
+
+		double scalarRate = MeasureTriangleRate(meshData, [=](Vertex* a_vertices) {
+			CalculateReferenceTangents(a_vertices, vertexCount, indices, indexCount);
+		});
+		double soaRate = MeasureTriangleRate(meshData, [=](Vertex* a_vertices) {
+			CalculateTangents(a_vertices, vertexCount, indices, indexCount);
+		});
+
+		// Normals are only generated for vertices that don't have one yet
+		std::vector<unsigned int> positionIds = GetPositionIds(meshData);
+		const unsigned int* ids = positionIds.data();
+		for (Vertex& vertex : meshData.Vertices)
+			vertex.Normal = DirectX::XMFLOAT3(0, 0, 0);
+		double normalRate = MeasureTriangleRate(meshData, [=](Vertex* a_vertices) {
+			CalculateNormals(a_vertices, vertexCount, indices, indexCount, ids);
+		});
+
+		printf("%-24s %10zu %14.0f %14.0f %7.2fx %14.0f\n", model, indexCount / 3, scalarRate, soaRate, soaRate / scalarRate, normalRate);
+	}
+
+	delete& JobSystem::GetInstance();
+	return 0;
+}
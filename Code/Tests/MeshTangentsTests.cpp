@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "ObjLoader.h"
+#include "MeshTangents.h"
+#include "JobSystem.h"
+#include "ReferenceTangents.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + a_model);
+		if (text.empty())
+			return false;
+		ParseOBJ(text.data(), a_meshData);
+		return !a_meshData.Indices.empty();
+	}
+
+	// Copies of the whole mesh side by side, to get past the size where tangents go to the job system
+	void RepeatMesh(MeshData& a_meshData, int a_copies)
+	{
+		size_t vertexCount = a_meshData.Vertices.size();
+		size_t indexCount = a_meshData.Indices.size();
+		for (int copy = 1; copy < a_copies; copy++) {
+			for (size_t i = 0; i < vertexCount; i++) {
+				Vertex vertex = a_meshData.Vertices[i];
+				vertex.Position.x += 10.0f * copy;
+				a_meshData.Vertices.push_back(vertex);
+			}
+			for (size_t i = 0; i < indexCount; i++)
+				a_meshData.Indices.push_back(a_meshData.Indices[i] + (unsigned int)(vertexCount * copy));
+		}
+	}
+
+	// Compares every vertex the reference had a clear answer for - where its
+	// sums (nearly) cancel out, the estimated square roots can tip either way
+	void CheckMatchesReference(const char* a_name, MeshData& a_meshData)
+	{
+		std::vector<Vertex> reference = a_meshData.Vertices;
+		std::vector<XMFLOAT4> sums;
+		CalculateReferenceTangents(reference.data(), reference.size(), a_meshData.Indices.data(), a_meshData.Indices.size(), &sums);
+		CalculateTangents(a_meshData.Vertices.data(), a_meshData.Vertices.size(), a_meshData.Indices.data(), a_meshData.Indices.size());
+
+		size_t directionMismatches = 0;
+		size_t handednessMismatches = 0;
+		for (size_t i = 0; i < reference.size(); i++) {
+			XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&reference[i].Normal));
+			XMVECTOR sum = XMVectorSetW(XMLoadFloat4(&sums[i]), 0.0f);
+			bool isClear = XMVectorGetX(XMVector3Length(XMVectorSubtract(sum, XMVectorMultiply(normal, XMVector3Dot(normal, sum))))) > 1e-2f;
+
+			const XMFLOAT4& expected = reference[i].Tangent;
+			const XMFLOAT4& actual = a_meshData.Vertices[i].Tangent;
+			float dot = expected.x * actual.x + expected.y * actual.y + expected.z * actual.z;
+			if (isClear && dot < 0.999f)
+				directionMismatches++;
+			if (fabsf(sums[i].w) > 1e-2f && expected.w != actual.w)
+				handednessMismatches++;
+			CHECK(actual.w == 1.0f || actual.w == -1.0f);
+		}
+
+		printf("%-24s %zu vertices, %zu direction and %zu handedness mismatches\n", a_name, reference.size(), directionMismatches, handednessMismatches);
+		CHECK(directionMismatches == 0);
+		CHECK(handednessMismatches == 0);
+	}
+
+	Vertex MakeVertex(float a_x, float a_y, float a_u, float a_v)
+	{
+		Vertex vertex = {};
+		vertex.Position = XMFLOAT3(a_x, a_y, 0.0f);
+		vertex.Normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+		vertex.UV = XMFLOAT2(a_u, a_v);
+		return vertex;
+	}
+}
+
+// The SIMD kernel agrees with the scalar one on every bundled model
+void TestMatchesReference()
+{
+	for (const char* model : c_testModels) {
+		MeshData meshData;
+		CHECK(LoadModel(model, meshData));
+		CheckMatchesReference(model, meshData);
+	}
+
+	// Big enough to be split over several threads
+	MeshData meshData;
+	CHECK(LoadModel("helix.obj", meshData));
+	RepeatMesh(meshData, 21);
+	CheckMatchesReference("helix.obj x 21", meshData);
+}
+
+// --------------------------------------------------------
+// Two copies of the same triangle facing the camera (-z),
+// the second with its u flipped like the far half of a
+// mirrored texture. +u runs along +x, then along -x, and
+// both have +v down -y - so only the second is mirrored,
+// and bitangent = cross(tangent, normal) * w has to point
+// the same way (against +v, up the texture) for both
+// --------------------------------------------------------
+void TestMirroredHandedness()
+{
+	Vertex vertices[] = {
+		MakeVertex(0, 0, 0, 1), MakeVertex(0, 1, 0, 0), MakeVertex(1, 0, 1, 1),
+		MakeVertex(2, 0, 1, 1), MakeVertex(2, 1, 1, 0), MakeVertex(3, 0, 0, 1) };
+	const unsigned int indices[] = { 0, 1, 2, 3, 4, 5 };
+
+	Vertex reference[6];
+	std::copy(vertices, vertices + 6, reference);
+	CalculateTangents(vertices, 6, indices, 6);
+	CalculateReferenceTangents(reference, 6, indices, 6);
+
+	for (int i = 0; i < 6; i++) {
+		bool isMirrored = i >= 3;
+		XMVECTOR tangent = XMLoadFloat4(&vertices[i].Tangent);
+		XMVECTOR bitangent = XMVectorScale(XMVector3Cross(tangent, XMLoadFloat3(&vertices[i].Normal)), vertices[i].Tangent.w);
+
+		CHECK(vertices[i].Tangent.w == (isMirrored ? -1.0f : 1.0f));
+		CHECK(reference[i].Tangent.w == vertices[i].Tangent.w);
+		CHECK(fabsf(vertices[i].Tangent.x - (isMirrored ? -1.0f : 1.0f)) < 1e-3f);
+		CHECK(XMVectorGetY(bitangent) > 0.999f);
+	}
+}
+
+int main()
+{
+	// Three workers, so the big mesh really is split up
+	JobSystem::GetInstance().Initialize(3);
+
+	TestMatchesReference();
+	TestMirroredHandedness();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
@@ -0,0 +1,48 @@
+#include <chrono>
+#include <cstdio>
+
+#include "ObjLoader.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+// --------------------------------------------------------
+// Parses each bundled model from memory over and over and
+// reports megabytes and triangles per second. Reading the
+// file is left out, so only the tokenizer and welding (and
+// normal generation, for models without any) are timed
+// --------------------------------------------------------
+int main()
+{
+	// Normal generation runs on the job system
+	JobSystem::GetInstance().Initialize();
+
+	const double c_minSeconds = 0.25;
+	printf("%-24s %10s %10s %12s %14s\n", "Model", "KB", "Triangles", "MB/s", "Triangles/s");
+	for (const char* model : c_testModels)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + model);
+		if (text.empty()) {
+			printf("%-24s could not be read\n", model);
+			continue;
+		}
+
+		// Repeat until enough time has passed for a steady number
+		MeshData meshData;
+		int runs = 0;
+		double seconds = 0.0;
+		while (seconds < c_minSeconds) {
+			auto start = std::chrono::high_resolution_clock::now();
+			ParseOBJ(text.data(), meshData);
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			runs++;
+		}
+
+		double bytes = (double)(text.size() - 1) * runs;
+		double triangles = (double)(meshData.Indices.size() / 3) * runs;
+		printf("%-24s %10.1f %10zu %12.1f %14.0f\n", model, (text.size() - 1) / 1024.0, meshData.Indices.size() / 3, bytes / seconds / 1e6, triangles / seconds);
+	}
+
+	delete& JobSystem::GetInstance();
+	return 0;
+}
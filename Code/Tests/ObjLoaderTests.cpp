@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <set>
+#include <string>
+#include <tuple>
+
+#include "ObjLoader.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	// Every vertex is used by some triangle and every index points at a vertex
+	void CheckIndices(const MeshData& a_meshData)
+	{
+		std::vector<bool> isUsed(a_meshData.Vertices.size(), false);
+		bool isInRange = true;
+		for (unsigned int index : a_meshData.Indices) {
+			if (index >= a_meshData.Vertices.size()) {
+				isInRange = false;
+				continue;
+			}
+			isUsed[index] = true;
+		}
+		CHECK(isInRange);
+		CHECK(std::find(isUsed.begin(), isUsed.end(), false) == isUsed.end());
+	}
+
+	// Counts the distinct "v/vt/vn" corners of the file's faces, the slow way
+	size_t CountUniqueCorners(const char* a_text)
+	{
+		std::set<std::tuple<int, int, int>> corners;
+		for (const char* line = a_text; *line != '\0'; ) {
+			const char* end = line;
+			while (*end != '\n' && *end != '\0') end++;
+			if (line[0] == 'f' && line[1] == ' ') {
+				const char* p = line + 2;
+				while (p < end) {
+					int position = 0, uv = 0, normal = 0;
+					if (sscanf(p, "%d/%d/%d", &position, &uv, &normal) == 3)
+						corners.insert(std::make_tuple(position, uv, normal));
+					while (p < end && *p != ' ') p++;
+					while (p < end && *p == ' ') p++;
+				}
+			}
+			line = (*end == '\n') ? end + 1 : end;
+		}
+		return corners.size();
+	}
+}
+
+// Corners shared between triangles become one vertex, and nothing is welded that shouldn't be
+void TestWeldsSharedCorners()
+{
+	std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + "cube.obj");
+	CHECK(!text.empty());
+
+	MeshData meshData;
+	ParseOBJ(text.data(), meshData);
+	size_t uniqueCorners = CountUniqueCorners(text.data());
+	printf("cube.obj: %zu corners welded into %zu vertices\n", meshData.Indices.size(), meshData.Vertices.size());
+	CHECK(meshData.Vertices.size() == uniqueCorners);
+	CHECK(meshData.Vertices.size() < meshData.Indices.size());
+	CheckIndices(meshData);
+	CHECK(CanUseShortIndices(meshData.Vertices.size()));
+}
+
+// A face with a corner that doesn't resolve is dropped whole, along with the vertices it would have added
+void TestRejectedFaceLeavesNoVertices()
+{
+	const char* text =
+		"v 0 0 0\n"
+		"v 1 0 0\n"
+		"v 0 1 0\n"
+		"v 1 1 0\n"
+		"f 2 4 3\n"
+		"f 1 2 9\n"		// 9 doesn't exist, so 1 and 2 mustn't be welded for it
+		"f 1 2\n";		// Too few corners to be a triangle
+	MeshData meshData;
+	ParseOBJ(text, meshData);
+	CHECK(meshData.Indices.size() == 3);
+	CHECK(meshData.Vertices.size() == 3);
+	CheckIndices(meshData);
+}
+
+// Only meshes with more vertices than 16 bits can index need 32-bit indices
+void TestIndexSize()
+{
+	CHECK(CanUseShortIndices(0xFFFF));
+	CHECK(!CanUseShortIndices(0x10000));
+
+	// Triangles that share nothing, so every corner is its own vertex
+	const unsigned int triangleCount = 22000;
+	std::string text;
+	for (unsigned int i = 0; i < triangleCount * 3; i++)
+		text += "v " + std::to_string(i) + " " + std::to_string(i % 7) + " 0\n";
+	for (unsigned int i = 0; i < triangleCount; i++)
+		text += "f " + std::to_string(i * 3 + 1) + " " + std::to_string(i * 3 + 2) + " " + std::to_string(i * 3 + 3) + "\n";
+
+	MeshData meshData;
+	ParseOBJ(text.c_str(), meshData);
+	CHECK(meshData.Vertices.size() == triangleCount * 3);
+	CHECK(meshData.Indices.size() == triangleCount * 3);
+	CHECK(!CanUseShortIndices(meshData.Vertices.size()));
+	CheckIndices(meshData);
+}
+
+int main()
+{
+	// Files without normals generate them on the job system
+	JobSystem::GetInstance().Initialize();
+
+	TestWeldsSharedCorners();
+	TestRejectedFaceLeavesNoVertices();
+	TestIndexSize();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+#include "Frustum.h"
+
+// --------------------------------------------------------
+// IsBoxOutsideFrustum the brute force way - transforms all
+// eight corners of a local box by the (row vector) matrix
+// and calls it outside if every corner is behind the same
+// plane. Arvo's box is never tighter than this, so the
+// tests hold it to never culling anything this keeps, and
+// the benchmark races the two
+// --------------------------------------------------------
+inline bool IsBoxOutsideFrustumByCorners(const Frustum& a_frustum, DirectX::FXMMATRIX a_matrix, DirectX::FXMVECTOR a_localMin, DirectX::FXMVECTOR a_localMax)
+{
+	using namespace DirectX;
+
+	XMVECTOR corners[8];
+	for (int c = 0; c < 8; c++)
+	{
+		XMVECTOR corner = XMVectorSet(
+			XMVectorGetX((c & 1) ? a_localMax : a_localMin),
+			XMVectorGetY((c & 2) ? a_localMax : a_localMin),
+			XMVectorGetZ((c & 4) ? a_localMax : a_localMin), 1.0f);
+		corners[c] = XMVector3Transform(corner, a_matrix);
+	}
+
+	for (int i = 0; i < 6; i++)
+	{
+		XMVECTOR plane = XMLoadFloat4(&a_frustum.Planes[i]);
+		bool isBehind = true;
+		for (int c = 0; c < 8 && isBehind; c++)
+			isBehind = XMVectorGetX(XMPlaneDotCoord(plane, corners[c])) < 0.0f;
+		if (isBehind)
+			return true;
+	}
+	return false;
+}
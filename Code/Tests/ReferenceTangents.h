@@ -0,0 +1,97 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cmath>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// CalculateTangents the plain way - one triangle at a time
+// with scalar math and exact square roots, but the same
+// MikkTSpace-style angle weighting and handedness vote.
+// The tests hold the SIMD kernel to it and the benchmark
+// races the two
+//
+// a_pSums, if given, gets each vertex's weighted tangent
+// sum (xyz) and handedness vote (w) before finishing
+// --------------------------------------------------------
+inline void CalculateReferenceTangents(Vertex* a_verts, size_t a_numVerts, const unsigned int* a_indices, size_t a_numIndices, std::vector<DirectX::XMFLOAT4>* a_pSums = nullptr)
+{
+	using namespace DirectX;
+
+	// Angle between two edges leaving the same corner, a right angle if either has no length
+	auto cornerAngle = [](FXMVECTOR a_edge1, FXMVECTOR a_edge2) {
+		float lengthsSq = XMVectorGetX(XMVector3LengthSq(a_edge1)) * XMVectorGetX(XMVector3LengthSq(a_edge2));
+		float cosine = (lengthsSq > 0.0f) ? XMVectorGetX(XMVector3Dot(a_edge1, a_edge2)) / sqrtf(lengthsSq) : 0.0f;
+		return acosf(cosine < -1.0f ? -1.0f : (cosine > 1.0f ? 1.0f : cosine));
+	};
+
+	std::vector<XMFLOAT4> sums(a_numVerts, XMFLOAT4(0, 0, 0, 0));
+	for (size_t i = 0; i + 2 < a_numIndices; i += 3)
+	{
+		const unsigned int* corners = &a_indices[i];
+		XMVECTOR p0 = XMLoadFloat3(&a_verts[corners[0]].Position);
+		XMVECTOR p1 = XMLoadFloat3(&a_verts[corners[1]].Position);
+		XMVECTOR p2 = XMLoadFloat3(&a_verts[corners[2]].Position);
+		const XMFLOAT2& uv0 = a_verts[corners[0]].UV;
+		const XMFLOAT2& uv1 = a_verts[corners[1]].UV;
+		const XMFLOAT2& uv2 = a_verts[corners[2]].UV;
+
+		XMVECTOR edge1 = XMVectorSubtract(p1, p0);
+		XMVECTOR edge2 = XMVectorSubtract(p2, p0);
+		float s1 = uv1.x - uv0.x;
+		float t1 = uv1.y - uv0.y;
+		float s2 = uv2.x - uv0.x;
+		float t2 = uv2.y - uv0.y;
+
+		float uvArea = s1 * t2 - s2 * t1;
+		if (fabsf(uvArea) < 1e-12f)
+			continue;
+		float areaSign = (uvArea < 0.0f) ? -1.0f : 1.0f;
+
+		// Directions of +u and +v across the triangle
+		XMVECTOR tangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge1, t2), XMVectorScale(edge2, t1)), areaSign);
+		XMVECTOR bitangent = XMVectorScale(XMVectorSubtract(XMVectorScale(edge2, s1), XMVectorScale(edge1, s2)), areaSign);
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) > 0.0f)
+			tangent = XMVector3Normalize(tangent);
+
+		XMVECTOR faceNormal = XMVector3Cross(edge1, edge2);
+		float handedness = (XMVectorGetX(XMVector3Dot(XMVector3Cross(faceNormal, tangent), bitangent)) < 0.0f) ? -1.0f : 1.0f;
+
+		float angles[3];
+		angles[0] = cornerAngle(edge1, edge2);
+		angles[1] = cornerAngle(XMVectorSubtract(p2, p1), XMVectorNegate(edge1));
+		angles[2] = XM_PI - angles[0] - angles[1];
+		if (angles[2] < 0.0f)
+			angles[2] = 0.0f;
+
+		for (int c = 0; c < 3; c++)
+		{
+			XMFLOAT4& sum = sums[corners[c]];
+			XMStoreFloat4(&sum, XMVectorAdd(XMLoadFloat4(&sum), XMVectorScale(XMVectorSetW(tangent, handedness), angles[c])));
+		}
+	}
+
+	for (size_t i = 0; i < a_numVerts; i++)
+	{
+		XMVECTOR normal = XMVector3Normalize(XMLoadFloat3(&a_verts[i].Normal));
+		XMVECTOR tangent = XMVectorSetW(XMLoadFloat4(&sums[i]), 0.0f);
+		tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+		if (XMVectorGetX(XMVector3LengthSq(tangent)) < 1e-12f)
+		{
+			XMVECTOR axis = (fabsf(XMVectorGetX(normal)) < 0.9f) ? XMVectorSet(1, 0, 0, 0) : XMVectorSet(0, 1, 0, 0);
+			tangent = XMVector3Normalize(XMVector3Cross(axis, normal));
+		}
+		else
+		{
+			tangent = XMVector3Normalize(tangent);
+		}
+
+		float handedness = (sums[i].w < 0.0f) ? -1.0f : 1.0f;
+		XMStoreFloat4(&a_verts[i].Tangent, XMVectorSetW(tangent, handedness));
+	}
+
+	if (a_pSums)
+		a_pSums->swap(sums);
+}
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "RenderQueue.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	std::mt19937_64 s_random(540);
+
+	// The order the radix sort has to give - by key, with equal keys left in the order they were added
+	std::vector<RenderQueueItem> GetReferenceOrder(const std::vector<RenderQueueItem>& a_items)
+	{
+		std::vector<RenderQueueItem> sorted = a_items;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const RenderQueueItem& a_first, const RenderQueueItem& a_second) {
+			return a_first.Key < a_second.Key;
+		});
+		return sorted;
+	}
+
+	void CheckSort(const char* a_name, const std::vector<uint64_t>& a_keys)
+	{
+		RenderQueue queue;
+		std::vector<RenderQueueItem> items;
+		for (size_t i = 0; i < a_keys.size(); i++) {
+			queue.Add(a_keys[i], (unsigned int)i);
+			items.push_back({ a_keys[i], (unsigned int)i });
+		}
+
+		queue.Sort();
+		std::vector<RenderQueueItem> expected = GetReferenceOrder(items);
+		const std::vector<RenderQueueItem>& sorted = queue.GetItems();
+
+		size_t mismatches = 0;
+		CHECK(sorted.size() == expected.size());
+		for (size_t i = 0; i < sorted.size() && i < expected.size(); i++) {
+			if (sorted[i].Key != expected[i].Key || sorted[i].Index != expected[i].Index)
+				mismatches++;
+		}
+		printf("%-28s %6zu items, %zu out of place\n", a_name, a_keys.size(), mismatches);
+		CHECK(mismatches == 0);
+	}
+
+	// A frame's worth of keys from a handful of shaders, materials and meshes, at random depths
+	std::vector<uint64_t> GetSceneKeys(size_t a_count, unsigned int a_shaders, unsigned int a_materials, unsigned int a_meshes)
+	{
+		std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+		std::vector<uint64_t> keys;
+		for (size_t i = 0; i < a_count; i++)
+			keys.push_back(RenderQueue::MakeKey((unsigned int)(s_random() % a_shaders), (unsigned int)(s_random() % a_materials), (unsigned int)(s_random() % a_meshes), depth(s_random)));
+		return keys;
+	}
+
+	RenderQueue MakeQueue(const std::vector<uint64_t>& a_keys)
+	{
+		RenderQueue queue;
+		for (size_t i = 0; i < a_keys.size(); i++)
+			queue.Add(a_keys[i], (unsigned int)i);
+		return queue;
+	}
+}
+
+// --------------------------------------------------------
+// The radix sort gives exactly what a stable std::sort
+// does - on fully random keys, on scene-like keys where
+// most bytes never change (so their passes are skipped),
+// on runs of equal keys that have to stay in order, and
+// on the sizes where there's nothing to sort
+// --------------------------------------------------------
+void TestSortMatchesReference()
+{
+	std::vector<uint64_t> keys;
+	for (int i = 0; i < 50000; i++)
+		keys.push_back(s_random());
+	CheckSort("Random 64 bit", keys);
+
+	CheckSort("Scene", GetSceneKeys(20000, 6, 40, 12));
+
+	std::vector<uint64_t> sorted = keys;
+	std::sort(sorted.begin(), sorted.end());
+	CheckSort("Already sorted", sorted);
+	std::reverse(sorted.begin(), sorted.end());
+	CheckSort("Reversed", sorted);
+
+	// Only one byte differs, and many keys are equal
+	keys.clear();
+	for (int i = 0; i < 5000; i++)
+		keys.push_back(0x1234000000000000ull | ((s_random() % 7) << 24));
+	CheckSort("One byte, many equal", keys);
+
+	CheckSort("All equal", std::vector<uint64_t>(1000, 42));
+	CheckSort("One item", std::vector<uint64_t>(1, 7));
+	CheckSort("Empty", std::vector<uint64_t>());
+}
+
+// Ids go shader, material, mesh from the top, and the depth at the bottom sorts front to back
+void TestMakeKey()
+{
+	uint64_t key = RenderQueue::MakeKey(3, 2, 1, 0.0f);
+	CHECK((key & RenderQueue::c_shaderMask) >> 48 == 3);
+	CHECK((key & RenderQueue::c_materialMask) >> 32 == 2);
+	CHECK((key & RenderQueue::c_meshMask) >> 16 == 1);
+	CHECK((key & RenderQueue::c_depthMask) == 0);
+
+	CHECK(RenderQueue::MakeKey(0, 0, 0, 0.25f) < RenderQueue::MakeKey(0, 0, 0, 0.5f));
+	CHECK(RenderQueue::MakeKey(0, 0, 1, 0.0f) > RenderQueue::MakeKey(0, 0, 0, 1.0f));
+	CHECK(RenderQueue::MakeKey(1, 0, 0, 0.0f) > RenderQueue::MakeKey(0, 0xFFFF, 0xFFFF, 1.0f));
+
+	// Depths outside [0, 1] are clamped rather than spilling into the mesh id
+	CHECK(RenderQueue::MakeKey(0, 0, 5, 2.0f) == RenderQueue::MakeKey(0, 0, 5, 1.0f));
+	CHECK(RenderQueue::MakeKey(0, 0, 5, -1.0f) == RenderQueue::MakeKey(0, 0, 5, 0.0f));
+}
+
+// The same pointers always get the same id, and new ones get the next
+void TestIds()
+{
+	RenderQueue queue;
+	int objects[4];
+	CHECK(queue.GetShaderId(&objects[0], &objects[1]) == 0);
+	CHECK(queue.GetShaderId(&objects[0], &objects[2]) == 1);
+	CHECK(queue.GetShaderId(&objects[0], &objects[1]) == 0);
+	CHECK(queue.GetMaterialId(&objects[3]) == 0);
+	CHECK(queue.GetMaterialId(&objects[2]) == 1);
+	CHECK(queue.GetMeshId(&objects[3]) == 0);
+	CHECK(queue.GetMaterialId(&objects[3]) == 0);
+
+	// Clearing the items keeps the ids, so they're stable from frame to frame
+	queue.Clear();
+	CHECK(queue.GetMaterialId(&objects[2]) == 1);
+}
+
+// --------------------------------------------------------
+// Counting binds without a device. A small queue with the
+// answers worked out by hand, then a scene where sorting
+// has to bring shader binds down to one per shader and
+// material binds to one per shader and material pair
+// --------------------------------------------------------
+void TestStateChanges()
+{
+	// Two setups, interleaved - every draw changes everything until they're sorted
+	std::vector<uint64_t> keys = {
+		RenderQueue::MakeKey(0, 0, 0, 0.1f), RenderQueue::MakeKey(1, 1, 1, 0.1f),
+		RenderQueue::MakeKey(0, 0, 0, 0.2f), RenderQueue::MakeKey(1, 1, 1, 0.2f) };
+	RenderQueue queue = MakeQueue(keys);
+	RenderQueueStats before = queue.CountStateChanges();
+	CHECK(before.Draws == 4 && before.ShaderBinds == 4 && before.MaterialBinds == 4 && before.MeshBinds == 4 && before.BindsAvoided == 0);
+	queue.Sort();
+	RenderQueueStats after = queue.CountStateChanges();
+	CHECK(after.Draws == 4 && after.ShaderBinds == 2 && after.MaterialBinds == 2 && after.MeshBinds == 2 && after.BindsAvoided == 6);
+
+	// A material change under a new shader still counts, even with the same material id
+	queue = MakeQueue({ RenderQueue::MakeKey(0, 5, 0, 0.0f), RenderQueue::MakeKey(1, 5, 0, 0.0f) });
+	after = queue.CountStateChanges();
+	CHECK(after.ShaderBinds == 2 && after.MaterialBinds == 2 && after.MeshBinds == 1);
+
+	// A bigger scene
+	const unsigned int shaderCount = 4;
+	const unsigned int materialCount = 16;
+	const unsigned int meshCount = 8;
+	keys = GetSceneKeys(5000, shaderCount, materialCount, meshCount);
+	std::set<uint64_t> shaders;
+	std::set<uint64_t> materials;
+	std::set<uint64_t> setups;
+	for (uint64_t key : keys) {
+		shaders.insert(key & RenderQueue::c_shaderMask);
+		materials.insert(key & (RenderQueue::c_shaderMask | RenderQueue::c_materialMask));
+		setups.insert(key & ~RenderQueue::c_depthMask);
+	}
+
+	queue = MakeQueue(keys);
+	before = queue.CountStateChanges();
+	queue.Sort();
+	after = queue.CountStateChanges();
+	printf("Scene: %u draws, binds before sorting %u/%u/%u, after %u/%u/%u (shader/material/mesh)\n",
+		after.Draws, before.ShaderBinds, before.MaterialBinds, before.MeshBinds, after.ShaderBinds, after.MaterialBinds, after.MeshBinds);
+
+	CHECK(after.Draws == before.Draws);
+	CHECK(after.ShaderBinds == shaders.size());
+	CHECK(after.MaterialBinds == materials.size());
+	CHECK(after.MeshBinds <= setups.size() && after.MeshBinds >= meshCount);
+	CHECK(after.ShaderBinds < before.ShaderBinds && after.MaterialBinds < before.MaterialBinds && after.MeshBinds < before.MeshBinds);
+	CHECK(after.BindsAvoided == after.Draws * 3 - (after.ShaderBinds + after.MaterialBinds + after.MeshBinds));
+}
+
+int main()
+{
+	TestSortMatchesReference();
+	TestMakeKey();
+	TestIds();
+	TestStateChanges();
+	return TestResult();
+}
@@ -0,0 +1,194 @@
+#include "ShaderReflectionCache.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	const uint64_t c_bytecodeHash = 0x0123456789ABCDEFull;
+
+	// Something like a lit vertex shader's reflection, with a bit of everything in it
+	ShaderReflectionData MakeReflectionData()
+	{
+		ShaderReflectionData data;
+
+		ShaderReflectionBuffer perFrame;
+		perFrame.Name = "PerFrame";
+		perFrame.Size = 128;
+		perFrame.BindIndex = 0;
+		perFrame.Variables.push_back({ "viewMatrix", 0, 64 });
+		perFrame.Variables.push_back({ "projectionMatrix", 64, 64 });
+		data.ConstantBuffers.push_back(perFrame);
+
+		ShaderReflectionBuffer perObject;
+		perObject.Name = "PerObject";
+		perObject.Type = 1;
+		perObject.Size = 160;
+		perObject.BindIndex = 1;
+		perObject.Variables.push_back({ "worldMatrix", 0, 64 });
+		perObject.Variables.push_back({ "worldInvTransposeMatrix", 64, 64 });
+		perObject.Variables.push_back({ "positionScale", 128, 12 });
+		data.ConstantBuffers.push_back(perObject);
+
+		data.Textures.push_back({ "SurfaceTexture", 0 });
+		data.Textures.push_back({ "NormalMap", 2 });
+		data.Samplers.push_back({ "BasicSampler", 0 });
+
+		data.Inputs.push_back({ "POSITION", 0, 3, 7 });
+		data.Inputs.push_back({ "TEXCOORD", 0, 3, 3 });
+		data.Inputs.push_back({ "TEXCOORD", 1, 1, 1 });
+		return data;
+	}
+
+	bool IsEmpty(const ShaderReflectionData& a_data)
+	{
+		return a_data.ConstantBuffers.empty() && a_data.Textures.empty() && a_data.Samplers.empty() && a_data.Inputs.empty();
+	}
+
+	bool AreEqual(const std::vector<ShaderReflectionResource>& a_first, const std::vector<ShaderReflectionResource>& a_second)
+	{
+		if (a_first.size() != a_second.size())
+			return false;
+		for (size_t i = 0; i < a_first.size(); i++) {
+			if (a_first[i].Name != a_second[i].Name || a_first[i].BindIndex != a_second[i].BindIndex)
+				return false;
+		}
+		return true;
+	}
+
+	bool AreEqual(const ShaderReflectionData& a_first, const ShaderReflectionData& a_second)
+	{
+		if (a_first.ConstantBuffers.size() != a_second.ConstantBuffers.size() || a_first.Inputs.size() != a_second.Inputs.size())
+			return false;
+
+		for (size_t b = 0; b < a_first.ConstantBuffers.size(); b++) {
+			const ShaderReflectionBuffer& first = a_first.ConstantBuffers[b];
+			const ShaderReflectionBuffer& second = a_second.ConstantBuffers[b];
+			if (first.Name != second.Name || first.Type != second.Type || first.Size != second.Size ||
+				first.BindIndex != second.BindIndex || first.Variables.size() != second.Variables.size())
+				return false;
+			for (size_t v = 0; v < first.Variables.size(); v++) {
+				if (first.Variables[v].Name != second.Variables[v].Name ||
+					first.Variables[v].ByteOffset != second.Variables[v].ByteOffset ||
+					first.Variables[v].Size != second.Variables[v].Size)
+					return false;
+			}
+		}
+
+		for (size_t i = 0; i < a_first.Inputs.size(); i++) {
+			const ShaderReflectionInput& first = a_first.Inputs[i];
+			const ShaderReflectionInput& second = a_second.Inputs[i];
+			if (first.SemanticName != second.SemanticName || first.SemanticIndex != second.SemanticIndex ||
+				first.ComponentType != second.ComponentType || first.Mask != second.Mask)
+				return false;
+		}
+
+		return AreEqual(a_first.Textures, a_second.Textures) && AreEqual(a_first.Samplers, a_second.Samplers);
+	}
+
+	// Deserializes bytes that are supposed to be rejected - which also has to leave the data empty
+	void CheckRejected(const std::vector<unsigned char>& a_bytes, uint64_t a_bytecodeHash)
+	{
+		ShaderReflectionData data = MakeReflectionData();
+		CHECK(!DeserializeShaderReflection(a_bytes.data(), a_bytes.size(), a_bytecodeHash, data));
+		CHECK(IsEmpty(data));
+	}
+
+	// Overwrites the little-endian value at a_offset
+	void PatchU32(std::vector<unsigned char>& a_bytes, size_t a_offset, uint32_t a_value)
+	{
+		for (int i = 0; i < 4; i++)
+			a_bytes[a_offset + i] = (unsigned char)(a_value >> (i * 8));
+	}
+}
+
+void TestRoundTrip()
+{
+	ShaderReflectionData original = MakeReflectionData();
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(original, c_bytecodeHash, bytes);
+
+	ShaderReflectionData loaded;
+	CHECK(DeserializeShaderReflection(bytes.data(), bytes.size(), c_bytecodeHash, loaded));
+	CHECK(AreEqual(original, loaded));
+
+	// A shader with nothing to reflect still makes a valid file
+	SerializeShaderReflection(ShaderReflectionData(), c_bytecodeHash, bytes);
+	loaded = MakeReflectionData();
+	CHECK(DeserializeShaderReflection(bytes.data(), bytes.size(), c_bytecodeHash, loaded));
+	CHECK(IsEmpty(loaded));
+}
+
+void TestRejectsTruncated()
+{
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(MakeReflectionData(), c_bytecodeHash, bytes);
+
+	// Every length short of the whole file, including nothing at all
+	for (size_t size = 0; size < bytes.size(); size++)
+		CheckRejected(std::vector<unsigned char>(bytes.begin(), bytes.begin() + size), c_bytecodeHash);
+}
+
+void TestRejectsWrongHash()
+{
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(MakeReflectionData(), c_bytecodeHash, bytes);
+	CheckRejected(bytes, c_bytecodeHash + 1);
+	CheckRejected(bytes, HashShaderBytecode("DXBC", 4));
+}
+
+void TestRejectsTrailingBytes()
+{
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(MakeReflectionData(), c_bytecodeHash, bytes);
+	bytes.push_back(0);
+	CheckRejected(bytes, c_bytecodeHash);
+}
+
+void TestRejectsWrongHeader()
+{
+	std::vector<unsigned char> original;
+	SerializeShaderReflection(MakeReflectionData(), c_bytecodeHash, original);
+
+	// Magic, then version
+	std::vector<unsigned char> bytes = original;
+	bytes[0] ^= 0xFF;
+	CheckRejected(bytes, c_bytecodeHash);
+
+	bytes = original;
+	PatchU32(bytes, 4, c_shaderReflectionVersion + 1);
+	CheckRejected(bytes, c_bytecodeHash);
+
+	// A buffer count no real shader has - the first one after the 16 byte header
+	bytes = original;
+	PatchU32(bytes, 16, 0x10000);
+	CheckRejected(bytes, c_bytecodeHash);
+}
+
+void TestRejectsVariableOutsideBuffer()
+{
+	ShaderReflectionData data = MakeReflectionData();
+	data.ConstantBuffers[0].Variables[1].ByteOffset = 100;
+
+	std::vector<unsigned char> bytes;
+	SerializeShaderReflection(data, c_bytecodeHash, bytes);
+	CheckRejected(bytes, c_bytecodeHash);
+}
+
+void TestCachePath()
+{
+	CHECK(GetShaderReflectionCachePath(L"Shaders/VertexShader.cso") == L"Shaders/VertexShader.refl");
+	CHECK(GetShaderReflectionCachePath(L"C:\\Game.v2\\PixelShader") == L"C:\\Game.v2\\PixelShader.refl");
+	CHECK(GetShaderReflectionCachePath(L"Sky") == L"Sky.refl");
+}
+
+int main()
+{
+	TestRoundTrip();
+	TestRejectsTruncated();
+	TestRejectsWrongHash();
+	TestRejectsTrailingBytes();
+	TestRejectsWrongHeader();
+	TestRejectsVariableOutsideBuffer();
+	TestCachePath();
+
+	return TestResult();
+}
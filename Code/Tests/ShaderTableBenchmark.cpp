@@ -0,0 +1,301 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderReflectionCache.h"
+#include "SimpleNameTable.h"
+
+// Every allocation the program makes goes through here, so building a
+// shader's metadata can be measured in allocations
+static size_t s_allocationCount = 0;
+
+void* operator new(size_t a_size)
+{
+	s_allocationCount++;
+	void* memory = malloc(a_size > 0 ? a_size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+void operator delete(void* a_memory) noexcept { free(a_memory); }
+void operator delete(void* a_memory, size_t) noexcept { free(a_memory); }
+
+namespace
+{
+	const double c_minSeconds = 0.25;
+	const unsigned int c_lookupCount = 100000;
+
+	struct Variable { unsigned int ByteOffset; unsigned int Size; unsigned int ConstantBufferIndex; };
+	struct Resource { unsigned int Index; unsigned int BindIndex; };
+
+	// --------------------------------------------------------
+	// SimpleShader's metadata as it was before the flat arrays -
+	// a node-based map per kind of name, each texture and
+	// sampler allocated on its own, and each buffer's local
+	// data allocated with new[]
+	// --------------------------------------------------------
+	struct NodeConstantBuffer
+	{
+		std::string Name;
+		unsigned int Size = 0;
+		unsigned char* LocalDataBuffer = 0;
+		std::vector<Variable> Variables;
+	};
+
+	struct NodeShaderTables
+	{
+		NodeShaderTables(const ShaderReflectionData& a_reflection)
+		{
+			for (const ShaderReflectionResource& resource : a_reflection.Textures) {
+				Resource* srv = new Resource{ (unsigned int)shaderResourceViews.size(), resource.BindIndex };
+				textureTable.insert(std::pair<std::string, Resource*>(resource.Name, srv));
+				shaderResourceViews.push_back(srv);
+			}
+			for (const ShaderReflectionResource& resource : a_reflection.Samplers) {
+				Resource* sampler = new Resource{ (unsigned int)samplerStates.size(), resource.BindIndex };
+				samplerTable.insert(std::pair<std::string, Resource*>(resource.Name, sampler));
+				samplerStates.push_back(sampler);
+			}
+
+			bufferCount = (unsigned int)a_reflection.ConstantBuffers.size();
+			constantBuffers = new NodeConstantBuffer[bufferCount];
+			for (unsigned int b = 0; b < bufferCount; b++) {
+				const ShaderReflectionBuffer& bufferDesc = a_reflection.ConstantBuffers[b];
+				constantBuffers[b].Name = bufferDesc.Name;
+				constantBuffers[b].Size = bufferDesc.Size;
+				constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
+				cbTable.insert(std::pair<std::string, NodeConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
+				for (const ShaderReflectionVariable& varDesc : bufferDesc.Variables) {
+					Variable var = { varDesc.ByteOffset, varDesc.Size, b };
+					varTable.insert(std::pair<std::string, Variable>(varDesc.Name, var));
+					varHashTable.insert(std::pair<unsigned int, Variable>(SimpleShaderHash(varDesc.Name.c_str()), var));
+					constantBuffers[b].Variables.push_back(var);
+				}
+			}
+		}
+
+		~NodeShaderTables()
+		{
+			for (Resource* srv : shaderResourceViews) delete srv;
+			for (Resource* sampler : samplerStates) delete sampler;
+			for (unsigned int b = 0; b < bufferCount; b++) delete[] constantBuffers[b].LocalDataBuffer;
+			delete[] constantBuffers;
+		}
+
+		unsigned int bufferCount = 0;
+		NodeConstantBuffer* constantBuffers = 0;
+		std::vector<Resource*> shaderResourceViews;
+		std::vector<Resource*> samplerStates;
+		std::unordered_map<std::string, NodeConstantBuffer*> cbTable;
+		std::unordered_map<std::string, Variable> varTable;
+		std::unordered_map<unsigned int, Variable> varHashTable;
+		std::unordered_map<std::string, Resource*> textureTable;
+		std::unordered_map<std::string, Resource*> samplerTable;
+	};
+
+	// --------------------------------------------------------
+	// SimpleShader's metadata now - flat arrays of everything,
+	// open-addressing name tables and one slab for every
+	// buffer's local data, the way ISimpleShader sets it up
+	// --------------------------------------------------------
+	struct FlatConstantBuffer
+	{
+		std::string Name;
+		unsigned int Size = 0;
+		unsigned char* LocalDataBuffer = 0;
+		unsigned int FirstVariable = 0;
+		unsigned int VariableCount = 0;
+	};
+
+	struct FlatShaderTables
+	{
+		FlatShaderTables(const ShaderReflectionData& a_reflection)
+		{
+			unsigned int bufferCount = (unsigned int)a_reflection.ConstantBuffers.size();
+			unsigned int variableCount = 0;
+			size_t localDataSize = 0;
+			for (const ShaderReflectionBuffer& buffer : a_reflection.ConstantBuffers) {
+				variableCount += (unsigned int)buffer.Variables.size();
+				localDataSize += ((buffer.Size + 15) / 16) * 16;
+			}
+			constantBuffers.resize(bufferCount);
+			variables.reserve(variableCount);
+			shaderResourceViews.reserve(a_reflection.Textures.size());
+			samplerStates.reserve(a_reflection.Samplers.size());
+			cbTable.Reserve(bufferCount);
+			varTable.Reserve(variableCount);
+			textureTable.Reserve((unsigned int)a_reflection.Textures.size());
+			samplerTable.Reserve((unsigned int)a_reflection.Samplers.size());
+			localData = new unsigned char[localDataSize];
+
+			for (const ShaderReflectionResource& resource : a_reflection.Textures) {
+				textureTable.Insert(resource.Name, (unsigned int)shaderResourceViews.size());
+				shaderResourceViews.push_back({ (unsigned int)shaderResourceViews.size(), resource.BindIndex });
+			}
+			for (const ShaderReflectionResource& resource : a_reflection.Samplers) {
+				samplerTable.Insert(resource.Name, (unsigned int)samplerStates.size());
+				samplerStates.push_back({ (unsigned int)samplerStates.size(), resource.BindIndex });
+			}
+
+			size_t localDataOffset = 0;
+			for (unsigned int b = 0; b < bufferCount; b++) {
+				const ShaderReflectionBuffer& bufferDesc = a_reflection.ConstantBuffers[b];
+				constantBuffers[b].Name = bufferDesc.Name;
+				constantBuffers[b].Size = bufferDesc.Size;
+				constantBuffers[b].LocalDataBuffer = localData + localDataOffset;
+				localDataOffset += ((bufferDesc.Size + 15) / 16) * 16;
+				cbTable.Insert(bufferDesc.Name, b);
+
+				constantBuffers[b].FirstVariable = (unsigned int)variables.size();
+				constantBuffers[b].VariableCount = (unsigned int)bufferDesc.Variables.size();
+				for (const ShaderReflectionVariable& varDesc : bufferDesc.Variables) {
+					varTable.Insert(varDesc.Name, (unsigned int)variables.size());
+					variables.push_back({ varDesc.ByteOffset, varDesc.Size, b });
+				}
+			}
+		}
+
+		~FlatShaderTables() { delete[] localData; }
+
+		std::vector<FlatConstantBuffer> constantBuffers;
+		std::vector<Variable> variables;
+		std::vector<Resource> shaderResourceViews;
+		std::vector<Resource> samplerStates;
+		unsigned char* localData = 0;
+		SimpleNameTable cbTable;
+		SimpleNameTable varTable;
+		SimpleNameTable textureTable;
+		SimpleNameTable samplerTable;
+	};
+
+	// The reflection of the PBR pixel shader
+	ShaderReflectionData GetPixelShaderReflection()
+	{
+		ShaderReflectionData data;
+
+		ShaderReflectionBuffer perFrame;
+		perFrame.Name = "PerFrame";
+		perFrame.Size = 352;
+		perFrame.Variables = { { "gamma", 0, 4 }, { "ambientColor", 4, 12 }, { "cameraPosition", 16, 12 }, { "lights", 32, 320 } };
+		data.ConstantBuffers.push_back(perFrame);
+
+		ShaderReflectionBuffer perMaterial;
+		perMaterial.Name = "PerMaterial";
+		perMaterial.Size = 48;
+		perMaterial.BindIndex = 1;
+		perMaterial.Variables = { { "roughness", 0, 4 }, { "colorTint", 4, 12 }, { "uvScale", 16, 8 }, { "uvOffset", 24, 8 }, { "useSpecularMap", 32, 4 } };
+		data.ConstantBuffers.push_back(perMaterial);
+
+		data.Textures = { { "DiffuseTexture", 0 }, { "SpecularMap", 1 }, { "NormalMap", 2 } };
+		data.Samplers = { { "BasicSampler", 0 } };
+		return data;
+	}
+
+	// Runs a_lookups until enough time has passed for a steady number, and
+	// returns nanoseconds per lookup. a_found is how many were found
+	double MeasureLookups(const std::function<unsigned int()>& a_lookups, unsigned int& a_found)
+	{
+		int runs = 0;
+		double seconds = 0.0;
+		while (seconds < c_minSeconds) {
+			auto start = std::chrono::high_resolution_clock::now();
+			a_found = a_lookups();
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			runs++;
+		}
+		return seconds * 1e9 / ((double)runs * c_lookupCount);
+	}
+}
+
+// --------------------------------------------------------
+// Builds the PBR pixel shader's metadata both ways and
+// counts the allocations each takes, then looks its
+// variables up 100k times in a random order - by name (with
+// the strings already built, so only the lookup is timed)
+// and by SimpleShaderHash(). Reports nanoseconds per lookup
+// --------------------------------------------------------
+int main()
+{
+	ShaderReflectionData reflection = GetPixelShaderReflection();
+
+	size_t before = s_allocationCount;
+	NodeShaderTables* nodeTables = new NodeShaderTables(reflection);
+	size_t nodeAllocations = s_allocationCount - before - 1;
+	before = s_allocationCount;
+	FlatShaderTables* flatTables = new FlatShaderTables(reflection);
+	size_t flatAllocations = s_allocationCount - before - 1;
+
+	std::vector<std::string> names;
+	for (const ShaderReflectionBuffer& buffer : reflection.ConstantBuffers)
+		for (const ShaderReflectionVariable& variable : buffer.Variables)
+			names.push_back(variable.Name);
+	std::mt19937 random(540);
+	std::vector<const std::string*> lookupNames(c_lookupCount);
+	std::vector<unsigned int> lookupHashes(c_lookupCount);
+	for (unsigned int i = 0; i < c_lookupCount; i++) {
+		lookupNames[i] = &names[random() % names.size()];
+		lookupHashes[i] = SimpleShaderHash(lookupNames[i]->c_str());
+	}
+
+	unsigned int nodeFound = 0;
+	double nodeTime = MeasureLookups([&]() {
+		unsigned int found = 0;
+		for (const std::string* name : lookupNames) {
+			auto variable = nodeTables->varTable.find(*name);
+			if (variable != nodeTables->varTable.end())
+				found += variable->second.Size > 0;
+		}
+		return found;
+	}, nodeFound);
+
+	unsigned int flatFound = 0;
+	double flatTime = MeasureLookups([&]() {
+		unsigned int found = 0;
+		for (const std::string* name : lookupNames) {
+			int index = flatTables->varTable.Find(*name);
+			if (index >= 0)
+				found += flatTables->variables[index].Size > 0;
+		}
+		return found;
+	}, flatFound);
+
+	unsigned int nodeHashFound = 0;
+	double nodeHashTime = MeasureLookups([&]() {
+		unsigned int found = 0;
+		for (unsigned int hash : lookupHashes) {
+			auto variable = nodeTables->varHashTable.find(hash);
+			if (variable != nodeTables->varHashTable.end())
+				found += variable->second.Size > 0;
+		}
+		return found;
+	}, nodeHashFound);
+
+	unsigned int flatHashFound = 0;
+	double flatHashTime = MeasureLookups([&]() {
+		unsigned int found = 0;
+		for (unsigned int hash : lookupHashes) {
+			int index = flatTables->varTable.FindHash(hash);
+			if (index >= 0)
+				found += flatTables->variables[index].Size > 0;
+		}
+		return found;
+	}, flatHashFound);
+
+	printf("%zu variables, %zu buffers, %zu textures, %zu samplers\n", names.size(), reflection.ConstantBuffers.size(), reflection.Textures.size(), reflection.Samplers.size());
+	printf("%-16s %12s %14s %14s\n", "Tables", "Allocations", "ns/name", "ns/hash");
+	printf("%-16s %12zu %14.2f %14.2f\n", "unordered_map", nodeAllocations, nodeTime, nodeHashTime);
+	printf("%-16s %12zu %14.2f %14.2f\n", "Flat", flatAllocations, flatTime, flatHashTime);
+	printf("Found %u/%u/%u/%u of %u\n", nodeFound, nodeHashFound, flatFound, flatHashFound, c_lookupCount);
+	printf("Flat tables make %.2fx fewer allocations, and look names up %.2fx and hashes %.2fx as fast\n", (double)nodeAllocations / flatAllocations, nodeTime / flatTime, nodeHashTime / flatHashTime);
+
+	delete nodeTables;
+	delete flatTables;
+	return 0;
+}
@@ -0,0 +1,293 @@
+#include <random>
+#include <vector>
+
+#include "StateCache.h"
+#include "TestHelpers.h"
+
+namespace
+{
+	enum class CallType { InputLayout, Shader, ConstantBuffers, ShaderResources, Samplers };
+
+	// One call the cache made to the context
+	struct RecordedCall
+	{
+		CallType Type;
+		ShaderStage Stage;
+		unsigned int StartSlot;
+		std::vector<void*> Values;
+	};
+
+	// --------------------------------------------------------
+	// Stands in for the device context - records every call,
+	// and keeps what each slot ends up holding, the way the
+	// context itself would
+	// --------------------------------------------------------
+	class RecordingTarget : public IStateCacheTarget
+	{
+	public:
+		RecordingTarget()
+		{
+			for (unsigned int s = 0; s < (unsigned int)ShaderStage::Count; s++) {
+				Stages[s].Shader = nullptr;
+				for (void*& buffer : Stages[s].ConstantBuffers) buffer = nullptr;
+				for (void*& resource : Stages[s].ShaderResources) resource = nullptr;
+				for (void*& sampler : Stages[s].Samplers) sampler = nullptr;
+			}
+		}
+
+		void SetInputLayout(void* a_pLayout)
+		{
+			Calls.push_back({ CallType::InputLayout, ShaderStage::Count, 0, { a_pLayout } });
+			pInputLayout = a_pLayout;
+		}
+		void SetShader(ShaderStage a_stage, void* a_pShader)
+		{
+			Calls.push_back({ CallType::Shader, a_stage, 0, { a_pShader } });
+			Stages[(unsigned int)a_stage].Shader = a_pShader;
+		}
+		void SetConstantBuffers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppBuffers)
+		{
+			Record(CallType::ConstantBuffers, a_stage, a_startSlot, a_count, a_ppBuffers, Stages[(unsigned int)a_stage].ConstantBuffers);
+		}
+		void SetShaderResources(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppResources)
+		{
+			Record(CallType::ShaderResources, a_stage, a_startSlot, a_count, a_ppResources, Stages[(unsigned int)a_stage].ShaderResources);
+		}
+		void SetSamplers(ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppSamplers)
+		{
+			Record(CallType::Samplers, a_stage, a_startSlot, a_count, a_ppSamplers, Stages[(unsigned int)a_stage].Samplers);
+		}
+
+		struct StageState
+		{
+			void* Shader;
+			void* ConstantBuffers[c_constantBufferSlotCount];
+			void* ShaderResources[c_shaderResourceSlotCount];
+			void* Samplers[c_samplerSlotCount];
+		};
+
+		std::vector<RecordedCall> Calls;
+		void* pInputLayout = nullptr;
+		StageState Stages[(unsigned int)ShaderStage::Count];
+
+	private:
+		void Record(CallType a_type, ShaderStage a_stage, unsigned int a_startSlot, unsigned int a_count, void* const* a_ppValues, void** a_pSlots)
+		{
+			Calls.push_back({ a_type, a_stage, a_startSlot, std::vector<void*>(a_ppValues, a_ppValues + a_count) });
+			for (unsigned int i = 0; i < a_count; i++)
+				a_pSlots[a_startSlot + i] = a_ppValues[i];
+		}
+	};
+
+	// Stand-ins for shaders, buffers, textures and samplers - only their addresses matter
+	int s_objects[64];
+	void* GetObject(unsigned int a_index) { return &s_objects[a_index]; }
+
+	bool IsCall(const RecordedCall& a_call, CallType a_type, ShaderStage a_stage, unsigned int a_startSlot, const std::vector<void*>& a_values)
+	{
+		return a_call.Type == a_type && a_call.Stage == a_stage && a_call.StartSlot == a_startSlot && a_call.Values == a_values;
+	}
+}
+
+// Binding the shader that's already bound does nothing, and a new one goes straight through
+void TestShaderBinds()
+{
+	RecordingTarget target;
+	StateCache cache(&target);
+
+	cache.SetShader(ShaderStage::Vertex, GetObject(0));
+	cache.SetShader(ShaderStage::Pixel, GetObject(1));
+	cache.Flush();
+	CHECK(target.Calls.size() == 2);
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[0], CallType::Shader, ShaderStage::Vertex, 0, { GetObject(0) }));
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[1], CallType::Shader, ShaderStage::Pixel, 0, { GetObject(1) }));
+
+	// The same again - filtered
+	target.Calls.clear();
+	cache.SetShader(ShaderStage::Vertex, GetObject(0));
+	cache.SetShader(ShaderStage::Pixel, GetObject(1));
+	cache.Flush();
+	CHECK(target.Calls.empty());
+
+	// A real change passes, and the same shader on another stage is a change too
+	cache.SetShader(ShaderStage::Pixel, GetObject(2));
+	cache.SetShader(ShaderStage::Compute, GetObject(0));
+	cache.Flush();
+	CHECK(target.Calls.size() == 2);
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[0], CallType::Shader, ShaderStage::Pixel, 0, { GetObject(2) }));
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[1], CallType::Shader, ShaderStage::Compute, 0, { GetObject(0) }));
+
+	// Changed and changed back before a flush - nothing to send
+	target.Calls.clear();
+	cache.SetShader(ShaderStage::Vertex, GetObject(5));
+	cache.SetShader(ShaderStage::Vertex, GetObject(0));
+	cache.Flush();
+	CHECK(target.Calls.empty());
+
+	// Binding nothing is a change from something
+	cache.SetShader(ShaderStage::Pixel, nullptr);
+	cache.Flush();
+	CHECK(target.Calls.size() == 1 && target.Stages[(unsigned int)ShaderStage::Pixel].Shader == nullptr);
+
+	CHECK(cache.GetBindsRequested() == 9 && cache.GetCallsMade() == 5 && cache.GetCallsSaved() == 4);
+}
+
+// --------------------------------------------------------
+// Buffers, textures and samplers only go out for the slots
+// that changed, one call per run of neighboring slots - a
+// run carries on over slots already holding their value
+// --------------------------------------------------------
+void TestSlotBinds()
+{
+	RecordingTarget target;
+	StateCache cache(&target);
+
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, GetObject(10));
+	cache.SetConstantBuffer(ShaderStage::Vertex, 1, GetObject(11));
+	cache.SetShaderResource(ShaderStage::Pixel, 0, GetObject(20));
+	cache.SetShaderResource(ShaderStage::Pixel, 1, GetObject(21));
+	cache.SetShaderResource(ShaderStage::Pixel, 2, GetObject(22));
+	cache.SetSampler(ShaderStage::Pixel, 0, GetObject(30));
+	cache.Flush();
+	CHECK(target.Calls.size() == 3);
+	CHECK(target.Calls.size() == 3 && IsCall(target.Calls[0], CallType::ConstantBuffers, ShaderStage::Vertex, 0, { GetObject(10), GetObject(11) }));
+	CHECK(target.Calls.size() == 3 && IsCall(target.Calls[1], CallType::ShaderResources, ShaderStage::Pixel, 0, { GetObject(20), GetObject(21), GetObject(22) }));
+	CHECK(target.Calls.size() == 3 && IsCall(target.Calls[2], CallType::Samplers, ShaderStage::Pixel, 0, { GetObject(30) }));
+
+	// Everything again, as a material that didn't change would - filtered
+	target.Calls.clear();
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, GetObject(10));
+	cache.SetConstantBuffer(ShaderStage::Vertex, 1, GetObject(11));
+	for (unsigned int i = 0; i < 3; i++)
+		cache.SetShaderResource(ShaderStage::Pixel, i, GetObject(20 + i));
+	cache.SetSampler(ShaderStage::Pixel, 0, GetObject(30));
+	cache.Flush();
+	CHECK(target.Calls.empty());
+
+	// Slots 0 and 2 change - one call, carrying slot 1's texture across
+	cache.SetShaderResource(ShaderStage::Pixel, 0, GetObject(23));
+	cache.SetShaderResource(ShaderStage::Pixel, 1, GetObject(21));
+	cache.SetShaderResource(ShaderStage::Pixel, 2, GetObject(24));
+	cache.Flush();
+	CHECK(target.Calls.size() == 1 && IsCall(target.Calls[0], CallType::ShaderResources, ShaderStage::Pixel, 0, { GetObject(23), GetObject(21), GetObject(24) }));
+
+	// Slots with nothing known between them can't be carried across - two calls
+	target.Calls.clear();
+	cache.SetSampler(ShaderStage::Pixel, 1, GetObject(31));
+	cache.SetSampler(ShaderStage::Pixel, 5, GetObject(32));
+	cache.Flush();
+	CHECK(target.Calls.size() == 2);
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[0], CallType::Samplers, ShaderStage::Pixel, 1, { GetObject(31) }));
+	CHECK(target.Calls.size() == 2 && IsCall(target.Calls[1], CallType::Samplers, ShaderStage::Pixel, 5, { GetObject(32) }));
+
+	// The same texture on another stage, and slots past the end, which are ignored
+	target.Calls.clear();
+	cache.SetShaderResource(ShaderStage::Vertex, 0, GetObject(23));
+	cache.SetShaderResource(ShaderStage::Vertex, c_shaderResourceSlotCount, GetObject(25));
+	cache.SetConstantBuffer(ShaderStage::Vertex, c_constantBufferSlotCount, GetObject(12));
+	cache.Flush();
+	CHECK(target.Calls.size() == 1 && IsCall(target.Calls[0], CallType::ShaderResources, ShaderStage::Vertex, 0, { GetObject(23) }));
+}
+
+// Flushes go input layout first, then stage by stage - shader, buffers, textures, samplers
+void TestFlushOrder()
+{
+	RecordingTarget target;
+	StateCache cache(&target);
+
+	cache.SetSampler(ShaderStage::Pixel, 0, GetObject(30));
+	cache.SetShaderResource(ShaderStage::Pixel, 0, GetObject(20));
+	cache.SetShader(ShaderStage::Pixel, GetObject(1));
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, GetObject(10));
+	cache.SetShader(ShaderStage::Vertex, GetObject(0));
+	cache.SetInputLayout(GetObject(40));
+	cache.Flush();
+
+	const CallType expected[] = { CallType::InputLayout, CallType::Shader, CallType::ConstantBuffers, CallType::Shader, CallType::ShaderResources, CallType::Samplers };
+	CHECK(target.Calls.size() == 6);
+	for (size_t i = 0; i < target.Calls.size() && i < 6; i++)
+		CHECK(target.Calls[i].Type == expected[i]);
+	CHECK(target.Calls.size() == 6 && target.Calls[1].Stage == ShaderStage::Vertex && target.Calls[3].Stage == ShaderStage::Pixel);
+
+	// Invalidating forgets it all, so the same binds go out again
+	target.Calls.clear();
+	cache.Invalidate();
+	cache.SetInputLayout(GetObject(40));
+	cache.SetShader(ShaderStage::Vertex, GetObject(0));
+	cache.Flush();
+	CHECK(target.Calls.size() == 2);
+}
+
+// --------------------------------------------------------
+// Frames of random binds, flushed at random points, against
+// a context that's given every bind directly - after each
+// flush, every slot has to hold what it would have without
+// the cache, with fewer calls. Reports the calls saved
+// --------------------------------------------------------
+void TestMatchesDirectBinds()
+{
+	RecordingTarget cachedTarget;
+	RecordingTarget directTarget;
+	StateCache cache(&cachedTarget);
+	std::mt19937 random(540);
+
+	size_t mismatches = 0;
+	for (int frame = 0; frame < 20; frame++) {
+		cache.ResetStats();
+		cachedTarget.Calls.clear();
+		directTarget.Calls.clear();
+
+		for (int draw = 0; draw < 200; draw++) {
+			// A few materials' worth of objects, so binds often repeat
+			unsigned int material = random() % 4;
+			ShaderStage stage = (random() % 3 == 0) ? ShaderStage::Vertex : ShaderStage::Pixel;
+			void* shader = GetObject(material % 2 + (stage == ShaderStage::Pixel ? 2 : 0));
+			cache.SetShader(stage, shader);
+			directTarget.SetShader(stage, shader);
+
+			for (unsigned int slot = 0; slot < 2; slot++) {
+				void* buffer = GetObject(8 + slot + (random() % 2) * 2);
+				cache.SetConstantBuffer(stage, slot, buffer);
+				directTarget.SetConstantBuffers(stage, slot, 1, &buffer);
+			}
+			for (unsigned int slot = 0; slot < 3; slot++) {
+				void* texture = GetObject(16 + material * 3 + slot);
+				cache.SetShaderResource(ShaderStage::Pixel, slot, texture);
+				directTarget.SetShaderResources(ShaderStage::Pixel, slot, 1, &texture);
+			}
+			void* sampler = GetObject(32 + material % 2);
+			unsigned int samplerSlot = random() % 2;
+			cache.SetSampler(ShaderStage::Pixel, samplerSlot, sampler);
+			directTarget.SetSamplers(ShaderStage::Pixel, samplerSlot, 1, &sampler);
+
+			// Binds only have to reach the context before a draw
+			cache.Flush();
+		}
+
+		for (unsigned int s = 0; s < (unsigned int)ShaderStage::Count; s++) {
+			const RecordingTarget::StageState& cached = cachedTarget.Stages[s];
+			const RecordingTarget::StageState& direct = directTarget.Stages[s];
+			mismatches += cached.Shader != direct.Shader;
+			for (unsigned int i = 0; i < c_constantBufferSlotCount; i++)
+				mismatches += cached.ConstantBuffers[i] != direct.ConstantBuffers[i];
+			for (unsigned int i = 0; i < c_shaderResourceSlotCount; i++)
+				mismatches += cached.ShaderResources[i] != direct.ShaderResources[i];
+			for (unsigned int i = 0; i < c_samplerSlotCount; i++)
+				mismatches += cached.Samplers[i] != direct.Samplers[i];
+		}
+		CHECK(directTarget.Calls.size() == cache.GetBindsRequested());
+		CHECK(cache.GetCallsMade() == cachedTarget.Calls.size());
+		CHECK(cache.GetCallsMade() < cache.GetBindsRequested());
+	}
+	printf("Last frame: %u binds asked for, %u calls made, %u saved\n", cache.GetBindsRequested(), cache.GetCallsMade(), cache.GetCallsSaved());
+	CHECK(mismatches == 0);
+}
+
+int main()
+{
+	TestShaderBinds();
+	TestSlotBinds();
+	TestFlushOrder();
+	TestMatchesDirectBinds();
+	return TestResult();
+}
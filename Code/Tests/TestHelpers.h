@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Just enough to write tests without a framework - CHECK()
+// reports a failure and carries on, and main() returns
+// TestResult() so CTest sees whether anything failed
+// --------------------------------------------------------
+inline int& TestFailureCount()
+{
+	static int s_failures = 0;
+	return s_failures;
+}
+
+#define CHECK(a_condition) \
+	do { \
+		if (!(a_condition)) { \
+			printf("%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #a_condition); \
+			TestFailureCount()++; \
+		} \
+	} while (0)
+
+inline int TestResult()
+{
+	if (TestFailureCount() > 0)
+		printf("%d check(s) failed\n", TestFailureCount());
+	else
+		printf("All checks passed\n");
+	return TestFailureCount() > 0 ? 1 : 0;
+}
+
+// Reads a whole file into a null-terminated buffer, empty if it can't be read
+inline std::vector<char> ReadTextFile(const std::string& a_path)
+{
+	std::ifstream file(a_path, std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return std::vector<char>();
+
+	std::streamsize size = file.tellg();
+	std::vector<char> text((size_t)(size > 0 ? size : 0) + 1);
+	file.seekg(0, std::ios::beg);
+	if (size > 0 && !file.read(text.data(), size))
+		return std::vector<char>();
+	text[text.size() - 1] = '\0';
+	return text;
+}
+
+// The models every mesh test runs over, found in MODELS_DIR
+static const char* const c_testModels[] = {
+	"cube.obj", "cylinder.obj", "helix.obj", "quad.obj", "quad_double_sided.obj",
+	"sphere.obj", "torus.obj", "hylian_shield.obj", "Steve.obj" };
@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "TransformPool.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const unsigned int c_transformCount = 100000;
+	const double c_minSeconds = 0.25;
+
+	// Everything the old per-object Transform kept, for rebuilding its matrices the way it used to
+	struct ObjectTransform
+	{
+		XMFLOAT3 Position;
+		XMFLOAT3 PitchYawRoll;
+		XMFLOAT3 Scale;
+		XMFLOAT4X4 World;
+		XMFLOAT4X4 WorldInverseTranspose;
+	};
+
+	// Times a_rebuild (after a_change, which isn't timed) until enough time has
+	// passed for a steady number, and returns nanoseconds per changed transform
+	double MeasureRebuild(size_t a_changedCount, const std::function<void()>& a_change, const std::function<void()>& a_rebuild)
+	{
+		int runs = 0;
+		double seconds = 0.0;
+		while (seconds < c_minSeconds) {
+			a_change();
+			auto start = std::chrono::high_resolution_clock::now();
+			a_rebuild();
+			auto end = std::chrono::high_resolution_clock::now();
+			seconds += std::chrono::duration<double>(end - start).count();
+			runs++;
+		}
+		return seconds * 1e9 / ((double)a_changedCount * runs);
+	}
+}
+
+// --------------------------------------------------------
+// Rebuilds the world and inverse-transpose matrices of
+// 100k transforms (every fourth uniformly scaled), with
+// every one of them changed and with one in sixteen
+// changed, four ways:
+//  - Per object, as Transform did before the pool - three
+//    matrices multiplied and a general inverse, each
+//  - The pool, one at a time, as GetWorldMatrix() and
+//    GetWorldInverseTransposeMatrix() rebuild them when
+//    something asks before UpdateMatrices() has run
+//  - The pool in one batch with UpdateMatrices(), on this
+//    thread only and then on every core
+// and reports nanoseconds per changed transform. Then
+// times the inverse-transpose on its own, both ways
+// --------------------------------------------------------
+int main()
+{
+	std::mt19937 random(540);
+	std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> scale(0.2f, 5.0f);
+
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles(c_transformCount);
+	std::vector<ObjectTransform> objects(c_transformCount);
+	for (unsigned int i = 0; i < c_transformCount; i++) {
+		ObjectTransform& object = objects[i];
+		object.Position = XMFLOAT3(position(random), position(random), position(random));
+		object.PitchYawRoll = XMFLOAT3(angle(random), angle(random), angle(random));
+		object.Scale = XMFLOAT3(scale(random), scale(random), scale(random));
+		if (i % 4 == 0)
+			object.Scale.y = object.Scale.z = object.Scale.x;
+
+		handles[i] = pool.Allocate();
+		pool.SetPosition(handles[i], object.Position);
+		pool.SetRotation(handles[i], object.PitchYawRoll);
+		pool.SetScale(handles[i], object.Scale);
+	}
+	pool.UpdateMatrices();
+
+	printf("%u transforms\n", c_transformCount);
+	printf("%-24s %14s %14s\n", "Rebuild", "All changed", "1/16 changed");
+	for (int method = 0; method < 4; method++) {
+		if (method == 3)
+			JobSystem::GetInstance().Initialize();
+
+		double times[2];
+		for (int pass = 0; pass < 2; pass++) {
+			unsigned int step = (pass == 0) ? 1 : 16;
+			size_t changedCount = (c_transformCount + step - 1) / step;
+
+			// Moving a transform is all it takes to make it out of date
+			auto change = [&]() {
+				for (unsigned int i = 0; i < c_transformCount; i += step) {
+					objects[i].Position.x += 0.001f;
+					pool.SetPosition(handles[i], objects[i].Position);
+				}
+			};
+
+			switch (method) {
+			case 0:
+				times[pass] = MeasureRebuild(changedCount, change, [&]() {
+					for (unsigned int i = 0; i < c_transformCount; i += step) {
+						ObjectTransform& object = objects[i];
+						XMMATRIX world = XMMatrixScaling(object.Scale.x, object.Scale.y, object.Scale.z) *
+							XMMatrixRotationRollPitchYaw(object.PitchYawRoll.x, object.PitchYawRoll.y, object.PitchYawRoll.z) *
+							XMMatrixTranslation(object.Position.x, object.Position.y, object.Position.z);
+						XMStoreFloat4x4(&object.World, world);
+						XMStoreFloat4x4(&object.WorldInverseTranspose, XMMatrixInverse(nullptr, XMMatrixTranspose(world)));
+					}
+				});
+				break;
+			case 1:
+				times[pass] = MeasureRebuild(changedCount, change, [&]() {
+					for (unsigned int i = 0; i < c_transformCount; i += step) {
+						objects[i].World = pool.GetWorldMatrix(handles[i]);
+						objects[i].WorldInverseTranspose = pool.GetWorldInverseTransposeMatrix(handles[i]);
+					}
+				});
+				break;
+			default:
+				times[pass] = MeasureRebuild(changedCount, change, [&]() {
+					pool.UpdateMatrices();
+				});
+				break;
+			}
+		}
+
+		const char* names[] = { "Per object", "Pool, one at a time", "Pool, batched", "Pool, batched (jobs)" };
+		printf("%-24s %11.2f ns %11.2f ns\n", names[method], times[0], times[1]);
+	}
+	printf("Batches ran on %u thread(s)\n", JobSystem::GetInstance().GetThreadCount());
+
+	// --------------------------------------------------------
+	// Just the inverse-transpose's upper 3x3, one transform at
+	// a time: a general inverse of the world matrix, against
+	// the pool's shortcut of the rotation rows divided by the
+	// scale. Reports nanoseconds per transform and the worst
+	// difference between the two, relative to the matrix
+	// --------------------------------------------------------
+	std::vector<XMFLOAT4> rotations(c_transformCount);
+	std::vector<XMFLOAT3> inverseScales(c_transformCount);
+	for (unsigned int i = 0; i < c_transformCount; i++) {
+		rotations[i] = pool.GetRotationQuaternion(handles[i]);
+		XMFLOAT3 scaling = pool.GetScale(handles[i]);
+		inverseScales[i] = XMFLOAT3(1.0f / scaling.x, 1.0f / scaling.y, 1.0f / scaling.z);
+		objects[i].World = pool.GetWorldMatrix(handles[i]);
+	}
+
+	std::vector<XMFLOAT4X4> general(c_transformCount);
+	std::vector<XMFLOAT4X4> shortcut(c_transformCount);
+	double generalTime = MeasureRebuild(c_transformCount, []() {}, [&]() {
+		for (unsigned int i = 0; i < c_transformCount; i++)
+			XMStoreFloat4x4(&general[i], XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&objects[i].World))));
+	});
+	double shortcutTime = MeasureRebuild(c_transformCount, []() {}, [&]() {
+		for (unsigned int i = 0; i < c_transformCount; i++) {
+			XMMATRIX rotation = XMMatrixRotationQuaternion(XMLoadFloat4(&rotations[i]));
+			rotation.r[0] = XMVectorScale(rotation.r[0], inverseScales[i].x);
+			rotation.r[1] = XMVectorScale(rotation.r[1], inverseScales[i].y);
+			rotation.r[2] = XMVectorScale(rotation.r[2], inverseScales[i].z);
+			XMStoreFloat4x4(&shortcut[i], rotation);
+		}
+	});
+
+	float worstError = 0.0f;
+	for (unsigned int i = 0; i < c_transformCount; i++) {
+		float errorSq = 0.0f;
+		float lengthSq = 0.0f;
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++) {
+				float difference = shortcut[i].m[r][c] - general[i].m[r][c];
+				errorSq += difference * difference;
+				lengthSq += general[i].m[r][c] * general[i].m[r][c];
+			}
+		worstError = (std::max)(worstError, sqrtf(errorSq / lengthSq));
+	}
+
+	printf("\n%-24s %14s\n", "Inverse-transpose", "Per transform");
+	printf("%-24s %11.2f ns\n", "General inverse", generalTime);
+	printf("%-24s %11.2f ns\n", "R * S^-1", shortcutTime);
+	printf("R * S^-1 is %.2fx as fast, worst relative difference %.2g\n", generalTime / shortcutTime, worstError);
+
+	delete& TransformPool::GetInstance();
+	delete& JobSystem::GetInstance();
+	return 0;
+}
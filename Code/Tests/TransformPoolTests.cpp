@@ -0,0 +1,414 @@
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "TransformPool.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Enough transforms for UpdateMatrices() to split the work into jobs
+	const unsigned int c_transformCount = 1000;
+	// More hierarchy nodes than one job takes, so the spine and spans both get used
+	const unsigned int c_wideNodeCount = 6000;
+	const unsigned int c_deepChainLength = 200;
+	const float c_tolerance = 1e-4f;
+	// Error builds up down a long chain, so the hierarchy gets more room
+	const float c_hierarchyTolerance = 1e-3f;
+
+	std::mt19937 s_random(540);
+
+	float RandomFloat(float a_min, float a_max)
+	{
+		return std::uniform_real_distribution<float>(a_min, a_max)(s_random);
+	}
+
+	// Random position, rotation and scale - every fourth one scaled the same on all three axes
+	void Randomize(TransformPool& a_pool, unsigned int a_handle, float a_maxPosition, float a_minScale, float a_maxScale)
+	{
+		a_pool.SetPosition(a_handle, XMFLOAT3(RandomFloat(-a_maxPosition, a_maxPosition), RandomFloat(-a_maxPosition, a_maxPosition), RandomFloat(-a_maxPosition, a_maxPosition)));
+		a_pool.SetRotation(a_handle, XMFLOAT3(RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI)));
+		if (a_handle % 4 == 0) {
+			float scale = RandomFloat(a_minScale, a_maxScale);
+			a_pool.SetScale(a_handle, XMFLOAT3(scale, scale, scale));
+		}
+		else
+			a_pool.SetScale(a_handle, XMFLOAT3(RandomFloat(a_minScale, a_maxScale), RandomFloat(a_minScale, a_maxScale), RandomFloat(a_minScale, a_maxScale)));
+	}
+
+	void Randomize(TransformPool& a_pool, unsigned int a_handle) { Randomize(a_pool, a_handle, 50.0f, 0.2f, 5.0f); }
+
+	// Scales close to 1 and small offsets, so a long chain of them stays a sensible size
+	void RandomizeChild(TransformPool& a_pool, unsigned int a_handle) { Randomize(a_pool, a_handle, 2.0f, 0.9f, 1.1f); }
+
+	bool IsUniformScale(TransformPool& a_pool, unsigned int a_handle)
+	{
+		XMFLOAT3 scale = a_pool.GetScale(a_handle);
+		return scale.x == scale.y && scale.y == scale.z;
+	}
+
+	// The world matrix worked out the slow way - scale, rotate and translate, then on through every parent
+	XMMATRIX GetNaiveWorldMatrix(TransformPool& a_pool, unsigned int a_handle)
+	{
+		XMFLOAT3 position = a_pool.GetPosition(a_handle);
+		XMFLOAT3 rotation = a_pool.GetRotation(a_handle);
+		XMFLOAT3 scale = a_pool.GetScale(a_handle);
+		XMMATRIX local = XMMatrixMultiply(XMMatrixMultiply(
+			XMMatrixScaling(scale.x, scale.y, scale.z),
+			XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z)),
+			XMMatrixTranslation(position.x, position.y, position.z));
+
+		unsigned int parent = a_pool.GetParent(a_handle);
+		if (parent == TransformPool::c_noParent)
+			return local;
+		return XMMatrixMultiply(local, GetNaiveWorldMatrix(a_pool, parent));
+	}
+
+	// How much the pool's inverse-transpose is allowed to be scaled by - each
+	// uniformly scaled transform up the chain stands in with its own matrix
+	float GetInverseTransposeFactor(TransformPool& a_pool, unsigned int a_handle)
+	{
+		float factor = 1.0f;
+		for (unsigned int handle = a_handle; handle != TransformPool::c_noParent; handle = a_pool.GetParent(handle)) {
+			if (IsUniformScale(a_pool, handle))
+				factor /= a_pool.GetScale(handle).x * a_pool.GetScale(handle).x;
+		}
+		return factor;
+	}
+
+	void CheckWorldMatrix(TransformPool& a_pool, unsigned int a_handle)
+	{
+		XMFLOAT4X4 world = a_pool.GetWorldMatrix(a_handle);
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, GetNaiveWorldMatrix(a_pool, a_handle));
+
+		float errorSq = 0.0f;
+		float expectedLengthSq = 0.0f;
+		for (int r = 0; r < 4; r++) {
+			for (int c = 0; c < 4; c++) {
+				float difference = world.m[r][c] - expected.m[r][c];
+				errorSq += difference * difference;
+				expectedLengthSq += expected.m[r][c] * expected.m[r][c];
+			}
+		}
+		CHECK(std::sqrt(errorSq) <= c_hierarchyTolerance * std::sqrt(expectedLengthSq));
+	}
+
+	// --------------------------------------------------------
+	// Checks the upper 3x3 of the pool's inverse-transpose
+	// against the one DirectXMath works out from the world
+	// matrix. Only the upper 3x3 transforms normals, and it
+	// only has to match up to a scale factor, which has to be
+	// 1 unless something up the chain is uniformly scaled
+	// --------------------------------------------------------
+	void CheckInverseTranspose(TransformPool& a_pool, unsigned int a_handle, float a_tolerance)
+	{
+		XMFLOAT4X4 world = a_pool.GetWorldMatrix(a_handle);
+		XMFLOAT4X4 inverseTranspose = a_pool.GetWorldInverseTransposeMatrix(a_handle);
+		XMFLOAT4X4 expected;
+		XMStoreFloat4x4(&expected, XMMatrixInverse(nullptr, XMMatrixTranspose(XMLoadFloat4x4(&world))));
+
+		// The scale factor that fits best, then how far off it still is
+		float dot = 0.0f;
+		float lengthSq = 0.0f;
+		float expectedLengthSq = 0.0f;
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				dot += inverseTranspose.m[r][c] * expected.m[r][c];
+				lengthSq += inverseTranspose.m[r][c] * inverseTranspose.m[r][c];
+				expectedLengthSq += expected.m[r][c] * expected.m[r][c];
+			}
+		}
+		float factor = dot / lengthSq;
+
+		float errorSq = 0.0f;
+		for (int r = 0; r < 3; r++) {
+			for (int c = 0; c < 3; c++) {
+				float difference = inverseTranspose.m[r][c] * factor - expected.m[r][c];
+				errorSq += difference * difference;
+			}
+		}
+		CHECK(std::sqrt(errorSq) <= a_tolerance * std::sqrt(expectedLengthSq));
+		CHECK(std::fabs(factor / GetInverseTransposeFactor(a_pool, a_handle) - 1.0f) <= a_tolerance);
+	}
+
+	void CheckHierarchy(TransformPool& a_pool, const std::vector<unsigned int>& a_handles)
+	{
+		for (unsigned int handle : a_handles) {
+			CheckWorldMatrix(a_pool, handle);
+			CheckInverseTranspose(a_pool, handle, c_hierarchyTolerance);
+		}
+	}
+
+	void FreeAll(TransformPool& a_pool, const std::vector<unsigned int>& a_handles)
+	{
+		for (unsigned int handle : a_handles)
+			a_pool.Free(handle);
+	}
+}
+
+// Every matrix rebuilt in one batch, then some changed again and rebuilt on their own when asked for
+void TestInverseTranspose()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < c_transformCount; i++) {
+		handles.push_back(pool.Allocate());
+		Randomize(pool, handles.back());
+	}
+
+	pool.UpdateMatrices();
+	for (unsigned int handle : handles)
+		CheckInverseTranspose(pool, handle, c_tolerance);
+
+	for (unsigned int i = 0; i < c_transformCount; i += 7)
+		Randomize(pool, handles[i]);
+	for (unsigned int handle : handles)
+		CheckInverseTranspose(pool, handle, c_tolerance);
+
+	FreeAll(pool, handles);
+}
+
+// One long chain, each transform the child of the one before, changed from the top and from partway down
+void TestDeepHierarchy()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < c_deepChainLength; i++) {
+		handles.push_back(pool.Allocate());
+		RandomizeChild(pool, handles.back());
+		if (i > 0)
+			pool.SetParent(handles[i], handles[i - 1]);
+	}
+
+	pool.UpdateMatrices();
+	CheckHierarchy(pool, handles);
+
+	RandomizeChild(pool, handles[0]);
+	RandomizeChild(pool, handles[c_deepChainLength / 2]);
+	CheckHierarchy(pool, handles);
+
+	FreeAll(pool, handles);
+}
+
+// A few roots with thousands of children and grandchildren between them, changed here and there
+void TestWideHierarchy()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < c_wideNodeCount; i++) {
+		handles.push_back(pool.Allocate());
+		RandomizeChild(pool, handles.back());
+		if (i >= 4)
+			pool.SetParent(handles[i], handles[std::uniform_int_distribution<unsigned int>(0, i / 2)(s_random)]);
+	}
+
+	pool.UpdateMatrices();
+	CheckHierarchy(pool, handles);
+
+	for (unsigned int i = 0; i < c_wideNodeCount; i += 97)
+		RandomizeChild(pool, handles[i]);
+	pool.UpdateMatrices();
+	CheckHierarchy(pool, handles);
+
+	FreeAll(pool, handles);
+}
+
+// Subtrees moved to other parents, onto their own and back, with nothing rebuilt in between
+void TestReparent()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < 64; i++) {
+		handles.push_back(pool.Allocate());
+		RandomizeChild(pool, handles.back());
+		if (i >= 2)
+			pool.SetParent(handles[i], handles[(i - 2) / 2]);
+	}
+
+	pool.UpdateMatrices();
+	CheckHierarchy(pool, handles);
+
+	pool.SetParent(handles[2], handles[1]);
+	pool.SetParent(handles[9], TransformPool::c_noParent);
+	pool.SetParent(handles[1], handles[40]);
+	RandomizeChild(pool, handles[0]);
+	CheckHierarchy(pool, handles);
+
+	// A transform can't become its own descendant's child
+	pool.SetParent(handles[0], handles[63]);
+	CHECK(pool.GetParent(handles[0]) == TransformPool::c_noParent);
+
+	pool.SetParent(handles[1], TransformPool::c_noParent);
+	pool.SetParent(handles[9], handles[62]);
+	CheckHierarchy(pool, handles);
+
+	FreeAll(pool, handles);
+}
+
+// Freeing a transform leaves its children on their own, and its slot comes back as the identity
+void TestFree()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < 16; i++) {
+		handles.push_back(pool.Allocate());
+		RandomizeChild(pool, handles.back());
+		if (i > 0)
+			pool.SetParent(handles[i], handles[(i - 1) / 3]);
+	}
+
+	pool.UpdateMatrices();
+	CheckHierarchy(pool, handles);
+
+	unsigned int freed = handles[1];
+	pool.Free(freed);
+	handles.erase(handles.begin() + 1);
+	for (unsigned int handle : handles)
+		CHECK(pool.GetParent(handle) != freed);
+	CheckHierarchy(pool, handles);
+
+	unsigned int reused = pool.Allocate();
+	CHECK(reused == freed);
+	CHECK(pool.GetParent(reused) == TransformPool::c_noParent);
+	XMFLOAT4X4 world = pool.GetWorldMatrix(reused);
+	for (int r = 0; r < 4; r++)
+		for (int c = 0; c < 4; c++)
+			CHECK(world.m[r][c] == (r == c ? 1.0f : 0.0f));
+
+	pool.SetParent(reused, handles[0]);
+	RandomizeChild(pool, reused);
+	handles.push_back(reused);
+	CheckHierarchy(pool, handles);
+
+	FreeAll(pool, handles);
+}
+
+// Once everything's up to date, jobs can read any slot without rebuilding it
+void TestReadFromJobs()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	std::vector<unsigned int> handles;
+	for (unsigned int i = 0; i < c_wideNodeCount; i++) {
+		handles.push_back(pool.Allocate());
+		RandomizeChild(pool, handles.back());
+		if (i % 3 != 0)
+			pool.SetParent(handles[i], handles[i - 1]);
+	}
+	pool.UpdateMatrices();
+
+	std::vector<XMFLOAT4X4> read(handles.size());
+	JobSystem::GetInstance().ParallelFor(handles.size(), 64, [&pool, &handles, &read](unsigned int, size_t a_begin, size_t a_end) {
+		for (size_t i = a_begin; i < a_end; i++)
+			read[i] = pool.ReadWorldMatrix(handles[i]);
+	});
+
+	for (size_t i = 0; i < handles.size(); i++) {
+		XMFLOAT4X4 world = pool.GetWorldMatrix(handles[i]);
+		bool isSame = true;
+		for (int r = 0; r < 4; r++)
+			for (int c = 0; c < 4; c++)
+				isSame = isSame && read[i].m[r][c] == world.m[r][c];
+		CHECK(isSame);
+	}
+
+	FreeAll(pool, handles);
+}
+
+// --------------------------------------------------------
+// Angles that were set come straight back, bit for bit,
+// and the quaternion made from them is the one DirectXMath
+// makes. Angles only worked out of a quaternion that was
+// set directly (including straight up and straight down,
+// where roll folds into yaw) describe the same rotation,
+// and setting angles again puts the set ones back in charge
+// --------------------------------------------------------
+void TestRotationRoundTrip()
+{
+	TransformPool& pool = TransformPool::GetInstance();
+	unsigned int handle = pool.Allocate();
+
+	// The same rotation either way, whichever sign the quaternion has
+	auto isSameRotation = [](const XMFLOAT4& a_first, const XMFLOAT4& a_second) {
+		float dot = a_first.x * a_second.x + a_first.y * a_second.y + a_first.z * a_second.z + a_first.w * a_second.w;
+		return std::fabs(std::fabs(dot) - 1.0f) <= c_tolerance;
+	};
+	auto toQuaternion = [](const XMFLOAT3& a_pitchYawRoll) {
+		XMFLOAT4 quaternion;
+		XMStoreFloat4(&quaternion, XMQuaternionRotationRollPitchYaw(a_pitchYawRoll.x, a_pitchYawRoll.y, a_pitchYawRoll.z));
+		return quaternion;
+	};
+
+	// Pitch stays clear of the poles, where GetRotation() snaps to looking straight up or down
+	for (int i = 0; i < 1000; i++) {
+		XMFLOAT3 angles(RandomFloat(-XM_PIDIV2 + 0.05f, XM_PIDIV2 - 0.05f), RandomFloat(-XM_PI, XM_PI), RandomFloat(-XM_PI, XM_PI));
+		XMFLOAT4 expected = toQuaternion(angles);
+
+		pool.SetRotation(handle, angles);
+		XMFLOAT3 cached = pool.GetRotation(handle);
+		XMFLOAT4 quaternion = pool.GetRotationQuaternion(handle);
+		CHECK(cached.x == angles.x && cached.y == angles.y && cached.z == angles.z);
+		CHECK(std::fabs(quaternion.x - expected.x) <= 1e-6f && std::fabs(quaternion.y - expected.y) <= 1e-6f &&
+			std::fabs(quaternion.z - expected.z) <= 1e-6f && std::fabs(quaternion.w - expected.w) <= 1e-6f);
+
+		// Set directly (and not normalized), the angles have to be worked back out
+		pool.SetRotationQuaternion(handle, XMFLOAT4(expected.x * 3.0f, expected.y * 3.0f, expected.z * 3.0f, expected.w * 3.0f));
+		CHECK(isSameRotation(pool.GetRotationQuaternion(handle), expected));
+		XMFLOAT3 worked = pool.GetRotation(handle);
+		CHECK(std::fabs(worked.x - angles.x) <= c_tolerance * 10.0f);
+		CHECK(std::fabs(worked.y - angles.y) <= c_tolerance * 10.0f);
+		CHECK(std::fabs(worked.z - angles.z) <= c_tolerance * 10.0f);
+
+		// Asking again gives the same answer, now from the cache
+		XMFLOAT3 again = pool.GetRotation(handle);
+		CHECK(again.x == worked.x && again.y == worked.y && again.z == worked.z);
+	}
+
+	// Straight up and straight down - roll can't be told from yaw, so it comes back as 0
+	for (float pitch : { XM_PIDIV2, -XM_PIDIV2 }) {
+		XMFLOAT4 expected = toQuaternion(XMFLOAT3(pitch, 0.7f, -1.2f));
+		pool.SetRotationQuaternion(handle, expected);
+		XMFLOAT3 worked = pool.GetRotation(handle);
+		CHECK(std::fabs(worked.x - pitch) <= c_tolerance);
+		CHECK(worked.z == 0.0f);
+		CHECK(isSameRotation(toQuaternion(worked), expected));
+	}
+
+	// Working the angles out doesn't touch the rotation itself
+	XMFLOAT4 quaternion = toQuaternion(XMFLOAT3(0.3f, -2.0f, 1.0f));
+	pool.SetRotationQuaternion(handle, quaternion);
+	XMFLOAT4X4 before = pool.GetWorldMatrix(handle);
+	pool.GetRotation(handle);
+	XMFLOAT4X4 after = pool.GetWorldMatrix(handle);
+	CHECK(memcmp(&before, &after, sizeof(XMFLOAT4X4)) == 0);
+
+	// Angles set after a quaternion replace the ones worked out of it
+	XMFLOAT3 angles(0.25f, 0.5f, -0.75f);
+	pool.SetRotationQuaternion(handle, toQuaternion(XMFLOAT3(1.0f, 1.0f, 1.0f)));
+	pool.SetRotation(handle, angles);
+	XMFLOAT3 cached = pool.GetRotation(handle);
+	CHECK(cached.x == angles.x && cached.y == angles.y && cached.z == angles.z);
+
+	pool.Free(handle);
+}
+
+int main()
+{
+	JobSystem::GetInstance().Initialize();
+
+	TestInverseTranspose();
+	TestDeepHierarchy();
+	TestWideHierarchy();
+	TestReparent();
+	TestFree();
+	TestReadFromJobs();
+	TestRotationRoundTrip();
+
+	delete& TransformPool::GetInstance();
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
@@ -0,0 +1,212 @@
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#include "ObjLoader.h"
+#include "MeshTangents.h"
+#include "VertexFormat.h"
+#include "JobSystem.h"
+#include "TestHelpers.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Worst angle a packed direction may be off by - half a step of its
+	// storage, stretched by the octahedron's worst distortion
+	const float c_maxError16 = 0.005f;
+	const float c_maxError8 = 1.0f;
+
+	// Angle between two unit vectors, in degrees - from the distance between
+	// them rather than their dot product, which can't resolve tiny angles
+	float AngleBetween(const XMFLOAT3& a_first, const XMFLOAT3& a_second)
+	{
+		float x = a_first.x - a_second.x;
+		float y = a_first.y - a_second.y;
+		float z = a_first.z - a_second.z;
+		float halfChord = sqrtf(x * x + y * y + z * z) * 0.5f;
+		return 2.0f * asinf(halfChord > 1.0f ? 1.0f : halfChord) * 180.0f / XM_PI;
+	}
+
+	XMFLOAT3 Normalize(XMFLOAT3 a_direction)
+	{
+		XMStoreFloat3(&a_direction, XMVector3Normalize(XMLoadFloat3(&a_direction)));
+		return a_direction;
+	}
+
+	// Evenly spread directions over the whole sphere, plus the ones on the folds
+	// and corners of the octahedron, where the encoding is most likely to slip
+	std::vector<XMFLOAT3> GetTestDirections()
+	{
+		std::vector<XMFLOAT3> directions;
+		const int c_count = 4096;
+		for (int i = 0; i < c_count; i++) {
+			float y = 1.0f - 2.0f * (i + 0.5f) / c_count;
+			float radius = sqrtf(1.0f - y * y);
+			float angle = i * 2.399963f;	// The golden angle
+			directions.push_back(XMFLOAT3(cosf(angle) * radius, y, sinf(angle) * radius));
+		}
+
+		for (float x = -1.0f; x <= 1.0f; x += 1.0f)
+			for (float y = -1.0f; y <= 1.0f; y += 1.0f)
+				for (float z = -1.0f; z <= 1.0f; z += 1.0f)
+					if (x != 0.0f || y != 0.0f || z != 0.0f)
+						directions.push_back(Normalize(XMFLOAT3(x, y, z)));
+		return directions;
+	}
+
+	bool LoadModel(const char* a_model, MeshData& a_meshData)
+	{
+		std::vector<char> text = ReadTextFile(std::string(MODELS_DIR) + a_model);
+		if (text.empty())
+			return false;
+		ParseOBJ(text.data(), a_meshData);
+		CalculateTangents(a_meshData.Vertices.data(), a_meshData.Vertices.size(), a_meshData.Indices.data(), a_meshData.Indices.size());
+		return !a_meshData.Indices.empty();
+	}
+
+	void GetBounds(const MeshData& a_meshData, XMFLOAT3& a_min, XMFLOAT3& a_max)
+	{
+		a_min = a_max = a_meshData.Vertices[0].Position;
+		for (const Vertex& vertex : a_meshData.Vertices) {
+			a_min = XMFLOAT3(fminf(a_min.x, vertex.Position.x), fminf(a_min.y, vertex.Position.y), fminf(a_min.z, vertex.Position.z));
+			a_max = XMFLOAT3(fmaxf(a_max.x, vertex.Position.x), fmaxf(a_max.y, vertex.Position.y), fmaxf(a_max.z, vertex.Position.z));
+		}
+	}
+
+	// Packs a model and unpacks it again, checking every attribute
+	// comes back within what its storage can hold
+	void CheckRoundTrip(const char* a_model, VertexFormat a_format, float a_maxDirectionError)
+	{
+		MeshData meshData;
+		CHECK(LoadModel(a_model, meshData));
+		XMFLOAT3 boundsMin;
+		XMFLOAT3 boundsMax;
+		GetBounds(meshData, boundsMin, boundsMax);
+
+		std::vector<unsigned char> packed;
+		EncodeVertices(a_format, meshData.Vertices.data(), meshData.Vertices.size(), boundsMin, boundsMax, packed);
+		CHECK(packed.size() == GetVertexStride(a_format) * meshData.Vertices.size());
+
+		std::vector<Vertex> unpacked(meshData.Vertices.size());
+		DecodeVertices(a_format, packed.data(), unpacked.size(), boundsMin, boundsMax, unpacked.data());
+
+		// Half a 16-bit step of the bounds on each axis, with a little room for rounding
+		XMFLOAT3 positionError(
+			(boundsMax.x - boundsMin.x) / 65535.0f * 0.5f + 1e-5f,
+			(boundsMax.y - boundsMin.y) / 65535.0f * 0.5f + 1e-5f,
+			(boundsMax.z - boundsMin.z) / 65535.0f * 0.5f + 1e-5f);
+
+		float worstNormal = 0.0f;
+		float worstTangent = 0.0f;
+		for (size_t i = 0; i < unpacked.size(); i++) {
+			const Vertex& original = meshData.Vertices[i];
+			const Vertex& vertex = unpacked[i];
+
+			CHECK(fabsf(vertex.Position.x - original.Position.x) <= positionError.x);
+			CHECK(fabsf(vertex.Position.y - original.Position.y) <= positionError.y);
+			CHECK(fabsf(vertex.Position.z - original.Position.z) <= positionError.z);
+
+			// Halves keep 11 significant bits
+			CHECK(fabsf(vertex.UV.x - original.UV.x) <= fabsf(original.UV.x) / 2048.0f + 1e-7f);
+			CHECK(fabsf(vertex.UV.y - original.UV.y) <= fabsf(original.UV.y) / 2048.0f + 1e-7f);
+
+			worstNormal = fmaxf(worstNormal, AngleBetween(vertex.Normal, Normalize(original.Normal)));
+			worstTangent = fmaxf(worstTangent, AngleBetween(XMFLOAT3(vertex.Tangent.x, vertex.Tangent.y, vertex.Tangent.z), XMFLOAT3(original.Tangent.x, original.Tangent.y, original.Tangent.z)));
+			CHECK(vertex.Tangent.w == original.Tangent.w);
+		}
+
+		printf("%-24s %-18s worst normal %.4f, tangent %.4f degrees\n", a_model, GetVertexFormatName(a_format), worstNormal, worstTangent);
+		CHECK(worstNormal <= a_maxDirectionError);
+		CHECK(worstTangent <= a_maxDirectionError);
+	}
+}
+
+// Unquantized, octahedral encoding loses nothing but float rounding and stays
+// in [-1, 1] - and stored in 16 or 8 bits it's off by no more than a step
+void TestOctahedralRoundTrip()
+{
+	float worst = 0.0f;
+	float worst16 = 0.0f;
+	float worst8 = 0.0f;
+	for (const XMFLOAT3& direction : GetTestDirections()) {
+		XMFLOAT2 encoded = EncodeOctahedral(direction);
+		CHECK(fabsf(encoded.x) <= 1.0f && fabsf(encoded.y) <= 1.0f);
+		worst = fmaxf(worst, AngleBetween(DecodeOctahedral(encoded), direction));
+
+		XMSHORTN2 shorts;
+		XMBYTEN2 bytes;
+		XMFLOAT2 stored;
+		XMStoreShortN2(&shorts, XMLoadFloat2(&encoded));
+		XMStoreFloat2(&stored, XMLoadShortN2(&shorts));
+		worst16 = fmaxf(worst16, AngleBetween(DecodeOctahedral(stored), direction));
+		XMStoreByteN2(&bytes, XMLoadFloat2(&encoded));
+		XMStoreFloat2(&stored, XMLoadByteN2(&bytes));
+		worst8 = fmaxf(worst8, AngleBetween(DecodeOctahedral(stored), direction));
+	}
+	printf("Octahedral: worst error %.4f, in 16 bits %.4f, in 8 bits %.4f degrees\n", worst, worst16, worst8);
+	CHECK(worst < 0.001f);
+	CHECK(worst16 <= c_maxError16);
+	CHECK(worst8 <= c_maxError8);
+
+	// Nothing in, nothing sensible out - but nothing undefined either
+	XMFLOAT2 zero = EncodeOctahedral(XMFLOAT3(0, 0, 0));
+	CHECK(zero.x == 0.0f && zero.y == 0.0f);
+}
+
+// Both compact formats hold every attribute to within their precision
+void TestCompactRoundTrip()
+{
+	for (const char* model : c_testModels) {
+		CheckRoundTrip(model, VertexFormat::Compact16, c_maxError16);
+		CheckRoundTrip(model, VertexFormat::Compact8, c_maxError8);
+	}
+}
+
+// The full format is a straight copy
+void TestFullRoundTrip()
+{
+	MeshData meshData;
+	CHECK(LoadModel("torus.obj", meshData));
+	std::vector<unsigned char> packed;
+	EncodeVertices(VertexFormat::Full, meshData.Vertices.data(), meshData.Vertices.size(), XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), packed);
+	CHECK(packed.size() == sizeof(Vertex) * meshData.Vertices.size());
+	CHECK(memcmp(packed.data(), meshData.Vertices.data(), packed.size()) == 0);
+}
+
+// The blocky player is packed to 8 bits because its normals are all
+// axis aligned, which 8-bit octahedral encoding gets back exactly
+void TestAxisAlignedNormalsAreExact()
+{
+	MeshData meshData;
+	CHECK(LoadModel("Steve.obj", meshData));
+	XMFLOAT3 boundsMin;
+	XMFLOAT3 boundsMax;
+	GetBounds(meshData, boundsMin, boundsMax);
+
+	std::vector<unsigned char> packed;
+	EncodeVertices(VertexFormat::Compact8, meshData.Vertices.data(), meshData.Vertices.size(), boundsMin, boundsMax, packed);
+	std::vector<Vertex> unpacked(meshData.Vertices.size());
+	DecodeVertices(VertexFormat::Compact8, packed.data(), unpacked.size(), boundsMin, boundsMax, unpacked.data());
+
+	for (size_t i = 0; i < unpacked.size(); i++) {
+		const XMFLOAT3& original = meshData.Vertices[i].Normal;
+		const XMFLOAT3& normal = unpacked[i].Normal;
+		CHECK(normal.x == original.x && normal.y == original.y && normal.z == original.z);
+	}
+}
+
+int main()
+{
+	// Tangents for big models go to the job system
+	JobSystem::GetInstance().Initialize();
+
+	TestOctahedralRoundTrip();
+	TestCompactRoundTrip();
+	TestFullRoundTrip();
+	TestAxisAlignedNormalsAreExact();
+
+	delete& JobSystem::GetInstance();
+	return TestResult();
+}
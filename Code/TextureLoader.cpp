@@ -0,0 +1,139 @@
+#include <wincodec.h>
+#include <wrl/client.h>
+
+#include "TextureLoader.h"
+
+// WIC's class IDs and the codecs behind them
+#pragma comment(lib, "windowscodecs.lib")
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	// Whether the image's metadata marks it as sRGB - the same checks
+	// DirectXTK's WIC loader makes, so colors come out as they always have
+	bool IsFrameSRGB(IWICBitmapFrameDecode* a_pFrame)
+	{
+		ComPtr<IWICMetadataQueryReader> reader;
+		GUID containerFormat;
+		if (FAILED(a_pFrame->GetMetadataQueryReader(reader.GetAddressOf())) || FAILED(reader->GetContainerFormat(&containerFormat)))
+			return false;
+
+		bool isSRGB = false;
+		PROPVARIANT value;
+		PropVariantInit(&value);
+		if (containerFormat == GUID_ContainerFormatPng) {
+			// Either an sRGB chunk, or a gamma chunk with sRGB's 1/2.2
+			if (SUCCEEDED(reader->GetMetadataByName(L"/sRGB/RenderingIntent", &value)) && value.vt == VT_UI1) {
+				isSRGB = true;
+			}
+			else {
+				PropVariantClear(&value);
+				if (SUCCEEDED(reader->GetMetadataByName(L"/gAMA/ImageGamma", &value)) && value.vt == VT_UI4)
+					isSRGB = (value.uintVal == 45455);
+			}
+		}
+		else if (SUCCEEDED(reader->GetMetadataByName(L"System.Image.ColorSpace", &value)) && value.vt == VT_UI2) {
+			isSRGB = (value.uiVal == 1);
+		}
+		PropVariantClear(&value);
+		return isSRGB;
+	}
+
+	bool DecodeWithWIC(const unsigned char* a_data, size_t a_size, DecodedTexture& a_texture)
+	{
+		ComPtr<IWICImagingFactory> factory;
+		if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(factory.GetAddressOf()))))
+			return false;
+
+		ComPtr<IWICStream> stream;
+		ComPtr<IWICBitmapDecoder> decoder;
+		ComPtr<IWICBitmapFrameDecode> frame;
+		if (FAILED(factory->CreateStream(stream.GetAddressOf())) ||
+			FAILED(stream->InitializeFromMemory(const_cast<BYTE*>(a_data), (DWORD)a_size)) ||
+			FAILED(factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand, decoder.GetAddressOf())) ||
+			FAILED(decoder->GetFrame(0, frame.GetAddressOf())))
+			return false;
+
+		UINT width = 0;
+		UINT height = 0;
+		if (FAILED(frame->GetSize(&width, &height)) || width == 0 || height == 0 ||
+			width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION || height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+			return false;
+
+		// Whatever the file holds (palettes, 24-bit, grayscale...) comes out
+		// as RGBA, so the context thread only ever has one format to deal with
+		ComPtr<IWICFormatConverter> converter;
+		if (FAILED(factory->CreateFormatConverter(converter.GetAddressOf())) ||
+			FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeMedianCut)))
+			return false;
+
+		a_texture.Width = width;
+		a_texture.Height = height;
+		a_texture.IsSRGB = IsFrameSRGB(frame.Get());
+		a_texture.Pixels.resize((size_t)width * height * 4);
+		return SUCCEEDED(converter->CopyPixels(nullptr, width * 4, (UINT)a_texture.Pixels.size(), a_texture.Pixels.data()));
+	}
+}
+
+// --------------------------------------------------------
+// Decodes an image into RGBA pixels with WIC.
+//
+// Job threads never set up COM themselves, so each decode
+// joins the multithreaded apartment for as long as it's
+// using WIC. A thread that's already in an apartment keeps
+// it, which is fine since WIC's objects work in either
+// --------------------------------------------------------
+bool DecodeTexture(const unsigned char* a_data, size_t a_size, DecodedTexture& a_texture)
+{
+	a_texture = DecodedTexture();
+	if (a_data == nullptr || a_size == 0 || a_size > 0xFFFFFFFF)
+		return false;
+
+	HRESULT comResult = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	bool isDecoded = DecodeWithWIC(a_data, a_size, a_texture);
+	if (SUCCEEDED(comResult))
+		CoUninitialize();
+
+	if (!isDecoded)
+		a_texture = DecodedTexture();
+	return isDecoded;
+}
+
+// --------------------------------------------------------
+// Uploads the full size image, then has the GPU filter it
+// down into the rest of the mip chain
+// --------------------------------------------------------
+bool CreateTexture(ID3D11Device* a_pDevice, ID3D11DeviceContext* a_pContext, const DecodedTexture& a_texture, ID3D11ShaderResourceView** a_ppSRV)
+{
+	if (a_texture.Pixels.empty())
+		return false;
+
+	DXGI_FORMAT format = a_texture.IsSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+
+	D3D11_TEXTURE2D_DESC textureDescription = {};
+	textureDescription.Width = a_texture.Width;
+	textureDescription.Height = a_texture.Height;
+	textureDescription.MipLevels = 0;	// As many as it takes to get down to 1x1
+	textureDescription.ArraySize = 1;
+	textureDescription.Format = format;
+	textureDescription.SampleDesc.Count = 1;
+	textureDescription.Usage = D3D11_USAGE_DEFAULT;
+	textureDescription.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;	// Generating mips renders into them
+	textureDescription.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	ComPtr<ID3D11Texture2D> texture;
+	if (FAILED(a_pDevice->CreateTexture2D(&textureDescription, nullptr, texture.GetAddressOf())))
+		return false;
+	a_pContext->UpdateSubresource(texture.Get(), 0, nullptr, a_texture.Pixels.data(), a_texture.Width * 4, 0);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDescription = {};
+	srvDescription.Format = format;
+	srvDescription.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDescription.Texture2D.MipLevels = (UINT)-1;
+	if (FAILED(a_pDevice->CreateShaderResourceView(texture.Get(), &srvDescription, a_ppSRV)))
+		return false;
+
+	a_pContext->GenerateMips(*a_ppSRV);
+	return true;
+}
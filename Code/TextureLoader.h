@@ -0,0 +1,28 @@
+#pragma once
+
+#include <d3d11.h>
+#include <vector>
+
+// --------------------------------------------------------
+// An image decoded into plain 8-bit RGBA pixels, waiting to
+// be turned into a texture
+//
+// Decoding is by far the slowest part of loading a texture
+// and doesn't need Direct3D, so it's split from creating
+// the texture so the two can run on different threads
+// --------------------------------------------------------
+struct DecodedTexture
+{
+	unsigned int Width = 0;
+	unsigned int Height = 0;
+	bool IsSRGB = false;				// The file says its colors are sRGB encoded
+	std::vector<unsigned char> Pixels;	// Width * Height * 4 bytes, rows top to bottom
+};
+
+// Decodes an image file held in memory (anything WIC can read) into RGBA pixels.
+// Nothing here touches Direct3D, so it's safe to call from any thread
+bool DecodeTexture(const unsigned char* a_data, size_t a_size, DecodedTexture& a_texture);
+
+// Creates a texture with a full mip chain from decoded pixels. Generating the
+// mips needs the context, so this has to run on the thread that owns it
+bool CreateTexture(ID3D11Device* a_pDevice, ID3D11DeviceContext* a_pContext, const DecodedTexture& a_texture, ID3D11ShaderResourceView** a_ppSRV);
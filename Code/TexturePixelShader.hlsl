@@ -2,18 +2,22 @@
 
 #define NUM_LIGHTS 5
 
-cbuffer ExternalData : register(b0)
+cbuffer PerFrame : register(b0)
 {
     float gamma;
-    float roughness;
-    float3 colorTint;
     float3 ambientColor;
     float3 cameraPosition;
+
+    Light lights[NUM_LIGHTS]; // Array of exactly NUM_LIGHTS lights
+}
+
+cbuffer PerMaterial : register(b1)
+{
+    float roughness;
+    float3 colorTint;
     float2 uvScale;
     float2 uvOffset;
     int useSpecularMap;
-
-    Light lights[NUM_LIGHTS]; // Array of exactly NUM_LIGHTS lights
 }
 
 Texture2D DiffuseTexture : register(t0); // "t" registers for textures
@@ -25,7 +29,6 @@ float4 main(VertexToPixel input) : SV_TARGET
 {
     // Must renormalize any interpolated vectors
     input.normal = normalize(input.normal);
-    input.tangent = normalize(input.tangent);
     input.uv = input.uv * uvScale + uvOffset;
     
     float specularScale = 1.0f;
@@ -38,9 +41,8 @@ float4 main(VertexToPixel input) : SV_TARGET
     float3 unpackedNormal = normalize(NormalMap.Sample(BasicSampler, input.uv).rgb * 2.0f - 1.0f);
 	// rotate the normal map to convert from tangent to world space
     float3 N = input.normal;
-    float3 T = input.tangent;
-    T = normalize(T - N * dot(input.tangent, N)); // ensure we ortho-normalize the tangent again
-    float3 B = cross(T, N);
+    float3 T = normalize(input.tangent.xyz);
+    float3 B = cross(T, N) * input.tangent.w; // flipped where the uvs are mirrored
     float3x3 TBN = float3x3(T, B, N);
     // multiply normal map vector by TBN
     input.normal = mul(unpackedNormal, TBN);
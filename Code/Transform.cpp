@@ -3,200 +3,159 @@
 using namespace DirectX;
 
 Transform::Transform() :
-	m_position(0, 0, 0),
-	m_rotation(0, 0, 0),
-	m_scale(1, 1, 1),
-	m_isMatricesChanged(false),
-	m_isVectorsChanged(false)
+	m_pPool(&TransformPool::GetInstance())
 {
-	XMStoreFloat4x4(&m_worldMatrix, XMMatrixIdentity());
-	XMStoreFloat4x4(&m_worldInverseTransposeMatrix, XMMatrixIdentity());
-
-	XMStoreFloat3(&m_right, XMVectorSet(1, 0, 0, 0));
-	XMStoreFloat3(&m_up, XMVectorSet(0, 1, 0, 0));
-	XMStoreFloat3(&m_forward, XMVectorSet(0, 0, 1, 0));
+	m_handle = m_pPool->Allocate();
 }
 
-// ================ GETTERS ================
-DirectX::XMFLOAT3 Transform::GetPosition() { return m_position; }
-DirectX::XMFLOAT3 Transform::GetRotation() { return m_rotation; }
-DirectX::XMFLOAT3 Transform::GetScale() { return m_scale; }
-
-DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
+Transform::Transform(const Transform& a_other) :
+	m_pPool(a_other.m_pPool)
 {
-	UpdateMatrices();
-	return m_worldMatrix;
+	m_handle = m_pPool->Allocate();
+	*this = a_other;
 }
 
-DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
+Transform& Transform::operator=(const Transform& a_other)
 {
-	UpdateMatrices();
-	return m_worldInverseTransposeMatrix;
+	if (this != &a_other) {
+		m_pPool->SetPosition(m_handle, m_pPool->GetPosition(a_other.m_handle));
+		m_pPool->SetRotation(m_handle, m_pPool->GetRotation(a_other.m_handle));
+		m_pPool->SetScale(m_handle, m_pPool->GetScale(a_other.m_handle));
+		m_pPool->SetParent(m_handle, m_pPool->GetParent(a_other.m_handle));
+	}
+	return *this;
 }
 
-DirectX::XMFLOAT3 Transform::GetRight()
+Transform::~Transform()
 {
-	UpdateVectors();
-	return m_right;
+	m_pPool->Free(m_handle);
 }
 
-DirectX::XMFLOAT3 Transform::GetUp()
-{
-	UpdateVectors();
-	return m_up;
-}
+// ================ GETTERS ================
+DirectX::XMFLOAT3 Transform::GetPosition() { return m_pPool->GetPosition(m_handle); }
+DirectX::XMFLOAT3 Transform::GetRotation() { return m_pPool->GetRotation(m_handle); }
+DirectX::XMFLOAT3 Transform::GetScale() { return m_pPool->GetScale(m_handle); }
+DirectX::XMFLOAT4X4 Transform::GetWorldMatrix() { return m_pPool->GetWorldMatrix(m_handle); }
+DirectX::XMFLOAT4X4 Transform::ReadWorldMatrix() const { return m_pPool->ReadWorldMatrix(m_handle); }
+DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix() { return m_pPool->GetWorldInverseTransposeMatrix(m_handle); }
+unsigned int Transform::GetHandle() { return m_handle; }
 
-DirectX::XMFLOAT3 Transform::GetForward()
-{
-	UpdateVectors();
-	return m_forward;
-}
+DirectX::XMFLOAT4 Transform::GetRotationQuaternion() { return m_pPool->GetRotationQuaternion(m_handle); }
+DirectX::XMFLOAT3 Transform::GetRight() { return m_pPool->GetRight(m_handle); }
+DirectX::XMFLOAT3 Transform::GetUp() { return m_pPool->GetUp(m_handle); }
+DirectX::XMFLOAT3 Transform::GetForward() { return m_pPool->GetForward(m_handle); }
 
 
 // ================ SETTERS ================
 void Transform::SetPosition(float a_x, float a_y, float a_z)
 {
-	m_position.x = a_x;
-	m_position.y = a_y;
-	m_position.z = a_z;
-	m_isMatricesChanged = true;
+	m_pPool->SetPosition(m_handle, XMFLOAT3(a_x, a_y, a_z));
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 newPosition) {
-	m_position = newPosition;
-	m_isMatricesChanged = true;
+	m_pPool->SetPosition(m_handle, newPosition);
 }
 
 void Transform::SetRotation(float a_pitch, float a_yaw, float a_roll)
 {
-	m_rotation.x = a_pitch;
-	m_rotation.y = a_yaw;
-	m_rotation.z = a_roll;
-	m_isMatricesChanged = m_isVectorsChanged = true;
+	m_pPool->SetRotation(m_handle, XMFLOAT3(a_pitch, a_yaw, a_roll));
 }
 void Transform::SetRotation(DirectX::XMFLOAT3 a_pitchYawRoll) {
-	m_rotation = a_pitchYawRoll;
-	m_isMatricesChanged = m_isVectorsChanged = true;
+	m_pPool->SetRotation(m_handle, a_pitchYawRoll);
+}
+
+void Transform::SetRotation(DirectX::XMFLOAT4 a_quaternion) {
+	m_pPool->SetRotationQuaternion(m_handle, a_quaternion);
 }
 
 void Transform::SetScale(float a_x, float a_y, float a_z)
 {
-	m_scale.x = a_x;
-	m_scale.y = a_y;
-	m_scale.z = a_z;
-	m_isMatricesChanged = true;
+	m_pPool->SetScale(m_handle, XMFLOAT3(a_x, a_y, a_z));
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 a_scale) {
-	m_scale = a_scale;
-	m_isMatricesChanged = true;
+	m_pPool->SetScale(m_handle, a_scale);
+}
+
+void Transform::SetParent(Transform* a_pParent) {
+	m_pPool->SetParent(m_handle, a_pParent ? a_pParent->m_handle : TransformPool::c_noParent);
 }
 
 
 // ================ TRANSFORMERS ================
 void Transform::MoveAbsolute(float a_x, float a_y, float a_z)
 {
-	m_position.x += a_x;
-	m_position.y += a_y;
-	m_position.z += a_z;
-	m_isMatricesChanged = true;
+	MoveAbsolute(XMFLOAT3(a_x, a_y, a_z));
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 a_offset)
 {
-	m_position.x += a_offset.x;
-	m_position.y += a_offset.y;
-	m_position.z += a_offset.z;
-	m_isMatricesChanged = true;
+	XMFLOAT3 position = GetPosition();
+	position.x += a_offset.x;
+	position.y += a_offset.y;
+	position.z += a_offset.z;
+	SetPosition(position);
 }
 
 void Transform::MoveRelative(float a_x, float a_y, float a_z)
 {
-	XMVECTOR moveBy = XMVectorSet(a_x, a_y, a_z, 0);
-	XMVECTOR currentRotation = XMLoadFloat3(&m_rotation);
-	XMVECTOR currentPosition = XMLoadFloat3(&m_position);
-
-	XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(currentRotation);
-	XMVECTOR relativeOffset = XMVector3Rotate(moveBy, rotQuat);
-
-	currentPosition += relativeOffset;
-
-	XMStoreFloat3(&m_position, currentPosition);
-	m_isMatricesChanged = true;
+	MoveRelative(XMFLOAT3(a_x, a_y, a_z));
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 a_offset)
 {
+	XMFLOAT4 rotation = GetRotationQuaternion();
+	XMFLOAT3 position = GetPosition();
 	XMVECTOR moveBy = XMLoadFloat3(&a_offset);
-	XMVECTOR currentRotation = XMLoadFloat3(&m_rotation);
-	XMVECTOR currentPosition = XMLoadFloat3(&m_position);
+	XMVECTOR rotQuat = XMLoadFloat4(&rotation);
+	XMVECTOR currentPosition = XMLoadFloat3(&position);
 
-	XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(currentRotation);
 	XMVECTOR relativeOffset = XMVector3Rotate(moveBy, rotQuat);
 
 	currentPosition += relativeOffset;
 
-	XMStoreFloat3(&m_position, currentPosition);
-	m_isMatricesChanged = true;
+	XMStoreFloat3(&position, currentPosition);
+	SetPosition(position);
 }
 
 void Transform::Rotate(float a_p, float a_y, float a_r)
 {
-	m_rotation.x += a_p;
-	m_rotation.y += a_y;
-	m_rotation.z += a_r;
-	m_isMatricesChanged = m_isVectorsChanged = true;
+	Rotate(XMFLOAT3(a_p, a_y, a_r));
 }
 
 void Transform::Rotate(DirectX::XMFLOAT3 a_pitchYawRoll)
 {
-	m_rotation.x += a_pitchYawRoll.x;
-	m_rotation.y += a_pitchYawRoll.y;
-	m_rotation.z += a_pitchYawRoll.z;
-	m_isMatricesChanged = m_isVectorsChanged = true;
+	XMFLOAT3 rotation = GetRotation();
+	rotation.x += a_pitchYawRoll.x;
+	rotation.y += a_pitchYawRoll.y;
+	rotation.z += a_pitchYawRoll.z;
+	SetRotation(rotation);
 }
 
-void Transform::Scale(float a_x, float a_y, float a_z)
+void Transform::Rotate(DirectX::XMFLOAT4 a_quaternion)
 {
-	m_scale.x *= a_x;
-	m_scale.y *= a_y;
-	m_scale.z *= a_z;
-	m_isMatricesChanged = true;
+	XMFLOAT4 rotation = GetRotationQuaternion();
+	XMStoreFloat4(&rotation, XMQuaternionMultiply(XMLoadFloat4(&rotation), XMLoadFloat4(&a_quaternion)));
+	SetRotation(rotation);
 }
 
-void Transform::Scale(DirectX::XMFLOAT3 a_scale)
+void Transform::Rotate(DirectX::XMFLOAT3 a_axis, float a_angle)
 {
-	m_scale.x *= a_scale.x;
-	m_scale.y *= a_scale.y;
-	m_scale.z *= a_scale.z;
-	m_isMatricesChanged = true;
+	XMFLOAT4 quaternion;
+	XMStoreFloat4(&quaternion, XMQuaternionRotationAxis(XMLoadFloat3(&a_axis), a_angle));
+	Rotate(quaternion);
 }
 
-void Transform::UpdateMatrices()
+void Transform::Scale(float a_x, float a_y, float a_z)
 {
-	if (m_isMatricesChanged == false) return;
-
-	XMMATRIX t = XMMatrixTranslation(m_position.x, m_position.y, m_position.z);
-	XMMATRIX r = XMMatrixRotationRollPitchYaw(m_rotation.x, m_rotation.y, m_rotation.z);
-	XMMATRIX s = XMMatrixScaling(m_scale.x, m_scale.y, m_scale.z);
-
-	XMMATRIX world = s * r * t;
-	XMStoreFloat4x4(&m_worldMatrix, world);
-	XMStoreFloat4x4(&m_worldInverseTransposeMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
-
-	m_isMatricesChanged = false;
+	Scale(XMFLOAT3(a_x, a_y, a_z));
 }
 
-void Transform::UpdateVectors()
+void Transform::Scale(DirectX::XMFLOAT3 a_scale)
 {
-	if (m_isVectorsChanged == false) return;
-
-	XMVECTOR currentRotation = XMLoadFloat3(&m_rotation);
-	XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(currentRotation);
-
-	XMStoreFloat3(&m_right, XMVector3Rotate(XMVectorSet(1, 0, 0, 0), rotQuat));
-	XMStoreFloat3(&m_up, XMVector3Rotate(XMVectorSet(0, 1, 0, 0), rotQuat));
-	XMStoreFloat3(&m_forward, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rotQuat));
-
-	m_isVectorsChanged = false;
+	XMFLOAT3 scale = GetScale();
+	scale.x *= a_scale.x;
+	scale.y *= a_scale.y;
+	scale.z *= a_scale.z;
+	SetScale(scale);
 }
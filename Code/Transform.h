@@ -2,28 +2,48 @@
 
 #include <DirectXMath.h>
 
+#include "TransformPool.h"
+
+// --------------------------------------------------------
+// A handle to one slot of the TransformPool - the values
+// and matrices live in the pool, not in this object
+//
+// Copying a Transform copies its values (and its parent)
+// into a new slot. Position, rotation and scale are always
+// relative to the parent, if there is one
+// --------------------------------------------------------
 class Transform
 {
 public:
 	Transform();
+	Transform(const Transform& a_other);
+	Transform& operator=(const Transform& a_other);
+	~Transform();
 
 	// Getters
 	DirectX::XMFLOAT3 GetPosition();
 	DirectX::XMFLOAT3 GetRotation();
+	DirectX::XMFLOAT4 GetRotationQuaternion();
 	DirectX::XMFLOAT3 GetScale();
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
+	/* The world matrix without rebuilding it - safe from any thread once the pool is up to date */
+	DirectX::XMFLOAT4X4 ReadWorldMatrix() const;
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
 	DirectX::XMFLOAT3 GetRight();
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
+	unsigned int GetHandle();
 
 	// Setters
 	void SetPosition(float a_x, float a_y, float a_z);
 	void SetPosition(DirectX::XMFLOAT3 a_position);
 	void SetRotation(float a_pitch, float a_yaw, float a_roll);
 	void SetRotation(DirectX::XMFLOAT3 pitchYawRoll);
+	void SetRotation(DirectX::XMFLOAT4 a_quaternion);
 	void SetScale(float a_x, float a_y, float a_z);
 	void SetScale(DirectX::XMFLOAT3 a_scale);
+	/* Attaches this transform to another so it follows it around - nullptr detaches it */
+	void SetParent(Transform* a_pParent);
 
 	// Transformers
 	void MoveAbsolute(float a_x, float a_y, float a_z);
@@ -32,25 +52,13 @@ public:
 	void MoveRelative(DirectX::XMFLOAT3 a_offset);
 	void Rotate(float a_pitch, float a_yaw, float a_roll);
 	void Rotate(DirectX::XMFLOAT3 a_pitchYawRoll);
+	/* Applies a further rotation on top of the current one, about the world axes */
+	void Rotate(DirectX::XMFLOAT4 a_quaternion);
+	void Rotate(DirectX::XMFLOAT3 a_axis, float a_angle);
 	void Scale(float a_x, float a_y, float a_z);
 	void Scale(DirectX::XMFLOAT3 a_scale);
 
 private:
-	DirectX::XMFLOAT3 m_position;
-	DirectX::XMFLOAT3 m_rotation;
-	DirectX::XMFLOAT3 m_scale;
-
-	DirectX::XMFLOAT3 m_right;
-	DirectX::XMFLOAT3 m_up;
-	DirectX::XMFLOAT3 m_forward;
-
-	DirectX::XMFLOAT4X4 m_worldMatrix;
-	DirectX::XMFLOAT4X4 m_worldInverseTransposeMatrix;
-
-	bool m_isMatricesChanged;
-	bool m_isVectorsChanged;
-
-	// Helpers
-	void UpdateMatrices();
-	void UpdateVectors();
+	TransformPool* m_pPool;
+	unsigned int m_handle;
 };
\ No newline at end of file
@@ -0,0 +1,598 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "TransformPool.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+// Singleton requirement
+TransformPool* TransformPool::instance;
+const unsigned int TransformPool::c_noParent;
+
+namespace
+{
+	// Slots are added 64 at a time, so the arrays always hold whole
+	// words of the dirty bitset and whole blocks of four
+	const size_t c_slotsPerWord = 64;
+
+	// Below this many bitset words (64 transforms each) a batch
+	// isn't worth handing to another thread
+	const size_t c_minWordsPerJob = 256;
+
+	// Subtrees with more nodes than this are split up between
+	// jobs, and smaller ones are gathered until they reach it
+	const size_t c_minNodesPerJob = 4096;
+
+	// Three vectors of four transforms each - one vector per axis
+	struct Vector3SoA
+	{
+		XMVECTOR X;
+		XMVECTOR Y;
+		XMVECTOR Z;
+	};
+
+	Vector3SoA Scale(const Vector3SoA& a_v, FXMVECTOR a_scale)
+	{
+		return { XMVectorMultiply(a_v.X, a_scale), XMVectorMultiply(a_v.Y, a_scale), XMVectorMultiply(a_v.Z, a_scale) };
+	}
+
+	// Turns one SoA row of four matrices back into that row of each
+	// matrix, with the given value in the fourth column
+	void StoreRows(XMFLOAT4X4* a_matrices, int a_row, const Vector3SoA& a_row3, FXMVECTOR a_w)
+	{
+		XMMATRIX rows = XMMatrixTranspose(XMMATRIX(a_row3.X, a_row3.Y, a_row3.Z, a_w));
+		for (int i = 0; i < 4; i++)
+			XMStoreFloat4((XMFLOAT4*)a_matrices[i].m[a_row], rows.r[i]);
+	}
+}
+
+// --------------------------------------------------------
+// Hands out a free slot, growing the arrays if there isn't
+// one, and resets it to the identity transform
+// --------------------------------------------------------
+unsigned int TransformPool::Allocate()
+{
+	if (m_freeSlots.empty())
+	{
+		size_t oldCapacity = m_capacity;
+		Reserve(m_capacity + c_slotsPerWord);
+		for (size_t i = m_capacity; i > oldCapacity; i--)
+			m_freeSlots.push_back((unsigned int)(i - 1));
+	}
+
+	unsigned int handle = m_freeSlots.back();
+	m_freeSlots.pop_back();
+
+	SetPosition(handle, XMFLOAT3(0, 0, 0));
+	SetRotation(handle, XMFLOAT3(0, 0, 0));
+	SetScale(handle, XMFLOAT3(1, 1, 1));
+	return handle;
+}
+
+void TransformPool::Free(unsigned int a_handle)
+{
+	SetParent(a_handle, c_noParent);
+	while (m_firstChildren[a_handle] != c_noParent)
+		SetParent(m_firstChildren[a_handle], c_noParent);
+
+	m_freeSlots.push_back(a_handle);
+}
+
+// --------------------------------------------------------
+// Children are kept in a linked list per parent. Nothing
+// is laid out here - the hierarchy array is rebuilt the
+// next time the matrices are
+// --------------------------------------------------------
+void TransformPool::SetParent(unsigned int a_handle, unsigned int a_parent)
+{
+	unsigned int oldParent = m_parents[a_handle];
+	if (a_parent == oldParent)
+		return;
+
+	for (unsigned int ancestor = a_parent; ancestor != c_noParent; ancestor = m_parents[ancestor])
+	{
+		if (ancestor == a_handle)
+		{
+			printf("Can't parent transform %u to %u, which is one of its own children\n", a_handle, a_parent);
+			return;
+		}
+	}
+
+	if (oldParent != c_noParent)
+	{
+		unsigned int* p_link = &m_firstChildren[oldParent];
+		while (*p_link != a_handle)
+			p_link = &m_nextSiblings[*p_link];
+		*p_link = m_nextSiblings[a_handle];
+	}
+
+	if (a_parent != c_noParent)
+	{
+		m_nextSiblings[a_handle] = m_firstChildren[a_parent];
+		m_firstChildren[a_parent] = a_handle;
+	}
+	else
+	{
+		m_nextSiblings[a_handle] = c_noParent;
+	}
+
+	m_parents[a_handle] = a_parent;
+	m_isHierarchyStale = true;
+	MarkDirty(a_handle);
+}
+
+unsigned int TransformPool::GetParent(unsigned int a_handle) { return m_parents[a_handle]; }
+
+XMFLOAT3 TransformPool::GetPosition(unsigned int a_handle) { return XMFLOAT3(m_positionX[a_handle], m_positionY[a_handle], m_positionZ[a_handle]); }
+XMFLOAT3 TransformPool::GetScale(unsigned int a_handle) { return XMFLOAT3(m_scaleX[a_handle], m_scaleY[a_handle], m_scaleZ[a_handle]); }
+XMFLOAT4 TransformPool::GetRotationQuaternion(unsigned int a_handle) { return XMFLOAT4(m_rotationX[a_handle], m_rotationY[a_handle], m_rotationZ[a_handle], m_rotationW[a_handle]); }
+unsigned int TransformPool::GetCount() { return (unsigned int)(m_capacity - m_freeSlots.size()); }
+
+// --------------------------------------------------------
+// Angles are only worked out of the quaternion when they're
+// asked for, since nothing but the UI normally wants them.
+// The rotation matrix is roll, then pitch, then yaw, so
+// its third row gives pitch and yaw and its second column
+// gives roll. Looking straight up or down leaves roll and
+// yaw spinning about the same axis, so roll is taken as 0
+// --------------------------------------------------------
+XMFLOAT3 TransformPool::GetRotation(unsigned int a_handle)
+{
+	uint64_t bit = 1ull << (a_handle % c_slotsPerWord);
+	uint64_t& staleBits = m_staleAngleBits[a_handle / c_slotsPerWord];
+	if (staleBits & bit)
+	{
+		float x = m_rotationX[a_handle], y = m_rotationY[a_handle], z = m_rotationZ[a_handle], w = m_rotationW[a_handle];
+		float sinPitch = -2.0f * (y * z - x * w);
+		if (fabsf(sinPitch) < 0.9999f)
+		{
+			m_pitch[a_handle] = asinf(sinPitch);
+			m_yaw[a_handle] = atan2f(2.0f * (x * z + y * w), 1.0f - 2.0f * (x * x + y * y));
+			m_roll[a_handle] = atan2f(2.0f * (x * y + z * w), 1.0f - 2.0f * (x * x + z * z));
+		}
+		else
+		{
+			m_pitch[a_handle] = copysignf(XM_PIDIV2, sinPitch);
+			m_yaw[a_handle] = atan2f(-2.0f * (x * z - y * w), 1.0f - 2.0f * (y * y + z * z));
+			m_roll[a_handle] = 0.0f;
+		}
+		staleBits &= ~bit;
+	}
+	return XMFLOAT3(m_pitch[a_handle], m_yaw[a_handle], m_roll[a_handle]);
+}
+
+// --------------------------------------------------------
+// The rows of the quaternion's rotation matrix, written
+// out so no matrix (or trig) is needed to get one axis
+// --------------------------------------------------------
+XMFLOAT3 TransformPool::GetRight(unsigned int a_handle)
+{
+	float x = m_rotationX[a_handle], y = m_rotationY[a_handle], z = m_rotationZ[a_handle], w = m_rotationW[a_handle];
+	return XMFLOAT3(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w));
+}
+
+XMFLOAT3 TransformPool::GetUp(unsigned int a_handle)
+{
+	float x = m_rotationX[a_handle], y = m_rotationY[a_handle], z = m_rotationZ[a_handle], w = m_rotationW[a_handle];
+	return XMFLOAT3(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w));
+}
+
+XMFLOAT3 TransformPool::GetForward(unsigned int a_handle)
+{
+	float x = m_rotationX[a_handle], y = m_rotationY[a_handle], z = m_rotationZ[a_handle], w = m_rotationW[a_handle];
+	return XMFLOAT3(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y));
+}
+
+void TransformPool::SetPosition(unsigned int a_handle, XMFLOAT3 a_position)
+{
+	m_positionX[a_handle] = a_position.x;
+	m_positionY[a_handle] = a_position.y;
+	m_positionZ[a_handle] = a_position.z;
+	MarkDirty(a_handle);
+}
+
+void TransformPool::SetRotation(unsigned int a_handle, XMFLOAT3 a_pitchYawRoll)
+{
+	m_pitch[a_handle] = a_pitchYawRoll.x;
+	m_yaw[a_handle] = a_pitchYawRoll.y;
+	m_roll[a_handle] = a_pitchYawRoll.z;
+	m_staleAngleBits[a_handle / c_slotsPerWord] &= ~(1ull << (a_handle % c_slotsPerWord));
+
+	XMFLOAT4 quaternion;
+	XMStoreFloat4(&quaternion, XMQuaternionRotationRollPitchYaw(a_pitchYawRoll.x, a_pitchYawRoll.y, a_pitchYawRoll.z));
+	m_rotationX[a_handle] = quaternion.x;
+	m_rotationY[a_handle] = quaternion.y;
+	m_rotationZ[a_handle] = quaternion.z;
+	m_rotationW[a_handle] = quaternion.w;
+	MarkDirty(a_handle);
+}
+
+void TransformPool::SetRotationQuaternion(unsigned int a_handle, XMFLOAT4 a_quaternion)
+{
+	XMStoreFloat4(&a_quaternion, XMQuaternionNormalize(XMLoadFloat4(&a_quaternion)));
+	m_rotationX[a_handle] = a_quaternion.x;
+	m_rotationY[a_handle] = a_quaternion.y;
+	m_rotationZ[a_handle] = a_quaternion.z;
+	m_rotationW[a_handle] = a_quaternion.w;
+	m_staleAngleBits[a_handle / c_slotsPerWord] |= 1ull << (a_handle % c_slotsPerWord);
+	MarkDirty(a_handle);
+}
+
+void TransformPool::SetScale(unsigned int a_handle, XMFLOAT3 a_scale)
+{
+	m_scaleX[a_handle] = a_scale.x;
+	m_scaleY[a_handle] = a_scale.y;
+	m_scaleZ[a_handle] = a_scale.z;
+	MarkDirty(a_handle);
+
+	uint64_t bit = 1ull << (a_handle % c_slotsPerWord);
+	if (a_scale.x == a_scale.y && a_scale.y == a_scale.z)
+		m_uniformScaleBits[a_handle / c_slotsPerWord] |= bit;
+	else
+		m_uniformScaleBits[a_handle / c_slotsPerWord] &= ~bit;
+}
+
+// --------------------------------------------------------
+// Anything that hasn't been picked up by UpdateMatrices()
+// yet gets its block of four rebuilt on the spot. A stale
+// transform in a hierarchy could be waiting on any of its
+// ancestors, so that means updating everything
+// --------------------------------------------------------
+XMFLOAT4X4 TransformPool::GetWorldMatrix(unsigned int a_handle)
+{
+	if (m_isHierarchyStale || (m_isHierarchyDirty && m_hierarchyIndices[a_handle] != c_noParent))
+		UpdateMatrices();
+	else if (IsDirty(a_handle))
+		UpdateWords(a_handle / c_slotsPerWord, a_handle / c_slotsPerWord + 1);
+
+	if (m_hierarchyIndices[a_handle] != c_noParent)
+		return m_hierarchyWorldMatrices[m_hierarchyIndices[a_handle]];
+	return m_localMatrices[a_handle];
+}
+
+// --------------------------------------------------------
+// Changes nothing, so a slot that's out of date (or under
+// a parent that is) is a bug in the caller, not something
+// to fix up from whichever thread is reading
+// --------------------------------------------------------
+XMFLOAT4X4 TransformPool::ReadWorldMatrix(unsigned int a_handle) const
+{
+	assert(!m_isHierarchyStale && !IsDirty(a_handle));
+	assert(!m_isHierarchyDirty || m_hierarchyIndices[a_handle] == c_noParent);
+
+	if (m_hierarchyIndices[a_handle] != c_noParent)
+		return m_hierarchyWorldMatrices[m_hierarchyIndices[a_handle]];
+	return m_localMatrices[a_handle];
+}
+
+// --------------------------------------------------------
+// With the same scale on every axis the inverse-transpose
+// only differs from the world matrix by a constant factor,
+// which the shaders normalize away, so the world matrix
+// stands in for it and it's never computed at all
+// --------------------------------------------------------
+XMFLOAT4X4 TransformPool::GetWorldInverseTransposeMatrix(unsigned int a_handle)
+{
+	if (m_isHierarchyStale || (m_isHierarchyDirty && m_hierarchyIndices[a_handle] != c_noParent))
+		UpdateMatrices();
+	else if (IsDirty(a_handle))
+		UpdateWords(a_handle / c_slotsPerWord, a_handle / c_slotsPerWord + 1);
+
+	if (m_hierarchyIndices[a_handle] != c_noParent)
+		return m_hierarchyWorldInverseTransposeMatrices[m_hierarchyIndices[a_handle]];
+	if (IsUniformScale(a_handle))
+		return m_localMatrices[a_handle];
+	return m_localInverseTransposeMatrices[a_handle];
+}
+
+// --------------------------------------------------------
+// Each job takes a run of bitset words, so no two threads
+// ever touch the same block, bit or matrix. The hierarchy
+// goes second since it needs every local matrix finished
+// --------------------------------------------------------
+void TransformPool::UpdateMatrices()
+{
+	JobSystem::GetInstance().ParallelFor(m_dirtyBits.size(), c_minWordsPerJob, [this](unsigned int, size_t a_begin, size_t a_end) {
+		UpdateWords(a_begin, a_end);
+	});
+
+	bool isEverythingChanged = m_isHierarchyStale;
+	if (m_isHierarchyStale)
+		RebuildHierarchy();
+	if (isEverythingChanged || m_isHierarchyDirty)
+		UpdateHierarchy(isEverythingChanged);
+}
+
+// --------------------------------------------------------
+// Walks down from every root, depth first, so each subtree
+// ends up as one contiguous run of the array, then works
+// out which nodes get their own jobs:
+//  - Nodes with subtrees bigger than c_minNodesPerJob form
+//    the "spine" and are updated one after another
+//  - Everything under them is whole subtrees hanging off a
+//    spine node (or off nothing), and runs of those that
+//    share a parent are gathered into spans of about
+//    c_minNodesPerJob nodes, which only ever read their
+//    parent's (already finished) matrices
+// --------------------------------------------------------
+void TransformPool::RebuildHierarchy()
+{
+	for (const HierarchyNode& node : m_hierarchy)
+		m_hierarchyIndices[node.Handle] = c_noParent;
+	m_hierarchy.clear();
+
+	std::vector<HierarchyNode> stack;
+	for (unsigned int root = 0; root < m_capacity; root++)
+	{
+		if (m_parents[root] != c_noParent || m_firstChildren[root] == c_noParent)
+			continue;
+
+		stack.push_back({ root, c_noParent, 1 });
+		while (!stack.empty())
+		{
+			HierarchyNode node = stack.back();
+			stack.pop_back();
+
+			unsigned int index = (unsigned int)m_hierarchy.size();
+			m_hierarchyIndices[node.Handle] = index;
+			m_hierarchy.push_back(node);
+			for (unsigned int child = m_firstChildren[node.Handle]; child != c_noParent; child = m_nextSiblings[child])
+				stack.push_back({ child, index, 1 });
+		}
+	}
+
+	// Children always come after their parents, so walking
+	// backwards finishes every subtree before its parent's
+	for (size_t i = m_hierarchy.size(); i-- > 0;)
+	{
+		if (m_hierarchy[i].Parent != c_noParent)
+			m_hierarchy[m_hierarchy[i].Parent].SubtreeSize += m_hierarchy[i].SubtreeSize;
+	}
+
+	m_hierarchySpine.clear();
+	m_hierarchySpans.clear();
+	unsigned int count = (unsigned int)m_hierarchy.size();
+	for (unsigned int i = 0; i < count;)
+	{
+		if (m_hierarchy[i].SubtreeSize > c_minNodesPerJob)
+		{
+			m_hierarchySpine.push_back(i);
+			i++;
+			continue;
+		}
+
+		HierarchySpan span = { i, i + m_hierarchy[i].SubtreeSize, m_hierarchy[i].Parent };
+		while (span.End < count && span.End - span.Start < c_minNodesPerJob &&
+			m_hierarchy[span.End].Parent == span.Parent && m_hierarchy[span.End].SubtreeSize <= c_minNodesPerJob)
+		{
+			span.End += m_hierarchy[span.End].SubtreeSize;
+		}
+		m_hierarchySpans.push_back(span);
+		i = span.End;
+	}
+
+	m_hierarchyWorldMatrices.resize(count);
+	m_hierarchyWorldInverseTransposeMatrices.resize(count);
+	m_hierarchyChanged.assign(count, 0);
+	m_isHierarchyStale = false;
+}
+
+// --------------------------------------------------------
+// A node is recomputed when its own local matrix changed
+// or anything above it was recomputed. Within a span that
+// second case is just "still inside the subtree of a node
+// that changed", since subtrees are contiguous
+// --------------------------------------------------------
+void TransformPool::UpdateHierarchy(bool a_isEverythingChanged)
+{
+	for (unsigned int index : m_hierarchySpine)
+	{
+		const HierarchyNode& node = m_hierarchy[index];
+		bool isChanged = a_isEverythingChanged || ((m_changedBits[node.Handle / c_slotsPerWord] >> (node.Handle % c_slotsPerWord)) & 1) ||
+			(node.Parent != c_noParent && m_hierarchyChanged[node.Parent]);
+		m_hierarchyChanged[index] = isChanged;
+		if (isChanged)
+			UpdateHierarchyNode(index);
+	}
+
+	JobSystem::GetInstance().ParallelFor(m_hierarchySpans.size(), 1, [this, a_isEverythingChanged](unsigned int, size_t a_begin, size_t a_end) {
+		for (size_t s = a_begin; s < a_end; s++)
+		{
+			const HierarchySpan& span = m_hierarchySpans[s];
+			bool isParentChanged = a_isEverythingChanged || (span.Parent != c_noParent && m_hierarchyChanged[span.Parent]);
+			size_t changedEnd = isParentChanged ? span.End : span.Start;
+			for (size_t i = span.Start; i < span.End; i++)
+			{
+				unsigned int handle = m_hierarchy[i].Handle;
+				if ((m_changedBits[handle / c_slotsPerWord] >> (handle % c_slotsPerWord)) & 1)
+					changedEnd = std::max(changedEnd, i + m_hierarchy[i].SubtreeSize);
+				if (i < changedEnd)
+					UpdateHierarchyNode(i);
+			}
+		}
+	});
+
+	std::fill(m_changedBits.begin(), m_changedBits.end(), 0);
+	m_isHierarchyDirty = false;
+}
+
+// --------------------------------------------------------
+// (A * B)^-T = A^-T * B^-T, so the inverse-transposes
+// chain together the same way the world matrices do. A
+// uniformly scaled node uses its local matrix in place of
+// its inverse-transpose, which only throws the result off
+// by a constant factor
+// --------------------------------------------------------
+void TransformPool::UpdateHierarchyNode(size_t a_index)
+{
+	const HierarchyNode& node = m_hierarchy[a_index];
+	XMMATRIX local = XMLoadFloat4x4(&m_localMatrices[node.Handle]);
+	XMMATRIX localInverseTranspose = IsUniformScale(node.Handle) ? local : XMLoadFloat4x4(&m_localInverseTransposeMatrices[node.Handle]);
+
+	if (node.Parent == c_noParent)
+	{
+		XMStoreFloat4x4(&m_hierarchyWorldMatrices[a_index], local);
+		XMStoreFloat4x4(&m_hierarchyWorldInverseTransposeMatrices[a_index], localInverseTranspose);
+		return;
+	}
+
+	XMMATRIX parentWorld = XMLoadFloat4x4(&m_hierarchyWorldMatrices[node.Parent]);
+	XMMATRIX parentInverseTranspose = XMLoadFloat4x4(&m_hierarchyWorldInverseTransposeMatrices[node.Parent]);
+	XMStoreFloat4x4(&m_hierarchyWorldMatrices[a_index], XMMatrixMultiply(local, parentWorld));
+	XMStoreFloat4x4(&m_hierarchyWorldInverseTransposeMatrices[a_index], XMMatrixMultiply(localInverseTranspose, parentInverseTranspose));
+}
+
+void TransformPool::Reserve(size_t a_capacity)
+{
+	a_capacity = (a_capacity + c_slotsPerWord - 1) / c_slotsPerWord * c_slotsPerWord;
+	if (a_capacity <= m_capacity)
+		return;
+
+	XMFLOAT4X4 identity;
+	XMStoreFloat4x4(&identity, XMMatrixIdentity());
+
+	m_positionX.resize(a_capacity, 0.0f);
+	m_positionY.resize(a_capacity, 0.0f);
+	m_positionZ.resize(a_capacity, 0.0f);
+	m_pitch.resize(a_capacity, 0.0f);
+	m_yaw.resize(a_capacity, 0.0f);
+	m_roll.resize(a_capacity, 0.0f);
+	m_rotationX.resize(a_capacity, 0.0f);
+	m_rotationY.resize(a_capacity, 0.0f);
+	m_rotationZ.resize(a_capacity, 0.0f);
+	m_rotationW.resize(a_capacity, 1.0f);
+	m_scaleX.resize(a_capacity, 1.0f);
+	m_scaleY.resize(a_capacity, 1.0f);
+	m_scaleZ.resize(a_capacity, 1.0f);
+	m_localMatrices.resize(a_capacity, identity);
+	m_localInverseTransposeMatrices.resize(a_capacity, identity);
+	m_parents.resize(a_capacity, c_noParent);
+	m_firstChildren.resize(a_capacity, c_noParent);
+	m_nextSiblings.resize(a_capacity, c_noParent);
+	m_hierarchyIndices.resize(a_capacity, c_noParent);
+	m_dirtyBits.resize(a_capacity / c_slotsPerWord, 0);
+	m_uniformScaleBits.resize(a_capacity / c_slotsPerWord, ~0ull);
+	m_staleAngleBits.resize(a_capacity / c_slotsPerWord, 0);
+	m_changedBits.resize(a_capacity / c_slotsPerWord, 0);
+	m_capacity = a_capacity;
+}
+
+void TransformPool::UpdateWords(size_t a_firstWord, size_t a_endWord)
+{
+	for (size_t word = a_firstWord; word < a_endWord; word++)
+	{
+		uint64_t bits = m_dirtyBits[word];
+		if (bits == 0)
+			continue;
+
+		// Any dirty transform means its whole block gets rebuilt -
+		// four at once costs the same as one
+		uint64_t uniformBits = m_uniformScaleBits[word];
+		for (size_t block = 0; block < c_slotsPerWord / 4; block++)
+		{
+			if ((bits >> (block * 4)) & 0xF)
+				UpdateBlock(word * c_slotsPerWord + block * 4, ((uniformBits >> (block * 4)) & 0xF) != 0xF);
+		}
+		m_changedBits[word] |= bits;
+		m_dirtyBits[word] = 0;
+	}
+}
+
+// --------------------------------------------------------
+// Builds scale * rotation * translation for four transforms
+// at once, one SIMD lane per transform. The rotation rows
+// come straight from the quaternions (the same matrix as
+// XMMatrixRotationQuaternion), which only takes multiplies
+//
+// The inverse-transpose only needs its upper 3x3 (it's
+// only ever used on normals). That's (S * R)^-T, and since
+// R is orthonormal it comes out as S^-1 * R - the same
+// rotation rows, divided by the scale instead of times it
+// --------------------------------------------------------
+void TransformPool::UpdateBlock(size_t a_first, bool a_isInverseTransposeNeeded)
+{
+	XMVECTOR x = XMLoadFloat4((const XMFLOAT4*)&m_rotationX[a_first]);
+	XMVECTOR y = XMLoadFloat4((const XMFLOAT4*)&m_rotationY[a_first]);
+	XMVECTOR z = XMLoadFloat4((const XMFLOAT4*)&m_rotationZ[a_first]);
+	XMVECTOR w = XMLoadFloat4((const XMFLOAT4*)&m_rotationW[a_first]);
+
+	XMVECTOR x2 = XMVectorAdd(x, x);
+	XMVECTOR y2 = XMVectorAdd(y, y);
+	XMVECTOR z2 = XMVectorAdd(z, z);
+	XMVECTOR xx = XMVectorMultiply(x, x2);
+	XMVECTOR yy = XMVectorMultiply(y, y2);
+	XMVECTOR zz = XMVectorMultiply(z, z2);
+	XMVECTOR xy = XMVectorMultiply(x, y2);
+	XMVECTOR xz = XMVectorMultiply(x, z2);
+	XMVECTOR yz = XMVectorMultiply(y, z2);
+	XMVECTOR wx = XMVectorMultiply(w, x2);
+	XMVECTOR wy = XMVectorMultiply(w, y2);
+	XMVECTOR wz = XMVectorMultiply(w, z2);
+	XMVECTOR one = XMVectorSplatOne();
+
+	Vector3SoA right = {
+		XMVectorSubtract(one, XMVectorAdd(yy, zz)),
+		XMVectorAdd(xy, wz),
+		XMVectorSubtract(xz, wy)
+	};
+	Vector3SoA up = {
+		XMVectorSubtract(xy, wz),
+		XMVectorSubtract(one, XMVectorAdd(xx, zz)),
+		XMVectorAdd(yz, wx)
+	};
+	Vector3SoA forward = {
+		XMVectorAdd(xz, wy),
+		XMVectorSubtract(yz, wx),
+		XMVectorSubtract(one, XMVectorAdd(xx, yy))
+	};
+
+	XMVECTOR scaleX = XMLoadFloat4((const XMFLOAT4*)&m_scaleX[a_first]);
+	XMVECTOR scaleY = XMLoadFloat4((const XMFLOAT4*)&m_scaleY[a_first]);
+	XMVECTOR scaleZ = XMLoadFloat4((const XMFLOAT4*)&m_scaleZ[a_first]);
+	Vector3SoA row0 = Scale(right, scaleX);
+	Vector3SoA row1 = Scale(up, scaleY);
+	Vector3SoA row2 = Scale(forward, scaleZ);
+	Vector3SoA row3 = {
+		XMLoadFloat4((const XMFLOAT4*)&m_positionX[a_first]),
+		XMLoadFloat4((const XMFLOAT4*)&m_positionY[a_first]),
+		XMLoadFloat4((const XMFLOAT4*)&m_positionZ[a_first])
+	};
+
+	XMFLOAT4X4* local = &m_localMatrices[a_first];
+	StoreRows(local, 0, row0, XMVectorZero());
+	StoreRows(local, 1, row1, XMVectorZero());
+	StoreRows(local, 2, row2, XMVectorZero());
+	StoreRows(local, 3, row3, one);
+
+	// Blocks where every transform is uniformly scaled never have
+	// their inverse-transposes read, so they're left alone
+	if (!a_isInverseTransposeNeeded)
+		return;
+
+	XMFLOAT4X4* inverseTranspose = &m_localInverseTransposeMatrices[a_first];
+	StoreRows(inverseTranspose, 0, Scale(right, XMVectorReciprocal(scaleX)), XMVectorZero());
+	StoreRows(inverseTranspose, 1, Scale(up, XMVectorReciprocal(scaleY)), XMVectorZero());
+	StoreRows(inverseTranspose, 2, Scale(forward, XMVectorReciprocal(scaleZ)), XMVectorZero());
+
+	// The last row is always (0, 0, 0, 1), which Reserve() already put there
+}
+
+void TransformPool::MarkDirty(unsigned int a_handle)
+{
+	m_dirtyBits[a_handle / c_slotsPerWord] |= 1ull << (a_handle % c_slotsPerWord);
+	if (m_hierarchyIndices[a_handle] != c_noParent)
+		m_isHierarchyDirty = true;
+}
+
+bool TransformPool::IsDirty(unsigned int a_handle) const
+{
+	return (m_dirtyBits[a_handle / c_slotsPerWord] >> (a_handle % c_slotsPerWord)) & 1;
+}
+
+bool TransformPool::IsUniformScale(unsigned int a_handle)
+{
+	return (m_uniformScaleBits[a_handle / c_slotsPerWord] >> (a_handle % c_slotsPerWord)) & 1;
+}
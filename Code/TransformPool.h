@@ -0,0 +1,174 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// --------------------------------------------------------
+// Storage for every Transform in the program
+//
+// Positions, rotations and scales are kept as separate
+// arrays of floats (one per component) so the matrices can
+// be rebuilt four transforms at a time. Rotations are held
+// as normalized quaternions, converted once when they're
+// set, with the pitch/yaw/roll they came from kept beside
+// them for anything that wants angles. Changing a value
+// just sets the transform's bit in the dirty bitset - the
+// matrices are rebuilt in one batch by UpdateMatrices(),
+// or on their own if something asks for them first
+//
+// Transforms can also have a parent, which makes their
+// values relative to it. Every transform that's part of a
+// hierarchy is kept in one flat array, depth first, so a
+// parent always comes before its children and each
+// subtree is one contiguous run. Only subtrees under a
+// changed transform get their world matrices recomputed
+// --------------------------------------------------------
+class TransformPool
+{
+#pragma region Singleton
+public:
+	// Gets the one and only instance of this class
+	static TransformPool& GetInstance()
+	{
+		if (!instance)
+		{
+			instance = new TransformPool();
+		}
+
+		return *instance;
+	}
+
+	// Remove these functions (C++ 11 version)
+	TransformPool(TransformPool const&) = delete;
+	void operator=(TransformPool const&) = delete;
+
+private:
+	static TransformPool* instance;
+	TransformPool() : m_isHierarchyStale(false), m_isHierarchyDirty(false), m_capacity(0) {};
+#pragma endregion
+
+public:
+	// Parent handle of a transform that isn't attached to anything
+	static const unsigned int c_noParent = 0xFFFFFFFF;
+
+	/* Reserves a slot holding the identity transform and returns its handle */
+	unsigned int Allocate();
+
+	/* Gives a slot back to the pool to be reused - its children are left without a parent */
+	void Free(unsigned int a_handle);
+
+	/* Puts a_handle's position, rotation and scale in a_parent's space (c_noParent detaches it) */
+	void SetParent(unsigned int a_handle, unsigned int a_parent);
+	unsigned int GetParent(unsigned int a_handle);
+
+	DirectX::XMFLOAT3 GetPosition(unsigned int a_handle);
+	DirectX::XMFLOAT3 GetScale(unsigned int a_handle);
+
+	/* Returns pitch, yaw and roll - worked back out of the quaternion if it was last set directly */
+	DirectX::XMFLOAT3 GetRotation(unsigned int a_handle);
+	DirectX::XMFLOAT4 GetRotationQuaternion(unsigned int a_handle);
+
+	/* The transform's local axes, read straight off the quaternion */
+	DirectX::XMFLOAT3 GetRight(unsigned int a_handle);
+	DirectX::XMFLOAT3 GetUp(unsigned int a_handle);
+	DirectX::XMFLOAT3 GetForward(unsigned int a_handle);
+
+	void SetPosition(unsigned int a_handle, DirectX::XMFLOAT3 a_position);
+	void SetRotation(unsigned int a_handle, DirectX::XMFLOAT3 a_pitchYawRoll);
+	void SetRotationQuaternion(unsigned int a_handle, DirectX::XMFLOAT4 a_quaternion);
+	void SetScale(unsigned int a_handle, DirectX::XMFLOAT3 a_scale);
+
+	/* Returns the transform's world matrix (including its parents), rebuilding it first if it's out of date */
+	DirectX::XMFLOAT4X4 GetWorldMatrix(unsigned int a_handle);
+
+	/* Returns the world matrix as it was last rebuilt, without rebuilding anything, so any number of threads can read at once - the slot has to be up to date already, e.g. after UpdateMatrices() */
+	DirectX::XMFLOAT4X4 ReadWorldMatrix(unsigned int a_handle) const;
+
+	/* The same for the inverse-transpose - uniformly scaled transforms return their world matrix, which only differs by a scale factor */
+	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix(unsigned int a_handle);
+
+	/* Rebuilds every out of date matrix, spread over the job system when there are enough of them */
+	void UpdateMatrices();
+
+	/* Returns how many slots are in use */
+	unsigned int GetCount();
+
+private:
+	// One transform in the hierarchy. Parent is the parent's index
+	// in m_hierarchy and the subtree size includes the node itself
+	struct HierarchyNode
+	{
+		unsigned int Handle;
+		unsigned int Parent;
+		unsigned int SubtreeSize;
+	};
+
+	// A run of whole sibling subtrees small enough to be one job
+	struct HierarchySpan
+	{
+		unsigned int Start;
+		unsigned int End;
+		unsigned int Parent;
+	};
+
+	// Grows every array to hold at least a_capacity transforms
+	void Reserve(size_t a_capacity);
+
+	// Rebuilds the matrices of the four transforms starting at a_first
+	void UpdateBlock(size_t a_first, bool a_isInverseTransposeNeeded);
+
+	// Rebuilds every dirty block within [a_firstWord, a_endWord) of the bitset
+	void UpdateWords(size_t a_firstWord, size_t a_endWord);
+
+	// Lays the hierarchy out again after a parent changes
+	void RebuildHierarchy();
+
+	// Carries every changed local matrix down to the world matrices below it
+	void UpdateHierarchy(bool a_isEverythingChanged);
+
+	// Multiplies one node's local matrices by its parent's world matrices
+	void UpdateHierarchyNode(size_t a_index);
+
+	void MarkDirty(unsigned int a_handle);
+	bool IsDirty(unsigned int a_handle) const;
+	bool IsUniformScale(unsigned int a_handle);
+
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_pitch;
+	std::vector<float> m_yaw;
+	std::vector<float> m_roll;
+	std::vector<float> m_rotationX;
+	std::vector<float> m_rotationY;
+	std::vector<float> m_rotationZ;
+	std::vector<float> m_rotationW;
+	std::vector<float> m_scaleX;
+	std::vector<float> m_scaleY;
+	std::vector<float> m_scaleZ;
+
+	std::vector<DirectX::XMFLOAT4X4> m_localMatrices;	// The world matrix too, for transforms without a parent
+	std::vector<DirectX::XMFLOAT4X4> m_localInverseTransposeMatrices;
+
+	std::vector<unsigned int> m_parents;
+	std::vector<unsigned int> m_firstChildren;
+	std::vector<unsigned int> m_nextSiblings;
+	std::vector<unsigned int> m_hierarchyIndices;	// Where each slot is in m_hierarchy, c_noParent if it isn't
+
+	std::vector<HierarchyNode> m_hierarchy;
+	std::vector<DirectX::XMFLOAT4X4> m_hierarchyWorldMatrices;
+	std::vector<DirectX::XMFLOAT4X4> m_hierarchyWorldInverseTransposeMatrices;
+	std::vector<uint8_t> m_hierarchyChanged;
+	std::vector<unsigned int> m_hierarchySpine;	// Nodes with subtrees too big for one job, updated in order before the spans
+	std::vector<HierarchySpan> m_hierarchySpans;	// Everything else, split into jobs that can run side by side
+	bool m_isHierarchyStale;	// A parent changed, so the layout above is out of date
+	bool m_isHierarchyDirty;	// Some transform in the hierarchy changed since it was last updated
+
+	std::vector<uint64_t> m_dirtyBits;		// One bit per slot
+	std::vector<uint64_t> m_uniformScaleBits;	// Set when all three scales match, so the world matrix can stand in for the inverse-transpose
+	std::vector<uint64_t> m_staleAngleBits;		// Set when the quaternion was set directly and pitch/yaw/roll haven't caught up
+	std::vector<uint64_t> m_changedBits;		// Local matrices rebuilt since the hierarchy last caught up
+	std::vector<unsigned int> m_freeSlots;
+	size_t m_capacity;
+};
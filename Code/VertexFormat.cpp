@@ -0,0 +1,165 @@
+#include <cmath>
+#include <cstring>
+
+#include "VertexFormat.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	// Where a position sits within the bounds, as 0-1 on each axis
+	// - Flat axes (like a quad's) have no extent, so they're all 0
+	XMVECTOR NormalizeToBounds(const XMFLOAT3& a_position, FXMVECTOR a_boundsMin, FXMVECTOR a_extent)
+	{
+		XMVECTOR relative = XMVectorSubtract(XMLoadFloat3(&a_position), a_boundsMin);
+		XMVECTOR hasExtent = XMVectorGreater(a_extent, XMVectorZero());
+		XMVECTOR fraction = XMVectorSelect(XMVectorZero(), XMVectorDivide(relative, a_extent), hasExtent);
+		return XMVectorSaturate(fraction);
+	}
+
+	template<typename CompactVertex, typename PackedDirection>
+	void EncodeCompact(const Vertex* a_verts, size_t a_numVerts, FXMVECTOR a_boundsMin, FXMVECTOR a_extent, CompactVertex* a_output,
+		void (*a_storeDirection)(PackedDirection*, FXMVECTOR))
+	{
+		for (size_t i = 0; i < a_numVerts; i++)
+		{
+			const Vertex& vertex = a_verts[i];
+			CompactVertex& compact = a_output[i];
+
+			float handedness = (vertex.Tangent.w < 0.0f) ? 0.0f : 1.0f;
+			XMStoreUShortN4(&compact.Position, XMVectorSetW(NormalizeToBounds(vertex.Position, a_boundsMin, a_extent), handedness));
+
+			XMFLOAT2 normal = EncodeOctahedral(vertex.Normal);
+			XMFLOAT2 tangent = EncodeOctahedral(XMFLOAT3(vertex.Tangent.x, vertex.Tangent.y, vertex.Tangent.z));
+			a_storeDirection(&compact.Normal, XMLoadFloat2(&normal));
+			a_storeDirection(&compact.Tangent, XMLoadFloat2(&tangent));
+
+			XMStoreHalf2(&compact.UV, XMLoadFloat2(&vertex.UV));
+		}
+	}
+
+	template<typename CompactVertex, typename PackedDirection>
+	void DecodeCompact(const CompactVertex* a_verts, size_t a_numVerts, FXMVECTOR a_boundsMin, FXMVECTOR a_extent, Vertex* a_output,
+		XMVECTOR (*a_loadDirection)(const PackedDirection*))
+	{
+		for (size_t i = 0; i < a_numVerts; i++)
+		{
+			const CompactVertex& compact = a_verts[i];
+			Vertex& vertex = a_output[i];
+
+			XMVECTOR position = XMLoadUShortN4(&compact.Position);
+			XMStoreFloat3(&vertex.Position, XMVectorMultiplyAdd(position, a_extent, a_boundsMin));
+
+			XMFLOAT2 normal;
+			XMFLOAT2 tangent;
+			XMStoreFloat2(&normal, a_loadDirection(&compact.Normal));
+			XMStoreFloat2(&tangent, a_loadDirection(&compact.Tangent));
+			vertex.Normal = DecodeOctahedral(normal);
+
+			XMFLOAT3 tangentDirection = DecodeOctahedral(tangent);
+			float handedness = (XMVectorGetW(position) < 0.5f) ? -1.0f : 1.0f;
+			vertex.Tangent = XMFLOAT4(tangentDirection.x, tangentDirection.y, tangentDirection.z, handedness);
+
+			XMStoreFloat2(&vertex.UV, XMLoadHalf2(&compact.UV));
+		}
+	}
+}
+
+unsigned int GetVertexStride(VertexFormat a_format)
+{
+	switch (a_format)
+	{
+	case VertexFormat::Compact16: return sizeof(CompactVertex16);
+	case VertexFormat::Compact8: return sizeof(CompactVertex8);
+	default: return sizeof(Vertex);
+	}
+}
+
+const char* GetVertexFormatName(VertexFormat a_format)
+{
+	switch (a_format)
+	{
+	case VertexFormat::Compact16: return "Compact (16-bit)";
+	case VertexFormat::Compact8: return "Compact (8-bit)";
+	default: return "Full";
+	}
+}
+
+// --------------------------------------------------------
+// Octahedral encoding: the direction is projected onto an
+// octahedron, whose bottom half is then folded out over
+// the top half's corners so it all flattens into a square
+// - Must match DecodeOctahedral() in ShaderIncludes.hlsli
+// --------------------------------------------------------
+XMFLOAT2 EncodeOctahedral(XMFLOAT3 a_direction)
+{
+	float length = fabsf(a_direction.x) + fabsf(a_direction.y) + fabsf(a_direction.z);
+	if (length <= 0.0f)
+		return XMFLOAT2(0.0f, 0.0f);
+
+	float x = a_direction.x / length;
+	float y = a_direction.y / length;
+	if (a_direction.z < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	return XMFLOAT2(x, y);
+}
+
+XMFLOAT3 DecodeOctahedral(XMFLOAT2 a_encoded)
+{
+	XMFLOAT3 direction(a_encoded.x, a_encoded.y, 1.0f - fabsf(a_encoded.x) - fabsf(a_encoded.y));
+
+	// Unfold the bottom half back underneath
+	float fold = (direction.z < 0.0f) ? -direction.z : 0.0f;
+	direction.x += (direction.x >= 0.0f) ? -fold : fold;
+	direction.y += (direction.y >= 0.0f) ? -fold : fold;
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVector3Normalize(XMLoadFloat3(&direction)));
+	return result;
+}
+
+void EncodeVertices(VertexFormat a_format, const Vertex* a_verts, size_t a_numVerts, XMFLOAT3 a_boundsMin, XMFLOAT3 a_boundsMax, std::vector<unsigned char>& a_output)
+{
+	a_output.resize(GetVertexStride(a_format) * a_numVerts);
+
+	XMVECTOR boundsMin = XMLoadFloat3(&a_boundsMin);
+	XMVECTOR extent = XMVectorSubtract(XMLoadFloat3(&a_boundsMax), boundsMin);
+
+	switch (a_format)
+	{
+	case VertexFormat::Compact16:
+		EncodeCompact(a_verts, a_numVerts, boundsMin, extent, (CompactVertex16*)a_output.data(), &XMStoreShortN2);
+		break;
+	case VertexFormat::Compact8:
+		EncodeCompact(a_verts, a_numVerts, boundsMin, extent, (CompactVertex8*)a_output.data(), &XMStoreByteN2);
+		break;
+	default:
+		memcpy(a_output.data(), a_verts, sizeof(Vertex) * a_numVerts);
+		break;
+	}
+}
+
+void DecodeVertices(VertexFormat a_format, const void* a_data, size_t a_numVerts, XMFLOAT3 a_boundsMin, XMFLOAT3 a_boundsMax, Vertex* a_output)
+{
+	XMVECTOR boundsMin = XMLoadFloat3(&a_boundsMin);
+	XMVECTOR extent = XMVectorSubtract(XMLoadFloat3(&a_boundsMax), boundsMin);
+
+	switch (a_format)
+	{
+	case VertexFormat::Compact16:
+		DecodeCompact((const CompactVertex16*)a_data, a_numVerts, boundsMin, extent, a_output, &XMLoadShortN2);
+		break;
+	case VertexFormat::Compact8:
+		DecodeCompact((const CompactVertex8*)a_data, a_numVerts, boundsMin, extent, a_output, &XMLoadByteN2);
+		break;
+	default:
+		memcpy(a_output, a_data, sizeof(Vertex) * a_numVerts);
+		break;
+	}
+}
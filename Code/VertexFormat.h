@@ -0,0 +1,62 @@
+#pragma once
+
+#include <DirectXPackedVector.h>
+#include <vector>
+
+#include "Vertex.h"
+
+// --------------------------------------------------------
+// The layouts a mesh's vertex buffer can be stored in
+//
+// Meshes are always loaded and processed as full Vertex
+// structs - they're only converted to their format when
+// the vertex buffer is created
+// --------------------------------------------------------
+enum class VertexFormat
+{
+	Full,		// Vertex - 48 bytes of floats
+	Compact16,	// CompactVertex16 - 20 bytes
+	Compact8,	// CompactVertex8 - 16 bytes
+	Count
+};
+
+// --------------------------------------------------------
+// Compact vertex definitions
+//
+// - Positions are 16-bit fractions of the mesh's bounding
+//    box, and w holds the tangent handedness (0 is -1)
+// - Normals and tangents are octahedral encoded, which
+//    squeezes a unit vector into two signed values
+// - UVs are half floats
+// --------------------------------------------------------
+struct CompactVertex16
+{
+	DirectX::PackedVector::XMUSHORTN4 Position;
+	DirectX::PackedVector::XMSHORTN2 Normal;
+	DirectX::PackedVector::XMSHORTN2 Tangent;
+	DirectX::PackedVector::XMHALF2 UV;
+};
+
+struct CompactVertex8
+{
+	DirectX::PackedVector::XMUSHORTN4 Position;
+	DirectX::PackedVector::XMBYTEN2 Normal;
+	DirectX::PackedVector::XMBYTEN2 Tangent;
+	DirectX::PackedVector::XMHALF2 UV;
+};
+
+// Returns the size of one vertex in the given format
+unsigned int GetVertexStride(VertexFormat a_format);
+
+// Returns a short name for the format, for the GUI
+const char* GetVertexFormatName(VertexFormat a_format);
+
+// Maps a unit vector to two values in [-1, 1] and back again
+DirectX::XMFLOAT2 EncodeOctahedral(DirectX::XMFLOAT3 a_direction);
+DirectX::XMFLOAT3 DecodeOctahedral(DirectX::XMFLOAT2 a_encoded);
+
+// Converts vertices to a_format, with positions relative to the given bounds
+void EncodeVertices(VertexFormat a_format, const Vertex* a_verts, size_t a_numVerts, DirectX::XMFLOAT3 a_boundsMin, DirectX::XMFLOAT3 a_boundsMax, std::vector<unsigned char>& a_output);
+
+// Converts vertices in a_format back to full Vertex structs (tangents come back with w)
+void DecodeVertices(VertexFormat a_format, const void* a_data, size_t a_numVerts, DirectX::XMFLOAT3 a_boundsMin, DirectX::XMFLOAT3 a_boundsMax, Vertex* a_output);
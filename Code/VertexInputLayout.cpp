@@ -0,0 +1,38 @@
+#include <cstdio>
+
+#include "VertexInputLayout.h"
+
+// --------------------------------------------------------
+// SimpleShader builds input layouts from reflection, which
+// only knows the shader wants floats - not that they're
+// packed - so compact formats describe their layout here
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11InputLayout> CreateVertexInputLayout(VertexFormat a_format, const void* a_shaderByteCode, size_t a_byteCodeLength, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice)
+{
+	DXGI_FORMAT directionFormat = (a_format == VertexFormat::Compact8) ? DXGI_FORMAT_R8G8_SNORM : DXGI_FORMAT_R16G16_SNORM;
+
+	const D3D11_INPUT_ELEMENT_DESC fullElements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	const D3D11_INPUT_ELEMENT_DESC compactElements[] =
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, directionFormat, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TANGENT", 0, directionFormat, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+
+	const D3D11_INPUT_ELEMENT_DESC* elements = (a_format == VertexFormat::Full) ? fullElements : compactElements;
+	UINT elementCount = (a_format == VertexFormat::Full) ? ARRAYSIZE(fullElements) : ARRAYSIZE(compactElements);
+
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+	HRESULT hr = a_pDevice->CreateInputLayout(elements, elementCount, a_shaderByteCode, a_byteCodeLength, inputLayout.GetAddressOf());
+	if (FAILED(hr))
+		printf("Unable to create the input layout for vertex format %s\n", GetVertexFormatName(a_format));
+
+	return inputLayout;
+}
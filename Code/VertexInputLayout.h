@@ -0,0 +1,9 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl/client.h>
+
+#include "VertexFormat.h"
+
+// Creates the input layout for a_format, checked against a vertex shader's byte code
+Microsoft::WRL::ComPtr<ID3D11InputLayout> CreateVertexInputLayout(VertexFormat a_format, const void* a_shaderByteCode, size_t a_byteCodeLength, Microsoft::WRL::ComPtr<ID3D11Device> a_pDevice);
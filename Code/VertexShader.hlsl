@@ -1,14 +1,18 @@
 #include "ShaderIncludes.hlsli"
 
-// Constant buffer
-cbuffer ExternalData : register(b0)
+// Constant buffers, split by how often they change
+cbuffer PerFrame : register(b0)
 {
-    matrix worldMatrix;
-    matrix worldInvTransposeMatrix;
     matrix viewMatrix;
     matrix projectionMatrix;
 }
 
+cbuffer PerObject : register(b1)
+{
+    matrix worldMatrix;
+    matrix worldInvTransposeMatrix;
+}
+
 // --------------------------------------------------------
 // The entry point (main method) for our vertex shader
 // 
@@ -35,7 +39,7 @@ VertexToPixel main(VertexShaderInput input)
 	// get the pixel's world position
     output.worldPosition = mul(worldMatrix, float4(input.localPosition, 1.0f)).xyz;
 	
-    output.tangent = normalize(mul((float3x3) worldMatrix, input.tangent));
+    output.tangent = float4(normalize(mul((float3x3) worldMatrix, input.tangent.xyz)), input.tangent.w);
 
 	// Whatever we return will make its way through the pipeline to the
 	// next programmable stage we're using (the pixel shader for now)